@@ -4,52 +4,120 @@
 #include "CHashStringPool.h"
 
 CHashStringPool::CHashStringPool()
-	: m_Strings( 256 )
 {
+	ResizeTable( MIN_TABLE_SIZE );
 }
 
 CHashStringPool::~CHashStringPool()
 {
+	for( auto& block : m_Blocks )
+		delete[] block.pData;
 }
 
 const char* CHashStringPool::Find( const char* pszString ) const
 {
-	Strings_t::const_iterator it = m_Strings.find( CAutoString( pszString ) );
+	if( !pszString )
+		pszString = "";
 
-	if( it != m_Strings.end() )
-		return it->Get();
+	size_t uiLength;
+
+	const uint32_t uiHash = Hash( pszString, uiLength );
+
+	if( auto pszPooled = m_Table[ FindSlot( pszString, uiHash, uiLength ) ] )
+		return pszPooled;
 
 	return "";
 }
 
 const char* CHashStringPool::Allocate( const char* pszString, bool* pNewAllocation )
 {
-	std::pair<Strings_t::iterator, bool> result = m_Strings.emplace( pszString );
+	if( !pszString )
+		pszString = "";
+
+	size_t uiLength;
+
+	const uint32_t uiHash = Hash( pszString, uiLength );
+
+	size_t uiSlot = FindSlot( pszString, uiHash, uiLength );
 
 	if( pNewAllocation )
-		*pNewAllocation = result.second;
+		*pNewAllocation = m_Table[ uiSlot ] == nullptr;
 
-	if( result.first != m_Strings.end() )
-		return result.first->Get();
+	if( m_Table[ uiSlot ] )
+		return m_Table[ uiSlot ];
 
-	return "";
+	//Keep the load factor at or below 0.5.
+	if( ( m_uiCount + 1 ) * 2 > m_Table.size() )
+	{
+		ResizeTable( m_Table.size() * 2 );
+		uiSlot = FindSlot( pszString, uiHash, uiLength );
+	}
+
+	//Keep headers aligned.
+	const size_t uiSize = ( sizeof( Header ) + uiLength + 1 + alignof( Header ) - 1 ) & ~( alignof( Header ) - 1 );
+
+	char* pMemory = AllocateMemory( uiSize );
+
+	auto pHeader = reinterpret_cast<Header*>( pMemory );
+
+	pHeader->uiHash = uiHash;
+	pHeader->uiLength = static_cast<uint32_t>( uiLength );
+
+	char* pszPooled = pMemory + sizeof( Header );
+
+	memcpy( pszPooled, pszString, uiLength + 1 );
+
+	m_Table[ uiSlot ] = pszPooled;
+
+	++m_uiCount;
+	m_uiStringBytes += uiLength + 1;
+
+	return pszPooled;
+}
+
+bool CHashStringPool::Owns( const char* pszString ) const
+{
+	if( pszString < m_pszLowest || pszString >= m_pszHighest )
+		return false;
+
+	for( const auto& block : m_Blocks )
+	{
+		if( pszString >= block.pData && pszString < block.pData + block.uiUsed )
+			return true;
+	}
+
+	return false;
 }
 
 void CHashStringPool::Clear()
 {
-	m_Strings.clear();
+	for( auto& block : m_Blocks )
+		delete[] block.pData;
+
+	m_Blocks.clear();
+
+	m_Table.clear();
+	ResizeTable( MIN_TABLE_SIZE );
+
+	m_uiCount = 0;
+	m_uiStringBytes = 0;
+
+	m_pszLowest = nullptr;
+	m_pszHighest = nullptr;
 }
 
 void CHashStringPool::DebugPrint() const
 {
-	size_t uiSizeInUse = 0;
+	size_t uiBlockBytes = 0;
 
-	for( Strings_t::const_iterator it = m_Strings.begin(); it != m_Strings.end(); ++it )
-	{
-		uiSizeInUse += strlen( it->Get() ) + 1;
-	}
+	for( const auto& block : m_Blocks )
+		uiBlockBytes += block.uiSize;
 
-	ALERT( at_console, "CHashStringPool: current status:\nNumber of strings allocated: %u\nMemory in use: %u bytes\n", m_Strings.size(), uiSizeInUse );
+	ALERT( at_console, "CHashStringPool: current status:\nNumber of strings allocated: %u\nMemory in use: %u bytes\n",
+		static_cast<unsigned int>( m_uiCount ), static_cast<unsigned int>( m_uiStringBytes ) );
+	ALERT( at_console, "Blocks: %u (%u bytes)\nHash table: %u slots, load factor %.2f\n",
+		static_cast<unsigned int>( m_Blocks.size() ), static_cast<unsigned int>( uiBlockBytes ),
+		static_cast<unsigned int>( m_Table.size() ), static_cast<double>( m_uiCount ) / m_Table.size() );
 }
 
 #ifdef DEBUG_STRING_ALLOCATION
@@ -59,16 +127,101 @@ void CHashStringPool::VerifyIntegrity() const
 
 	size_t uiFailed = 0;
 
-	for( Strings_t::const_iterator it = m_Strings.begin(); it != m_Strings.end(); ++it )
+	for( auto pszString : m_Table )
 	{
-		if( !it->VerifyIntegrity() )
+		if( !pszString )
+			continue;
+
+		size_t uiLength;
+
+		const uint32_t uiHash = Hash( pszString, uiLength );
+
+		if( uiHash != GetHash( pszString ) || uiLength != GetLength( pszString ) )
 		{
 			++uiFailed;
 
-			ALERT( at_console, "%s failed to verify: Was %s\n", it->Get(), it->GetVerifyString() );
+			ALERT( at_console, "%s failed to verify: hash or length was modified\n", pszString );
 		}
 	}
 
-	ALERT( at_console, "CHashStringPool: %u strings checked; %u failed to verify\n", m_Strings.size(), uiFailed );
+	ALERT( at_console, "CHashStringPool: %u strings checked; %u failed to verify\n",
+		static_cast<unsigned int>( m_uiCount ), static_cast<unsigned int>( uiFailed ) );
+}
+#endif
+
+uint32_t CHashStringPool::Hash( const char* pszString, size_t& uiLength )
+{
+	//Computed in the same pass as the length.
+	return StringHashFNV1a( pszString, false, SIZE_MAX, &uiLength );
+}
+
+size_t CHashStringPool::FindSlot( const char* pszString, const uint32_t uiHash, const size_t uiLength ) const
+{
+	const size_t uiMask = m_Table.size() - 1;
+
+	for( size_t uiSlot = uiHash & uiMask; ; uiSlot = ( uiSlot + 1 ) & uiMask )
+	{
+		const char* pszPooled = m_Table[ uiSlot ];
+
+		if( !pszPooled )
+			return uiSlot;
+
+		const Header* pHeader = GetHeader( pszPooled );
+
+		if( pHeader->uiHash == uiHash && pHeader->uiLength == uiLength && !memcmp( pszPooled, pszString, uiLength ) )
+			return uiSlot;
+	}
+}
+
+char* CHashStringPool::AllocateMemory( const size_t uiSize )
+{
+	if( m_Blocks.empty() || m_Blocks.back().uiSize - m_Blocks.back().uiUsed < uiSize )
+	{
+		//Strings larger than a block get a block of their own.
+		Block block;
+
+		block.uiSize = uiSize > BLOCK_SIZE ? uiSize : static_cast<size_t>( BLOCK_SIZE );
+		block.pData = new char[ block.uiSize ];
+		block.uiUsed = 0;
+
+		if( !m_pszLowest || block.pData < m_pszLowest )
+			m_pszLowest = block.pData;
+
+		if( !m_pszHighest || block.pData + block.uiSize > m_pszHighest )
+			m_pszHighest = block.pData + block.uiSize;
+
+		m_Blocks.push_back( block );
+	}
+
+	auto& block = m_Blocks.back();
+
+	char* pMemory = block.pData + block.uiUsed;
+
+	block.uiUsed += uiSize;
+
+	return pMemory;
+}
+
+void CHashStringPool::ResizeTable( const size_t uiSize )
+{
+	std::vector<const char*> oldTable;
+
+	oldTable.swap( m_Table );
+
+	m_Table.resize( uiSize, nullptr );
+
+	const size_t uiMask = uiSize - 1;
+
+	for( auto pszString : oldTable )
+	{
+		if( !pszString )
+			continue;
+
+		size_t uiSlot = GetHash( pszString ) & uiMask;
+
+		while( m_Table[ uiSlot ] )
+			uiSlot = ( uiSlot + 1 ) & uiMask;
+
+		m_Table[ uiSlot ] = pszString;
+	}
 }
-#endif
\ No newline at end of file
@@ -1,23 +1,55 @@
 #ifndef CHASHSTRINGPOOL_H
 #define CHASHSTRINGPOOL_H
 
-#include <unordered_set>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
-#include "CAutoString.h"
+#include "StringUtils.h"
 
+/**
+*	Pool of interned strings.
+*	Strings are stored in large blocks, each preceded by its hash and length, and are never moved or freed until the pool is cleared.
+*	Every distinct string is stored once, so two strings returned by the same pool are equal if and only if their addresses are equal.
+*/
 class CHashStringPool final
 {
-private:
-	typedef std::unordered_set<CAutoString> Strings_t;
-
 public:
 	CHashStringPool();
 	~CHashStringPool();
 
+	/**
+	*	@return The pooled copy of the given string, or an empty string if it isn't in the pool.
+	*/
 	const char* Find( const char* pszString ) const;
 
+	/**
+	*	@return The pooled copy of the given string. It is added if it isn't in the pool yet.
+	*/
 	const char* Allocate( const char* pszString, bool* pNewAllocation = nullptr );
 
+	/**
+	*	@return Whether the given string was returned by this pool.
+	*	Addresses outside of all blocks are rejected immediately, others are checked against each block in turn.
+	*/
+	bool Owns( const char* pszString ) const;
+
+	/**
+	*	@return Length of a string returned by this pool.
+	*/
+	static size_t GetLength( const char* pszPooledString )
+	{
+		return GetHeader( pszPooledString )->uiLength;
+	}
+
+	/**
+	*	@return Hash of a string returned by this pool.
+	*/
+	static uint32_t GetHash( const char* pszPooledString )
+	{
+		return GetHeader( pszPooledString )->uiHash;
+	}
+
 	void Clear();
 
 	void DebugPrint() const;
@@ -27,11 +59,63 @@ public:
 #endif
 
 private:
-	Strings_t m_Strings;
+	struct Header
+	{
+		uint32_t uiHash;
+		uint32_t uiLength;
+	};
+
+	struct Block
+	{
+		char* pData;
+		size_t uiSize;
+		size_t uiUsed;
+	};
+
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	static const size_t MIN_TABLE_SIZE = 256;
+
+	static const Header* GetHeader( const char* pszPooledString )
+	{
+		return reinterpret_cast<const Header*>( pszPooledString ) - 1;
+	}
+
+	static uint32_t Hash( const char* pszString, size_t& uiLength );
+
+	/**
+	*	@return Index of the slot that holds the string, or the empty slot it should go in.
+	*/
+	size_t FindSlot( const char* pszString, const uint32_t uiHash, const size_t uiLength ) const;
+
+	char* AllocateMemory( const size_t uiSize );
+
+	void ResizeTable( const size_t uiSize );
+
+private:
+	std::vector<Block> m_Blocks;
+
+	/**
+	*	Open addressed hash table of pooled strings. The size is a power of 2.
+	*/
+	std::vector<const char*> m_Table;
+
+	size_t m_uiCount = 0;
+
+	/**
+	*	Size of all strings, including terminators.
+	*/
+	size_t m_uiStringBytes = 0;
+
+	/**
+	*	Address range covered by all blocks, to quickly reject strings that aren't pooled.
+	*/
+	const char* m_pszLowest = nullptr;
+	const char* m_pszHighest = nullptr;
 
 private:
 	CHashStringPool( const CHashStringPool& ) = delete;
 	CHashStringPool& operator=( const CHashStringPool& ) = delete;
 };
 
-#endif //CHASHSTRINGPOOL_H
\ No newline at end of file
+#endif //CHASHSTRINGPOOL_H
@@ -42,5 +42,80 @@ struct dheader_t
 	lump_t		lumps[HEADER_LUMPS];
 };
 
+// Lumps needed to trace against the point hull. dmodel_t is in com_model.h.
+
+struct dplane_t
+{
+	float	normal[3];
+	float	dist;
+	int		type;		// 0-2 are axial planes
+};
+
+struct dnode_t
+{
+	int			planenum;
+	short		children[2];	// negative numbers are -(leafs+1), not nodes
+	short		mins[3];		// for sphere culling
+	short		maxs[3];
+	unsigned short	firstface;
+	unsigned short	numfaces;	// counting both sides
+};
+
+struct dleaf_t
+{
+	int			contents;
+	int			visofs;				// -1 = no visibility info
+
+	short		mins[3];			// for frustum culling
+	short		maxs[3];
+
+	unsigned short		firstmarksurface;
+	unsigned short		nummarksurfaces;
+
+	byte		ambient_level[4];
+};
+
+// Lumps needed to find the texture at a point on a surface.
+
+// Only the start of a miptex_t, the pixel data follows it.
+struct dmiptexname_t
+{
+	char		name[16];
+	unsigned	width, height;
+};
+
+struct dvertex_t
+{
+	float	point[3];
+};
+
+struct dtexinfo_t
+{
+	float		vecs[2][4];		// [s/t][xyz offset]
+	int			miptex;
+	int			flags;
+};
+
+// note that edge 0 is never used, because negative edge nums are used for
+// counterclockwise use of the edge in a face
+struct dedge_t
+{
+	unsigned short	v[2];		// vertex numbers
+};
+
+struct dface_t
+{
+	short		planenum;
+	short		side;
+
+	int			firstedge;		// we must support > 64k edges
+	short		numedges;
+	short		texinfo;
+
+// lighting info
+	byte		styles[4];
+	int			lightofs;		// start of [numstyles*surfsize] samples
+};
+
 
 #endif //COMMON_MINIBSPFILE_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <string>
@@ -56,6 +57,33 @@ inline size_t StringHashI( const char* pszString )
 	return ( _Val );
 }
 
+/**
+*	FNV-1a string hash. Unlike StringHash, every character is hashed, and the result does not depend on the size of size_t.
+*	@param pszString String to hash.
+*	@param bCaseInsensitive Whether to hash characters as if they were lowercase.
+*	@param uiMaxLength Maximum number of characters to hash.
+*	@param puiLength If not null, receives the number of characters that were hashed.
+*/
+inline uint32_t StringHashFNV1a( const char* pszString, const bool bCaseInsensitive = false, const size_t uiMaxLength = SIZE_MAX, size_t* puiLength = nullptr )
+{
+	uint32_t uiHash = 2166136261U;
+
+	size_t uiIndex = 0;
+
+	for( ; uiIndex < uiMaxLength && pszString[ uiIndex ]; ++uiIndex )
+	{
+		const unsigned char character = static_cast<unsigned char>( pszString[ uiIndex ] );
+
+		uiHash ^= bCaseInsensitive ? static_cast<unsigned char>( tolower( character ) ) : character;
+		uiHash *= 16777619U;
+	}
+
+	if( puiLength )
+		*puiLength = uiIndex;
+
+	return uiHash;
+}
+
 /**
 *	Functor for char* hashing.
 */
@@ -18,6 +18,9 @@ public:
 	bool IsValid( void ) const				{ return (m_fileData) ? true : false; }	///< returns true if this file object is attached to a file
 	bool Read( void *data, int length );		///< read 'length' bytes from the file
 
+	const byte *GetCursor( void ) const		{ return m_cursor; }		///< the unread part of the file, to use in place
+	int GetBytesLeft( void ) const			{ return m_bytesLeft; }
+
 private:
 	byte *m_fileData;												///< the file read into memory
 	int m_fileDataLength;										///< the length of the file
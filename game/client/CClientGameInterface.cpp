@@ -16,6 +16,8 @@
 
 #include "BSPIO.h"
 
+#include "materials/Materials.h"
+
 #if USE_ANGELSCRIPT
 #include "Angelscript/CHLASClientManager.h"
 #endif
@@ -103,6 +105,9 @@ bool CClientGameInterface::ConnectionEstablished()
 	m_bNewMapStarted = true;
 	m_bParseMapData = true;
 
+	//The engine frees textures on map change, cached material types refer to the previous map's.
+	g_MaterialsList.ClearTextureCache();
+
 	return true;
 }
 
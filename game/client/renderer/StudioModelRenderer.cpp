@@ -487,7 +487,7 @@ void CStudioModelRenderer::StudioSetupBones ( void )
 
 	static Vector		pos[MAXSTUDIOBONES];
 	static Vector4D		q[MAXSTUDIOBONES];
-	Matrix3x4			bonematrix;
+	static Matrix3x4	bonematrices[MAXSTUDIOBONES];
 
 	static Vector		pos2[MAXSTUDIOBONES];
 	static Vector4D		q2[MAXSTUDIOBONES];
@@ -656,13 +656,11 @@ void CStudioModelRenderer::StudioSetupBones ( void )
 		}
 	}
 
+	QuaternionMatrices( q, pos, bonematrices, m_pStudioHeader->numbones );
+
 	for (i = 0; i < m_pStudioHeader->numbones; i++) 
 	{
-		QuaternionMatrix( q[i], bonematrix );
-
-		bonematrix[0][3] = pos[i][0];
-		bonematrix[1][3] = pos[i][1];
-		bonematrix[2][3] = pos[i][2];
+		const Matrix3x4& bonematrix = bonematrices[i];
 
 		if (pbones[i].parent == -1) 
 		{
@@ -21,6 +21,8 @@
 
 #include "CASPluginModuleBuilder.h"
 
+#include "CASScriptProfiler.h"
+
 #include "CASPluginManager.h"
 
 #include "xml/CStrX.h"
@@ -439,6 +441,8 @@ void CASPluginManager::UnloadPlugin( CASModule* pPlugin )
 
 	//Plugin data is now removed by the module's destructor.
 
+	g_ASScriptProfiler.RemoveModule( pPlugin );
+
 	m_ASManager.GetASManager().GetModuleManager().RemoveModule( pPlugin );
 }
 
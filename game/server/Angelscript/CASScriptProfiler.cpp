@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include <angelscript.h>
+
+#include <Angelscript/CASModule.h>
+#include <Angelscript/event/CASEvent.h>
+
+#include "extdll.h"
+#include "util.h"
+
+#include "Server.h"
+
+#include "CASScriptProfiler.h"
+
+CASScriptProfiler g_ASScriptProfiler;
+
+static void ServerCommand_ProfileDump()
+{
+	size_t uiCount = 10;
+
+	if( CMD_ARGC() >= 2 )
+	{
+		const int iCount = atoi( CMD_ARGV( 1 ) );
+
+		if( iCount > 0 )
+			uiCount = static_cast<size_t>( iCount );
+	}
+
+	g_ASScriptProfiler.Dump( uiCount );
+}
+
+static void ServerCommand_ProfileReset()
+{
+	g_ASScriptProfiler.Reset();
+}
+
+void CASScriptProfiler::Initialize()
+{
+	g_engfuncs.pfnAddServerCommand( "as_profile_dump", &::ServerCommand_ProfileDump );
+	g_engfuncs.pfnAddServerCommand( "as_profile_reset", &::ServerCommand_ProfileReset );
+
+	Think();
+}
+
+void CASScriptProfiler::Shutdown()
+{
+	m_Mode = Mode::OFF;
+
+	Reset();
+}
+
+void CASScriptProfiler::Think()
+{
+	ASSERT( m_Scopes.empty() );
+
+	const int iMode = static_cast<int>( as_profile.value );
+
+	//The frame budget needs every call to be timed if profiling wasn't enabled explicitly.
+	if( iMode == 2 )
+		m_Mode = Mode::SAMPLED;
+	else if( iMode == 1 || as_plugin_frame_budget.value > 0 )
+		m_Mode = Mode::FULL;
+	else
+		m_Mode = Mode::OFF;
+
+	m_uiSampleRate = m_Mode == Mode::SAMPLED ? static_cast<unsigned int>( std::max( 1, static_cast<int>( as_profile_sample_rate.value ) ) ) : 1;
+
+	const double flBudget = as_plugin_frame_budget.value / 1000.0;
+
+	for( auto& module : m_Modules )
+	{
+		auto& record = module.second;
+
+		record.flWorstFrameTime = std::max( record.flWorstFrameTime, record.flFrameTime );
+
+		if( flBudget > 0 && record.flFrameTime > flBudget )
+		{
+			++record.uiBudgetOverruns;
+
+			//At most one warning per module per second.
+			if( record.flLastWarningTime < 0 || gpGlobals->time < record.flLastWarningTime || gpGlobals->time - record.flLastWarningTime >= 1 )
+			{
+				Alert( at_warning, "Script module \"%s\" used %.3f ms in one frame (budget %.3f ms, %llu overruns)\n",
+					record.szName.c_str(), record.flFrameTime * 1000, as_plugin_frame_budget.value, static_cast<unsigned long long>( record.uiBudgetOverruns ) );
+
+				record.flLastWarningTime = gpGlobals->time;
+			}
+		}
+
+		record.flFrameTime = 0;
+	}
+}
+
+void CASScriptProfiler::BeginHook( const CASEvent& event, const asIScriptFunction& function )
+{
+	const Key key{ &event, &function };
+
+	auto it = m_Records.find( key );
+
+	if( it != m_Records.end() )
+	{
+		Begin( it->second );
+		return;
+	}
+
+	//Delegates belong to the module of the function they call.
+	auto pFunction = function.GetDelegateFunction() ? function.GetDelegateFunction() : &function;
+
+	const std::string szName = std::string( event.GetCategory() ) + "::" + event.GetName() + " -> " + pFunction->GetDeclaration( true, true );
+
+	Begin( FindOrCreateRecord( key, Category::HOOK, GetModuleFromScriptFunction( pFunction ), szName.c_str() ) );
+}
+
+void CASScriptProfiler::BeginEntity( const asITypeInfo& type, const char* const pszMethod )
+{
+	const Key key{ &type, pszMethod };
+
+	auto it = m_Records.find( key );
+
+	if( it != m_Records.end() )
+	{
+		Begin( it->second );
+		return;
+	}
+
+	std::string szName;
+
+	if( type.GetNamespace() && *type.GetNamespace() )
+		szName = std::string( type.GetNamespace() ) + "::";
+
+	szName += type.GetName();
+	szName += "::";
+	szName += pszMethod;
+
+	Begin( FindOrCreateRecord( key, Category::ENTITY, type.GetModule() ? GetModuleFromScriptModule( type.GetModule() ) : nullptr, szName.c_str() ) );
+}
+
+void CASScriptProfiler::Begin( Record& record )
+{
+	m_Scopes.push_back( { &record, Clock::now(), 0 } );
+}
+
+void CASScriptProfiler::End()
+{
+	ASSERT( !m_Scopes.empty() );
+
+	if( m_Scopes.empty() )
+		return;
+
+	const auto endTime = Clock::now();
+
+	const auto scope = m_Scopes.back();
+
+	m_Scopes.pop_back();
+
+	const double flElapsed = std::chrono::duration<double>( endTime - scope.startTime ).count();
+
+	if( !m_Scopes.empty() )
+		m_Scopes.back().flChildTime += flElapsed;
+
+	//Sampled calls stand in for the calls that weren't timed.
+	const double flScale = m_uiSampleRate;
+
+	auto& record = *scope.pRecord;
+
+	record.uiCalls += m_uiSampleRate;
+	record.flTime += flElapsed * flScale;
+	record.flMaxTime = std::max( record.flMaxTime, flElapsed );
+
+	auto& module = *record.pModuleRecord;
+
+	const double flSelfTime = std::max( 0.0, flElapsed - scope.flChildTime ) * flScale;
+
+	module.uiCalls += m_uiSampleRate;
+	module.flTime += flSelfTime;
+	module.flFrameTime += flSelfTime;
+}
+
+void CASScriptProfiler::RemoveModule( const CASModule* pModule )
+{
+	ASSERT( m_Scopes.empty() );
+
+	for( auto it = m_Records.begin(); it != m_Records.end(); )
+	{
+		if( it->second.pModule == pModule )
+			it = m_Records.erase( it );
+		else
+			++it;
+	}
+
+	m_Modules.erase( pModule );
+}
+
+void CASScriptProfiler::Reset()
+{
+	ASSERT( m_Scopes.empty() );
+
+	m_Records.clear();
+	m_Modules.clear();
+	m_uiSampleCounter = 0;
+}
+
+void CASScriptProfiler::Dump( const size_t uiCount ) const
+{
+	if( m_Mode == Mode::OFF )
+		Alert( at_console, "Script profiling is off, set as_profile to 1 (every call) or 2 (sampled) to enable it\n" );
+	else if( m_Mode == Mode::SAMPLED )
+		Alert( at_console, "Sampling 1 in %u calls; calls and times are estimates\n", m_uiSampleRate );
+
+	//The same method name literal can have a different address in each file that calls it, so merge records by name.
+	std::vector<Record> records;
+
+	for( const auto& entry : m_Records )
+	{
+		const auto& record = entry.second;
+
+		auto it = std::find_if( records.begin(), records.end(), [ & ]( const Record& other )
+		{
+			return other.category == record.category && other.pModule == record.pModule && other.szName == record.szName;
+		} );
+
+		if( it != records.end() )
+		{
+			it->uiCalls += record.uiCalls;
+			it->flTime += record.flTime;
+			it->flMaxTime = std::max( it->flMaxTime, record.flMaxTime );
+		}
+		else
+		{
+			records.emplace_back( record );
+		}
+	}
+
+	std::sort( records.begin(), records.end(), []( const Record& lhs, const Record& rhs )
+	{
+		return lhs.flTime > rhs.flTime;
+	} );
+
+	const auto printRecords = [ & ]( const Category category, const char* const pszTitle )
+	{
+		Alert( at_console, "%s:\n%10s %12s %10s %10s  %-16s %s\n", pszTitle, "calls", "total ms", "avg us", "max us", "module", "function" );
+
+		size_t uiPrinted = 0;
+
+		for( const auto& record : records )
+		{
+			if( record.category != category )
+				continue;
+
+			if( uiPrinted++ >= uiCount )
+				break;
+
+			Alert( at_console, "%10llu %12.3f %10.2f %10.2f  %-16s %s\n",
+				static_cast<unsigned long long>( record.uiCalls ), record.flTime * 1000,
+				record.uiCalls ? record.flTime * 1000000 / record.uiCalls : 0.0, record.flMaxTime * 1000000,
+				record.szModuleName.c_str(), record.szName.c_str() );
+		}
+	};
+
+	printRecords( Category::HOOK, "Hooks" );
+	printRecords( Category::ENTITY, "Custom entity methods" );
+
+	std::vector<const ModuleRecord*> modules;
+
+	modules.reserve( m_Modules.size() );
+
+	for( const auto& module : m_Modules )
+	{
+		modules.emplace_back( &module.second );
+	}
+
+	std::sort( modules.begin(), modules.end(), []( const ModuleRecord* pLHS, const ModuleRecord* pRHS )
+	{
+		return pLHS->flTime > pRHS->flTime;
+	} );
+
+	Alert( at_console, "Modules (exclusive time):\n%10s %12s %14s %10s  %s\n", "calls", "total ms", "worst frame ms", "overruns", "module" );
+
+	for( size_t uiIndex = 0; uiIndex < modules.size() && uiIndex < uiCount; ++uiIndex )
+	{
+		const auto& module = *modules[ uiIndex ];
+
+		Alert( at_console, "%10llu %12.3f %14.3f %10llu  %s\n",
+			static_cast<unsigned long long>( module.uiCalls ), module.flTime * 1000, module.flWorstFrameTime * 1000,
+			static_cast<unsigned long long>( module.uiBudgetOverruns ), module.szName.c_str() );
+	}
+}
+
+CASScriptProfiler::Record& CASScriptProfiler::FindOrCreateRecord( const Key& key, Category category, const CASModule* pModule, const char* const pszName )
+{
+	auto& record = m_Records[ key ];
+
+	record.category = category;
+	record.pModule = pModule;
+	record.pModuleRecord = &GetModuleRecord( pModule );
+	record.szModuleName = record.pModuleRecord->szName;
+	record.szName = pszName;
+
+	return record;
+}
+
+CASScriptProfiler::ModuleRecord& CASScriptProfiler::GetModuleRecord( const CASModule* pModule )
+{
+	auto it = m_Modules.find( pModule );
+
+	if( it == m_Modules.end() )
+	{
+		it = m_Modules.emplace( pModule, ModuleRecord() ).first;
+
+		it->second.szName = pModule ? pModule->GetModuleName() : "<unknown>";
+	}
+
+	return it->second;
+}
@@ -0,0 +1,230 @@
+#ifndef GAME_SERVER_ANGELSCRIPT_CASSCRIPTPROFILER_H
+#define GAME_SERVER_ANGELSCRIPT_CASSCRIPTPROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class asIScriptFunction;
+class asITypeInfo;
+class CASEvent;
+class CASModule;
+
+/**
+*	Measures the time spent in script code called from the server: event hooks and custom entity methods.
+*	Controlled by as_profile: 0 is off, 1 times every call, 2 times one in as_profile_sample_rate calls and scales the results up.
+*	Time is recorded inclusive per hooked function and per entity class method, and exclusive per module so nested calls into another plugin are charged to that plugin.
+*	If as_plugin_frame_budget is set, modules that spend more than that many milliseconds in a frame are reported. This times every call if profiling is off.
+*/
+class CASScriptProfiler final
+{
+public:
+	using Clock = std::chrono::high_resolution_clock;
+
+	enum class Category
+	{
+		HOOK,
+		ENTITY
+	};
+
+	enum class Mode
+	{
+		OFF,
+		FULL,
+		SAMPLED
+	};
+
+	struct ModuleRecord;
+
+	/**
+	*	Totals for a single hooked function or entity class method.
+	*/
+	struct Record
+	{
+		Category category;
+		const CASModule* pModule;
+		ModuleRecord* pModuleRecord;
+
+		std::string szModuleName;
+		std::string szName;
+
+		uint64_t uiCalls = 0;
+
+		/**
+		*	Inclusive time, in seconds.
+		*/
+		double flTime = 0;
+		double flMaxTime = 0;
+	};
+
+	/**
+	*	Totals for a module.
+	*/
+	struct ModuleRecord
+	{
+		std::string szName;
+
+		uint64_t uiCalls = 0;
+
+		/**
+		*	Exclusive time, in seconds.
+		*/
+		double flTime = 0;
+
+		double flFrameTime = 0;
+		double flWorstFrameTime = 0;
+
+		uint64_t uiBudgetOverruns = 0;
+		float flLastWarningTime = -1;
+	};
+
+private:
+	struct Key
+	{
+		const void* pSource;
+		const void* pTag;
+
+		bool operator==( const Key& other ) const
+		{
+			return pSource == other.pSource && pTag == other.pTag;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()( const Key& key ) const
+		{
+			return std::hash<const void*>()( key.pSource ) ^ ( std::hash<const void*>()( key.pTag ) * 31 );
+		}
+	};
+
+	struct ActiveScope
+	{
+		Record* pRecord;
+		Clock::time_point startTime;
+
+		/**
+		*	Time spent in sampled scopes nested in this one.
+		*/
+		double flChildTime;
+	};
+
+public:
+	CASScriptProfiler() = default;
+	~CASScriptProfiler() = default;
+
+	/**
+	*	Registers the profiler's console commands.
+	*/
+	void Initialize();
+
+	void Shutdown();
+
+	/**
+	*	Should be called once per frame. Picks up cvar changes and checks the per module frame budget.
+	*/
+	void Think();
+
+	Mode GetMode() const { return m_Mode; }
+
+	/**
+	*	@return Whether the next call should be timed.
+	*/
+	bool ShouldSample()
+	{
+		if( m_Mode == Mode::OFF )
+			return false;
+
+		if( m_Mode == Mode::FULL )
+			return true;
+
+		return ++m_uiSampleCounter % m_uiSampleRate == 0;
+	}
+
+	/**
+	*	Starts timing a call to a function hooked into an event.
+	*/
+	void BeginHook( const CASEvent& event, const asIScriptFunction& function );
+
+	/**
+	*	Starts timing a call to a custom entity method.
+	*	@param pszMethod Method name. Must be a string literal, it is used as part of the key.
+	*/
+	void BeginEntity( const asITypeInfo& type, const char* const pszMethod );
+
+	void End();
+
+	/**
+	*	Removes all records for the given module. Must be called before a module is destroyed.
+	*/
+	void RemoveModule( const CASModule* pModule );
+
+	void Reset();
+
+	/**
+	*	Prints the most expensive functions and modules to the console.
+	*/
+	void Dump( const size_t uiCount ) const;
+
+private:
+	void Begin( Record& record );
+
+	Record& FindOrCreateRecord( const Key& key, Category category, const CASModule* pModule, const char* const pszName );
+
+	ModuleRecord& GetModuleRecord( const CASModule* pModule );
+
+private:
+	Mode m_Mode = Mode::OFF;
+
+	unsigned int m_uiSampleRate = 1;
+	unsigned int m_uiSampleCounter = 0;
+
+	std::unordered_map<Key, Record, KeyHash> m_Records;
+	std::unordered_map<const CASModule*, ModuleRecord> m_Modules;
+
+	std::vector<ActiveScope> m_Scopes;
+
+private:
+	CASScriptProfiler( const CASScriptProfiler& ) = delete;
+	CASScriptProfiler& operator=( const CASScriptProfiler& ) = delete;
+};
+
+extern CASScriptProfiler g_ASScriptProfiler;
+
+/**
+*	Times the script call made in the scope it is declared in, if the profiler decides to sample it.
+*/
+class CASProfileScope final
+{
+public:
+	CASProfileScope( const CASEvent& event, const asIScriptFunction& function )
+		: m_bActive( g_ASScriptProfiler.ShouldSample() )
+	{
+		if( m_bActive )
+			g_ASScriptProfiler.BeginHook( event, function );
+	}
+
+	CASProfileScope( const asITypeInfo* pType, const char* const pszMethod )
+		: m_bActive( pType && g_ASScriptProfiler.ShouldSample() )
+	{
+		if( m_bActive )
+			g_ASScriptProfiler.BeginEntity( *pType, pszMethod );
+	}
+
+	~CASProfileScope()
+	{
+		if( m_bActive )
+			g_ASScriptProfiler.End();
+	}
+
+private:
+	const bool m_bActive;
+
+private:
+	CASProfileScope( const CASProfileScope& ) = delete;
+	CASProfileScope& operator=( const CASProfileScope& ) = delete;
+};
+
+#endif //GAME_SERVER_ANGELSCRIPT_CASSCRIPTPROFILER_H
@@ -17,7 +17,9 @@
 
 #include "Angelscript/CHLASServerInitializer.h"
 
+#include "Angelscript/CASBytecodeCache.h"
 #include "Angelscript/CASMapModuleBuilder.h"
+#include "Angelscript/CASScriptProfiler.h"
 
 #include "ScriptAPI/Extensions/CASGameRules.h"
 
@@ -29,6 +31,19 @@
 
 CHLASServerManager g_ASManager;
 
+static void ServerCommand_BytecodeCacheStats()
+{
+	const auto& stats = g_ASBytecodeCache.GetStats();
+
+	const uint64_t uiTotal = stats.uiHits + stats.uiMisses;
+
+	Alert( at_console, "Module builds: %llu\n", static_cast<unsigned long long>( uiTotal ) );
+	Alert( at_console, "Cache hits: %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiHits ),
+		uiTotal ? 100.0 * stats.uiHits / uiTotal : 0.0 );
+	Alert( at_console, "Cache misses: %llu (%llu out of date)\n", static_cast<unsigned long long>( stats.uiMisses ), static_cast<unsigned long long>( stats.uiStale ) );
+	Alert( at_console, "Compile time saved: %.2f ms\n", stats.flTimeSaved * 1000 );
+}
+
 CHLASServerManager::CHLASServerManager()
 	: m_PluginManager( *this )
 {
@@ -44,6 +59,10 @@ bool CHLASServerManager::Initialize()
 	if( !m_PluginManager.Initialize() )
 		return false;
 
+	g_engfuncs.pfnAddServerCommand( "as_bytecodecache_stats", &::ServerCommand_BytecodeCacheStats );
+
+	g_ASScriptProfiler.Initialize();
+
 	//Map scripts are per-map scripts that always have their hooks executed before any other module.
 	auto descriptor = m_Manager.GetModuleManager().AddDescriptor( "MapScript", ModuleAccessMask::MAPSCRIPT, as::ModulePriority::HIGHEST );
 
@@ -71,6 +90,8 @@ bool CHLASServerManager::Initialize()
 
 void CHLASServerManager::Shutdown()
 {
+	g_ASScriptProfiler.Shutdown();
+
 	g_CustomEntities.Shutdown();
 
 #if USE_AS_SQL
@@ -79,6 +100,8 @@ void CHLASServerManager::Shutdown()
 
 	if( m_pModule )
 	{
+		g_ASScriptProfiler.RemoveModule( m_pModule );
+
 		m_Manager.GetModuleManager().RemoveModule( m_pModule );
 		m_pModule = nullptr;
 	}
@@ -90,6 +113,9 @@ void CHLASServerManager::Shutdown()
 
 void CHLASServerManager::Think()
 {
+	//Close out the previous frame before any script code runs in this one.
+	g_ASScriptProfiler.Think();
+
 #if USE_AS_SQL
 	CASOwningContext ctx( *m_Manager.GetEngine() );
 	g_pSQLThreadPool->ProcessQueue( *ctx.GetContext() );
@@ -199,6 +225,8 @@ void CHLASServerManager::WorldEnded()
 
 	if( m_pModule )
 	{
+		g_ASScriptProfiler.RemoveModule( m_pModule );
+
 		m_Manager.GetModuleManager().RemoveModule( m_pModule );
 		m_pModule = nullptr;
 	}
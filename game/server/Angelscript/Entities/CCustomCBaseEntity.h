@@ -7,12 +7,58 @@
 #include <Angelscript/util/CASRefPtr.h>
 #include <Angelscript/util/CASExtendAdapter.h>
 
+#include "Angelscript/CASScriptProfiler.h"
+
 #include "IASCustomEntity.h"
 
 #include "CASCustomEntities.h"
 
 #undef GetObject
 
+/**
+*	The CASExtendAdapter call macros, with the script call timed by the script profiler.
+*/
+#define CALL_CUSTOM_FUNC_RET_DIFFFUNC( retType, methodName, baseMethodName, pszParams, ... )							\
+retType result = retType();																							\
+																													\
+if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( #retType " " #methodName pszParams ) )				\
+{																													\
+	CASProfileScope profile( GetObject().GetTypeInfo(), #methodName );												\
+																													\
+	CASOwningContext ctx( *pFunction->GetEngine() );																\
+																													\
+	CASMethod method( *pFunction, ctx, GetObject().Get() );															\
+																													\
+	if( method.Call( CallFlag::NONE, ##__VA_ARGS__ ) )																\
+	{																												\
+		method.GetReturnValue( &result );																			\
+	}																												\
+}																													\
+else																												\
+{																													\
+	result = baseMethodName( __VA_ARGS__ );																			\
+}																													\
+																													\
+return result
+
+#define CALL_CUSTOM_FUNC_RET( retType, methodName, pszParams, ... )									\
+CALL_CUSTOM_FUNC_RET_DIFFFUNC( retType, methodName, BaseClass::methodName, pszParams, ##__VA_ARGS__ )
+
+#define CALL_CUSTOM_FUNC_DIFFFUNC( methodName, baseMethodName, pszParams, ... )								\
+if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "void " #methodName pszParams ) )			\
+{																											\
+	CASProfileScope profile( GetObject().GetTypeInfo(), #methodName );										\
+																											\
+	as::Call( GetObject().Get(), pFunction, ##__VA_ARGS__ );												\
+}																											\
+else																										\
+{																											\
+	baseMethodName( __VA_ARGS__ );																			\
+}
+
+#define CALL_CUSTOM_FUNC( methodName, pszParams, ... )									\
+CALL_CUSTOM_FUNC_DIFFFUNC( methodName, BaseClass::methodName, pszParams, ##__VA_ARGS__ )
+
 /**
 *	Extension class for custom entities inheriting from BASECLASS.
 *	Provides extension methods for CBaseEntity.
@@ -113,49 +159,49 @@ public:
 
 	void OnCreate() override
 	{
-		CALL_EXTEND_FUNC( OnCreate, "()" );
+		CALL_CUSTOM_FUNC( OnCreate, "()" );
 	}
 
 	void OnDestroy() override
 	{
-		CALL_EXTEND_FUNC( OnDestroy, "()" );
+		CALL_CUSTOM_FUNC( OnDestroy, "()" );
 
 		m_Instance.Reset();
 	}
 
 	void UpdateOnRemove() override
 	{
-		CALL_EXTEND_FUNC( UpdateOnRemove, "()" );
+		CALL_CUSTOM_FUNC( UpdateOnRemove, "()" );
 	}
 
 	void KeyValue( KeyValueData* pkvd ) override
 	{
-		CALL_EXTEND_FUNC( KeyValue, "(KeyValueData@)", pkvd );
+		CALL_CUSTOM_FUNC( KeyValue, "(KeyValueData@)", pkvd );
 	}
 
 	void Precache() override
 	{
-		CALL_EXTEND_FUNC( Precache, "()" );
+		CALL_CUSTOM_FUNC( Precache, "()" );
 	}
 
 	void Spawn() override
 	{
-		CALL_EXTEND_FUNC( Spawn, "()" );
+		CALL_CUSTOM_FUNC( Spawn, "()" );
 	}
 
 	void Activate() override
 	{
-		CALL_EXTEND_FUNC( Activate, "()" );
+		CALL_CUSTOM_FUNC( Activate, "()" );
 	}
 
 	int ObjectCaps() const override
 	{
-		CALL_EXTEND_FUNC_RET( int, ObjectCaps, "()" );
+		CALL_CUSTOM_FUNC_RET( int, ObjectCaps, "()" );
 	}
 
 	void SetObjectCollisionBox() override
 	{
-		CALL_EXTEND_FUNC( SetObjectCollisionBox, "()" );
+		CALL_CUSTOM_FUNC( SetObjectCollisionBox, "()" );
 	}
 
 	CBaseEntity* Respawn() override
@@ -165,6 +211,8 @@ public:
 
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "CBaseEntity@ Respawn()" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "Respawn" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -189,6 +237,8 @@ public:
 		if( m_ThinkFunc )
 		{
 			//This is a delegate so we don't pass 'this'.
+			CASProfileScope profile( GetObject().GetTypeInfo(), "Think" );
+
 			as::Call( m_ThinkFunc.Get() );
 		}
 	}
@@ -200,7 +250,7 @@ public:
 
 	void Think() override
 	{
-		CALL_EXTEND_FUNC_DIFFFUNC( Think, DefaultScriptThink, "()" );
+		CALL_CUSTOM_FUNC_DIFFFUNC( Think, DefaultScriptThink, "()" );
 	}
 
 	void DefaultScriptTouch( CBaseEntity* pOther )
@@ -210,6 +260,8 @@ public:
 		if( m_TouchFunc )
 		{
 			//This is a delegate so we don't pass 'this'.
+			CASProfileScope profile( GetObject().GetTypeInfo(), "Touch" );
+
 			as::Call( m_TouchFunc.Get(), pOther );
 		}
 	}
@@ -221,7 +273,7 @@ public:
 
 	void Touch( CBaseEntity* pOther ) override
 	{
-		CALL_EXTEND_FUNC_DIFFFUNC( Touch, DefaultScriptTouch, "(CBaseEntity@)", pOther );
+		CALL_CUSTOM_FUNC_DIFFFUNC( Touch, DefaultScriptTouch, "(CBaseEntity@)", pOther );
 	}
 
 	void DefaultScriptUse( CBaseEntity* pActivator, CBaseEntity* pCaller, USE_TYPE useType, float flValue )
@@ -231,6 +283,8 @@ public:
 		if( m_UseFunc )
 		{
 			//This is a delegate so we don't pass 'this'.
+			CASProfileScope profile( GetObject().GetTypeInfo(), "Use" );
+
 			as::Call( m_UseFunc.Get(), pActivator, pCaller, useType, flValue );
 		}
 	}
@@ -242,7 +296,7 @@ public:
 
 	void Use( CBaseEntity* pActivator, CBaseEntity* pCaller, USE_TYPE useType, float flValue ) override
 	{
-		CALL_EXTEND_FUNC_DIFFFUNC( Use, DefaultScriptUse, "(CBaseEntity@, CBaseEntity@, USE_TYPE, float)", pActivator, pCaller, useType, flValue );
+		CALL_CUSTOM_FUNC_DIFFFUNC( Use, DefaultScriptUse, "(CBaseEntity@, CBaseEntity@, USE_TYPE, float)", pActivator, pCaller, useType, flValue );
 	}
 
 	void DefaultScriptBlocked( CBaseEntity* pOther )
@@ -252,6 +306,8 @@ public:
 		if( m_BlockedFunc )
 		{
 			//This is a delegate so we don't pass 'this'.
+			CASProfileScope profile( GetObject().GetTypeInfo(), "Blocked" );
+
 			as::Call( m_BlockedFunc.Get(), pOther );
 		}
 	}
@@ -263,23 +319,25 @@ public:
 
 	void Blocked( CBaseEntity* pOther ) override
 	{
-		CALL_EXTEND_FUNC_DIFFFUNC( Blocked, DefaultScriptBlocked, "(CBaseEntity@)", pOther );
+		CALL_CUSTOM_FUNC_DIFFFUNC( Blocked, DefaultScriptBlocked, "(CBaseEntity@)", pOther );
 	}
 
 	EntityClassification_t GetClassification() override
 	{
-		CALL_EXTEND_FUNC_RET( EntityClassification_t, GetClassification, "()" );
+		CALL_CUSTOM_FUNC_RET( EntityClassification_t, GetClassification, "()" );
 	}
 
 	int BloodColor() const override
 	{
-		CALL_EXTEND_FUNC_RET( int, BloodColor, "() const" );
+		CALL_CUSTOM_FUNC_RET( int, BloodColor, "() const" );
 	}
 
 	void TraceAttack( const CTakeDamageInfo& info, Vector vecDir, TraceResult& tr ) override
 	{
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "void TraceAttack(const CTakeDamageInfo& in, Vector, TraceResult& in)" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "TraceAttack" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -296,6 +354,8 @@ public:
 	{
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "void TraceBleed(const CTakeDamageInfo& in, Vector, TraceResult& in)" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "TraceBleed" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -312,6 +372,8 @@ public:
 	{
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "void OnTakeDamage(const CTakeDamageInfo& in)" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "OnTakeDamage" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -328,6 +390,8 @@ public:
 	{
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "void Killed(const CTakeDamageInfo& in, GibAction)" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "Killed" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -342,51 +406,51 @@ public:
 
 	float GiveHealth( float flHealth, int bitsDamageType ) override
 	{
-		CALL_EXTEND_FUNC_RET( float, GiveHealth, "(float, int)", flHealth, bitsDamageType );
+		CALL_CUSTOM_FUNC_RET( float, GiveHealth, "(float, int)", flHealth, bitsDamageType );
 	}
 
 	bool IsTriggered( const CBaseEntity* const pActivator ) const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, IsTriggered, "(const CBaseEntity@) const", pActivator );
+		CALL_CUSTOM_FUNC_RET( bool, IsTriggered, "(const CBaseEntity@) const", pActivator );
 	}
 
 	//TODO: MyMonsterPointer. Allows scripts to return null if monsters need that kind of behavior. - Solokiller
 
 	bool IsMoving() const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, IsMoving, "() const" );
+		CALL_CUSTOM_FUNC_RET( bool, IsMoving, "() const" );
 	}
 
 	void OverrideReset() override
 	{
-		CALL_EXTEND_FUNC( OverrideReset, "()" );
+		CALL_CUSTOM_FUNC( OverrideReset, "()" );
 	}
 
 	int DamageDecal( int bitsDamageType ) const override
 	{
-		CALL_EXTEND_FUNC_RET( int, DamageDecal, "(int) const", bitsDamageType );
+		CALL_CUSTOM_FUNC_RET( int, DamageDecal, "(int) const", bitsDamageType );
 	}
 
 	//TODO: temporary - Solokiller
 
 	bool OnControls( const CBaseEntity* const pTest ) const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, OnControls, "(const CBaseEntity@) const", pTest );
+		CALL_CUSTOM_FUNC_RET( bool, OnControls, "(const CBaseEntity@) const", pTest );
 	}
 
 	bool IsAlive() const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, IsAlive, "() const" );
+		CALL_CUSTOM_FUNC_RET( bool, IsAlive, "() const" );
 	}
 
 	bool IsBSPModel() const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, IsBSPModel, "() const" );
+		CALL_CUSTOM_FUNC_RET( bool, IsBSPModel, "() const" );
 	}
 
 	bool ReflectGauss() const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, ReflectGauss, "() const" );
+		CALL_CUSTOM_FUNC_RET( bool, ReflectGauss, "() const" );
 	}
 
 	bool HasTarget( string_t targetname ) const override
@@ -395,6 +459,8 @@ public:
 
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "bool HasTarget(const string_t& in) const" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "HasTarget" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -414,7 +480,7 @@ public:
 
 	bool IsInWorld() const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, IsInWorld, "() const" );
+		CALL_CUSTOM_FUNC_RET( bool, IsInWorld, "() const" );
 	}
 
 	//Do not override IsPlayer or IsNetClient: code assumes it's a CBasePlayer/CBaseSpectator in that case. - Solokiller
@@ -425,6 +491,8 @@ public:
 
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "string TeamID() const" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "TeamID" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -448,6 +516,8 @@ public:
 
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "CBaseEntity@ GetNextTarget()" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "GetNextTarget" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -467,32 +537,32 @@ public:
 
 	bool IsLockedByMaster() const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, IsLockedByMaster, "() const" );
+		CALL_CUSTOM_FUNC_RET( bool, IsLockedByMaster, "() const" );
 	}
 
 	void DeathNotice( CBaseEntity* pChild ) override
 	{
-		CALL_EXTEND_FUNC( DeathNotice, "(CBaseEntity@)", pChild );
+		CALL_CUSTOM_FUNC( DeathNotice, "(CBaseEntity@)", pChild );
 	}
 
 	bool BarnacleVictimGrabbed( CBaseEntity* pBarnacle ) override
 	{
-		CALL_EXTEND_FUNC_RET( bool, BarnacleVictimGrabbed, "(CBaseEntity@)", pBarnacle );
+		CALL_CUSTOM_FUNC_RET( bool, BarnacleVictimGrabbed, "(CBaseEntity@)", pBarnacle );
 	}
 
 	Vector Center() const override
 	{
-		CALL_EXTEND_FUNC_RET( Vector, Center, "() const" );
+		CALL_CUSTOM_FUNC_RET( Vector, Center, "() const" );
 	}
 
 	Vector EyePosition() const override
 	{
-		CALL_EXTEND_FUNC_RET( Vector, EyePosition, "() const" );
+		CALL_CUSTOM_FUNC_RET( Vector, EyePosition, "() const" );
 	}
 
 	Vector EarPosition() const override
 	{
-		CALL_EXTEND_FUNC_RET( Vector, EarPosition, "() const" );
+		CALL_CUSTOM_FUNC_RET( Vector, EarPosition, "() const" );
 	}
 
 	Vector BodyTarget( const Vector &posSrc ) const override
@@ -501,6 +571,8 @@ public:
 
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "Vector BodyTarget(const Vector& in) const" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "BodyTarget" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -520,12 +592,12 @@ public:
 
 	int Illumination() const override
 	{
-		CALL_EXTEND_FUNC_RET( int, Illumination, "() const" );
+		CALL_CUSTOM_FUNC_RET( int, Illumination, "() const" );
 	}
 
 	bool FVisible( const CBaseEntity *pEntity ) const override
 	{
-		CALL_EXTEND_FUNC_RET( bool, FVisible, "(const CBaseEntity@) const", pEntity );
+		CALL_CUSTOM_FUNC_RET( bool, FVisible, "(const CBaseEntity@) const", pEntity );
 	}
 
 	bool FVisible( const Vector &vecOrigin ) const override
@@ -534,6 +606,8 @@ public:
 
 		if( auto pFunction = GetObject().GetTypeInfo()->GetMethodByDecl( "Vector BodyTarget(const Vector& in) const" ) )
 		{
+			CASProfileScope profile( GetObject().GetTypeInfo(), "BodyTarget" );
+
 			CASOwningContext ctx( *pFunction->GetEngine() );
 
 			CASMethod method( *pFunction, ctx, GetObject().Get() );
@@ -3,21 +3,103 @@
 
 #include <angelscript.h>
 
+#include <Angelscript/wrapper/ASCallable.h>
+#include <Angelscript/wrapper/CASContext.h>
+
 #include "Angelscript/HLASConstants.h"
 //TODO: avoid using server specific code here. - Solokiller
 #include "Angelscript/CHLASServerManager.h"
+#include "Angelscript/CASScriptProfiler.h"
 
 #include "ASEvents.h"
 
+/**
+*	Calls events the same way CASEventCaller does, but times each hooked function with the script profiler.
+*/
+class CASProfilingEventCaller : public CASBaseEventCaller<CASProfilingEventCaller, CASEvent, HookCallResult, HookCallResult::FAILED>
+{
+public:
+	ReturnType_t CallEvent( EventType_t& event, asIScriptContext* pContext, CallFlags_t flags, va_list list );
+};
+
+CASProfilingEventCaller::ReturnType_t CASProfilingEventCaller::CallEvent( EventType_t& event, asIScriptContext* pContext, CallFlags_t flags, va_list list )
+{
+	CASContext ctx( *pContext );
+
+	bool bSuccess = true;
+
+	HookReturnCode returnCode = HookReturnCode::CONTINUE;
+
+	const char* pszLastModuleName = nullptr;
+
+	for( size_t uiIndex = 0; uiIndex < event.GetFunctionCount(); ++uiIndex )
+	{
+		auto pFunction = event.GetFunctionByIndex( uiIndex );
+
+		//Removed while the event was being called.
+		if( !pFunction )
+			continue;
+
+		//Finish calling the module that handled the event, then stop.
+		if( event.GetStopMode() == EventStopMode::MODULE_HANDLED && returnCode == HookReturnCode::HANDLED )
+		{
+			if( !pszLastModuleName || pFunction->GetModuleName() != pszLastModuleName )
+				break;
+		}
+
+		pszLastModuleName = pFunction->GetModuleName();
+
+		CASFunction function( *pFunction, ctx );
+
+		pFunction->AddRef();
+
+		bool bCallSucceeded;
+
+		{
+			CASProfileScope profile( event, *pFunction );
+
+			bCallSucceeded = function.VCall( flags, list );
+		}
+
+		pFunction->Release();
+
+		bSuccess = bCallSucceeded && bSuccess;
+
+		if( bCallSucceeded && returnCode == HookReturnCode::CONTINUE )
+		{
+			bSuccess = function.GetReturnValue( &returnCode ) && bSuccess;
+		}
+
+		if( returnCode == HookReturnCode::HANDLED && event.GetStopMode() == EventStopMode::ON_HANDLED )
+			break;
+	}
+
+	if( !bSuccess )
+		return HookCallResult::FAILED;
+
+	return returnCode == HookReturnCode::HANDLED ? HookCallResult::HANDLED : HookCallResult::NONE_HANDLED;
+}
+
 HookCallResult CallGlobalEvent( CASEvent& event, CallFlags_t flags, ... )
 {
 	va_list list;
 
 	va_start( list, flags );
 
-	CASEventCaller caller;
+	HookCallResult result;
+
+	if( g_ASScriptProfiler.GetMode() != CASScriptProfiler::Mode::OFF )
+	{
+		CASProfilingEventCaller caller;
+
+		result = caller.VCall( event, g_ASManager.GetASManager().GetEngine(), flags, list );
+	}
+	else
+	{
+		CASEventCaller caller;
 
-	const auto result = caller.VCall( event, g_ASManager.GetASManager().GetEngine(), flags, list );
+		result = caller.VCall( event, g_ASManager.GetASManager().GetEngine(), flags, list );
+	}
 
 	va_end( list );
 
@@ -69,6 +69,33 @@ static CBaseEntity* FindEntityByString( CBaseEntity* pStartEntity, const std::st
 	return UTIL_FindEntityByString( pStartEntity, szKeyword.c_str(), szValue.c_str() );
 }
 
+static uint32_t CountEntitiesByString( const std::string& szKeyword, const std::string& szValue )
+{
+	uint32_t uiCount = 0;
+
+	CBaseEntity* pEntity = nullptr;
+
+	while( ( pEntity = UTIL_FindEntityByString( pEntity, szKeyword.c_str(), szValue.c_str() ) ) != nullptr )
+		++uiCount;
+
+	return uiCount;
+}
+
+static uint32_t CountEntitiesByClassname( const std::string& szClassname )
+{
+	return CountEntitiesByString( "classname", szClassname );
+}
+
+static uint32_t CountEntitiesByTargetname( const std::string& szTargetname )
+{
+	return CountEntitiesByString( "targetname", szTargetname );
+}
+
+static uint32_t CountEntitiesByTarget( const std::string& szTarget )
+{
+	return CountEntitiesByString( "target", szTarget );
+}
+
 static CBaseEntity* FindEntityGeneric( const std::string& szName, const Vector& vecSrc, const float flRadius )
 {
 	return UTIL_FindEntityGeneric( szName.c_str(), vecSrc, flRadius );
@@ -112,6 +139,22 @@ void RegisterScriptEntityFuncs( asIScriptEngine& engine )
 		"CBaseEntity@ FindEntityByString(CBaseEntity@ pStartEntity, const string& in szKeyword, const string& in szValue)",
 		asFUNCTION( Entity::FindEntityByString ), asCALL_CDECL );
 
+	engine.RegisterGlobalFunction(
+		"uint CountEntitiesByClassname(const string& in szClassname)",
+		asFUNCTION( Entity::CountEntitiesByClassname ), asCALL_CDECL );
+
+	engine.RegisterGlobalFunction(
+		"uint CountEntitiesByTargetname(const string& in szTargetname)",
+		asFUNCTION( Entity::CountEntitiesByTargetname ), asCALL_CDECL );
+
+	engine.RegisterGlobalFunction(
+		"uint CountEntitiesByTarget(const string& in szTarget)",
+		asFUNCTION( Entity::CountEntitiesByTarget ), asCALL_CDECL );
+
+	engine.RegisterGlobalFunction(
+		"uint CountEntitiesByString(const string& in szKeyword, const string& in szValue)",
+		asFUNCTION( Entity::CountEntitiesByString ), asCALL_CDECL );
+
 	engine.RegisterGlobalFunction(
 		"CBaseEntity@ FindEntityInSphere(CBaseEntity@ pStartEntity, const Vector& in vecSrc, const float flRadius)",
 		asFUNCTION( UTIL_FindEntityInSphere ), asCALL_CDECL );
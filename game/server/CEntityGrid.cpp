@@ -0,0 +1,276 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <algorithm>
+
+#include "extdll.h"
+#include "util.h"
+
+#include "CEntityGrid.h"
+
+constexpr float CEntityGrid::MIN_MOVE_FRAME_TIME;
+
+CEntityGrid g_EntityGrid;
+
+void CEntityGrid::Clear()
+{
+	m_pEdicts = nullptr;
+
+	m_Cells.clear();
+	m_GlobalEntities.clear();
+	m_Entries.clear();
+	m_QueryMarks.clear();
+	m_uiQueryMark = 0;
+	m_QueryResults.clear();
+}
+
+void CEntityGrid::Link( edict_t* pEdict )
+{
+	if( !pEdict || !EnsureInitialized() )
+		return;
+
+	const int iIndex = pEdict - m_pEdicts;
+
+	//World is never returned by queries.
+	if( iIndex <= 0 || iIndex >= static_cast<int>( m_Entries.size() ) )
+		return;
+
+	Link( iIndex, pEdict );
+}
+
+void CEntityGrid::RelinkAll()
+{
+	if( !EnsureInitialized() )
+		return;
+
+	const int iCount = static_cast<int>( m_Entries.size() );
+
+	edict_t* pEdict = m_pEdicts + 1;
+
+	for( int iIndex = 1; iIndex < iCount; ++iIndex, ++pEdict )
+	{
+		auto& entry = m_Entries[ iIndex ];
+
+		if( pEdict->free )
+		{
+			if( entry.fLinked )
+				Unlink( iIndex );
+
+			continue;
+		}
+
+		Vector vecMins, vecMaxs;
+
+		GetLinkBounds( pEdict, vecMins, vecMaxs );
+
+		if( !entry.fLinked || vecMins != entry.vecMins || vecMaxs != entry.vecMaxs || entry.fFast != IsFastMover( pEdict ) )
+			Link( iIndex, pEdict );
+	}
+}
+
+const std::vector<int>& CEntityGrid::Query( const Vector& vecMins, const Vector& vecMaxs )
+{
+	m_QueryResults.clear();
+
+	if( !EnsureInitialized() )
+		return m_QueryResults;
+
+	if( ++m_uiQueryMark == 0 )
+	{
+		//Wrapped around, reset all marks.
+		std::fill( m_QueryMarks.begin(), m_QueryMarks.end(), 0 );
+		m_uiQueryMark = 1;
+	}
+
+	const int iMinX = CellCoord( vecMins.x );
+	const int iMinY = CellCoord( vecMins.y );
+	const int iMaxX = CellCoord( vecMaxs.x );
+	const int iMaxY = CellCoord( vecMaxs.y );
+
+	for( int iY = iMinY; iY <= iMaxY; ++iY )
+	{
+		for( int iX = iMinX; iX <= iMaxX; ++iX )
+		{
+			for( auto iIndex : Cell( iX, iY ) )
+			{
+				if( m_QueryMarks[ iIndex ] != m_uiQueryMark )
+				{
+					m_QueryMarks[ iIndex ] = m_uiQueryMark;
+					m_QueryResults.push_back( iIndex );
+				}
+			}
+		}
+	}
+
+	m_QueryResults.insert( m_QueryResults.end(), m_GlobalEntities.begin(), m_GlobalEntities.end() );
+
+	//Callers expect entities in the same order as a linear scan.
+	std::sort( m_QueryResults.begin(), m_QueryResults.end() );
+
+	return m_QueryResults;
+}
+
+bool CEntityGrid::EnsureInitialized()
+{
+	if( m_pEdicts )
+		return true;
+
+	if( gpGlobals->maxEntities <= 0 )
+		return false;
+
+	m_pEdicts = INDEXENT( 0 );
+
+	if( !m_pEdicts )
+		return false;
+
+	m_Cells.resize( GRID_CELLS * GRID_CELLS );
+	m_Entries.resize( gpGlobals->maxEntities );
+	m_QueryMarks.resize( gpGlobals->maxEntities );
+
+	return true;
+}
+
+int CEntityGrid::CellCoord( const float flCoord )
+{
+	const int iCoord = static_cast<int>( floor( flCoord / CELL_SIZE ) ) + GRID_CELLS / 2;
+
+	return clamp( iCoord, 0, GRID_CELLS - 1 );
+}
+
+void CEntityGrid::GetLinkBounds( const edict_t* pEdict, Vector& vecMins, Vector& vecMaxs )
+{
+	//Include the origin; UTIL_MonstersInSphere tests against it, and brush entities can have their origin outside their bounds.
+	for( int iAxis = 0; iAxis < 3; ++iAxis )
+	{
+		vecMins[ iAxis ] = min( pEdict->v.absmin[ iAxis ], pEdict->v.origin[ iAxis ] );
+		vecMaxs[ iAxis ] = max( pEdict->v.absmax[ iAxis ], pEdict->v.origin[ iAxis ] );
+	}
+}
+
+bool CEntityGrid::IsFastMover( const edict_t* pEdict )
+{
+	float flSpeed = pEdict->v.velocity.Length() + pEdict->v.basevelocity.Length();
+
+	//Riders are moved by the entity they stand on, followers by the entity they follow, without velocity of their own.
+	for( const edict_t* pMover : { pEdict->v.groundentity, pEdict->v.aiment } )
+	{
+		if( !pMover || pMover->free )
+			continue;
+
+		//Rotating movers move riders by their distance to the pivot, which isn't bounded here.
+		if( pMover->v.avelocity != g_vecZero )
+			return true;
+
+		flSpeed += pMover->v.velocity.Length();
+	}
+
+	return flSpeed * max( gpGlobals->frametime, MIN_MOVE_FRAME_TIME ) > LINK_PADDING;
+}
+
+void CEntityGrid::Link( const int iIndex, edict_t* pEdict )
+{
+	if( pEdict->free )
+	{
+		Unlink( iIndex );
+		return;
+	}
+
+	Vector vecMins, vecMaxs;
+
+	GetLinkBounds( pEdict, vecMins, vecMaxs );
+
+	const int iMinX = CellCoord( vecMins.x - LINK_PADDING );
+	const int iMinY = CellCoord( vecMins.y - LINK_PADDING );
+	const int iMaxX = CellCoord( vecMaxs.x + LINK_PADDING );
+	const int iMaxY = CellCoord( vecMaxs.y + LINK_PADDING );
+
+	const bool fFast = IsFastMover( pEdict );
+
+	const bool fGlobal = fFast || ( iMaxX - iMinX + 1 ) * ( iMaxY - iMinY + 1 ) > MAX_LINKED_CELLS;
+
+	auto& entry = m_Entries[ iIndex ];
+
+	entry.vecMins = vecMins;
+	entry.vecMaxs = vecMaxs;
+	entry.fFast = fFast;
+
+	if( entry.fLinked )
+	{
+		if( entry.fGlobal && fGlobal )
+			return;
+
+		if( !entry.fGlobal && !fGlobal &&
+			entry.iMinX == iMinX && entry.iMinY == iMinY &&
+			entry.iMaxX == iMaxX && entry.iMaxY == iMaxY )
+			return;
+
+		Unlink( iIndex );
+	}
+
+	entry.fLinked = true;
+	entry.fGlobal = fGlobal;
+	entry.iMinX = iMinX;
+	entry.iMinY = iMinY;
+	entry.iMaxX = iMaxX;
+	entry.iMaxY = iMaxY;
+
+	if( fGlobal )
+	{
+		m_GlobalEntities.push_back( iIndex );
+		return;
+	}
+
+	for( int iY = iMinY; iY <= iMaxY; ++iY )
+	{
+		for( int iX = iMinX; iX <= iMaxX; ++iX )
+		{
+			Cell( iX, iY ).push_back( iIndex );
+		}
+	}
+}
+
+void CEntityGrid::Unlink( const int iIndex )
+{
+	auto& entry = m_Entries[ iIndex ];
+
+	if( !entry.fLinked )
+		return;
+
+	entry.fLinked = false;
+
+	auto removeFrom = [ = ]( std::vector<int>& list )
+	{
+		auto it = std::find( list.begin(), list.end(), iIndex );
+
+		if( it != list.end() )
+		{
+			*it = list.back();
+			list.pop_back();
+		}
+	};
+
+	if( entry.fGlobal )
+	{
+		removeFrom( m_GlobalEntities );
+		return;
+	}
+
+	for( int iY = entry.iMinY; iY <= entry.iMaxY; ++iY )
+	{
+		for( int iX = entry.iMinX; iX <= entry.iMaxX; ++iX )
+		{
+			removeFrom( Cell( iX, iY ) );
+		}
+	}
+}
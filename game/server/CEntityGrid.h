@@ -0,0 +1,144 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_CENTITYGRID_H
+#define GAME_SERVER_CENTITYGRID_H
+
+#include <vector>
+
+/**
+*	Uniform 2D grid over entity bounds, used to accelerate spatial entity queries.
+*	Entities are relinked when their origin or size is set, and once per frame to catch movement done by the engine.
+*	Entries are padded so entities that moved a bit since they were last linked are still found.
+*	Entities that can move further than the padding in a frame are checked by every query instead.
+*	Queries only return candidates; callers must test the entity's current bounds.
+*/
+class CEntityGrid final
+{
+public:
+	/**
+	*	Size of a single cell, in units.
+	*/
+	static const int CELL_SIZE = 256;
+
+	/**
+	*	Number of cells along each axis. Coordinates outside the grid are clamped to the border cells.
+	*/
+	static const int GRID_CELLS = 128;
+
+	/**
+	*	Entities that cover more cells than this are stored in a separate list that's checked by every query.
+	*/
+	static const int MAX_LINKED_CELLS = 16;
+
+	/**
+	*	How far entity bounds are padded, in units.
+	*/
+	static const int LINK_PADDING = 64;
+
+	/**
+	*	Frame time assumed when estimating how far an entity moves in a frame, if the actual frame time is shorter.
+	*	Frame times vary from frame to frame, this leaves room for slower frames.
+	*/
+	static constexpr float MIN_MOVE_FRAME_TIME = 0.1f;
+
+public:
+	CEntityGrid() = default;
+
+	/**
+	*	Removes all entities. Must be called when a new map starts.
+	*/
+	void Clear();
+
+	/**
+	*	Links the given entity into the grid, or unlinks it if it has been freed.
+	*/
+	void Link( edict_t* pEdict );
+
+	/**
+	*	Relinks every entity whose bounds have changed since it was last linked.
+	*/
+	void RelinkAll();
+
+	/**
+	*	Finds all entities whose padded bounds intersect the given box.
+	*	@return Indices of candidate entities, sorted in ascending order. Valid until the next query.
+	*/
+	const std::vector<int>& Query( const Vector& vecMins, const Vector& vecMaxs );
+
+	/**
+	*	@return The edict with the given index.
+	*/
+	edict_t* GetEdict( const int iIndex ) const { return m_pEdicts + iIndex; }
+
+private:
+	struct Entry
+	{
+		bool fLinked = false;
+
+		//In m_GlobalEntities instead of in cells.
+		bool fGlobal = false;
+
+		//Linked while moving too fast for the padding.
+		bool fFast = false;
+
+		int iMinX, iMinY, iMaxX, iMaxY;
+
+		//Bounds at the time the entity was linked.
+		Vector vecMins;
+		Vector vecMaxs;
+	};
+
+	bool EnsureInitialized();
+
+	static int CellCoord( const float flCoord );
+
+	static void GetLinkBounds( const edict_t* pEdict, Vector& vecMins, Vector& vecMaxs );
+
+	/**
+	*	@return Whether engine physics can move the entity further than LINK_PADDING before it is relinked.
+	*/
+	static bool IsFastMover( const edict_t* pEdict );
+
+	void Link( const int iIndex, edict_t* pEdict );
+
+	void Unlink( const int iIndex );
+
+	std::vector<int>& Cell( const int iX, const int iY ) { return m_Cells[ iY * GRID_CELLS + iX ]; }
+
+private:
+	edict_t* m_pEdicts = nullptr;
+
+	std::vector<std::vector<int>> m_Cells;
+	/**
+	*	Entities that cover too many cells or move too fast. Checked by every query.
+	*/
+	std::vector<int> m_GlobalEntities;
+
+	std::vector<Entry> m_Entries;
+
+	//Used to avoid returning entities that are in multiple cells more than once.
+	std::vector<unsigned int> m_QueryMarks;
+	unsigned int m_uiQueryMark = 0;
+
+	std::vector<int> m_QueryResults;
+
+private:
+	CEntityGrid( const CEntityGrid& ) = delete;
+	CEntityGrid& operator=( const CEntityGrid& ) = delete;
+};
+
+extern CEntityGrid g_EntityGrid;
+
+#endif //GAME_SERVER_CENTITYGRID_H
@@ -0,0 +1,323 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <algorithm>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+
+#include "CEntityNameIndex.h"
+
+CEntityNameIndex g_EntityNameIndex;
+
+namespace
+{
+const auto CompareEntryIndex = []( const int iIndex, const auto& entry )
+{
+	return iIndex < entry.iIndex;
+};
+}
+
+CEntityNameIndex::CIterator& CEntityNameIndex::CIterator::operator++()
+{
+	if( m_pEntity )
+		m_pEntity = m_pIndex->FindNextInBucket( *m_pBucket, m_Field, m_pEntity->entindex() );
+
+	return *this;
+}
+
+bool CEntityNameIndex::FieldFromKeyword( const char* const pszKeyword, EntityNameField& field )
+{
+	if( !pszKeyword )
+		return false;
+
+	if( !strcmp( pszKeyword, "classname" ) )
+		field = EntityNameField::CLASSNAME;
+	else if( !strcmp( pszKeyword, "targetname" ) )
+		field = EntityNameField::TARGETNAME;
+	else if( !strcmp( pszKeyword, "target" ) )
+		field = EntityNameField::TARGET;
+	else
+		return false;
+
+	return true;
+}
+
+void CEntityNameIndex::Clear()
+{
+	m_pEdicts = nullptr;
+
+	for( auto& buckets : m_Buckets )
+		buckets.clear();
+
+	m_Records.clear();
+}
+
+void CEntityNameIndex::Update( edict_t* pEdict )
+{
+	if( !pEdict || !EnsureInitialized() )
+		return;
+
+	const int iIndex = pEdict - m_pEdicts;
+
+	//The world is never returned by lookups.
+	if( iIndex <= 0 || iIndex >= static_cast<int>( m_Records.size() ) )
+		return;
+
+	Update( iIndex, pEdict );
+}
+
+void CEntityNameIndex::Remove( edict_t* pEdict )
+{
+	if( !pEdict || !m_pEdicts )
+		return;
+
+	const int iIndex = pEdict - m_pEdicts;
+
+	if( iIndex <= 0 || iIndex >= static_cast<int>( m_Records.size() ) )
+		return;
+
+	Remove( iIndex );
+}
+
+void CEntityNameIndex::RefreshAll()
+{
+	if( !EnsureInitialized() )
+		return;
+
+	const int iCount = static_cast<int>( m_Records.size() );
+
+	edict_t* pEdict = m_pEdicts + 1;
+
+	for( int iIndex = 1; iIndex < iCount; ++iIndex, ++pEdict )
+	{
+		if( NeedsUpdate( iIndex, pEdict ) )
+			Update( iIndex, pEdict );
+	}
+}
+
+CBaseEntity* CEntityNameIndex::FindNext( const EntityNameField field, const CBaseEntity* pStartEntity, const char* const pszValue ) const
+{
+	if( !pszValue )
+		return nullptr;
+
+	auto pBucket = FindBucket( field, pszValue );
+
+	if( !pBucket )
+		return nullptr;
+
+	return FindNextInBucket( *pBucket, field, pStartEntity ? pStartEntity->entindex() : 0 );
+}
+
+CEntityNameIndex::CRange CEntityNameIndex::Find( const EntityNameField field, const char* const pszValue ) const
+{
+	auto pBucket = pszValue ? FindBucket( field, pszValue ) : nullptr;
+
+	if( !pBucket )
+		return CRange( CIterator(), CIterator() );
+
+	return CRange( CIterator( this, pBucket, field, FindNextInBucket( *pBucket, field, 0 ) ), CIterator() );
+}
+
+size_t CEntityNameIndex::Count( const EntityNameField field, const char* const pszValue ) const
+{
+	const auto range = Find( field, pszValue );
+
+	return std::distance( range.begin(), range.end() );
+}
+
+string_t CEntityNameIndex::GetFieldValue( const edict_t* pEdict, const EntityNameField field )
+{
+	switch( field )
+	{
+	case EntityNameField::CLASSNAME:	return pEdict->v.classname;
+	case EntityNameField::TARGETNAME:	return pEdict->v.targetname;
+	case EntityNameField::TARGET:		return pEdict->v.target;
+
+	default: return iStringNull;
+	}
+}
+
+bool CEntityNameIndex::EnsureInitialized()
+{
+	if( m_pEdicts )
+		return true;
+
+	if( gpGlobals->maxEntities <= 0 )
+		return false;
+
+	m_pEdicts = INDEXENT( 0 );
+
+	if( !m_pEdicts )
+		return false;
+
+	m_Records.resize( gpGlobals->maxEntities );
+
+	return true;
+}
+
+bool CEntityNameIndex::NeedsUpdate( const int iIndex, const edict_t* pEdict ) const
+{
+	const auto& record = m_Records[ iIndex ];
+
+	if( pEdict->free )
+	{
+		//Only needs removing if it's still indexed.
+		for( auto pBucket : record.pBuckets )
+		{
+			if( pBucket )
+				return true;
+		}
+
+		return false;
+	}
+
+	if( record.iSerialNumber != pEdict->serialnumber )
+		return true;
+
+	for( size_t uiField = 0; uiField < static_cast<size_t>( EntityNameField::COUNT ); ++uiField )
+	{
+		if( record.iszValues[ uiField ] != GetFieldValue( pEdict, static_cast<EntityNameField>( uiField ) ) )
+			return true;
+	}
+
+	return false;
+}
+
+void CEntityNameIndex::Update( const int iIndex, edict_t* pEdict )
+{
+	if( pEdict->free )
+	{
+		Remove( iIndex );
+		return;
+	}
+
+	auto& record = m_Records[ iIndex ];
+
+	//Edict was reused by another entity, remove the old one's entries.
+	if( record.iSerialNumber != pEdict->serialnumber )
+	{
+		Remove( iIndex );
+		record.iSerialNumber = pEdict->serialnumber;
+	}
+
+	for( size_t uiField = 0; uiField < static_cast<size_t>( EntityNameField::COUNT ); ++uiField )
+	{
+		const string_t iszValue = GetFieldValue( pEdict, static_cast<EntityNameField>( uiField ) );
+
+		//Strings are never modified in place, so the same string_t means the same value.
+		if( record.pBuckets[ uiField ] && record.iszValues[ uiField ] == iszValue )
+			continue;
+
+		if( auto pOldBucket = record.pBuckets[ uiField ] )
+		{
+			auto& entries = pOldBucket->Entries;
+
+			auto it = std::upper_bound( entries.begin(), entries.end(), iIndex, CompareEntryIndex );
+
+			if( it != entries.begin() && ( it - 1 )->iIndex == iIndex )
+				entries.erase( it - 1 );
+
+			record.pBuckets[ uiField ] = nullptr;
+		}
+
+		record.iszValues[ uiField ] = iszValue;
+
+		if( !iszValue )
+			continue;
+
+		const char* const pszValue = STRING( iszValue );
+
+		auto& buckets = m_Buckets[ uiField ];
+
+		auto bucketIt = buckets.find( pszValue );
+
+		if( bucketIt == buckets.end() )
+		{
+			auto bucket = std::make_unique<Bucket>();
+
+			bucket->szValue = pszValue;
+
+			//The key points to the bucket's own copy so it stays valid if the entity's string is freed.
+			const char* const pszKey = bucket->szValue.c_str();
+
+			bucketIt = buckets.emplace( pszKey, std::move( bucket ) ).first;
+		}
+
+		auto& entries = bucketIt->second->Entries;
+
+		auto it = std::upper_bound( entries.begin(), entries.end(), iIndex, CompareEntryIndex );
+
+		entries.insert( it, Entry{ iIndex, EHANDLE( pEdict, pEdict->serialnumber ) } );
+
+		record.pBuckets[ uiField ] = bucketIt->second.get();
+	}
+}
+
+void CEntityNameIndex::Remove( const int iIndex )
+{
+	auto& record = m_Records[ iIndex ];
+
+	for( size_t uiField = 0; uiField < static_cast<size_t>( EntityNameField::COUNT ); ++uiField )
+	{
+		if( auto pBucket = record.pBuckets[ uiField ] )
+		{
+			auto& entries = pBucket->Entries;
+
+			auto it = std::upper_bound( entries.begin(), entries.end(), iIndex, CompareEntryIndex );
+
+			if( it != entries.begin() && ( it - 1 )->iIndex == iIndex )
+				entries.erase( it - 1 );
+		}
+	}
+
+	record = Record();
+}
+
+const CEntityNameIndex::Bucket* CEntityNameIndex::FindBucket( const EntityNameField field, const char* const pszValue ) const
+{
+	const auto& buckets = m_Buckets[ static_cast<size_t>( field ) ];
+
+	auto it = buckets.find( pszValue );
+
+	if( it == buckets.end() )
+		return nullptr;
+
+	return it->second.get();
+}
+
+CBaseEntity* CEntityNameIndex::FindNextInBucket( const Bucket& bucket, const EntityNameField field, const int iStartIndex ) const
+{
+	const auto& entries = bucket.Entries;
+
+	for( auto it = std::upper_bound( entries.begin(), entries.end(), iStartIndex, CompareEntryIndex ); it != entries.end(); ++it )
+	{
+		edict_t* pEdict = it->hEntity.Get();
+
+		if( !pEdict || pEdict->free )
+			continue;
+
+		//Skip entries that have gone stale since the entity was last indexed.
+		const string_t iszValue = GetFieldValue( pEdict, field );
+
+		if( !iszValue || strcmp( STRING( iszValue ), bucket.szValue.c_str() ) )
+			continue;
+
+		if( auto pEntity = GET_PRIVATE( pEdict ) )
+			return pEntity;
+	}
+
+	return nullptr;
+}
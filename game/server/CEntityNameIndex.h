@@ -0,0 +1,219 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_CENTITYNAMEINDEX_H
+#define GAME_SERVER_CENTITYNAMEINDEX_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "StringUtils.h"
+
+/**
+*	Entity string fields that can be looked up through the name index.
+*/
+enum class EntityNameField
+{
+	CLASSNAME = 0,
+	TARGETNAME,
+	TARGET,
+
+	COUNT
+};
+
+/**
+*	Maps classnames, targetnames and targets to the entities that use them, so lookups don't have to scan every edict.
+*	Entities are reindexed when they are created, spawned, restored, when one of the fields is set through CBaseEntity or a keyvalue,
+*	and once per frame to catch anything else. Entries are verified against the entity's current value when they are returned,
+*	so stale entries are never returned.
+*	Entities are returned in ascending index order, just like the engine's FIND_ENTITY_BY_STRING. The world is never returned.
+*/
+class CEntityNameIndex final
+{
+private:
+	struct Entry
+	{
+		int iIndex;
+		EHANDLE hEntity;
+	};
+
+	struct Bucket
+	{
+		std::string szValue;
+
+		/**
+		*	Sorted by entity index.
+		*/
+		std::vector<Entry> Entries;
+	};
+
+public:
+	/**
+	*	Iterates over all entities with a given value. The index can be modified while iterating.
+	*/
+	class CIterator final
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = CBaseEntity*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = CBaseEntity**;
+		using reference = CBaseEntity*;
+
+		CIterator() = default;
+
+		CBaseEntity* operator*() const { return m_pEntity; }
+
+		CIterator& operator++();
+
+		CIterator operator++( int )
+		{
+			CIterator it = *this;
+			++( *this );
+			return it;
+		}
+
+		bool operator==( const CIterator& other ) const { return m_pEntity == other.m_pEntity; }
+		bool operator!=( const CIterator& other ) const { return !( *this == other ); }
+
+	private:
+		friend class CEntityNameIndex;
+
+		CIterator( const CEntityNameIndex* pIndex, const Bucket* pBucket, const EntityNameField field, CBaseEntity* pEntity )
+			: m_pIndex( pIndex )
+			, m_pBucket( pBucket )
+			, m_Field( field )
+			, m_pEntity( pEntity )
+		{
+		}
+
+	private:
+		const CEntityNameIndex* m_pIndex = nullptr;
+		const Bucket* m_pBucket = nullptr;
+		EntityNameField m_Field = EntityNameField::CLASSNAME;
+		CBaseEntity* m_pEntity = nullptr;
+	};
+
+	/**
+	*	Range of entities, for use with range based for loops.
+	*/
+	class CRange final
+	{
+	public:
+		CRange( const CIterator& begin, const CIterator& end )
+			: m_Begin( begin )
+			, m_End( end )
+		{
+		}
+
+		CIterator begin() const { return m_Begin; }
+		CIterator end() const { return m_End; }
+
+	private:
+		CIterator m_Begin;
+		CIterator m_End;
+	};
+
+public:
+	CEntityNameIndex() = default;
+
+	/**
+	*	Gets the field that corresponds to an entvars keyword, as used by FIND_ENTITY_BY_STRING.
+	*	@return Whether the keyword is an indexed field.
+	*/
+	static bool FieldFromKeyword( const char* const pszKeyword, EntityNameField& field );
+
+	/**
+	*	Removes all entities. Must be called when a new map starts.
+	*/
+	void Clear();
+
+	/**
+	*	Reindexes the given entity's fields, or removes it if it has been freed.
+	*/
+	void Update( edict_t* pEdict );
+
+	/**
+	*	Removes the given entity from the index.
+	*/
+	void Remove( edict_t* pEdict );
+
+	/**
+	*	Reindexes every entity whose fields have changed since it was last indexed.
+	*/
+	void RefreshAll();
+
+	/**
+	*	Finds the next entity after pStartEntity whose field matches the given value.
+	*	@param pStartEntity Entity to start after, or null to start at the beginning.
+	*/
+	CBaseEntity* FindNext( const EntityNameField field, const CBaseEntity* pStartEntity, const char* const pszValue ) const;
+
+	/**
+	*	@return All entities whose field matches the given value.
+	*/
+	CRange Find( const EntityNameField field, const char* const pszValue ) const;
+
+	/**
+	*	@return The number of entities whose field matches the given value.
+	*/
+	size_t Count( const EntityNameField field, const char* const pszValue ) const;
+
+private:
+	struct Record
+	{
+		int iSerialNumber = 0;
+
+		string_t iszValues[ static_cast<size_t>( EntityNameField::COUNT ) ] = {};
+		Bucket* pBuckets[ static_cast<size_t>( EntityNameField::COUNT ) ] = {};
+	};
+
+	using BucketMap = std::unordered_map<const char*, std::unique_ptr<Bucket>, RawCharHash, RawCharEqualTo>;
+
+	static string_t GetFieldValue( const edict_t* pEdict, const EntityNameField field );
+
+	bool EnsureInitialized();
+
+	bool NeedsUpdate( const int iIndex, const edict_t* pEdict ) const;
+
+	void Update( const int iIndex, edict_t* pEdict );
+
+	void Remove( const int iIndex );
+
+	const Bucket* FindBucket( const EntityNameField field, const char* const pszValue ) const;
+
+	/**
+	*	Finds the first live entity in the bucket after the given entity index.
+	*/
+	CBaseEntity* FindNextInBucket( const Bucket& bucket, const EntityNameField field, const int iStartIndex ) const;
+
+private:
+	edict_t* m_pEdicts = nullptr;
+
+	BucketMap m_Buckets[ static_cast<size_t>( EntityNameField::COUNT ) ];
+
+	std::vector<Record> m_Records;
+
+private:
+	CEntityNameIndex( const CEntityNameIndex& ) = delete;
+	CEntityNameIndex& operator=( const CEntityNameIndex& ) = delete;
+};
+
+extern CEntityNameIndex g_EntityNameIndex;
+
+#endif //GAME_SERVER_CENTITYNAMEINDEX_H
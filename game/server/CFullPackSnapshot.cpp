@@ -0,0 +1,310 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+#include "CBasePlayer.h"
+#include "customentity.h"
+
+#include "client.h"
+
+#include "CFullPackSnapshot.h"
+
+CFullPackSnapshot g_FullPackSnapshot;
+
+void CFullPackSnapshot::Invalidate()
+{
+	++m_iFrame;
+}
+
+bool CFullPackSnapshot::AddToFullPack( entity_state_t& state, const int e, edict_t* ent, edict_t* host, const int hostflags, const bool player, unsigned char* pSet )
+{
+	UpdateFrame();
+
+	const auto& info = GetCullInfo( e, ent );
+
+	const bool fIsHost = ent == host;
+
+	// don't send if flagged for NODRAW and it's not the host getting the message
+	if( ( info.flags & CULL_NODRAW ) && !fIsHost )
+	{
+		++m_Stats.uiNoDraw;
+		return false;
+	}
+
+	// Ignore ents without valid / visible models
+	if( info.flags & CULL_NOMODEL )
+	{
+		++m_Stats.uiNoModel;
+		return false;
+	}
+
+	// Don't send spectators to other players
+	if( ( info.flags & CULL_SPECTATOR ) && !fIsHost )
+	{
+		++m_Stats.uiSpectator;
+		return false;
+	}
+
+	// Ignore if not the host and not touching a PVS/PAS leaf
+	// If pSet is NULL, then the test will always succeed and the entity will be added to the update
+	if( !fIsHost && !ENGINE_CHECK_VISIBILITY( ent, pSet ) )
+	{
+		++m_Stats.uiNotVisible;
+		return false;
+	}
+
+	// Don't send entity to local client if the client says it's predicting the entity itself.
+	if( ( info.flags & CULL_SKIPLOCALHOST ) && ( hostflags & HOSTFL_WEAPONPRED ) && info.pOwner == host )
+	{
+		++m_Stats.uiSkipLocalHost;
+		return false;
+	}
+
+	// Only send entities in the host's group. The group trace used to be set to GROUP_OP_AND here, so that's the only operation that applies.
+	if( host->v.groupinfo && info.groupinfo && !( info.groupinfo & host->v.groupinfo ) )
+	{
+		++m_Stats.uiGroup;
+		return false;
+	}
+
+	state = GetState( e, ent, player );
+
+	++m_Stats.uiSent;
+
+	return true;
+}
+
+void CFullPackSnapshot::EnsureInitialized()
+{
+	const size_t uiCount = static_cast<size_t>( max( gpGlobals->maxEntities, 0 ) );
+
+	if( m_CullInfos.size() != uiCount )
+	{
+		m_CullInfos.clear();
+		m_CullInfos.resize( uiCount );
+
+		m_States.clear();
+		m_States.resize( uiCount );
+	}
+}
+
+void CFullPackSnapshot::UpdateFrame()
+{
+	EnsureInitialized();
+
+	// Clients are only sent updates once per frame, so a new time always means a new frame.
+	if( m_flFrameTime != gpGlobals->time )
+	{
+		m_flFrameTime = gpGlobals->time;
+		++m_iFrame;
+	}
+}
+
+const CFullPackSnapshot::CullInfo& CFullPackSnapshot::GetCullInfo( const int e, const edict_t* ent )
+{
+	auto& info = m_CullInfos[ e ];
+
+	if( info.iFrame == m_iFrame )
+		return info;
+
+	info.iFrame = m_iFrame;
+	info.flags = 0;
+
+	if( ent->v.effects & EF_NODRAW )
+		info.flags |= CULL_NODRAW;
+
+	if( !ent->v.modelindex || !STRING( ent->v.model ) )
+		info.flags |= CULL_NOMODEL;
+
+	if( ent->v.flags & FL_SPECTATOR )
+		info.flags |= CULL_SPECTATOR;
+
+	if( ent->v.flags & FL_SKIPLOCALHOST )
+		info.flags |= CULL_SKIPLOCALHOST;
+
+	info.groupinfo = ent->v.groupinfo;
+	info.pOwner = ent->v.owner;
+
+	return info;
+}
+
+const entity_state_t& CFullPackSnapshot::GetState( const int e, const edict_t* ent, const bool player )
+{
+	auto& info = m_States[ e ];
+
+	if( info.iFrame != m_iFrame || info.player != player )
+	{
+		info.iFrame = m_iFrame;
+		info.player = player;
+
+		BuildState( info.state, e, ent, player );
+
+		++m_Stats.uiStatesBuilt;
+	}
+
+	return info.state;
+}
+
+void CFullPackSnapshot::BuildState( entity_state_t& state, const int e, const edict_t* ent, const bool player )
+{
+	int					i;
+
+	memset( static_cast<void*>( &state ), 0, sizeof( state ) );
+
+	// Assign index so we can track this entity from frame to frame and
+	//  delta from it.
+	state.number	  = e;
+	state.entityType = ENTITY_NORMAL;
+
+	// Flag custom entities.
+	if ( ent->v.flags & FL_CUSTOMENTITY )
+	{
+		state.entityType = ENTITY_BEAM;
+	}
+
+	//
+	// Copy state data
+	//
+
+	// Round animtime to nearest millisecond
+	state.animtime   = (int)(1000.0 * ent->v.animtime ) / 1000.0;
+
+	memcpy( state.origin, ent->v.origin, 3 * sizeof( float ) );
+	memcpy( state.angles, ent->v.angles, 3 * sizeof( float ) );
+	memcpy( state.mins, ent->v.mins, 3 * sizeof( float ) );
+	memcpy( state.maxs, ent->v.maxs, 3 * sizeof( float ) );
+
+	memcpy( state.startpos, ent->v.startpos, 3 * sizeof( float ) );
+	memcpy( state.endpos, ent->v.endpos, 3 * sizeof( float ) );
+
+	state.impacttime = ent->v.impacttime;
+	state.starttime = ent->v.starttime;
+
+	state.modelindex = ent->v.modelindex;
+
+	state.frame      = ent->v.frame;
+
+	state.skin       = ent->v.skin;
+	state.effects    = ent->v.effects;
+
+	// This non-player entity is being moved by the game .dll and not the physics simulation system
+	//  make sure that we interpolate it's position on the client if it moves
+	if ( !player &&
+		 ent->v.animtime &&
+		 ent->v.velocity[ 0 ] == 0 &&
+		 ent->v.velocity[ 1 ] == 0 &&
+		 ent->v.velocity[ 2 ] == 0 )
+	{
+		state.eflags |= EFLAG_SLERP;
+	}
+
+	state.scale	  = ent->v.scale;
+	state.solid	  = ent->v.solid;
+	state.colormap   = ent->v.colormap;
+
+	state.movetype   = ent->v.movetype;
+	state.sequence   = ent->v.sequence;
+	state.framerate  = ent->v.framerate;
+	state.body       = ent->v.body;
+
+	for (i = 0; i < 4; i++)
+	{
+		state.controller[i] = ent->v.controller[i];
+	}
+
+	for (i = 0; i < 2; i++)
+	{
+		state.blending[i]   = ent->v.blending[i];
+	}
+
+	state.rendermode    = ent->v.rendermode;
+	state.renderamt     = ent->v.renderamt;
+	state.renderfx      = ent->v.renderfx;
+	state.rendercolor.r = ent->v.rendercolor.x;
+	state.rendercolor.g = ent->v.rendercolor.y;
+	state.rendercolor.b = ent->v.rendercolor.z;
+
+	state.aiment = 0;
+	if ( ent->v.aiment )
+	{
+		state.aiment = ENTINDEX( ent->v.aiment );
+	}
+
+	state.owner = 0;
+	if ( ent->v.owner )
+	{
+		int owner = ENTINDEX( ent->v.owner );
+
+		// Only care if owned by a player
+		if ( owner >= 1 && owner <= gpGlobals->maxClients )
+		{
+			state.owner = owner;
+		}
+	}
+
+	// HACK:  Somewhat...
+	// Class is overridden for non-players to signify a breakable glass object ( sort of a class? )
+	if ( !player )
+	{
+		state.playerclass  = ent->v.playerclass;
+	}
+
+	// Special stuff for players only
+	if ( player )
+	{
+		memcpy( state.basevelocity, ent->v.basevelocity, 3 * sizeof( float ) );
+
+		if( auto pPlayer = static_cast<CBasePlayer*>( GET_PRIVATE( const_cast<edict_t*>( ent ) ) ) )
+			state.weaponmodel = pPlayer->GetWeaponModelIndex();
+		else
+			state.weaponmodel = MODEL_INDEX( STRING( ent->v.weaponmodel ) );
+
+		state.gaitsequence = ent->v.gaitsequence;
+		state.spectator = ent->v.flags & FL_SPECTATOR;
+		state.friction     = ent->v.friction;
+
+		state.gravity      = ent->v.gravity;
+//		state.team			= ent->v.team;
+//
+		state.usehull      = ( ent->v.flags & FL_DUCKING ) ? 1 : 0;
+		state.health		= ent->v.health;
+	}
+}
+
+void ServerCommand_FullPackStats()
+{
+	const auto& stats = g_FullPackSnapshot.GetStats();
+
+	const uint64_t uiTotal = stats.uiNoDraw + stats.uiNoModel + stats.uiSpectator + stats.uiNotVisible +
+		stats.uiSkipLocalHost + stats.uiGroup + stats.uiSent;
+
+	auto percentage = [ = ]( const uint64_t uiCount )
+	{
+		return uiTotal ? 100.0 * uiCount / uiTotal : 0.0;
+	};
+
+	ALERT( at_console, "AddToFullPack: %llu calls\n", static_cast<unsigned long long>( uiTotal ) );
+	ALERT( at_console, "Culled (no draw): %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiNoDraw ), percentage( stats.uiNoDraw ) );
+	ALERT( at_console, "Culled (no model): %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiNoModel ), percentage( stats.uiNoModel ) );
+	ALERT( at_console, "Culled (spectator): %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiSpectator ), percentage( stats.uiSpectator ) );
+	ALERT( at_console, "Culled (not visible): %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiNotVisible ), percentage( stats.uiNotVisible ) );
+	ALERT( at_console, "Culled (predicted by host): %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiSkipLocalHost ), percentage( stats.uiSkipLocalHost ) );
+	ALERT( at_console, "Culled (group): %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiGroup ), percentage( stats.uiGroup ) );
+	ALERT( at_console, "Sent: %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiSent ), percentage( stats.uiSent ) );
+	ALERT( at_console, "States built: %llu\n", static_cast<unsigned long long>( stats.uiStatesBuilt ) );
+
+	g_FullPackSnapshot.ResetStats();
+}
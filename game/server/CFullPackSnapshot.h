@@ -0,0 +1,132 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_CFULLPACKSNAPSHOT_H
+#define GAME_SERVER_CFULLPACKSNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "entity_state.h"
+
+/**
+*	Per frame snapshot of the networked state of entities, used by AddToFullPack.
+*	AddToFullPack is called for every entity for every client, but the state it sends only depends on the client for culling.
+*	The culling inputs and the entity state are read from the entity once per frame, the first time a client needs them,
+*	so every other client only does the client specific checks and copies the state.
+*/
+class CFullPackSnapshot final
+{
+public:
+	/**
+	*	Number of entity visibility checks that ended at each stage.
+	*/
+	struct Stats
+	{
+		uint64_t uiNoDraw = 0;
+		uint64_t uiNoModel = 0;
+		uint64_t uiSpectator = 0;
+		uint64_t uiNotVisible = 0;
+		uint64_t uiSkipLocalHost = 0;
+		uint64_t uiGroup = 0;
+		uint64_t uiSent = 0;
+
+		/**
+		*	Number of entity states that were read from entities.
+		*/
+		uint64_t uiStatesBuilt = 0;
+	};
+
+public:
+	CFullPackSnapshot() = default;
+
+	/**
+	*	Discards the snapshot. Must be called whenever entities may have changed since the last time clients were sent updates.
+	*/
+	void Invalidate();
+
+	/**
+	*	Implementation of AddToFullPack.
+	*	@see DLL_FUNCTIONS::pfnAddToFullPack
+	*/
+	bool AddToFullPack( entity_state_t& state, const int e, edict_t* ent, edict_t* host, const int hostflags, const bool player, unsigned char* pSet );
+
+	const Stats& GetStats() const { return m_Stats; }
+
+	void ResetStats()
+	{
+		m_Stats = Stats();
+	}
+
+private:
+	enum CullFlag : unsigned char
+	{
+		CULL_NODRAW			= 1 << 0,
+		CULL_NOMODEL		= 1 << 1,
+		CULL_SPECTATOR		= 1 << 2,
+		CULL_SKIPLOCALHOST	= 1 << 3
+	};
+
+	/**
+	*	Client independent inputs for culling. Kept separate from the states so checks touch as little memory as possible.
+	*/
+	struct CullInfo
+	{
+		int iFrame = -1;
+		unsigned char flags = 0;
+		int groupinfo = 0;
+		edict_t* pOwner = nullptr;
+	};
+
+	struct StateInfo
+	{
+		int iFrame = -1;
+		bool player = false;
+		entity_state_t state;
+	};
+
+	void EnsureInitialized();
+
+	void UpdateFrame();
+
+	const CullInfo& GetCullInfo( const int e, const edict_t* ent );
+
+	const entity_state_t& GetState( const int e, const edict_t* ent, const bool player );
+
+	static void BuildState( entity_state_t& state, const int e, const edict_t* ent, const bool player );
+
+private:
+	int m_iFrame = 0;
+
+	float m_flFrameTime = 0;
+
+	std::vector<CullInfo> m_CullInfos;
+
+	std::vector<StateInfo> m_States;
+
+	Stats m_Stats;
+
+private:
+	CFullPackSnapshot( const CFullPackSnapshot& ) = delete;
+	CFullPackSnapshot& operator=( const CFullPackSnapshot& ) = delete;
+};
+
+extern CFullPackSnapshot g_FullPackSnapshot;
+
+/**
+*	Prints how many entities were culled at each stage of AddToFullPack since the last time this was used, and resets the counters.
+*/
+void ServerCommand_FullPackStats();
+
+#endif //GAME_SERVER_CFULLPACKSNAPSHOT_H
@@ -0,0 +1,157 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include "extdll.h"
+#include "util.h"
+
+#include "usercmd.h"
+#include "pm_defs.h"
+#include "pm_shared.h"
+
+#include "CPMoveRecorder.h"
+
+CPMoveRecorder g_PMoveRecorder;
+
+void CPMoveRecorder::Start( const char* const pszFileName, const int iPlayer )
+{
+	Stop();
+
+	char szGameDir[ MAX_PATH ];
+	GET_GAME_DIR( szGameDir );
+
+	m_szFileName = std::string( szGameDir ) + '/' + pszFileName;
+	m_iPlayer = iPlayer;
+
+	ALERT( at_console, "Recording player movement to \"%s\"\n", m_szFileName.c_str() );
+}
+
+void CPMoveRecorder::Stop()
+{
+	if( !IsRecording() )
+		return;
+
+	ALERT( at_console, "Recorded %u player moves to \"%s\"\n", m_Writer.GetFrameCount(), m_szFileName.c_str() );
+
+	m_Writer.Close();
+	m_szFileName.clear();
+}
+
+void CPMoveRecorder::Move( playermove_t* ppmove, const int server )
+{
+	if( !IsRecording() || ( m_iPlayer > 0 && ppmove->player_index + 1 != m_iPlayer ) )
+	{
+		PM_Move( ppmove, server );
+		return;
+	}
+
+	if( !m_Writer.IsOpen() )
+	{
+		PMoveRecordHeader header;
+
+		strncpy( header.szMapName, STRING( gpGlobals->mapname ), sizeof( header.szMapName ) );
+		header.szMapName[ sizeof( header.szMapName ) - 1 ] = '\0';
+
+		for( int iHull = 0; iHull < 4; ++iHull )
+		{
+			header.player_mins[ iHull ] = ppmove->player_mins[ iHull ];
+			header.player_maxs[ iHull ] = ppmove->player_maxs[ iHull ];
+		}
+
+		if( !m_Writer.Open( m_szFileName.c_str(), header ) )
+		{
+			ALERT( at_console, "Couldn't create \"%s\", player movement is not being recorded\n", m_szFileName.c_str() );
+			m_szFileName.clear();
+
+			PM_Move( ppmove, server );
+			return;
+		}
+	}
+
+	PM_SaveRecordFrame( *ppmove, m_Frame );
+
+	for( auto& ent : m_Frame.PhysEnts )
+	{
+		if( edict_t* pEdict = INDEXENT( ent.info ) )
+			ent.velocity = pEdict->v.velocity;
+	}
+
+	m_pfnRandomLong = ppmove->RandomLong;
+	m_pfnFloatTime = ppmove->Sys_FloatTime;
+
+	ppmove->RandomLong = &CPMoveRecorder::RecordRandomLong;
+	ppmove->Sys_FloatTime = &CPMoveRecorder::RecordFloatTime;
+
+	PM_Move( ppmove, server );
+
+	ppmove->RandomLong = m_pfnRandomLong;
+	ppmove->Sys_FloatTime = m_pfnFloatTime;
+
+	PM_SaveRecordState( *ppmove, m_Frame.Post );
+
+	m_Writer.WriteFrame( m_Frame );
+}
+
+int32 CPMoveRecorder::RecordRandomLong( int32 lLow, int32 lHigh )
+{
+	const int32 iValue = g_PMoveRecorder.m_pfnRandomLong( lLow, lHigh );
+
+	g_PMoveRecorder.m_Frame.RandomLongs.push_back( iValue );
+
+	return iValue;
+}
+
+double CPMoveRecorder::RecordFloatTime()
+{
+	const double flTime = g_PMoveRecorder.m_pfnFloatTime();
+
+	g_PMoveRecorder.m_Frame.FloatTimes.push_back( flTime );
+
+	return flTime;
+}
+
+void PM_RecordedMove( playermove_t* ppmove, int server )
+{
+	g_PMoveRecorder.Move( ppmove, server );
+}
+
+void ServerCommand_PMoveRecord()
+{
+	if( CMD_ARGC() < 2 )
+	{
+		ALERT( at_console, "Usage: sv_pmove_record <file> [player index]\nsv_pmove_record stop\n" );
+
+		if( g_PMoveRecorder.IsRecording() )
+			ALERT( at_console, "A recording is in progress\n" );
+
+		return;
+	}
+
+	const char* pszFileName = CMD_ARGV( 1 );
+
+	if( !stricmp( pszFileName, "stop" ) )
+	{
+		if( !g_PMoveRecorder.IsRecording() )
+			ALERT( at_console, "Player movement is not being recorded\n" );
+
+		g_PMoveRecorder.Stop();
+		return;
+	}
+
+	int iPlayer = 0;
+
+	if( CMD_ARGC() >= 3 )
+		iPlayer = max( 0, atoi( CMD_ARGV( 2 ) ) );
+
+	g_PMoveRecorder.Start( pszFileName, iPlayer );
+}
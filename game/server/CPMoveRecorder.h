@@ -0,0 +1,84 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_CPMOVERECORDER_H
+#define GAME_SERVER_CPMOVERECORDER_H
+
+#include <string>
+
+#include "pm_record.h"
+
+/**
+*	Records the server's player movement to a file, so it can be replayed and benchmarked by the pmovesim tool.
+*	The values returned by RandomLong and Sys_FloatTime are recorded as well, a replay gets the same values.
+*	A recording covers one map, it's stopped when a new map starts.
+*/
+class CPMoveRecorder final
+{
+public:
+	CPMoveRecorder() = default;
+
+	bool IsRecording() const { return !m_szFileName.empty(); }
+
+	/**
+	*	Starts recording. The file is created when the first move is recorded.
+	*	@param pszFileName Name of the file, relative to the game directory.
+	*	@param iPlayer Entity index of the player to record, or 0 to record all players.
+	*/
+	void Start( const char* const pszFileName, const int iPlayer );
+
+	void Stop();
+
+	/**
+	*	Runs PM_Move, and records the move if it's for a player that's being recorded.
+	*/
+	void Move( playermove_t* ppmove, const int server );
+
+private:
+	static int32 RecordRandomLong( int32 lLow, int32 lHigh );
+
+	static double RecordFloatTime();
+
+private:
+	std::string m_szFileName;
+	int m_iPlayer = 0;
+
+	CPMoveRecordWriter m_Writer;
+
+	PMoveRecordFrame m_Frame;
+
+	//The engine's callbacks, while a move is being recorded.
+	int32 ( *m_pfnRandomLong )( int32 lLow, int32 lHigh ) = nullptr;
+	double ( *m_pfnFloatTime )() = nullptr;
+
+private:
+	CPMoveRecorder( const CPMoveRecorder& ) = delete;
+	CPMoveRecorder& operator=( const CPMoveRecorder& ) = delete;
+};
+
+extern CPMoveRecorder g_PMoveRecorder;
+
+/**
+*	The server's PM_Move. Records moves while sv_pmove_record is active.
+*/
+void PM_RecordedMove( playermove_t* ppmove, int server );
+
+/**
+*	Server command that starts or stops recording player movement.
+*	Usage: sv_pmove_record <file> [player index]
+*	sv_pmove_record stop
+*/
+void ServerCommand_PMoveRecord();
+
+#endif //GAME_SERVER_CPMOVERECORDER_H
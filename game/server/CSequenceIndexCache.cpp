@@ -0,0 +1,256 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <algorithm>
+#include <cstring>
+
+#include "extdll.h"
+#include "util.h"
+#include "studio.h"
+
+#include "StringUtils.h"
+
+#include "animation.h"
+
+#include "CSequenceIndexCache.h"
+
+CSequenceIndexCache g_SequenceIndexCache;
+
+namespace
+{
+unsigned int HashLabel( const char* pszLabel )
+{
+	return StringHashFNV1a( pszLabel, true );
+}
+
+int MakeTransitionKey( const int iFromNode, const int iToNode )
+{
+	return ( iFromNode << 16 ) | ( iToNode & 0xFFFF );
+}
+
+const mstudioseqdesc_t* GetSequences( const studiohdr_t* pstudiohdr )
+{
+	return reinterpret_cast<const mstudioseqdesc_t*>( reinterpret_cast<const byte*>( pstudiohdr ) + pstudiohdr->seqindex );
+}
+}
+
+void CSequenceIndexCache::Clear()
+{
+	m_Models.clear();
+}
+
+int CSequenceIndexCache::LookupActivity( const studiohdr_t* pstudiohdr, int activity )
+{
+	const auto& model = GetModel( pstudiohdr );
+
+	if( activity < 0 || static_cast<size_t>( activity ) >= model.Activities.size() )
+		return ACTIVITY_NOT_AVAILABLE;
+
+	const auto& range = model.Activities[ activity ];
+
+	if( range.iCount == 0 )
+		return ACTIVITY_NOT_AVAILABLE;
+
+	const auto pFirst = model.Sequences.data() + range.iFirst;
+	const auto pLast = pFirst + range.iCount;
+
+	const int iWeightTotal = pLast[ -1 ].iWeightSum;
+
+	//The linear pick keeps the last sequence if no sequence has any weight.
+	if( iWeightTotal <= 0 )
+		return pLast[ -1 ].iSequence;
+
+	//Sequence i is picked with probability weight / total either way.
+	const int iPick = RANDOM_LONG( 0, iWeightTotal - 1 );
+
+	const auto pSequence = std::upper_bound( pFirst, pLast, iPick, []( const int iValue, const WeightedSequence& sequence )
+	{
+		return iValue < sequence.iWeightSum;
+	} );
+
+	return pSequence->iSequence;
+}
+
+int CSequenceIndexCache::LookupActivityHeaviest( const studiohdr_t* pstudiohdr, int activity )
+{
+	const auto& model = GetModel( pstudiohdr );
+
+	if( activity < 0 || static_cast<size_t>( activity ) >= model.Activities.size() )
+		return ACTIVITY_NOT_AVAILABLE;
+
+	return model.Activities[ activity ].iHeaviest;
+}
+
+int CSequenceIndexCache::LookupSequence( const studiohdr_t* pstudiohdr, const char* label )
+{
+	const auto& model = GetModel( pstudiohdr );
+
+	if( model.Labels.empty() )
+		return -1;
+
+	const auto pseqdesc = GetSequences( pstudiohdr );
+
+	const size_t uiMask = model.Labels.size() - 1;
+
+	for( size_t uiSlot = HashLabel( label ) & uiMask; model.Labels[ uiSlot ] != -1; uiSlot = ( uiSlot + 1 ) & uiMask )
+	{
+		if( stricmp( pseqdesc[ model.Labels[ uiSlot ] ].label, label ) == 0 )
+			return model.Labels[ uiSlot ];
+	}
+
+	return -1;
+}
+
+int CSequenceIndexCache::FindTransitionSequence( const studiohdr_t* pstudiohdr, int iEndNode, int iInternNode, int& iDirection )
+{
+	const auto& model = GetModel( pstudiohdr );
+
+	auto it = model.Transitions.find( MakeTransitionKey( iEndNode, iInternNode ) );
+
+	if( it == model.Transitions.end() )
+		return -1;
+
+	iDirection = it->second.iDirection;
+
+	return it->second.iSequence;
+}
+
+CSequenceIndexCache::Model& CSequenceIndexCache::GetModel( const studiohdr_t* pstudiohdr )
+{
+	auto it = m_Models.find( pstudiohdr );
+
+	if( it != m_Models.end() )
+	{
+		auto& model = it->second;
+
+		//The engine can free model data when it runs low on cache memory and load another model in its place.
+		if( model.iLength == pstudiohdr->length &&
+			model.iNumSequences == pstudiohdr->numseq &&
+			strncmp( model.szName, pstudiohdr->name, sizeof( model.szName ) ) == 0 )
+			return model;
+
+		model = Model();
+		BuildModel( pstudiohdr, model );
+
+		return model;
+	}
+
+	auto& model = m_Models[ pstudiohdr ];
+
+	BuildModel( pstudiohdr, model );
+
+	return model;
+}
+
+void CSequenceIndexCache::BuildModel( const studiohdr_t* pstudiohdr, Model& model )
+{
+	strncpy( model.szName, pstudiohdr->name, sizeof( model.szName ) );
+	model.iLength = pstudiohdr->length;
+	model.iNumSequences = pstudiohdr->numseq;
+
+	const auto pseqdesc = GetSequences( pstudiohdr );
+
+	const int iNumSequences = pstudiohdr->numseq;
+
+	//Group sequences by activity, keeping model order within an activity. Negative activities can't be looked up.
+	int iMaxActivity = -1;
+
+	for( int i = 0; i < iNumSequences; ++i )
+	{
+		iMaxActivity = std::max( iMaxActivity, pseqdesc[ i ].activity );
+	}
+
+	model.Activities.resize( iMaxActivity + 1 );
+
+	for( int i = 0; i < iNumSequences; ++i )
+	{
+		if( pseqdesc[ i ].activity >= 0 )
+			++model.Activities[ pseqdesc[ i ].activity ].iCount;
+	}
+
+	int iFirst = 0;
+
+	for( auto& range : model.Activities )
+	{
+		range.iFirst = iFirst;
+		iFirst += range.iCount;
+		range.iCount = 0;
+	}
+
+	model.Sequences.resize( iFirst );
+
+	for( int i = 0; i < iNumSequences; ++i )
+	{
+		const auto& seqdesc = pseqdesc[ i ];
+
+		if( seqdesc.activity < 0 )
+			continue;
+
+		auto& range = model.Activities[ seqdesc.activity ];
+
+		const int iPrevious = range.iCount > 0 ? model.Sequences[ range.iFirst + range.iCount - 1 ].iWeightSum : 0;
+
+		model.Sequences[ range.iFirst + range.iCount ] = { i, iPrevious + seqdesc.actweight };
+		++range.iCount;
+
+		//First sequence with the highest positive weight.
+		if( seqdesc.actweight > 0 && ( range.iHeaviest == ACTIVITY_NOT_AVAILABLE || seqdesc.actweight > pseqdesc[ range.iHeaviest ].actweight ) )
+			range.iHeaviest = i;
+	}
+
+	//Labels, at most half full. Only the first sequence with a given label can be found.
+	size_t uiTableSize = 0;
+
+	if( iNumSequences > 0 )
+	{
+		uiTableSize = 8;
+
+		while( uiTableSize < static_cast<size_t>( iNumSequences ) * 2 )
+			uiTableSize *= 2;
+	}
+
+	model.Labels.assign( uiTableSize, -1 );
+
+	const size_t uiMask = uiTableSize - 1;
+
+	for( int i = 0; i < iNumSequences; ++i )
+	{
+		size_t uiSlot = HashLabel( pseqdesc[ i ].label ) & uiMask;
+
+		bool bDuplicate = false;
+
+		for( ; model.Labels[ uiSlot ] != -1; uiSlot = ( uiSlot + 1 ) & uiMask )
+		{
+			if( stricmp( pseqdesc[ model.Labels[ uiSlot ] ].label, pseqdesc[ i ].label ) == 0 )
+			{
+				bDuplicate = true;
+				break;
+			}
+		}
+
+		if( !bDuplicate )
+			model.Labels[ uiSlot ] = i;
+	}
+
+	//Transitions, in the order FindTransition checks them: forward before backward, lowest sequence first.
+	for( int i = 0; i < iNumSequences; ++i )
+	{
+		const auto& seqdesc = pseqdesc[ i ];
+
+		model.Transitions.emplace( MakeTransitionKey( seqdesc.entrynode, seqdesc.exitnode ), Transition{ i, 1 } );
+
+		if( seqdesc.nodeflags )
+			model.Transitions.emplace( MakeTransitionKey( seqdesc.exitnode, seqdesc.entrynode ), Transition{ i, -1 } );
+	}
+}
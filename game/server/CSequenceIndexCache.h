@@ -0,0 +1,127 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_CSEQUENCEINDEXCACHE_H
+#define GAME_SERVER_CSEQUENCEINDEXCACHE_H
+
+#include <unordered_map>
+#include <vector>
+
+struct studiohdr_t;
+
+/**
+*	Per model indices over a studio model's sequences, used to answer the lookups in animation.cpp without scanning every sequence.
+*	A model's indices are built the first time it's used. Models are keyed by studio header, which is only valid for the current map,
+*	so the cache must be cleared when a new map starts.
+*/
+class CSequenceIndexCache final
+{
+private:
+	/**
+	*	A sequence with the sum of the weights of all sequences for the same activity up to and including this one.
+	*/
+	struct WeightedSequence
+	{
+		int iSequence;
+		int iWeightSum;
+	};
+
+	/**
+	*	The sequences for one activity, in model order.
+	*/
+	struct ActivityRange
+	{
+		int iFirst = 0;
+		int iCount = 0;
+		int iHeaviest = -1;
+	};
+
+	struct Transition
+	{
+		int iSequence;
+		int iDirection;
+	};
+
+	struct Model
+	{
+		//Used to detect the engine reusing the header's memory for another model.
+		char szName[ 64 ];
+		int iLength;
+		int iNumSequences;
+
+		std::vector<WeightedSequence> Sequences;
+
+		/**
+		*	Indexed by activity.
+		*/
+		std::vector<ActivityRange> Activities;
+
+		/**
+		*	Open addressed table of sequence indices, hashed by lowercase label. -1 is an empty slot.
+		*/
+		std::vector<int> Labels;
+
+		/**
+		*	Maps a pair of nodes to the first sequence that goes from one to the other.
+		*/
+		std::unordered_map<int, Transition> Transitions;
+	};
+
+public:
+	CSequenceIndexCache() = default;
+
+	/**
+	*	Frees all model indices. Must be called when a new map starts.
+	*/
+	void Clear();
+
+	/**
+	*	@copydoc ::LookupActivity
+	*	Sequences are picked with the same probabilities, but the random number generator is only used once.
+	*/
+	int LookupActivity( const studiohdr_t* pstudiohdr, int activity );
+
+	/**
+	*	@copydoc ::LookupActivityHeaviest
+	*/
+	int LookupActivityHeaviest( const studiohdr_t* pstudiohdr, int activity );
+
+	/**
+	*	@copydoc ::LookupSequence
+	*/
+	int LookupSequence( const studiohdr_t* pstudiohdr, const char* label );
+
+	/**
+	*	Finds the sequence that goes from iEndNode to iInternNode.
+	*	@param[ out ] iDirection 1 if the sequence plays forward, -1 if it plays backward.
+	*	@return Sequence index, or -1 if there is no such sequence.
+	*/
+	int FindTransitionSequence( const studiohdr_t* pstudiohdr, int iEndNode, int iInternNode, int& iDirection );
+
+private:
+	Model& GetModel( const studiohdr_t* pstudiohdr );
+
+	static void BuildModel( const studiohdr_t* pstudiohdr, Model& model );
+
+private:
+	std::unordered_map<const studiohdr_t*, Model> m_Models;
+
+private:
+	CSequenceIndexCache( const CSequenceIndexCache& ) = delete;
+	CSequenceIndexCache& operator=( const CSequenceIndexCache& ) = delete;
+};
+
+extern CSequenceIndexCache g_SequenceIndexCache;
+
+#endif //GAME_SERVER_CSEQUENCEINDEXCACHE_H
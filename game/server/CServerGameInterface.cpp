@@ -11,7 +11,14 @@
 #include "gamerules/GameRules.h"
 #include "Server.h"
 #include "CMap.h"
+#include "CEntityGrid.h"
+#include "CEntityNameIndex.h"
+#include "CFullPackSnapshot.h"
+#include "CPMoveRecorder.h"
+#include "CSequenceIndexCache.h"
+#include "entities/NPCs/CAILODManager.h"
 #include "config/CServerConfig.h"
+#include "materials/Materials.h"
 
 #include "nodes/Nodes.h"
 #include "nodes/CTestHull.h"
@@ -74,6 +81,14 @@ void CServerGameInterface::EntityCreated( entvars_t* pev )
 
 		WorldInit();
 	}
+
+	//The engine sets the classname before the entity is created.
+	g_EntityNameIndex.Update( ENT( pev ) );
+}
+
+void Server_EntityNamesChanged( entvars_t* pev )
+{
+	g_EntityNameIndex.Update( ENT( pev ) );
 }
 
 void Server_EntityCreated( entvars_t* pev )
@@ -157,6 +172,9 @@ void CServerGameInterface::ClientCommand( edict_t* pEntity )
 	const char *pcmd = CMD_ARGV( 0 );
 	const char *pstr;
 
+	//Commands can change entities outside of the regular frame, for example while paused.
+	g_FullPackSnapshot.Invalidate();
+
 	// Is the client spawned yet?
 	if( !pEntity->pvPrivateData )
 		return;
@@ -519,6 +537,22 @@ void CServerGameInterface::WorldInit()
 	if( !m_ServerConfig->Parse( server_cfg.string, "GAMECONFIG", false ) )
 		m_ServerConfig.reset();
 
+	//Edicts are reallocated for every map.
+	g_EntityGrid.Clear();
+	g_EntityNameIndex.Clear();
+
+	//Model data is reloaded for every map.
+	g_SequenceIndexCache.Clear();
+
+	//So are textures, cached material types refer to the previous map's.
+	g_MaterialsList.ClearTextureCache();
+
+	//Movement recordings only cover one map.
+	g_PMoveRecorder.Stop();
+
+	//Entities that are freed after the world still refer to pooled strings, so the previous map's strings are only released here.
+	g_StringPool.Clear();
+
 	//A new map has started, initialize everything. - Solokiller
 	//This will be worldspawn for new maps and multiplayer maps, the first restored entity when transitioning or loading maps.
 	CMap::CreateIfNeeded();
@@ -620,6 +654,15 @@ void CServerGameInterface::Deactivate()
 
 void CServerGameInterface::StartFrame()
 {
+	//Pick up entities moved by engine physics since the last frame.
+	g_EntityGrid.RelinkAll();
+	g_EntityNameIndex.RefreshAll();
+
+	g_FullPackSnapshot.Invalidate();
+
+	//Monsters think after this, use this frame's client positions.
+	g_AILODManager.Update();
+
 	if( g_pGameRules )
 		g_pGameRules->Think();
 
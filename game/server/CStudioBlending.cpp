@@ -12,8 +12,11 @@
 *   without written permission from Valve LLC.
 *
 ****/
+#include <algorithm>
+
 #include "extdll.h"
 #include "util.h"
+#include "Server.h"
 
 #include "r_studioint.h"
 #include "com_model.h"
@@ -69,5 +72,213 @@ void CStudioBlending::StudioSetupBones( model_t*		pModel,
 										int				iBone,
 										const edict_t*	pEdict )
 {
-	//TODO: implement default bone setup. - Solokiller
+	if( !sv_bone_cache.value || !pEdict )
+	{
+		SetupBones( pModel, frame, sequence, angles, origin, pcontroller, pblending, iBone );
+		return;
+	}
+
+	CacheKey key;
+
+	key.pModel = pModel;
+	key.flFrame = frame;
+	key.iSequence = sequence;
+	key.vecAngles = angles;
+	key.vecOrigin = origin;
+	memcpy( key.controller, pcontroller, sizeof( key.controller ) );
+	memcpy( key.blending, pblending, sizeof( key.blending ) );
+	key.flTime = gpGlobals->time;
+
+	const size_t uiIndex = ENTINDEX( pEdict );
+
+	if( uiIndex >= m_Cache.size() )
+		m_Cache.resize( uiIndex + 1 );
+
+	auto& entry = m_Cache[ uiIndex ];
+
+	if( entry.fValid && entry.key == key )
+	{
+		++m_Stats.uiHits;
+
+		if( sv_bone_cache.value == 2 )
+		{
+			const int cBones = SetupBones( pModel, frame, sequence, angles, origin, pcontroller, pblending, -1 );
+
+			if( memcmp( &entry.rotationMatrix, m_pRotationMatrix, sizeof( Matrix3x4 ) ) ||
+				static_cast<size_t>( cBones ) != entry.boneTransforms.size() ||
+				memcmp( entry.boneTransforms.data(), m_pBoneTransform, cBones * sizeof( Matrix3x4 ) ) )
+			{
+				++m_Stats.uiMismatches;
+			}
+
+			return;
+		}
+
+		*m_pRotationMatrix = entry.rotationMatrix;
+		std::copy( entry.boneTransforms.begin(), entry.boneTransforms.end(), m_pBoneTransform );
+
+		return;
+	}
+
+	++m_Stats.uiMisses;
+
+	const int cBones = SetupBones( pModel, frame, sequence, angles, origin, pcontroller, pblending, iBone );
+
+	//Only the chain of the requested bone was set up, which can't be reused for other bones.
+	if( iBone != -1 )
+		return;
+
+	entry.fValid = true;
+	entry.key = key;
+	entry.rotationMatrix = *m_pRotationMatrix;
+	entry.boneTransforms.assign( m_pBoneTransform, m_pBoneTransform + cBones );
+}
+
+void CStudioBlending::ClearCache()
+{
+	m_Cache.clear();
+}
+
+bool CStudioBlending::CacheKey::operator==( const CacheKey& other ) const
+{
+	return pModel == other.pModel &&
+		flFrame == other.flFrame &&
+		iSequence == other.iSequence &&
+		vecAngles == other.vecAngles &&
+		vecOrigin == other.vecOrigin &&
+		!memcmp( controller, other.controller, sizeof( controller ) ) &&
+		!memcmp( blending, other.blending, sizeof( blending ) ) &&
+		flTime == other.flTime;
+}
+
+int CStudioBlending::SetupBones( model_t* pModel, float frame, int sequence, const Vector& angles, const Vector& origin, const byte* pcontroller, const byte* pblending, int iBone )
+{
+	static Vector		pos[ MAXSTUDIOBONES ];
+	static Vector4D		q[ MAXSTUDIOBONES ];
+
+	static Vector		pos2[ MAXSTUDIOBONES ];
+	static Vector4D		q2[ MAXSTUDIOBONES ];
+	static Vector		pos3[ MAXSTUDIOBONES ];
+	static Vector4D		q3[ MAXSTUDIOBONES ];
+	static Vector		pos4[ MAXSTUDIOBONES ];
+	static Vector4D		q4[ MAXSTUDIOBONES ];
+
+	auto pStudioHeader = reinterpret_cast<studiohdr_t*>( IEngineStudio.Mod_Extradata( pModel ) );
+
+	if( !pStudioHeader )
+		return 0;
+
+	if( sequence < 0 || sequence >= pStudioHeader->numseq )
+		sequence = 0;
+
+	mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pStudioHeader + pStudioHeader->seqindex ) + sequence;
+	mstudiobone_t* pbones = ( mstudiobone_t* ) ( ( byte* ) pStudioHeader + pStudioHeader->boneindex );
+
+	if( iBone < -1 || iBone >= pStudioHeader->numbones )
+		iBone = 0;
+
+	//The requested bone and its parents, from the bone to the root. Unused if all bones are set up.
+	int chain[ MAXSTUDIOBONES ];
+	int iChainLength = 0;
+
+	if( iBone != -1 )
+	{
+		for( int i = iBone; i != -1; i = pbones[ i ].parent )
+			chain[ iChainLength++ ] = i;
+	}
+
+	//The engine passes the frame in the range [ 0, 256 ).
+	const float f = pseqdesc->numframes > 1 ? ( pseqdesc->numframes - 1 ) * frame / 256.0f : 0.0f;
+
+	//The server has no latched state, so there is nothing to interpolate from.
+	auto calcRotations = [ & ]( Vector* vecPos, Vector4D* quat, mstudioanim_t* panim )
+	{
+		if( iBone == -1 )
+			studio::CalcRotations( pStudioHeader, vecPos, quat, pseqdesc, panim, f, 1.0, pcontroller, pcontroller, 0, pseqdesc->fps );
+		else
+			studio::CalcChainRotations( pStudioHeader, vecPos, quat, pseqdesc, panim, f, 1.0, pcontroller, pcontroller, 0, pseqdesc->fps, chain, iChainLength );
+	};
+
+	mstudioanim_t* panim = studio::GetAnim( pStudioHeader, pModel, pseqdesc );
+	calcRotations( pos, q, panim );
+
+	if( pseqdesc->numblends > 1 )
+	{
+		panim += pStudioHeader->numbones;
+		calcRotations( pos2, q2, panim );
+
+		studio::SlerpBones( pStudioHeader, q, pos, q2, pos2, pblending[ 0 ] / 255.0 );
+
+		if( pseqdesc->numblends == 4 )
+		{
+			panim += pStudioHeader->numbones;
+			calcRotations( pos3, q3, panim );
+
+			panim += pStudioHeader->numbones;
+			calcRotations( pos4, q4, panim );
+
+			studio::SlerpBones( pStudioHeader, q3, pos3, q4, pos4, pblending[ 0 ] / 255.0 );
+
+			studio::SlerpBones( pStudioHeader, q, pos, q3, pos3, pblending[ 1 ] / 255.0 );
+		}
+	}
+
+	AngleMatrix( angles, *m_pRotationMatrix );
+
+	( *m_pRotationMatrix )[ 0 ][ 3 ] = origin[ 0 ];
+	( *m_pRotationMatrix )[ 1 ][ 3 ] = origin[ 1 ];
+	( *m_pRotationMatrix )[ 2 ][ 3 ] = origin[ 2 ];
+
+	static Matrix3x4	bonematrices[ MAXSTUDIOBONES ];
+
+	auto concatTransforms = [ & ]( const int i )
+	{
+		if( pbones[ i ].parent == -1 )
+			ConcatTransforms( *m_pRotationMatrix, bonematrices[ i ], m_pBoneTransform[ i ] );
+		else
+			ConcatTransforms( m_pBoneTransform[ pbones[ i ].parent ], bonematrices[ i ], m_pBoneTransform[ i ] );
+	};
+
+	if( iBone == -1 )
+	{
+		QuaternionMatrices( q, pos, bonematrices, pStudioHeader->numbones );
+
+		for( int i = 0; i < pStudioHeader->numbones; ++i )
+			concatTransforms( i );
+	}
+	else
+	{
+		//Parents first.
+		for( int i = iChainLength - 1; i >= 0; --i )
+		{
+			const int j = chain[ i ];
+
+			QuaternionMatrix( q[ j ], bonematrices[ j ] );
+
+			bonematrices[ j ][ 0 ][ 3 ] = pos[ j ][ 0 ];
+			bonematrices[ j ][ 1 ][ 3 ] = pos[ j ][ 1 ];
+			bonematrices[ j ][ 2 ][ 3 ] = pos[ j ][ 2 ];
+
+			concatTransforms( j );
+		}
+	}
+
+	return pStudioHeader->numbones;
+}
+
+void ServerCommand_BoneCacheStats()
+{
+	const auto& stats = g_StudioBlending.GetStats();
+
+	const uint64_t uiTotal = stats.uiHits + stats.uiMisses;
+
+	ALERT( at_console, "Bone setups: %llu\n", static_cast<unsigned long long>( uiTotal ) );
+	ALERT( at_console, "Cache hits: %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiHits ),
+		uiTotal ? 100.0 * stats.uiHits / uiTotal : 0.0 );
+	ALERT( at_console, "Cache misses: %llu\n", static_cast<unsigned long long>( stats.uiMisses ) );
+
+	if( sv_bone_cache.value == 2 )
+		ALERT( at_console, "Mismatches: %llu\n", static_cast<unsigned long long>( stats.uiMismatches ) );
+
+	g_StudioBlending.ResetStats();
 }
@@ -15,14 +15,33 @@
 #ifndef GAME_SERVER_CSTUDIOBLENDING_H
 #define GAME_SERVER_CSTUDIOBLENDING_H
 
-struct Matrix3x4;
+#include <cstdint>
+#include <vector>
+
 struct model_t;
+struct server_studio_api_t;
+struct sv_blending_interface_t;
 
 /**
 *	Studio model blending. - Solokiller
+*	Complete bone setups are cached per edict. If the engine asks for the same entity's bones again in the same frame,
+*	for instance for another trace against its hitboxes, the cached transforms are copied instead of rebuilt.
+*	If the engine only asks for one bone, only that bone and its parents are set up, unless a complete setup is cached.
 */
 class CStudioBlending final
 {
+public:
+	struct Stats
+	{
+		uint64_t uiHits = 0;
+		uint64_t uiMisses = 0;
+
+		/**
+		*	Number of hits where the recomputed transforms differed from the cached ones. Only counted if sv_bone_cache is 2.
+		*/
+		uint64_t uiMismatches = 0;
+	};
+
 public:
 	CStudioBlending() = default;
 
@@ -38,12 +57,68 @@ public:
 						   int				iBone,
 						   const edict_t*	pEdict );
 
+	/**
+	*	Frees all cached bone transforms.
+	*/
+	void ClearCache();
+
+	const Stats& GetStats() const { return m_Stats; }
+
+	void ResetStats()
+	{
+		m_Stats = Stats();
+	}
+
+private:
+	/**
+	*	Everything that the bone transforms are computed from.
+	*/
+	struct CacheKey
+	{
+		const model_t* pModel;
+		float flFrame;
+		int iSequence;
+		Vector vecAngles;
+		Vector vecOrigin;
+		byte controller[ 4 ];
+		byte blending[ 2 ];
+
+		/**
+		*	Server time of the frame the transforms were computed in.
+		*/
+		float flTime;
+
+		bool operator==( const CacheKey& other ) const;
+	};
+
+	struct CacheEntry
+	{
+		bool fValid = false;
+		CacheKey key;
+		Matrix3x4 rotationMatrix;
+		std::vector<Matrix3x4> boneTransforms;
+	};
+
+	/**
+	*	Computes the rotation matrix and the bone transforms into the engine's buffers.
+	*	@param iBone If -1, all bones are set up. Otherwise only this bone and its parents are set up.
+	*	@return Number of bones in the model.
+	*/
+	int SetupBones( model_t* pModel, float frame, int sequence, const Vector& angles, const Vector& origin, const byte* pcontroller, const byte* pblending, int iBone );
+
 private:
 	Matrix3x4* m_pRotationMatrix = nullptr;
 
 	//MAXSTUDIOBONES elements in array.
 	Matrix3x4* m_pBoneTransform = nullptr;
 
+	/**
+	*	Indexed by edict index.
+	*/
+	std::vector<CacheEntry> m_Cache;
+
+	Stats m_Stats;
+
 private:
 	CStudioBlending( const CStudioBlending& ) = delete;
 	CStudioBlending& operator=( const CStudioBlending& ) = delete;
@@ -53,4 +128,9 @@ extern server_studio_api_t IEngineStudio;
 
 extern CStudioBlending g_StudioBlending;
 
+/**
+*	Prints the bone cache hit rate since the last time this was used, and resets the counters.
+*/
+void ServerCommand_BoneCacheStats();
+
 #endif //GAME_SERVER_CSTUDIOBLENDING_H
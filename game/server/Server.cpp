@@ -21,6 +21,16 @@
 #include "CServerGameInterface.h"
 
 #include "Server.h"
+#include "ServerInterface.h"
+
+#include "CFullPackSnapshot.h"
+#include "CPMoveRecorder.h"
+#include "CStudioBlending.h"
+#include "StudioBenchmark.h"
+#include "nodes/CNearestNodeIndex.h"
+#include "entities/NPCs/CAILODManager.h"
+
+#include "saverestore/SaveRestoreBenchmark.h"
 
 cvar_t g_DummyCvar = { "_not_a_real_cvar_", "0" };
 
@@ -56,10 +66,49 @@ cvar_t  mp_chattime = {"mp_chattime","10", FCVAR_SERVER };
 //Whether to use the new way to check for impulse commands (unaffected by weapon state) - Solokiller
 cvar_t	sv_new_impulse_check = { "sv_new_impulse_check", "0", FCVAR_SERVER };
 
+//Number of worker threads used to compute node graph routing tables. 0 uses the hardware thread count, negative values use the original serial builder.
+cvar_t	sv_graph_routing_threads = { "sv_graph_routing_threads", "0", FCVAR_SERVER };
+
+//Spatial entity queries: 0 uses a linear scan, 1 uses the entity grid, 2 uses the entity grid and reports differences with a linear scan.
+cvar_t	sv_entity_grid = { "sv_entity_grid", "1", FCVAR_SERVER };
+
+//Entity lookups by classname, targetname and target: 0 uses the engine's linear scan, 1 uses the name index, 2 uses the name index and reports differences with the engine.
+cvar_t	sv_entity_name_index = { "sv_entity_name_index", "1", FCVAR_SERVER };
+
+//Whether to save entity data in the hashed field format. This build loads saves in either format, but older builds can only load the name token format.
+cvar_t	sv_save_hashed_fields = { "sv_save_hashed_fields", "0", FCVAR_SERVER };
+
+//Whether to give the engine the game's bone setup. Its results haven't been compared with the engine's own bone setup yet, so it's off by default.
+//The engine asks for it right after GameDLLInit, before any config is executed, so it can only be enabled with -sv_studio_blending on the command line.
+cvar_t	sv_studio_blending = { "sv_studio_blending", "0", FCVAR_SERVER };
+
+//Server side bone setup: 0 always rebuilds bones, 1 reuses bones built for the same entity and inputs in the same frame, 2 rebuilds them anyway and reports differences.
+cvar_t	sv_bone_cache = { "sv_bone_cache", "1", FCVAR_SERVER };
+
+//Sequence and activity lookups: 0 scans every sequence in the model, 1 uses per model indices, 2 uses the indices and reports differences with a scan.
+cvar_t	sv_sequence_cache = { "sv_sequence_cache", "1", FCVAR_SERVER };
+
+//AI level of detail: 0 runs every monster's AI at full rate, 1 thinks and senses less often for monsters that are far from clients or outside of their PVS.
+cvar_t	sv_ai_lod = { "sv_ai_lod", "0", FCVAR_SERVER };
+
+//Monsters in a client's PVS and within this distance of a client run their AI at full rate.
+cvar_t	sv_ai_lod_full_dist = { "sv_ai_lod_full_dist", "1024", FCVAR_SERVER };
+
+//Monsters outside of every client's PVS and further than this from all clients think least often.
+cvar_t	sv_ai_lod_near_dist = { "sv_ai_lod_near_dist", "2048", FCVAR_SERVER };
+
 cvar_t	server_cfg = { "server_cfg", "server/default_server_config.xml", FCVAR_SERVER | FCVAR_UNLOGGED };
 
 cvar_t	as_plugin_list_file = { "as_plugin_list_file", "default_plugins.xml", FCVAR_SERVER | FCVAR_UNLOGGED };
 
+//Script profiling: 0 is off, 1 times every hook and custom entity call, 2 times one in as_profile_sample_rate calls.
+cvar_t	as_profile = { "as_profile", "0", FCVAR_SERVER };
+
+cvar_t	as_profile_sample_rate = { "as_profile_sample_rate", "16", FCVAR_SERVER };
+
+//Milliseconds of script time a module may use per frame before a warning is logged. 0 disables the budget.
+cvar_t	as_plugin_frame_budget = { "as_plugin_frame_budget", "0", FCVAR_SERVER };
+
 //Config file that contains the MySQL settings to use for default connections.
 cvar_t	as_mysql_config = { "as_mysql_config", "server/default_mysql_config.xml", FCVAR_SERVER | FCVAR_UNLOGGED };
 
@@ -586,6 +635,11 @@ void ShutdownGame()
 	SERVER_COMMAND( "quit\n" );
 }
 
+static void ServerCommand_StringPoolStats()
+{
+	g_StringPool.DebugPrint();
+}
+
 // Register your console variables here
 // This gets called one time when the game is initialied
 void GameDLLInit( void )
@@ -625,12 +679,26 @@ void GameDLLInit( void )
 	CVAR_REGISTER (&mp_chattime);
 
 	CVAR_REGISTER( &sv_new_impulse_check );
+	CVAR_REGISTER( &sv_graph_routing_threads );
+	CVAR_REGISTER( &sv_entity_grid );
+	CVAR_REGISTER( &sv_entity_name_index );
+	CVAR_REGISTER( &sv_save_hashed_fields );
+	CVAR_REGISTER( &sv_studio_blending );
+	CVAR_REGISTER( &sv_bone_cache );
+	CVAR_REGISTER( &sv_sequence_cache );
+	CVAR_REGISTER( &sv_ai_lod );
+	CVAR_REGISTER( &sv_ai_lod_full_dist );
+	CVAR_REGISTER( &sv_ai_lod_near_dist );
 	CVAR_REGISTER( &server_cfg );
 
 	CVAR_REGISTER( &as_plugin_list_file );
 
 	CVAR_REGISTER( &as_mysql_config );
 
+	CVAR_REGISTER( &as_profile );
+	CVAR_REGISTER( &as_profile_sample_rate );
+	CVAR_REGISTER( &as_plugin_frame_budget );
+
 // REGISTER CVARS FOR SKILL LEVEL STUFF
 	// Agrunt
 	CVAR_REGISTER ( &sk_agrunt_health1 );// {"sk_agrunt_health1","0"};
@@ -1143,6 +1211,16 @@ void GameDLLInit( void )
 	CVAR_REGISTER ( &sk_player_leg3 );
 // END REGISTER CVARS FOR SKILL LEVEL STUFF
 
+	g_engfuncs.pfnAddServerCommand( "sv_saverestore_benchmark", &::ServerCommand_SaveRestoreBenchmark );
+	g_engfuncs.pfnAddServerCommand( "sv_fullpack_stats", &::ServerCommand_FullPackStats );
+	g_engfuncs.pfnAddServerCommand( "sv_nearestnode_stats", &::ServerCommand_NearestNodeStats );
+	g_engfuncs.pfnAddServerCommand( "sv_stringpool_stats", &::ServerCommand_StringPoolStats );
+	g_engfuncs.pfnAddServerCommand( "sv_keyvalue_stats", &::ServerCommand_KeyValueStats );
+	g_engfuncs.pfnAddServerCommand( "sv_bonecache_stats", &::ServerCommand_BoneCacheStats );
+	g_engfuncs.pfnAddServerCommand( "sv_studio_benchmark", &::ServerCommand_StudioBenchmark );
+	g_engfuncs.pfnAddServerCommand( "sv_ai_lod_stats", &::ServerCommand_AILODStats );
+	g_engfuncs.pfnAddServerCommand( "sv_pmove_record", &::ServerCommand_PMoveRecord );
+
 	//Link user messages now.
 	LinkUserMessages();
 
@@ -41,9 +41,22 @@ extern cvar_t	teamoverride;
 extern cvar_t	defaultteam;
 extern cvar_t	allowmonsters;
 extern cvar_t	sv_new_impulse_check;
+extern cvar_t	sv_graph_routing_threads;
+extern cvar_t	sv_entity_grid;
+extern cvar_t	sv_entity_name_index;
+extern cvar_t	sv_save_hashed_fields;
+extern cvar_t	sv_studio_blending;
+extern cvar_t	sv_bone_cache;
+extern cvar_t	sv_sequence_cache;
+extern cvar_t	sv_ai_lod;
+extern cvar_t	sv_ai_lod_full_dist;
+extern cvar_t	sv_ai_lod_near_dist;
 extern cvar_t	server_cfg;
 extern cvar_t	as_plugin_list_file;
 extern cvar_t	as_mysql_config;
+extern cvar_t	as_profile;
+extern cvar_t	as_profile_sample_rate;
+extern cvar_t	as_plugin_frame_budget;
 
 // Engine Cvars
 extern cvar_t	*g_psv_gravity;
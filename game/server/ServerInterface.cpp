@@ -28,6 +28,8 @@
 #include "CStudioBlending.h"
 
 #include "CMap.h"
+#include "CEntityNameIndex.h"
+#include "CPMoveRecorder.h"
 
 #include "engine/saverestore/CSaveRestoreBuffer.h"
 #include "engine/saverestore/CSave.h"
@@ -95,7 +97,7 @@ DLL_FUNCTIONS gFunctionTable =
 
 	Sys_Error,					//pfnSys_Error				Called when engine has encountered an error
 
-	PM_Move,					//pfnPM_Move
+	PM_RecordedMove,			//pfnPM_Move
 	PM_Init,					//pfnPM_Init				Server version of player movement initialization
 	PM_FindTextureType,			//pfnPM_FindTextureType
 
@@ -170,12 +172,18 @@ int GetNewDLLFunctions( NEW_DLL_FUNCTIONS* pFunctionTable, int* pInterfaceVersio
 	return true;
 }
 
-#if 0
 int Server_GetBlendingInterface( int version, sv_blending_interface_t** ppInterface, server_studio_api_t* pStudio, Matrix3x4* pRotationMatrix, Matrix3x4* pBoneTransform )
 {
+	//No config has been executed yet, see sv_studio_blending.
+	if( UTIL_CheckParm( "-sv_studio_blending" ) )
+		CVAR_SET_FLOAT( "sv_studio_blending", 1 );
+
+	//Returning false makes the engine use its own bone setup.
+	if( !sv_studio_blending.value )
+		return false;
+
 	return g_StudioBlending.Initialize( version, ppInterface, pStudio, pRotationMatrix, pBoneTransform );
 }
-#endif
 }
 
 int DispatchSpawn( edict_t *pent )
@@ -195,6 +203,8 @@ int DispatchSpawn( edict_t *pent )
 		// that would touch too much code for me to do that right now.
 		pEntity = ( CBaseEntity * ) GET_PRIVATE( pent );
 
+		g_EntityNameIndex.Update( pent );
+
 		if( pEntity )
 		{
 			if( g_pGameRules && !g_pGameRules->IsAllowedToSpawn( pEntity ) )
@@ -275,6 +285,19 @@ void DispatchBlocked( edict_t *pentBlocked, edict_t *pentOther )
 		pEntity->Blocked( pOther );
 }
 
+namespace
+{
+struct KeyValueStats
+{
+	size_t uiEntvars = 0;
+	size_t uiDataDesc = 0;
+	size_t uiKeyValue = 0;
+	size_t uiUnhandled = 0;
+};
+
+KeyValueStats g_KeyValueStats;
+}
+
 void DispatchKeyValue( edict_t *pentKeyvalue, KeyValueData *pkvd )
 {
 	if( !pkvd || !pentKeyvalue )
@@ -282,6 +305,12 @@ void DispatchKeyValue( edict_t *pentKeyvalue, KeyValueData *pkvd )
 
 	EntvarsKeyvalue( VARS( pentKeyvalue ), pkvd );
 
+	if( pkvd->fHandled )
+	{
+		++g_KeyValueStats.uiEntvars;
+		g_EntityNameIndex.Update( pentKeyvalue );
+	}
+
 	// If the key was an entity variable, or there's no class set yet, don't look for the object, it may
 	// not exist yet.
 	if( pkvd->fHandled || pkvd->szClassName == NULL )
@@ -294,19 +323,40 @@ void DispatchKeyValue( edict_t *pentKeyvalue, KeyValueData *pkvd )
 		return;
 
 	//See if the keyvalue is in the datadesc as a key.
-	if( auto pDesc = UTIL_FindTypeDescInDataMap( *pEntity->GetDataMap(), pkvd->szKeyName, true ) )
+	if( auto pDesc = UTIL_FindKeyTypeDescInDataMap( *pEntity->GetDataMap(), pkvd->szKeyName ) )
 	{
-		if( pDesc->flags & TypeDescFlag::KEY )
+		if( UTIL_SetTypeDescValue( pEntity, *pDesc, pkvd->szValue ) )
 		{
-			if( UTIL_SetTypeDescValue( pEntity, *pDesc, pkvd->szValue ) )
-			{
-				pkvd->fHandled = true;
-				return;
-			}
+			++g_KeyValueStats.uiDataDesc;
+			pkvd->fHandled = true;
+			return;
 		}
 	}
 
 	pEntity->KeyValue( pkvd );
+
+	if( pkvd->fHandled )
+		++g_KeyValueStats.uiKeyValue;
+	else
+		++g_KeyValueStats.uiUnhandled;
+}
+
+void ServerCommand_KeyValueStats()
+{
+	const size_t uiTotal = g_KeyValueStats.uiEntvars + g_KeyValueStats.uiDataDesc + g_KeyValueStats.uiKeyValue + g_KeyValueStats.uiUnhandled;
+
+	auto percent = [ = ]( const size_t uiCount )
+	{
+		return uiTotal ? 100.0 * uiCount / uiTotal : 0.0;
+	};
+
+	ALERT( at_console, "Keyvalues: %u\n", static_cast<unsigned int>( uiTotal ) );
+	ALERT( at_console, "Entity variables: %u (%.1f%%)\n", static_cast<unsigned int>( g_KeyValueStats.uiEntvars ), percent( g_KeyValueStats.uiEntvars ) );
+	ALERT( at_console, "Data descriptor keys: %u (%.1f%%)\n", static_cast<unsigned int>( g_KeyValueStats.uiDataDesc ), percent( g_KeyValueStats.uiDataDesc ) );
+	ALERT( at_console, "KeyValue: %u (%.1f%%)\n", static_cast<unsigned int>( g_KeyValueStats.uiKeyValue ), percent( g_KeyValueStats.uiKeyValue ) );
+	ALERT( at_console, "Unhandled: %u (%.1f%%)\n", static_cast<unsigned int>( g_KeyValueStats.uiUnhandled ), percent( g_KeyValueStats.uiUnhandled ) );
+
+	g_KeyValueStats = KeyValueStats();
 }
 
 void DispatchSave( edict_t *pent, SAVERESTOREDATA *pSaveData )
@@ -335,6 +385,10 @@ void DispatchSave( edict_t *pent, SAVERESTOREDATA *pSaveData )
 		pTable->classname = MAKE_STRING( pEntity->GetClassname() );	// Remember entity class for respawn
 
 		CSave saveHelper( pSaveData );
+
+		//Only entity data can use the hashed format. Other blocks keep their name tokens so anything that reads them by field name still finds the fields.
+		saveHelper.SetHashedFormat( sv_save_hashed_fields.value != 0 );
+
 		pEntity->Save( saveHelper );
 
 		pTable->size = pSaveData->size - pTable->location;	// Size of entity block is data size written to block
@@ -427,6 +481,8 @@ int DispatchRestore( edict_t *pent, SAVERESTOREDATA *pSaveData, int globalEntity
 		// Again, could be deleted, get the pointer again.
 		pEntity = ( CBaseEntity * ) GET_PRIVATE( pent );
 
+		g_EntityNameIndex.Update( pent );
+
 #if 0
 		if( pEntity && pEntity->HasGlobalName() && globalEntity )
 		{
@@ -501,6 +557,8 @@ void OnFreeEntPrivateData( edict_t* pEdict )
 
 		UTIL_DestructEntity( pEntity );
 	}
+
+	g_EntityNameIndex.Remove( pEdict );
 }
 
 int ShouldCollide( edict_t *pentTouched, edict_t *pentOther )
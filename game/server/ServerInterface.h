@@ -52,6 +52,13 @@ void DispatchUse( edict_t *pentUsed, edict_t *pentOther );
 void DispatchTouch( edict_t *pentTouched, edict_t *pentOther );
 void DispatchBlocked( edict_t *pentBlocked, edict_t *pentOther );
 void DispatchKeyValue( edict_t *pentKeyvalue, KeyValueData *pkvd );
+
+/**
+*	Prints how many keyvalues were handled as entity variables, as data descriptor keys and by KeyValue since the last time this was used,
+*	and resets the counters.
+*/
+void ServerCommand_KeyValueStats();
+
 void DispatchSave( edict_t *pent, SAVERESTOREDATA *pSaveData );
 int  DispatchRestore( edict_t *pent, SAVERESTOREDATA *pSaveData, int globalEntity );
 void DispatchObjectCollisionBox( edict_t *pent );
@@ -97,11 +104,10 @@ extern "C" DLLEXPORT int GetEntityAPI2( DLL_FUNCTIONS *pFunctionTable, int *inte
 */
 extern "C" DLLEXPORT int GetNewDLLFunctions( NEW_DLL_FUNCTIONS* pFunctionTable, int* pInterfaceVersion );
 
-#if 0
 /**
 *	Provides a blending interface to the engine to allow the engine to set up bones on the server side to match non-standard blending on the client side. - Solokiller
+*	Only provided if sv_studio_blending is enabled.
 */
 extern "C" DLLEXPORT int Server_GetBlendingInterface( int version, sv_blending_interface_t** ppInterface, server_studio_api_t* pStudio, Matrix3x4* pRotationMatrix, Matrix3x4* pBoneTransform );
-#endif
 
 #endif //GAME_SERVER_SERVERINTERFACE_H
\ No newline at end of file
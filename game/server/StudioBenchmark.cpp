@@ -0,0 +1,349 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "extdll.h"
+#include "util.h"
+
+#include "com_model.h"
+#include "studio.h"
+#include "studio/StudioUtils.h"
+
+#include "ssemath.h"
+
+#include "StudioBenchmark.h"
+
+namespace
+{
+const int STUDIO_IDENT = ( 'T' << 24 ) + ( 'S' << 16 ) + ( 'D' << 8 ) + 'I';
+const int STUDIO_MODEL_VERSION = 10;
+
+/**
+*	Number of frames sampled from each sequence.
+*/
+const int FRAMES_PER_SEQUENCE = 4;
+
+/**
+*	Largest difference that is considered equivalent. Differences are relative for values larger than 1.
+*/
+const float MAX_ERROR = 1e-4f;
+
+struct Sample
+{
+	mstudioseqdesc_t* pseqdesc;
+	mstudioanim_t* panim;
+	float f;
+};
+
+struct Pose
+{
+	Vector pos[ MAXSTUDIOBONES ];
+	Vector4D q[ MAXSTUDIOBONES ];
+};
+
+struct KernelResult
+{
+	double flScalarTime = 0;
+	double flSSETime = 0;
+	float flMaxError = 0;
+};
+
+const byte g_Controllers[ MAXSTUDIOCONTROLLERS ] = {};
+
+using Clock = std::chrono::high_resolution_clock;
+
+double ElapsedSince( const Clock::time_point& start )
+{
+	return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+void UpdateError( float& flMaxError, const float* pflResult, const float* pflReference, const size_t uiCount )
+{
+	for( size_t i = 0; i < uiCount; ++i )
+	{
+		const float flError = fabsf( pflResult[ i ] - pflReference[ i ] ) / max( 1.0f, fabsf( pflReference[ i ] ) );
+
+		if( flError > flMaxError )
+			flMaxError = flError;
+	}
+}
+
+template<typename FUNC>
+void CalcRotations( FUNC func, studiohdr_t* pHeader, const Sample& sample, Pose& pose )
+{
+	func( pHeader, pose.pos, pose.q, sample.pseqdesc, sample.panim, sample.f, 1.0, g_Controllers, g_Controllers, 0, sample.pseqdesc->fps );
+}
+
+void BuildHierarchy( void ( *pConcat )( const Matrix3x4&, const Matrix3x4&, Matrix3x4& ),
+					 const mstudiobone_t* pbones, const int numbones, const Matrix3x4& rotationMatrix, const Matrix3x4* pBoneMatrices, Matrix3x4* pTransforms )
+{
+	for( int i = 0; i < numbones; ++i )
+	{
+		if( pbones[ i ].parent == -1 )
+			pConcat( rotationMatrix, pBoneMatrices[ i ], pTransforms[ i ] );
+		else
+			pConcat( pTransforms[ pbones[ i ].parent ], pBoneMatrices[ i ], pTransforms[ i ] );
+	}
+}
+
+void PrintResult( const char* pszKernel, const KernelResult& result, const int cIterations )
+{
+	ALERT( at_console, "%-18s scalar %8.3f ms, SSE2 %8.3f ms (%.2fx), max error %g%s\n",
+		   pszKernel, result.flScalarTime * 1000 / cIterations, result.flSSETime * 1000 / cIterations,
+		   result.flSSETime > 0 ? result.flScalarTime / result.flSSETime : 0.0,
+		   result.flMaxError, result.flMaxError <= MAX_ERROR ? "" : " (MISMATCH)" );
+}
+}
+
+void ServerCommand_StudioBenchmark()
+{
+	if( CMD_ARGC() < 2 )
+	{
+		ALERT( at_console, "Usage: sv_studio_benchmark <model> [iterations]\n" );
+		return;
+	}
+
+	const char* pszModel = CMD_ARGV( 1 );
+
+	int cIterations = 20;
+
+	if( CMD_ARGC() >= 3 )
+		cIterations = max( 1, atoi( CMD_ARGV( 2 ) ) );
+
+	int iLength = 0;
+
+	byte* pFile = LOAD_FILE_FOR_ME( pszModel, &iLength );
+
+	if( !pFile )
+	{
+		ALERT( at_console, "sv_studio_benchmark: Couldn't load \"%s\"\n", pszModel );
+		return;
+	}
+
+	auto pHeader = reinterpret_cast<studiohdr_t*>( pFile );
+
+	if( iLength < static_cast<int>( sizeof( studiohdr_t ) ) || pHeader->id != STUDIO_IDENT || pHeader->version != STUDIO_MODEL_VERSION )
+	{
+		ALERT( at_console, "sv_studio_benchmark: \"%s\" is not a studio model\n", pszModel );
+		FREE_FILE( pFile );
+		return;
+	}
+
+	const int numbones = pHeader->numbones;
+
+	if( numbones <= 0 || numbones > MAXSTUDIOBONES )
+	{
+		ALERT( at_console, "sv_studio_benchmark: \"%s\" has %d bones\n", pszModel, numbones );
+		FREE_FILE( pFile );
+		return;
+	}
+
+	//Sample a few frames, with a fraction so the frames are interpolated, from every blend of every sequence.
+	//Sequences in external sequence group files are skipped.
+	std::vector<Sample> samples;
+
+	int cSkipped = 0;
+
+	auto pseqdescs = reinterpret_cast<mstudioseqdesc_t*>( pFile + pHeader->seqindex );
+
+	for( int iSequence = 0; iSequence < pHeader->numseq; ++iSequence )
+	{
+		mstudioseqdesc_t* pseqdesc = &pseqdescs[ iSequence ];
+
+		if( pseqdesc->seqgroup != 0 )
+		{
+			++cSkipped;
+			continue;
+		}
+
+		for( int iBlend = 0; iBlend < pseqdesc->numblends; ++iBlend )
+		{
+			auto panim = reinterpret_cast<mstudioanim_t*>( pFile + pseqdesc->animindex ) + iBlend * numbones;
+
+			for( int iFrame = 0; iFrame < FRAMES_PER_SEQUENCE; ++iFrame )
+			{
+				const float f = ( pseqdesc->numframes - 1 ) * ( iFrame + 0.37f ) / FRAMES_PER_SEQUENCE;
+
+				samples.push_back( Sample{ pseqdesc, panim, f } );
+			}
+		}
+	}
+
+	if( samples.empty() )
+	{
+		ALERT( at_console, "sv_studio_benchmark: \"%s\" has no sequences in the model file\n", pszModel );
+		FREE_FILE( pFile );
+		return;
+	}
+
+	const size_t cSamples = samples.size();
+
+	const mstudiobone_t* pbones = reinterpret_cast<mstudiobone_t*>( pFile + pHeader->boneindex );
+
+	std::vector<Pose> reference( cSamples );
+	std::vector<Pose> result( cSamples );
+
+	KernelResult calcRotations, slerpBones, quaternionMatrices, concatTransforms;
+
+	//CalcRotations.
+	auto start = Clock::now();
+
+	for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+	{
+		for( size_t i = 0; i < cSamples; ++i )
+			CalcRotations( &studio::scalar::CalcRotations, pHeader, samples[ i ], reference[ i ] );
+	}
+
+	calcRotations.flScalarTime = ElapsedSince( start );
+
+	start = Clock::now();
+
+	for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+	{
+		for( size_t i = 0; i < cSamples; ++i )
+			CalcRotations( &studio::CalcRotations, pHeader, samples[ i ], result[ i ] );
+	}
+
+	calcRotations.flSSETime = ElapsedSince( start );
+
+	for( size_t i = 0; i < cSamples; ++i )
+	{
+		UpdateError( calcRotations.flMaxError, &result[ i ].pos[ 0 ].x, &reference[ i ].pos[ 0 ].x, numbones * 3 );
+		UpdateError( calcRotations.flMaxError, &result[ i ].q[ 0 ].x, &reference[ i ].q[ 0 ].x, numbones * 4 );
+	}
+
+	//SlerpBones, blending each reference pose with the next one.
+	//Poses are blended in place, so fresh copies are made before each iteration.
+	{
+		std::vector<Pose> to( cSamples );
+		std::vector<Pose> referenceSlerped;
+
+		for( int iVersion = 0; iVersion < 2; ++iVersion )
+		{
+			auto pSlerp = iVersion == 0 ? &studio::scalar::SlerpBones : &studio::SlerpBones;
+
+			double flTime = 0;
+
+			for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+			{
+				result = reference;
+
+				for( size_t i = 0; i < cSamples; ++i )
+					to[ i ] = reference[ ( i + 1 ) % cSamples ];
+
+				start = Clock::now();
+
+				for( size_t i = 0; i < cSamples; ++i )
+					pSlerp( pHeader, result[ i ].q, result[ i ].pos, to[ i ].q, to[ i ].pos, ( i % 2 ) ? 0.7f : 0.3f );
+
+				flTime += ElapsedSince( start );
+			}
+
+			if( iVersion == 0 )
+			{
+				slerpBones.flScalarTime = flTime;
+				referenceSlerped = result;
+			}
+			else
+			{
+				slerpBones.flSSETime = flTime;
+			}
+		}
+
+		for( size_t i = 0; i < cSamples; ++i )
+		{
+			UpdateError( slerpBones.flMaxError, &result[ i ].pos[ 0 ].x, &referenceSlerped[ i ].pos[ 0 ].x, numbones * 3 );
+			UpdateError( slerpBones.flMaxError, &result[ i ].q[ 0 ].x, &referenceSlerped[ i ].q[ 0 ].x, numbones * 4 );
+		}
+	}
+
+	//QuaternionMatrices and ConcatTransforms, from the reference poses.
+	{
+		std::vector<Matrix3x4> referenceMatrices( cSamples * numbones );
+		std::vector<Matrix3x4> resultMatrices( cSamples * numbones );
+
+		start = Clock::now();
+
+		for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+		{
+			for( size_t i = 0; i < cSamples; ++i )
+				QuaternionMatricesScalar( reference[ i ].q, reference[ i ].pos, &referenceMatrices[ i * numbones ], numbones );
+		}
+
+		quaternionMatrices.flScalarTime = ElapsedSince( start );
+
+		start = Clock::now();
+
+		for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+		{
+			for( size_t i = 0; i < cSamples; ++i )
+				QuaternionMatrices( reference[ i ].q, reference[ i ].pos, &resultMatrices[ i * numbones ], numbones );
+		}
+
+		quaternionMatrices.flSSETime = ElapsedSince( start );
+
+		UpdateError( quaternionMatrices.flMaxError, resultMatrices[ 0 ].matrix[ 0 ], referenceMatrices[ 0 ].matrix[ 0 ], cSamples * numbones * 12 );
+
+		Matrix3x4 rotationMatrix;
+
+		AngleMatrix( Vector( 0, 90, 0 ), rotationMatrix );
+
+		rotationMatrix[ 0 ][ 3 ] = 128;
+		rotationMatrix[ 1 ][ 3 ] = -256;
+		rotationMatrix[ 2 ][ 3 ] = 64;
+
+		std::vector<Matrix3x4> referenceTransforms( cSamples * numbones );
+		std::vector<Matrix3x4> resultTransforms( cSamples * numbones );
+
+		start = Clock::now();
+
+		for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+		{
+			for( size_t i = 0; i < cSamples; ++i )
+				BuildHierarchy( &ConcatTransformsScalar, pbones, numbones, rotationMatrix, &referenceMatrices[ i * numbones ], &referenceTransforms[ i * numbones ] );
+		}
+
+		concatTransforms.flScalarTime = ElapsedSince( start );
+
+		start = Clock::now();
+
+		for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+		{
+			for( size_t i = 0; i < cSamples; ++i )
+				BuildHierarchy( &ConcatTransforms, pbones, numbones, rotationMatrix, &referenceMatrices[ i * numbones ], &resultTransforms[ i * numbones ] );
+		}
+
+		concatTransforms.flSSETime = ElapsedSince( start );
+
+		UpdateError( concatTransforms.flMaxError, resultTransforms[ 0 ].matrix[ 0 ], referenceTransforms[ 0 ].matrix[ 0 ], cSamples * numbones * 12 );
+	}
+
+	ALERT( at_console, "Studio benchmark: \"%s\", %d bones, %u samples (%d sequences skipped), %d iterations\n",
+		   pszModel, numbones, static_cast<unsigned int>( cSamples ), cSkipped, cIterations );
+
+	if( !MATHLIB_USE_SSE2 )
+		ALERT( at_console, "SSE2 is not available in this build; both versions run the scalar code\n" );
+
+	ALERT( at_console, "Time per iteration:\n" );
+
+	PrintResult( "CalcRotations", calcRotations, cIterations );
+	PrintResult( "SlerpBones", slerpBones, cIterations );
+	PrintResult( "QuaternionMatrices", quaternionMatrices, cIterations );
+	PrintResult( "ConcatTransforms", concatTransforms, cIterations );
+
+	FREE_FILE( pFile );
+}
@@ -0,0 +1,25 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_STUDIOBENCHMARK_H
+#define GAME_SERVER_STUDIOBENCHMARK_H
+
+/**
+*	Server command that runs the bone setup kernels over every sequence of a model, with both the scalar and the SSE2 versions.
+*	Reports the time taken by each kernel and the largest difference between the results of both versions.
+*	Usage: sv_studio_benchmark <model> [iterations]
+*/
+void ServerCommand_StudioBenchmark();
+
+#endif //GAME_SERVER_STUDIOBENCHMARK_H
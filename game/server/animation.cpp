@@ -20,6 +20,9 @@
 #include "entities/NPCs/Activity.h"
 #include "ScriptEvent.h"
 
+#include "Server.h"
+#include "CSequenceIndexCache.h"
+
 #include "animation.h"
 
 int ExtractBbox( void *pmodel, int sequence, Vector& vecMins, Vector& vecMaxs )
@@ -43,13 +46,8 @@ int ExtractBbox( void *pmodel, int sequence, Vector& vecMins, Vector& vecMaxs )
 }
 
 
-int LookupActivity( void *pmodel, int activity )
+static int LinearLookupActivity( studiohdr_t* pstudiohdr, int activity )
 {
-	studiohdr_t* pstudiohdr = ( studiohdr_t* ) pmodel;
-
-	if( !pstudiohdr )
-		return 0;
-
 	mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pstudiohdr + pstudiohdr->seqindex );
 
 	int weighttotal = 0;
@@ -68,13 +66,39 @@ int LookupActivity( void *pmodel, int activity )
 }
 
 
-int LookupActivityHeaviest( void *pmodel, int activity )
+int LookupActivity( void *pmodel, int activity )
 {
 	studiohdr_t* pstudiohdr = ( studiohdr_t* ) pmodel;
 
 	if( !pstudiohdr )
 		return 0;
 
+	if( sv_sequence_cache.value <= 0 )
+		return LinearLookupActivity( pstudiohdr, activity );
+
+	const int seq = g_SequenceIndexCache.LookupActivity( pstudiohdr, activity );
+
+	if( sv_sequence_cache.value >= 2 )
+	{
+		//The pick is random, so only check that it's a sequence for the activity.
+		const int linearSeq = LinearLookupActivity( pstudiohdr, activity );
+
+		mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pstudiohdr + pstudiohdr->seqindex );
+
+		if( ( seq == ACTIVITY_NOT_AVAILABLE ) != ( linearSeq == ACTIVITY_NOT_AVAILABLE ) ||
+			( seq != ACTIVITY_NOT_AVAILABLE && pseqdesc[ seq ].activity != activity ) )
+		{
+			ALERT( at_console, "LookupActivity: sequence cache returned %d, linear scan returned %d for activity %d in %s\n",
+				seq, linearSeq, activity, pstudiohdr->name );
+		}
+	}
+
+	return seq;
+}
+
+
+static int LinearLookupActivityHeaviest( studiohdr_t* pstudiohdr, int activity )
+{
 	mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pstudiohdr + pstudiohdr->seqindex );
 
 	int weight = 0;
@@ -94,6 +118,32 @@ int LookupActivityHeaviest( void *pmodel, int activity )
 	return seq;
 }
 
+int LookupActivityHeaviest( void *pmodel, int activity )
+{
+	studiohdr_t* pstudiohdr = ( studiohdr_t* ) pmodel;
+
+	if( !pstudiohdr )
+		return 0;
+
+	if( sv_sequence_cache.value <= 0 )
+		return LinearLookupActivityHeaviest( pstudiohdr, activity );
+
+	const int seq = g_SequenceIndexCache.LookupActivityHeaviest( pstudiohdr, activity );
+
+	if( sv_sequence_cache.value >= 2 )
+	{
+		const int linearSeq = LinearLookupActivityHeaviest( pstudiohdr, activity );
+
+		if( seq != linearSeq )
+		{
+			ALERT( at_console, "LookupActivityHeaviest: sequence cache returned %d, linear scan returned %d for activity %d in %s\n",
+				seq, linearSeq, activity, pstudiohdr->name );
+		}
+	}
+
+	return seq;
+}
+
 void GetEyePosition ( void *pmodel, Vector& vecEyePosition )
 {
 	studiohdr_t *pstudiohdr = (studiohdr_t *)pmodel;
@@ -107,6 +157,19 @@ void GetEyePosition ( void *pmodel, Vector& vecEyePosition )
 	vecEyePosition = pstudiohdr->eyeposition;
 }
 
+static int LinearLookupSequence( studiohdr_t* pstudiohdr, const char *label )
+{
+	mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pstudiohdr + pstudiohdr->seqindex );
+
+	for (int i = 0; i < pstudiohdr->numseq; i++)
+	{
+		if (stricmp( pseqdesc[i].label, label ) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
 int LookupSequence( void *pmodel, const char *label )
 {
 	studiohdr_t* pstudiohdr = ( studiohdr_t* ) pmodel;
@@ -114,15 +177,23 @@ int LookupSequence( void *pmodel, const char *label )
 	if( !pstudiohdr )
 		return 0;
 
-	mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pstudiohdr + pstudiohdr->seqindex );
+	if( sv_sequence_cache.value <= 0 )
+		return LinearLookupSequence( pstudiohdr, label );
 
-	for (int i = 0; i < pstudiohdr->numseq; i++)
+	const int seq = g_SequenceIndexCache.LookupSequence( pstudiohdr, label );
+
+	if( sv_sequence_cache.value >= 2 )
 	{
-		if (stricmp( pseqdesc[i].label, label ) == 0)
-			return i;
+		const int linearSeq = LinearLookupSequence( pstudiohdr, label );
+
+		if( seq != linearSeq )
+		{
+			ALERT( at_console, "LookupSequence: sequence cache returned %d, linear scan returned %d for \"%s\" in %s\n",
+				seq, linearSeq, label, pstudiohdr->name );
+		}
 	}
 
-	return -1;
+	return seq;
 }
 
 
@@ -350,6 +421,34 @@ float SetBlending( void *pmodel, entvars_t *pev, int iBlender, float flValue )
 
 
 
+/**
+*	Finds the first sequence that goes from iEndNode to iInternNode, forward or backward.
+*/
+static int LinearFindTransitionSequence( studiohdr_t* pstudiohdr, int iEndNode, int iInternNode, int& iDir )
+{
+	mstudioseqdesc_t* pseqdesc = ( mstudioseqdesc_t* ) ( ( byte* ) pstudiohdr + pstudiohdr->seqindex );
+
+	// look for someone going
+	for (int i = 0; i < pstudiohdr->numseq; i++)
+	{
+		if (pseqdesc[i].entrynode == iEndNode && pseqdesc[i].exitnode == iInternNode)
+		{
+			iDir = 1;
+			return i;
+		}
+		if (pseqdesc[i].nodeflags)
+		{
+			if (pseqdesc[i].exitnode == iEndNode && pseqdesc[i].entrynode == iInternNode)
+			{
+				iDir = -1;
+				return i;
+			}
+		}
+	}
+
+	return -1;
+}
+
 int FindTransition( void *pmodel, int iEndingAnim, int iGoalAnim, int *piDir )
 {
 	studiohdr_t* pstudiohdr = ( studiohdr_t* ) pmodel;
@@ -391,25 +490,36 @@ int FindTransition( void *pmodel, int iEndingAnim, int iGoalAnim, int *piDir )
 	if (iInternNode == 0)
 		return iGoalAnim;
 
-	int i;
+	int iDir = 0;
+	int iSequence;
 
-	// look for someone going
-	for (i = 0; i < pstudiohdr->numseq; i++)
+	if( sv_sequence_cache.value > 0 )
 	{
-		if (pseqdesc[i].entrynode == iEndNode && pseqdesc[i].exitnode == iInternNode)
-		{
-			*piDir = 1;
-			return i;
-		}
-		if (pseqdesc[i].nodeflags)
+		iSequence = g_SequenceIndexCache.FindTransitionSequence( pstudiohdr, iEndNode, iInternNode, iDir );
+
+		if( sv_sequence_cache.value >= 2 )
 		{
-			if (pseqdesc[i].exitnode == iEndNode && pseqdesc[i].entrynode == iInternNode)
+			int iLinearDir = 0;
+
+			const int iLinearSequence = LinearFindTransitionSequence( pstudiohdr, iEndNode, iInternNode, iLinearDir );
+
+			if( iSequence != iLinearSequence || iDir != iLinearDir )
 			{
-				*piDir = -1;
-				return i;
+				ALERT( at_console, "FindTransition: sequence cache returned %d, linear scan returned %d for nodes %d -> %d in %s\n",
+					iSequence, iLinearSequence, iEndNode, iInternNode, pstudiohdr->name );
 			}
 		}
 	}
+	else
+	{
+		iSequence = LinearFindTransitionSequence( pstudiohdr, iEndNode, iInternNode, iDir );
+	}
+
+	if( iSequence != -1 )
+	{
+		*piDir = iDir;
+		return iSequence;
+	}
 
 	ALERT( at_console, "error in transition graph" );
 	return iGoalAnim;
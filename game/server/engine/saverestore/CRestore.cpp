@@ -114,7 +114,11 @@ int CRestore::ReadField( void *pBaseData, const TYPEDESCRIPTION *pFields, int fi
 						{
 							int string;
 
-							string = ALLOC_STRING( ( char * ) pInputData );
+							//Plain strings are interned, see UTIL_SetTypeDescValue.
+							if( pTest->fieldType == FIELD_STRING && !strchr( ( char * ) pInputData, '\\' ) )
+								string = POOL_STRING( ( char * ) pInputData );
+							else
+								string = ALLOC_STRING( ( char * ) pInputData );
 
 							*( ( int * ) pOutputData ) = string;
 
@@ -56,7 +56,7 @@ void CMultiManager::KeyValue( KeyValueData *pkvd )
 			char tmp[ 128 ];
 
 			UTIL_StripToken( pkvd->szKeyName, tmp );
-			m_iTargetName[ m_cTargets ] = ALLOC_STRING( tmp );
+			m_iTargetName[ m_cTargets ] = POOL_STRING( tmp );
 			m_flTargetDelay[ m_cTargets ] = atof( pkvd->szValue );
 			m_cTargets++;
 			pkvd->fHandled = true;
@@ -99,7 +99,7 @@ void CMultiManager::Spawn( void )
 bool CMultiManager::HasTarget( string_t targetname ) const
 {
 	for( int i = 0; i < m_cTargets; i++ )
-		if( FStrEq( STRING( targetname ), STRING( m_iTargetName[ i ] ) ) )
+		if( FStringsEqual( targetname, m_iTargetName[ i ] ) )
 			return true;
 
 	return false;
@@ -216,6 +216,9 @@ void CSoundEnt::InsertSound( int iType, const Vector &vecOrigin, int iVolume, fl
 	g_pSoundEnt->m_SoundPool[ iThisSound ].m_iType = iType;
 	g_pSoundEnt->m_SoundPool[ iThisSound ].m_iVolume = iVolume;
 	g_pSoundEnt->m_SoundPool[ iThisSound ].m_flExpireTime = gpGlobals->time + flDuration;
+
+	// wake up monsters that can hear this so they don't wait for their next slow think.
+	g_AILODManager.OnSound( vecOrigin, iType, iVolume );
 }
 
 //=========================================================
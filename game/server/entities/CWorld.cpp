@@ -28,6 +28,7 @@ precaches and defs for entities and other data that must always be available.
 
 #include "client.h"
 #include "gamerules/GameRules.h"
+#include "CStudioBlending.h"
 
 #include "nodes/Nodes.h"
 #include "Decals.h"
@@ -96,8 +97,7 @@ void CWorld::OnDestroy()
 
 	BaseClass::OnDestroy();
 
-	//TODO: this might not be the best place to put the pool clear call - Solokiller
-	g_StringPool.Clear();
+	g_StudioBlending.ClearCache();
 }
 
 void CWorld::Spawn()
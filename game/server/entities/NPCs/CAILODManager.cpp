@@ -0,0 +1,294 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <cfloat>
+#include <cmath>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+#include "CBasePlayer.h"
+#include "entities/CSoundEnt.h"
+
+#include "Server.h"
+
+#include "CAILODManager.h"
+
+CAILODManager g_AILODManager;
+
+namespace
+{
+const char* const g_pszTierNames[] =
+{
+	"full",
+	"visible",
+	"near",
+	"dormant"
+};
+
+static_assert( ARRAYSIZE( g_pszTierNames ) == static_cast<size_t>( AILODTier::COUNT ), "AI LOD tier names out of sync" );
+
+/**
+*	@return Whether the monster must think and sense as often as it originally did.
+*/
+bool MustBeFullTier( const CBaseMonster& monster )
+{
+	if( gpGlobals->time < monster.m_flAILODPromoteTime )
+		return true;
+
+	//Fights continue outside of the PVS, scripts must stay in sync and dying monsters are animating.
+	return monster.m_pCine ||
+		monster.m_MonsterState == MONSTERSTATE_COMBAT ||
+		monster.m_MonsterState == MONSTERSTATE_SCRIPT ||
+		monster.m_MonsterState == MONSTERSTATE_DEAD;
+}
+}
+
+void CAILODManager::Update()
+{
+	m_ClientOrigins.clear();
+
+	if( !IsEnabled() )
+		return;
+
+	for( int iPlayer = 1; iPlayer <= gpGlobals->maxClients; ++iPlayer )
+	{
+		auto pPlayer = UTIL_PlayerByIndex( iPlayer );
+
+		if( pPlayer )
+			m_ClientOrigins.push_back( pPlayer->GetAbsOrigin() );
+	}
+}
+
+bool CAILODManager::IsEnabled() const
+{
+	return sv_ai_lod.value > 0;
+}
+
+float CAILODManager::GetThinkInterval( const AILODTier tier )
+{
+	switch( tier )
+	{
+	default:
+	case AILODTier::FULL:
+	case AILODTier::VISIBLE:	return 0.1f;
+	case AILODTier::NEAR:		return 0.2f;
+	case AILODTier::DORMANT:	return 0.5f;
+	}
+}
+
+float CAILODManager::Think( CBaseMonster& monster )
+{
+	const auto oldTier = monster.m_AILODTier;
+
+	if( !IsEnabled() )
+	{
+		monster.m_AILODTier = AILODTier::FULL;
+	}
+	else if( gpGlobals->time >= monster.m_flAILODUpdateTime ||
+		//Time went back, a save game was loaded.
+		monster.m_flAILODUpdateTime - gpGlobals->time > UPDATE_INTERVAL )
+	{
+		SetTier( monster, EvaluateTier( monster ) );
+		monster.m_flAILODUpdateTime = gpGlobals->time + UPDATE_INTERVAL;
+	}
+	else if( oldTier != AILODTier::FULL && MustBeFullTier( monster ) )
+	{
+		SetTier( monster, AILODTier::FULL );
+	}
+
+	const auto tier = monster.m_AILODTier;
+
+	++m_Stats[ static_cast<size_t>( tier ) ].uiThinks;
+
+	const float flInterval = GetThinkInterval( tier );
+
+	//Spread monsters that just moved to a slower tier over the interval so they don't all think in the same frame.
+	if( tier != oldTier && flInterval > GetThinkInterval( AILODTier::FULL ) )
+		return flInterval * ( 0.5f + GetPhase( monster ) );
+
+	return flInterval;
+}
+
+bool CAILODManager::ShouldSense( CBaseMonster& monster )
+{
+	//Monsters in the slower tiers are outside of the PVS, so they only sense if a client just showed up.
+	if( monster.m_AILODTier != AILODTier::VISIBLE )
+		return true;
+
+	if( gpGlobals->time >= monster.m_flAILODSenseTime ||
+		monster.m_flAILODSenseTime - gpGlobals->time > SENSE_INTERVAL )
+	{
+		monster.m_flAILODSenseTime = gpGlobals->time + SENSE_INTERVAL;
+		return true;
+	}
+
+	++m_Stats[ static_cast<size_t>( AILODTier::VISIBLE ) ].uiSensesSkipped;
+
+	return false;
+}
+
+void CAILODManager::Promote( CBaseMonster& monster )
+{
+	if( !IsEnabled() )
+		return;
+
+	monster.m_flAILODPromoteTime = gpGlobals->time + PROMOTE_TIME;
+
+	if( monster.m_AILODTier == AILODTier::FULL )
+		return;
+
+	++m_Stats[ static_cast<size_t>( monster.m_AILODTier ) ].uiPromotions;
+
+	SetTier( monster, AILODTier::FULL );
+
+	//Don't wait out the slower tier's interval.
+	if( monster.m_pfnThink == static_cast<BASEPTR>( &CBaseMonster::CallMonsterThink ) &&
+		monster.GetNextThink() > gpGlobals->time + GetThinkInterval( AILODTier::FULL ) )
+	{
+		monster.SetNextThink( gpGlobals->time );
+	}
+}
+
+void CAILODManager::OnSound( const Vector& vecOrigin, const int iType, const int iVolume )
+{
+	//Scents don't wake monsters up.
+	if( !IsEnabled() || iVolume <= 0 || !( iType & ( bits_SOUND_COMBAT | bits_SOUND_WORLD | bits_SOUND_PLAYER | bits_SOUND_DANGER ) ) )
+		return;
+
+	CBaseEntity* pList[ 64 ];
+
+	const int iCount = UTIL_MonstersInSphere( pList, ARRAYSIZE( pList ), vecOrigin, iVolume );
+
+	for( int iIndex = 0; iIndex < iCount; ++iIndex )
+	{
+		auto pMonster = pList[ iIndex ]->MyMonsterPointer();
+
+		if( !pMonster || pMonster->IsPlayer() || !pMonster->IsAlive() )
+			continue;
+
+		//Same test as Listen.
+		if( !( pMonster->ISoundMask() & iType ) ||
+			( vecOrigin - pMonster->EarPosition() ).Length() > iVolume * pMonster->HearingSensitivity() )
+			continue;
+
+		Promote( *pMonster );
+	}
+}
+
+void CAILODManager::ResetStats()
+{
+	for( auto& stats : m_Stats )
+	{
+		stats = TierStats();
+	}
+}
+
+AILODTier CAILODManager::EvaluateTier( CBaseMonster& monster ) const
+{
+	if( MustBeFullTier( monster ) )
+		return AILODTier::FULL;
+
+	const Vector vecOrigin = monster.GetAbsOrigin();
+
+	float flDistSqr = FLT_MAX;
+
+	for( const auto& vecClient : m_ClientOrigins )
+	{
+		const Vector vecDelta = vecClient - vecOrigin;
+
+		const float flClientDistSqr = DotProduct( vecDelta, vecDelta );
+
+		if( flClientDistSqr < flDistSqr )
+			flDistSqr = flClientDistSqr;
+	}
+
+	AILODTier tier;
+
+	if( UTIL_FindClientInPVS( &monster ) )
+	{
+		tier = flDistSqr <= sv_ai_lod_full_dist.value * sv_ai_lod_full_dist.value ? AILODTier::FULL : AILODTier::VISIBLE;
+	}
+	else
+	{
+		tier = flDistSqr <= sv_ai_lod_near_dist.value * sv_ai_lod_near_dist.value ? AILODTier::NEAR : AILODTier::DORMANT;
+
+		//Long steps make route following unreliable.
+		if( tier == AILODTier::DORMANT && !monster.MovementIsComplete() )
+			tier = AILODTier::NEAR;
+	}
+
+	return tier;
+}
+
+float CAILODManager::GetPhase( const CBaseMonster& monster )
+{
+	//Golden ratio sequence, neighbouring indices end up far apart.
+	const float flPhase = monster.entindex() * 0.618034f;
+
+	return flPhase - floor( flPhase );
+}
+
+void CAILODManager::SetTier( CBaseMonster& monster, const AILODTier tier )
+{
+	if( monster.m_AILODTier == tier )
+		return;
+
+	monster.m_AILODTier = tier;
+
+	if( tier == AILODTier::VISIBLE )
+		monster.m_flAILODSenseTime = gpGlobals->time + SENSE_INTERVAL * GetPhase( monster );
+}
+
+void ServerCommand_AILODStats()
+{
+	size_t uiMonsters[ static_cast<size_t>( AILODTier::COUNT ) ] = {};
+
+	edict_t* pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
+
+	if( pEdict )
+	{
+		for( int i = 1; i < gpGlobals->maxEntities; ++i, ++pEdict )
+		{
+			if( pEdict->free )
+				continue;
+
+			auto pEntity = CBaseEntity::Instance( pEdict );
+
+			if( !pEntity || pEntity->IsPlayer() )
+				continue;
+
+			auto pMonster = pEntity->MyMonsterPointer();
+
+			if( pMonster && pMonster->m_pfnThink == static_cast<BASEPTR>( &CBaseMonster::CallMonsterThink ) )
+				++uiMonsters[ static_cast<size_t>( pMonster->m_AILODTier ) ];
+		}
+	}
+
+	if( !g_AILODManager.IsEnabled() )
+		ALERT( at_console, "AI LOD is off, set sv_ai_lod to 1 to enable it\n" );
+
+	ALERT( at_console, "%-10s %10s %12s %14s %12s\n", "tier", "monsters", "thinks", "senses skipped", "promotions" );
+
+	for( size_t uiTier = 0; uiTier < static_cast<size_t>( AILODTier::COUNT ); ++uiTier )
+	{
+		const auto& stats = g_AILODManager.GetStats( static_cast<AILODTier>( uiTier ) );
+
+		ALERT( at_console, "%-10s %10u %12llu %14llu %12llu\n", g_pszTierNames[ uiTier ], static_cast<unsigned int>( uiMonsters[ uiTier ] ),
+			static_cast<unsigned long long>( stats.uiThinks ), static_cast<unsigned long long>( stats.uiSensesSkipped ),
+			static_cast<unsigned long long>( stats.uiPromotions ) );
+	}
+
+	g_AILODManager.ResetStats();
+}
@@ -0,0 +1,149 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_ENTITIES_NPCS_CAILODMANAGER_H
+#define GAME_SERVER_ENTITIES_NPCS_CAILODMANAGER_H
+
+#include <cstdint>
+#include <vector>
+
+class CBaseMonster;
+
+/**
+*	AI level of detail tiers, from most to least detailed.
+*/
+enum class AILODTier
+{
+	/**
+	*	Thinks every 0.1 seconds and senses on every think. Used for monsters close to a client, fighting, scripted or recently promoted.
+	*/
+	FULL = 0,
+
+	/**
+	*	In a client's PVS but far away. Thinks every 0.1 seconds so movement and animation stay smooth, but only senses every SENSE_INTERVAL seconds.
+	*/
+	VISIBLE,
+
+	/**
+	*	Outside of every client's PVS but within sv_ai_lod_near_dist of one. Thinks less often.
+	*/
+	NEAR,
+
+	/**
+	*	Outside of every client's PVS and far away from all of them. Thinks rarely.
+	*/
+	DORMANT,
+
+	COUNT
+};
+
+/**
+*	Decides how often monsters think and sense based on their distance and PVS relation to clients.
+*	Monsters are promoted to the full tier immediately when they take damage, hear a sound or start a scripted sequence, and stay there for PROMOTE_TIME seconds.
+*	When a monster changes tier its next think is offset by a phase derived from its entity index, so monsters in the same tier don't all think in the same frame.
+*	Controlled by sv_ai_lod: 0, the default, runs every monster at the full tier.
+*/
+class CAILODManager final
+{
+public:
+	/**
+	*	How long a promoted monster stays in the full tier, in seconds.
+	*/
+	static constexpr float PROMOTE_TIME = 5;
+
+	/**
+	*	How often a monster's tier is re-evaluated, in seconds. Monsters that must be in the full tier are moved there on their next think.
+	*/
+	static constexpr float UPDATE_INTERVAL = 0.3f;
+
+	/**
+	*	How often monsters in the visible tier look and listen, in seconds.
+	*/
+	static constexpr float SENSE_INTERVAL = 0.3f;
+
+	struct TierStats
+	{
+		uint64_t uiThinks = 0;
+		uint64_t uiSensesSkipped = 0;
+		uint64_t uiPromotions = 0;
+	};
+
+public:
+	CAILODManager() = default;
+
+	/**
+	*	Caches client positions. Should be called once per frame before entities think.
+	*/
+	void Update();
+
+	bool IsEnabled() const;
+
+	/**
+	*	@return Interval between thinks for the given tier, in seconds.
+	*/
+	static float GetThinkInterval( const AILODTier tier );
+
+	/**
+	*	Re-evaluates the monster's tier if needed and counts the think.
+	*	@return How long until the monster should think again, in seconds.
+	*/
+	float Think( CBaseMonster& monster );
+
+	/**
+	*	@return Whether the monster should look and listen on this think.
+	*/
+	bool ShouldSense( CBaseMonster& monster );
+
+	/**
+	*	Moves the monster to the full tier and makes it think on the next frame if it was thinking less often.
+	*/
+	void Promote( CBaseMonster& monster );
+
+	/**
+	*	Promotes all monsters that can hear the given sound.
+	*/
+	void OnSound( const Vector& vecOrigin, const int iType, const int iVolume );
+
+	const TierStats& GetStats( const AILODTier tier ) const { return m_Stats[ static_cast<size_t>( tier ) ]; }
+
+	void ResetStats();
+
+private:
+	AILODTier EvaluateTier( CBaseMonster& monster ) const;
+
+	/**
+	*	@return Fraction in [ 0, 1 [ used to spread thinks for the monster.
+	*/
+	static float GetPhase( const CBaseMonster& monster );
+
+	void SetTier( CBaseMonster& monster, const AILODTier tier );
+
+private:
+	std::vector<Vector> m_ClientOrigins;
+
+	TierStats m_Stats[ static_cast<size_t>( AILODTier::COUNT ) ];
+
+private:
+	CAILODManager( const CAILODManager& ) = delete;
+	CAILODManager& operator=( const CAILODManager& ) = delete;
+};
+
+extern CAILODManager g_AILODManager;
+
+/**
+*	Prints the number of monsters in each AI LOD tier, and the thinks, skipped senses and promotions in each tier since the last time this was used, and resets the counters.
+*/
+void ServerCommand_AILODStats();
+
+#endif //GAME_SERVER_ENTITIES_NPCS_CAILODMANAGER_H
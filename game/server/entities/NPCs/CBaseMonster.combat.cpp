@@ -439,6 +439,9 @@ void CBaseMonster::OnTakeDamage( const CTakeDamageInfo& info )
 		return;
 	}
 
+	// react at full rate, even if no client is nearby.
+	g_AILODManager.Promote( *this );
+
 	if ( GetDeadFlag() == DEAD_NO )
 	{
 		// no pain sound during death animation.
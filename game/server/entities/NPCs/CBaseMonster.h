@@ -16,6 +16,7 @@
 #define GAME_SERVER_ENTITIES_NPCS_BASEMONSTER_H
 
 #include "Monsters.h"
+#include "CAILODManager.h"
 
 #define	ROUTE_SIZE			8 // how many waypoints a monster can store at one time
 #define MAX_OLD_ENEMIES		4 // how many old enemies to remember
@@ -530,6 +531,12 @@ public:
 	void UpdateShockEffect();
 
 	//Shock effect end. - Solokiller
+
+	//AI level of detail. Not saved; the tier is re-evaluated on the first think after a restore.
+	AILODTier m_AILODTier = AILODTier::FULL;
+	float m_flAILODUpdateTime = 0;	// when the tier should be re-evaluated
+	float m_flAILODPromoteTime = 0;	// stay in the full tier until this time
+	float m_flAILODSenseTime = 0;	// next time the monster looks and listens in the visible tier
 };
 
 #endif //GAME_SERVER_ENTITIES_NPCS_BASEMONSTER_H
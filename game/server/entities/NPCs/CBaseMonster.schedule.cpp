@@ -24,6 +24,7 @@
 #include "entities/NPCs/scripted/Scripted.h"
 #include "nodes/Nodes.h"
 #include "entities/NPCs/DefaultAI.h"
+#include "entities/NPCs/CScheduleTable.h"
 #include "entities/CSoundEnt.h"
 
 extern CGraph WorldGraph;
@@ -94,7 +95,7 @@ void CBaseMonster :: ChangeSchedule ( Schedule_t *pNewSchedule )
 	}
 
 #if _DEBUG
-	if ( !ScheduleFromName( pNewSchedule->pName ) )
+	if ( !CScheduleTable::Get( *GetSchedulesList() ).Contains( pNewSchedule ) )
 	{
 		ALERT( at_console, "Schedule %s not in table!!!\n", pNewSchedule->pName );
 	}
@@ -81,7 +81,8 @@ void CBaseMonster :: RunAI ( void )
 		// things will happen before the player gets there!
 		// UPDATE: We now let COMBAT state monsters think and act fully outside of player PVS. This allows the player to leave 
 		// an area where monsters are fighting, and the fight will continue.
-		if ( UTIL_FindClientInPVS( this ) || ( m_MonsterState == MONSTERSTATE_COMBAT ) )
+		// Monsters that are far away from clients sense less often, see CAILODManager.
+		if ( g_AILODManager.ShouldSense( *this ) && ( UTIL_FindClientInPVS( this ) || ( m_MonsterState == MONSTERSTATE_COMBAT ) ) )
 		{
 			Look( m_flDistLook );
 			Listen();// check for audible sounds. 
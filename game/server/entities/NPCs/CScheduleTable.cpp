@@ -0,0 +1,86 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <algorithm>
+#include <memory>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+#include "entities/NPCs/Monsters.h"
+#include "entities/NPCs/Schedule.h"
+
+#include "CScheduleTable.h"
+
+const CScheduleTable& CScheduleTable::Get( const Schedules_t& schedules )
+{
+	if( !schedules.pTable )
+	{
+		//Tables live as long as the schedules they index.
+		static std::vector<std::unique_ptr<CScheduleTable>> tables;
+
+		tables.emplace_back( std::make_unique<CScheduleTable>( schedules ) );
+
+		schedules.pTable = tables.back().get();
+	}
+
+	return *schedules.pTable;
+}
+
+CScheduleTable::CScheduleTable( const Schedules_t& schedules )
+{
+	for( auto pList = &schedules; pList; pList = pList->pBaseList )
+	{
+		for( size_t uiIndex = 0; uiIndex < pList->uiNumSchedules; ++uiIndex )
+		{
+			const auto pSchedule = pList->ppSchedules[ uiIndex ];
+
+			if( !pSchedule->pName )
+			{
+				ALERT( at_console, "Unnamed schedule!\n" );
+				continue;
+			}
+
+			const int iID = static_cast<int>( m_Schedules.size() );
+
+			m_Schedules.emplace_back( pSchedule );
+			m_IDs.emplace_back( pSchedule, iID );
+
+			//Keeps the first schedule with a given name, like the linear search did.
+			m_Names.emplace( pSchedule->pName, iID );
+		}
+	}
+
+	std::sort( m_IDs.begin(), m_IDs.end() );
+}
+
+int CScheduleTable::GetScheduleID( const Schedule_t* pSchedule ) const
+{
+	auto it = std::lower_bound( m_IDs.begin(), m_IDs.end(), std::make_pair( pSchedule, INVALID_ID ) );
+
+	if( it == m_IDs.end() || it->first != pSchedule )
+		return INVALID_ID;
+
+	return it->second;
+}
+
+const Schedule_t* CScheduleTable::FindByName( const char* const pszName ) const
+{
+	auto it = m_Names.find( pszName );
+
+	if( it == m_Names.end() )
+		return nullptr;
+
+	return m_Schedules[ it->second ];
+}
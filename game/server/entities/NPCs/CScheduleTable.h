@@ -0,0 +1,88 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_ENTITIES_NPCS_CSCHEDULETABLE_H
+#define GAME_SERVER_ENTITIES_NPCS_CSCHEDULETABLE_H
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "StringUtils.h"
+
+struct Schedule_t;
+struct Schedules_t;
+
+/**
+*	Flattened view of a monster class's schedule list and all of its base lists.
+*	Schedules are numbered in lookup order: the class's own schedules first, then its base class's, and so on.
+*	Built the first time a class's schedules are looked up, after all schedule lists have been initialized.
+*/
+class CScheduleTable final
+{
+public:
+	static const int INVALID_ID = -1;
+
+public:
+	/**
+	*	@return The table for the given list. Created on first use.
+	*/
+	static const CScheduleTable& Get( const Schedules_t& schedules );
+
+	explicit CScheduleTable( const Schedules_t& schedules );
+
+	size_t GetCount() const { return m_Schedules.size(); }
+
+	/**
+	*	@return The schedule with the given ID, or null if the ID is out of range.
+	*/
+	const Schedule_t* GetScheduleByID( const int iID ) const
+	{
+		return iID >= 0 && static_cast<size_t>( iID ) < m_Schedules.size() ? m_Schedules[ iID ] : nullptr;
+	}
+
+	/**
+	*	@return The ID of the given schedule, or INVALID_ID if it isn't in this table.
+	*/
+	int GetScheduleID( const Schedule_t* pSchedule ) const;
+
+	bool Contains( const Schedule_t* pSchedule ) const
+	{
+		return GetScheduleID( pSchedule ) != INVALID_ID;
+	}
+
+	/**
+	*	Finds a schedule by name, case insensitively. If several schedules share a name, the first in lookup order is returned.
+	*/
+	const Schedule_t* FindByName( const char* const pszName ) const;
+
+private:
+	std::vector<const Schedule_t*> m_Schedules;
+
+	/**
+	*	Schedules sorted by address, with their IDs.
+	*/
+	std::vector<std::pair<const Schedule_t*, int>> m_IDs;
+
+	/**
+	*	Points to the names in the schedules themselves.
+	*/
+	std::unordered_map<const char*, int, RawCharHashI, RawCharEqualToI> m_Names;
+
+private:
+	CScheduleTable( const CScheduleTable& ) = delete;
+	CScheduleTable& operator=( const CScheduleTable& ) = delete;
+};
+
+#endif //GAME_SERVER_ENTITIES_NPCS_CSCHEDULETABLE_H
@@ -21,6 +21,7 @@
 #include	"entities/NPCs/Monsters.h"
 #include	"entities/NPCs/Schedule.h"
 #include	"DefaultAI.h"
+#include	"CScheduleTable.h"
 #include	"entities/CSoundEnt.h"
 #include	"nodes/Nodes.h"
 #include	"entities/NPCs/scripted/Scripted.h"
@@ -1021,17 +1022,13 @@ END_SCHEDULES()
 
 const Schedule_t* CBaseMonster::ScheduleFromName( const char* const pszName ) const
 {
-	const Schedules_t* pSchedules = GetSchedulesList();
-
-	while( pSchedules )
+	if ( !pszName )
 	{
-		if( const Schedule_t* pSchedule = ScheduleInList( pszName, pSchedules->ppSchedules, pSchedules->uiNumSchedules ) )
-			return pSchedule;
-
-		pSchedules = pSchedules->pBaseList;
+		ALERT( at_console, "%s set to unnamed schedule!\n", GetClassname() );
+		return nullptr;
 	}
 
-	return nullptr;
+	return CScheduleTable::Get( *GetSchedulesList() ).FindByName( pszName );
 }
 
 
@@ -447,7 +447,7 @@ CSound* CBaseMonster :: PBestScent ( void )
 //=========================================================
 void CBaseMonster :: MonsterThink ( void )
 {
-	SetNextThink( gpGlobals->time + 0.1 );// keep monster thinking.
+	SetNextThink( gpGlobals->time + g_AILODManager.Think( *this ) );// keep monster thinking.
 
 
 	RunAI();
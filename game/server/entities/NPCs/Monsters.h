@@ -27,6 +27,7 @@
 */
 
 struct Schedule_t;
+class CScheduleTable;
 
 // CHECKLOCALMOVE result types 
 enum LocalMove
@@ -356,6 +357,12 @@ struct Schedules_t
 	const Schedule_t* const* ppSchedules;
 
 	size_t uiNumSchedules;
+
+	/**
+	*	Lookup table over this list and its base lists, created on first use.
+	*	@see CScheduleTable::Get
+	*/
+	mutable const CScheduleTable* pTable;
 };
 
 /**
@@ -371,6 +371,8 @@ void CCineMonster::PossessEntity( void )
 		pTarget->m_pCine = this;
 		pTarget->m_hTargetEnt = this;
 
+		g_AILODManager.Promote( *pTarget );
+
 		m_saved_movetype = pTarget->GetMoveType();
 		m_saved_solid = pTarget->GetSolidType();
 		m_saved_effects = pTarget->GetEffects();
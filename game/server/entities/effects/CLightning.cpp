@@ -10,18 +10,18 @@
 
 BEGIN_DATADESC( CLightning )
 	DEFINE_FIELD( m_active, FIELD_BOOLEAN ),
-	DEFINE_FIELD( m_iszStartEntity, FIELD_STRING ),
-	DEFINE_FIELD( m_iszEndEntity, FIELD_STRING ),
-	DEFINE_FIELD( m_life, FIELD_FLOAT ),
-	DEFINE_FIELD( m_boltWidth, FIELD_INTEGER ),
-	DEFINE_FIELD( m_noiseAmplitude, FIELD_INTEGER ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iszStartEntity, FIELD_STRING, "LightningStart" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iszEndEntity, FIELD_STRING, "LightningEnd" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_life, FIELD_FLOAT, "life" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_boltWidth, FIELD_INTEGER, "BoltWidth" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_noiseAmplitude, FIELD_INTEGER, "NoiseAmplitude" ),
 	DEFINE_FIELD( m_brightness, FIELD_INTEGER ),
-	DEFINE_FIELD( m_speed, FIELD_INTEGER ),
-	DEFINE_FIELD( m_restrike, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_speed, FIELD_INTEGER, "TextureScroll" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_restrike, FIELD_FLOAT, "StrikeTime" ),
 	DEFINE_FIELD( m_spriteTexture, FIELD_INTEGER ),
-	DEFINE_FIELD( m_iszSpriteName, FIELD_STRING ),
-	DEFINE_FIELD( m_frameStart, FIELD_INTEGER ),
-	DEFINE_FIELD( m_radius, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iszSpriteName, FIELD_STRING, "texture" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_frameStart, FIELD_INTEGER, "framestart" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_radius, FIELD_FLOAT, "Radius" ),
 	DEFINE_THINKFUNC( StrikeThink ),
 	DEFINE_THINKFUNC( DamageThink ),
 	DEFINE_USEFUNC( StrikeUse ),
@@ -88,57 +88,7 @@ void CLightning::Precache( void )
 
 void CLightning::KeyValue( KeyValueData *pkvd )
 {
-	if( FStrEq( pkvd->szKeyName, "LightningStart" ) )
-	{
-		m_iszStartEntity = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "LightningEnd" ) )
-	{
-		m_iszEndEntity = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "life" ) )
-	{
-		m_life = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "BoltWidth" ) )
-	{
-		m_boltWidth = atoi( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "NoiseAmplitude" ) )
-	{
-		m_noiseAmplitude = atoi( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "TextureScroll" ) )
-	{
-		m_speed = atoi( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "StrikeTime" ) )
-	{
-		m_restrike = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "texture" ) )
-	{
-		m_iszSpriteName = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "framestart" ) )
-	{
-		m_frameStart = atoi( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "Radius" ) )
-	{
-		m_radius = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "damage" ) )
+	if( FStrEq( pkvd->szKeyName, "damage" ) )
 	{
 		SetDamage( atof( pkvd->szValue ) );
 		pkvd->fHandled = true;
@@ -45,7 +45,7 @@ void CPathTrack::KeyValue( KeyValueData *pkvd )
 {
 	if( FStrEq( pkvd->szKeyName, "altpath" ) )
 	{
-		m_altName = ALLOC_STRING( pkvd->szValue );
+		m_altName = POOL_STRING( pkvd->szValue );
 		pkvd->fHandled = true;
 	}
 	else
@@ -55,7 +55,7 @@ void CPathTrack::KeyValue( KeyValueData *pkvd )
 void CPathTrack::SetPrevious( CPathTrack *pprev )
 {
 	// Only set previous if this isn't my alternate path
-	if( pprev && !FStrEq( pprev->GetTargetname(), STRING( m_altName ) ) )
+	if( pprev && !FStringsEqual( pprev->pev->targetname, m_altName ) )
 		m_pprevious = pprev;
 }
 
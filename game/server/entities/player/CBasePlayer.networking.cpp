@@ -309,4 +309,15 @@ void CBasePlayer::SendWeatherUpdate()
 			WRITE_BYTE( type );
 		MESSAGE_END();
 	}
-}
\ No newline at end of file
+}
+
+int CBasePlayer::GetWeaponModelIndex()
+{
+	if( m_iCachedWeaponModelIndex == -1 || m_iszCachedWeaponModel != static_cast<string_t>( pev->weaponmodel ) )
+	{
+		m_iszCachedWeaponModel = pev->weaponmodel;
+		m_iCachedWeaponModelIndex = MODEL_INDEX( GetWeaponModelName() );
+	}
+
+	return m_iCachedWeaponModelIndex;
+}
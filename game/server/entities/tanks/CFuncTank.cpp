@@ -9,31 +9,31 @@
 
 BEGIN_DATADESC( CFuncTank )
 	DEFINE_FIELD( m_yawCenter, FIELD_FLOAT ),
-	DEFINE_FIELD( m_yawRate, FIELD_FLOAT ),
-	DEFINE_FIELD( m_yawRange, FIELD_FLOAT ),
-	DEFINE_FIELD( m_yawTolerance, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_yawRate, FIELD_FLOAT, "yawrate" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_yawRange, FIELD_FLOAT, "yawrange" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_yawTolerance, FIELD_FLOAT, "yawtolerance" ),
 	DEFINE_FIELD( m_pitchCenter, FIELD_FLOAT ),
-	DEFINE_FIELD( m_pitchRate, FIELD_FLOAT ),
-	DEFINE_FIELD( m_pitchRange, FIELD_FLOAT ),
-	DEFINE_FIELD( m_pitchTolerance, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_pitchRate, FIELD_FLOAT, "pitchrate" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_pitchRange, FIELD_FLOAT, "pitchrange" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_pitchTolerance, FIELD_FLOAT, "pitchtolerance" ),
 	DEFINE_FIELD( m_fireLast, FIELD_TIME ),
-	DEFINE_FIELD( m_fireRate, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_fireRate, FIELD_FLOAT, "firerate" ),
 	DEFINE_FIELD( m_lastSightTime, FIELD_TIME ),
-	DEFINE_FIELD( m_persist, FIELD_FLOAT ),
-	DEFINE_FIELD( m_minRange, FIELD_FLOAT ),
-	DEFINE_FIELD( m_maxRange, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_persist, FIELD_FLOAT, "persistence" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_minRange, FIELD_FLOAT, "minRange" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_maxRange, FIELD_FLOAT, "maxRange" ),
 	DEFINE_FIELD( m_barrelPos, FIELD_VECTOR ),
-	DEFINE_FIELD( m_spriteScale, FIELD_FLOAT ),
-	DEFINE_FIELD( m_iszSpriteSmoke, FIELD_STRING ),
-	DEFINE_FIELD( m_iszSpriteFlash, FIELD_STRING ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_spriteScale, FIELD_FLOAT, "spritescale" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iszSpriteSmoke, FIELD_STRING, "spritesmoke" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iszSpriteFlash, FIELD_STRING, "spriteflash" ),
 	DEFINE_FIELD( m_bulletType, FIELD_INTEGER ),
 	DEFINE_FIELD( m_sightOrigin, FIELD_VECTOR ),
-	DEFINE_FIELD( m_spread, FIELD_INTEGER ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_spread, FIELD_INTEGER, "firespread" ),
 	DEFINE_FIELD( m_pController, FIELD_CLASSPTR ),
 	DEFINE_FIELD( m_vecControllerUsePos, FIELD_VECTOR ),
 	DEFINE_FIELD( m_flNextAttack, FIELD_TIME ),
-	DEFINE_FIELD( m_iBulletDamage, FIELD_INTEGER ),
-	DEFINE_FIELD( m_iszMaster, FIELD_STRING ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iBulletDamage, FIELD_INTEGER, "bullet_damage" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_iszMaster, FIELD_STRING, "master" ),
 END_DATADESC()
 
 const Vector gTankSpread[] =
@@ -85,42 +85,7 @@ void CFuncTank::Precache( void )
 
 void CFuncTank::KeyValue( KeyValueData *pkvd )
 {
-	if( FStrEq( pkvd->szKeyName, "yawrate" ) )
-	{
-		m_yawRate = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "yawrange" ) )
-	{
-		m_yawRange = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "yawtolerance" ) )
-	{
-		m_yawTolerance = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "pitchrange" ) )
-	{
-		m_pitchRange = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "pitchrate" ) )
-	{
-		m_pitchRate = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "pitchtolerance" ) )
-	{
-		m_pitchTolerance = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "firerate" ) )
-	{
-		m_fireRate = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "barrel" ) )
+	if( FStrEq( pkvd->szKeyName, "barrel" ) )
 	{
 		m_barrelPos.x = atof( pkvd->szValue );
 		pkvd->fHandled = true;
@@ -135,61 +100,16 @@ void CFuncTank::KeyValue( KeyValueData *pkvd )
 		m_barrelPos.z = atof( pkvd->szValue );
 		pkvd->fHandled = true;
 	}
-	else if( FStrEq( pkvd->szKeyName, "spritescale" ) )
-	{
-		m_spriteScale = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "spritesmoke" ) )
-	{
-		m_iszSpriteSmoke = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "spriteflash" ) )
-	{
-		m_iszSpriteFlash = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
 	else if( FStrEq( pkvd->szKeyName, "rotatesound" ) )
 	{
 		pev->noise = ALLOC_STRING( pkvd->szValue );
 		pkvd->fHandled = true;
 	}
-	else if( FStrEq( pkvd->szKeyName, "persistence" ) )
-	{
-		m_persist = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
 	else if( FStrEq( pkvd->szKeyName, "bullet" ) )
 	{
 		m_bulletType = ( TANKBULLET ) atoi( pkvd->szValue );
 		pkvd->fHandled = true;
 	}
-	else if( FStrEq( pkvd->szKeyName, "bullet_damage" ) )
-	{
-		m_iBulletDamage = atoi( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "firespread" ) )
-	{
-		m_spread = atoi( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "minRange" ) )
-	{
-		m_minRange = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "maxRange" ) )
-	{
-		m_maxRange = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "master" ) )
-	{
-		m_iszMaster = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
 	else
 		CBaseEntity::KeyValue( pkvd );
 }
@@ -24,8 +24,8 @@ int BuildChangeList( LEVELLIST *pLevelList, int maxList )
 BEGIN_DATADESC( CChangeLevel )
 	DEFINE_ARRAY( m_szMapName, FIELD_CHARACTER, cchMapNameMost ),
 	DEFINE_ARRAY( m_szLandmarkName, FIELD_CHARACTER, cchMapNameMost ),
-	DEFINE_FIELD( m_changeTarget, FIELD_STRING ),
-	DEFINE_FIELD( m_changeTargetDelay, FIELD_FLOAT ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_changeTarget, FIELD_STRING, "changetarget" ),
+	DEFINE_CASE_SENSITIVE_KEYFIELD( m_changeTargetDelay, FIELD_FLOAT, "changedelay" ),
 
 	DEFINE_USEFUNC( UseChangeLevel ),
 	DEFINE_THINKFUNC( ExecuteChangeLevel ),
@@ -71,16 +71,6 @@ void CChangeLevel::KeyValue( KeyValueData *pkvd )
 		strcpy( m_szLandmarkName, pkvd->szValue );
 		pkvd->fHandled = true;
 	}
-	else if( FStrEq( pkvd->szKeyName, "changetarget" ) )
-	{
-		m_changeTarget = ALLOC_STRING( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
-	else if( FStrEq( pkvd->szKeyName, "changedelay" ) )
-	{
-		m_changeTargetDelay = atof( pkvd->szValue );
-		pkvd->fHandled = true;
-	}
 	else
 		CBaseTrigger::KeyValue( pkvd );
 }
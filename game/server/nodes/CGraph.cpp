@@ -21,9 +21,12 @@
 #include "cbase.h"
 #include "entities/NPCs/Monsters.h"
 #include "CGraph.h"
+#include "CNearestNodeIndex.h"
 #include "animation.h"
 #include "entities/DoorConstants.h"
 #include "CQueuePriority.h"
+#include "CRoutingTableBuilder.h"
+#include "Server.h"
 
 #if !defined ( _WIN32 )
 #include <sys/stat.h>
@@ -94,6 +97,8 @@ void CGraph :: InitGraph( void)
 
 	m_iLastActiveIdleSearch = 0;
 	m_iLastCoverSearch = 0;
+
+	g_NearestNodeIndex.Clear();
 }
 	
 //=========================================================
@@ -768,29 +773,6 @@ int CGraph :: FindShortestPath ( int *piPath, int iStart, int iDest, int iHull,
 	return iNumPathNodes;
 }
 
-inline CRC32_t Hash(void *p, int len)
-{
-	CRC32_t ulCrc;
-	CRC32_INIT(&ulCrc);
-	CRC32_PROCESS_BUFFER(&ulCrc, p, len);
-	return CRC32_FINAL(ulCrc);
-}
-
-void inline CalcBounds(int &Lower, int &Upper, int Goal, int Best)
-{
-    int Temp = 2*Goal - Best;
-    if (Best > Goal)
-    {
-        Lower = max(0, Temp);
-        Upper = Best;
-    }
-    else
-    {
-        Upper = min(255, Temp);
-        Lower = Best;
-    }
-}
-
 // Convert from [-8192,8192] to [0, 255]
 //
 inline int CALC_RANGE(int x, int lower, int upper)
@@ -799,52 +781,6 @@ inline int CALC_RANGE(int x, int lower, int upper)
 }
 
 
-void inline UpdateRange(int &minValue, int &maxValue, int Goal, int Best)
-{
-    int Lower, Upper;
-    CalcBounds(Lower, Upper, Goal, Best);
-    if (Upper < maxValue) maxValue = Upper;
-    if (minValue < Lower) minValue = Lower;
-}
-
-void CGraph :: CheckNode(Vector vecOrigin, int iNode)
-{
-    // Have we already seen this point before?.
-    //
-    if (m_di[iNode].m_CheckedEvent == m_CheckedCounter) return;
-    m_di[iNode].m_CheckedEvent = m_CheckedCounter;
-
-	float flDist = ( vecOrigin - m_pNodes[ iNode ].m_vecOriginPeek ).Length();
-
-	if ( flDist < m_flShortest )
-	{
-		TraceResult tr;
-
-		// make sure that vecOrigin can trace to this node!
-		UTIL_TraceLine ( vecOrigin, m_pNodes[ iNode ].m_vecOriginPeek, ignore_monsters, 0, &tr );
-
-		if ( tr.flFraction == 1.0 )
-		{
-			m_iNearest = iNode;
-			m_flShortest = flDist;
-
-			UpdateRange(m_minX, m_maxX, CALC_RANGE(vecOrigin.x, m_RegionMin[0], m_RegionMax[0]), m_pNodes[iNode].m_Region[0]);
-			UpdateRange(m_minY, m_maxY, CALC_RANGE(vecOrigin.y, m_RegionMin[1], m_RegionMax[1]), m_pNodes[iNode].m_Region[1]);
-			UpdateRange(m_minZ, m_maxZ, CALC_RANGE(vecOrigin.z, m_RegionMin[2], m_RegionMax[2]), m_pNodes[iNode].m_Region[2]);
-
-			// From maxCircle, calculate maximum bounds box. All points must be
-			// simultaneously inside all bounds of the box.
-			//
-			m_minBoxX = CALC_RANGE(vecOrigin.x - flDist, m_RegionMin[0], m_RegionMax[0]);
-			m_maxBoxX = CALC_RANGE(vecOrigin.x + flDist, m_RegionMin[0], m_RegionMax[0]);
-			m_minBoxY = CALC_RANGE(vecOrigin.y - flDist, m_RegionMin[1], m_RegionMax[1]);
-			m_maxBoxY = CALC_RANGE(vecOrigin.y + flDist, m_RegionMin[1], m_RegionMax[1]);
-			m_minBoxZ = CALC_RANGE(vecOrigin.z - flDist, m_RegionMin[2], m_RegionMax[2]);
-			m_maxBoxZ = CALC_RANGE(vecOrigin.z + flDist, m_RegionMin[2], m_RegionMax[2]);
-		}
-	}
-}
-
 //=========================================================
 // CGraph - FindNearestNode - returns the index of the node nearest
 // the given vector -1 is failure (couldn't find a valid
@@ -857,211 +793,18 @@ int	CGraph :: FindNearestNode ( const Vector &vecOrigin,  const CBaseEntity* con
 
 int	CGraph :: FindNearestNode ( const Vector &vecOrigin,  int afNodeTypes )
 {
-	TraceResult tr;
-
 	if ( !m_fGraphPresent || !m_fGraphPointersSet )
 	{// protect us in the case that the node graph isn't available
 		ALERT ( at_aiconsole, "Graph not ready!\n" );
 		return -1;
 	}
 
-	// Check with the cache
-	//
-	CRC32_t iHash = ( NODE_CACHE_SIZE -1) & Hash((void *)(const float *)vecOrigin, sizeof(vecOrigin));
-	if (m_Cache[iHash].v == vecOrigin)
+	if ( !g_NearestNodeIndex.IsBuilt() )
 	{
-		//ALERT(at_aiconsole, "Cache Hit.\n");
-		return m_Cache[iHash].n;
-	}
-	else
-	{
-		//ALERT(at_aiconsole, "Cache Miss.\n");
-	}
-
-	// Mark all points as unchecked.
-	//
-	m_CheckedCounter++;
-	if (m_CheckedCounter == 0)
-	{
-		for (int i = 0; i < m_cNodes; i++)
-		{
-			m_di[i].m_CheckedEvent = 0;
-		}
-		m_CheckedCounter++;
+		g_NearestNodeIndex.Build( m_pNodes, m_cNodes );
 	}
 
-	m_iNearest = -1;
-	m_flShortest = 999999.0; // just a big number.
-
-	// If we can find a visible point, then let CalcBounds set the limits, but if
-	// we have no visible point at all to start with, then don't restrict the limits.
-	//
-#if 1
-	m_minX = 0; m_maxX = 255;
-	m_minY = 0; m_maxY = 255;
-	m_minZ = 0; m_maxZ = 255;
-	m_minBoxX = 0; m_maxBoxX = 255;
-	m_minBoxY = 0; m_maxBoxY = 255;
-	m_minBoxZ = 0; m_maxBoxZ = 255;
-#else
-	m_minBoxX = CALC_RANGE(vecOrigin.x - flDist, m_RegionMin[0], m_RegionMax[0]);
-	m_maxBoxX = CALC_RANGE(vecOrigin.x + flDist, m_RegionMin[0], m_RegionMax[0]);
-	m_minBoxY = CALC_RANGE(vecOrigin.y - flDist, m_RegionMin[1], m_RegionMax[1]);
-	m_maxBoxY = CALC_RANGE(vecOrigin.y + flDist, m_RegionMin[1], m_RegionMax[1]);
-	m_minBoxZ = CALC_RANGE(vecOrigin.z - flDist, m_RegionMin[2], m_RegionMax[2]);
-	m_maxBoxZ = CALC_RANGE(vecOrigin.z + flDist, m_RegionMin[2], m_RegionMax[2])
-    CalcBounds(m_minX, m_maxX, CALC_RANGE(vecOrigin.x, m_RegionMin[0], m_RegionMax[0]), m_pNodes[m_iNearest].m_Region[0]);
-    CalcBounds(m_minY, m_maxY, CALC_RANGE(vecOrigin.y, m_RegionMin[1], m_RegionMax[1]), m_pNodes[m_iNearest].m_Region[1]);
-    CalcBounds(m_minZ, m_maxZ, CALC_RANGE(vecOrigin.z, m_RegionMin[2], m_RegionMax[2]), m_pNodes[m_iNearest].m_Region[2]);
-#endif
-
-    int halfX = (m_minX+m_maxX)/2;
-    int halfY = (m_minY+m_maxY)/2;
-    int halfZ = (m_minZ+m_maxZ)/2;
-
-    int j;
-
-    for (int i = halfX; i >= m_minX; i--)
-    {
-        for (j = m_RangeStart[0][i]; j <= m_RangeEnd[0][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[0]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgY = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[1];
-			if (rgY > m_maxBoxY) break;
-            if (rgY < m_minBoxY) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[2];
-            if (rgZ < m_minBoxZ) continue;
-            if (rgZ > m_maxBoxZ) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[0]);
-        }
-    }
-
-    for (int i = max(m_minY,halfY+1); i <= m_maxY; i++)
-    {
-        for (j = m_RangeStart[1][i]; j <= m_RangeEnd[1][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[1]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[2];
-            if (rgZ > m_maxBoxZ) break;
-            if (rgZ < m_minBoxZ) continue;
-			int rgX = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[0];
-            if (rgX < m_minBoxX) continue;
-            if (rgX > m_maxBoxX) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[1]);
-        }
-    }
-
-    for (int i = min(m_maxZ,halfZ); i >= m_minZ; i--)
-    {
-        for (j = m_RangeStart[2][i]; j <= m_RangeEnd[2][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[2]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgX = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[0];
-            if (rgX > m_maxBoxX) break;
-            if (rgX < m_minBoxX) continue;
-			int rgY = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[1];
-            if (rgY < m_minBoxY) continue;
-			if (rgY > m_maxBoxY) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[2]);
-        }
-    }
-
-    for (int i = max(m_minX,halfX+1); i <= m_maxX; i++)
-    {
-        for (j = m_RangeStart[0][i]; j <= m_RangeEnd[0][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[0]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgY = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[1];
-			if (rgY > m_maxBoxY) break;
-            if (rgY < m_minBoxY) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[2];
-            if (rgZ < m_minBoxZ) continue;
-            if (rgZ > m_maxBoxZ) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[0]);
-        }
-    }
-
-    for (int i = min(m_maxY,halfY); i >= m_minY; i--)
-    {
-        for (j = m_RangeStart[1][i]; j <= m_RangeEnd[1][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[1]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[2];
-            if (rgZ > m_maxBoxZ) break;
-            if (rgZ < m_minBoxZ) continue;
-			int rgX = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[0];
-            if (rgX < m_minBoxX) continue;
-            if (rgX > m_maxBoxX) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[1]);
-        }
-    }
-
-    for (int i = max(m_minZ,halfZ+1); i <= m_maxZ; i++)
-    {
-        for (j = m_RangeStart[2][i]; j <= m_RangeEnd[2][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[2]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgX = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[0];
-            if (rgX > m_maxBoxX) break;
-            if (rgX < m_minBoxX) continue;
-			int rgY = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[1];
-            if (rgY < m_minBoxY) continue;
-			if (rgY > m_maxBoxY) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[2]);
-        }
-    }
-
-#if 0
-	// Verify our answers.
-	//
-	int iNearestCheck = -1;
-	m_flShortest = 8192;// find nodes within this radius
-
-	for ( int i = 0 ; i < m_cNodes ; i++ )
-	{
-		float flDist = ( vecOrigin - m_pNodes[ i ].m_vecOriginPeek ).Length();
-
-		if ( flDist < m_flShortest )
-		{
-			// make sure that vecOrigin can trace to this node!
-			UTIL_TraceLine ( vecOrigin, m_pNodes[ i ].m_vecOriginPeek, ignore_monsters, 0, &tr );
-
-			if ( tr.flFraction == 1.0 )
-			{
-				iNearestCheck = i;
-				m_flShortest = flDist;
-			}
-		}
-	}
-
-	if (iNearestCheck != m_iNearest)
-	{
-		ALERT( at_aiconsole, "NOT closest %d(%f,%f,%f) %d(%f,%f,%f).\n",
-			iNearestCheck,
-			m_pNodes[iNearestCheck].m_vecOriginPeek.x,
-			m_pNodes[iNearestCheck].m_vecOriginPeek.y,
-			m_pNodes[iNearestCheck].m_vecOriginPeek.z,
-			m_iNearest,
-			(m_iNearest == -1?0.0:m_pNodes[m_iNearest].m_vecOriginPeek.x),
-			(m_iNearest == -1?0.0:m_pNodes[m_iNearest].m_vecOriginPeek.y),
-			(m_iNearest == -1?0.0:m_pNodes[m_iNearest].m_vecOriginPeek.z));
-	}
-	if (m_iNearest == -1)
-	{
-		ALERT(at_aiconsole, "All that work for nothing.\n");
-	}
-#endif
-	m_Cache[iHash].v = vecOrigin;
-	m_Cache[iHash].n = m_iNearest;
-	return m_iNearest;
+	return g_NearestNodeIndex.FindNearestVisible( vecOrigin, afNodeTypes );
 }
 
 //=========================================================
@@ -1583,6 +1326,10 @@ bool CGraph::FLoadGraph( const char* const pszMapName )
 		//
 		m_fGraphPresent = true;
 		m_fGraphPointersSet = false;
+
+		// This is used for FindNearestNode
+		//
+		g_NearestNodeIndex.Build( m_pNodes, m_cNodes );
 		
 		FREE_FILE(aMemFile);
 
@@ -2158,6 +1905,25 @@ void CGraph::BuildRegionTables(void)
 }
 
 void CGraph :: ComputeStaticRoutingTables( void )
+{
+	if( sv_graph_routing_threads.value < 0 )
+	{
+		ComputeStaticRoutingTablesSerial();
+	}
+	else
+	{
+		CRoutingTableBuilder builder( *this, static_cast<int>( sv_graph_routing_threads.value ) );
+
+		builder.Build();
+	}
+
+#if 0
+	TestRoutingTables();
+#endif
+	m_fRoutingComplete = true;
+}
+
+void CGraph::ComputeStaticRoutingTablesSerial()
 {
 	int nRoutes = m_cNodes*m_cNodes;
 #define FROM_TO(x,y) ((x)*m_cNodes+(y))
@@ -2170,24 +1936,14 @@ void CGraph :: ComputeStaticRoutingTables( void )
 
 	if (Routes && pMyPath && BestNextNodes && pRoute)
 	{
+		std::vector<char> routeInfo( m_pRouteInfo, m_pRouteInfo + ( m_pRouteInfo ? m_nRouteInfo : 0 ) );
+
 		int nTotalCompressedSize = 0;
 		for (int iHull = 0; iHull < MAX_NODE_HULLS; iHull++)
 		{
 			for (int iCap = 0; iCap < 2; iCap++)
 			{
-				int iCapMask;
-				switch (iCap)
-				{
-				default:
-				case 0:
-					iCapMask = 0;
-					break;
-
-				case 1:
-					iCapMask = bits_CAP_OPEN_DOORS | bits_CAP_AUTO_DOORS | bits_CAP_USE;
-					break;
-				}
-
+				const int iCapMask = CapMaskForIndex( iCap );
 
 				// Initialize Routing table to uncalculated.
 				//
@@ -2255,196 +2011,18 @@ void CGraph :: ComputeStaticRoutingTables( void )
 						BestNextNodes[iTo] = Routes[FROM_TO(iFrom, iTo)];
 					}
 
-					// Compress this node's routing table.
-					//
-					int iLastNode = 9999999; // just really big.
-					int cSequence = 0;
-					int cRepeats = 0;
-					int CompressedSize = 0;
-					char *p = pRoute;
-					for (int i = 0; i < m_cNodes; i++)
-					{
-						const bool CanRepeat = ((BestNextNodes[i] == iLastNode) && cRepeats < 127);
-						const bool CanSequence = (BestNextNodes[i] == i && cSequence < 128);
-
-						if (cRepeats)
-						{
-							if (CanRepeat)
-							{
-								cRepeats++;
-							}
-							else
-							{
-								// Emit the repeat phrase.
-								//
-								CompressedSize += 2; // (count-1, iLastNode-i)
-								*p++ = cRepeats - 1;
-								int a = iLastNode - iFrom;
-								int b = iLastNode - iFrom + m_cNodes;
-								int c = iLastNode - iFrom - m_cNodes;
-								if (-128 <= a && a <= 127)
-								{
-									*p++ = a;
-								}
-								else if (-128 <= b && b <= 127)
-								{
-									*p++ = b;
-								}
-								else if (-128 <= c && c <= 127)
-								{
-									*p++ = c;
-								}
-								else
-								{
-									ALERT( at_aiconsole, "Nodes need sorting (%d,%d)!\n", iLastNode, iFrom);
-								}
-								cRepeats = 0;
-
-								if (CanSequence)
-								{
-									// Start a sequence.
-									//
-									cSequence++;
-								}
-								else
-								{
-									// Start another repeat.
-									//
-									cRepeats++;
-								}
-							}
-						}
-						else if (cSequence)
-						{
-							if (CanSequence)
-							{
-								cSequence++;
-							}
-							else
-							{
-								// It may be advantageous to combine
-								// a single-entry sequence phrase with the
-								// next repeat phrase.
-								//
-								if (cSequence == 1 && CanRepeat)
-								{
-									// Combine with repeat phrase.
-									//
-									cRepeats = 2;
-									cSequence = 0;
-								}
-								else
-								{
-									// Emit the sequence phrase.
-									//
-									CompressedSize += 1; // (-count)
-									*p++ = -cSequence;
-									cSequence = 0;
-
-									// Start a repeat sequence.
-									//
-									cRepeats++;
-								}
-							}
-						}
-						else
-						{
-							if (CanSequence)
-							{
-								// Start a sequence phrase.
-								//
-								cSequence++;
-							}
-							else
-							{
-								// Start a repeat sequence.
-								//
-								cRepeats++;
-							}
-						}
-						iLastNode = BestNextNodes[i];
-					}
-					if (cRepeats)
-					{
-						// Emit the repeat phrase.
-						//
-						CompressedSize += 2;
-						*p++ = cRepeats - 1;
-#if 0
-						iLastNode = iFrom + *pRoute;
-						if (iLastNode >= m_cNodes) iLastNode -= m_cNodes;
-						else if (iLastNode < 0) iLastNode += m_cNodes;
-#endif
-						int a = iLastNode - iFrom;
-						int b = iLastNode - iFrom + m_cNodes;
-						int c = iLastNode - iFrom - m_cNodes;
-						if (-128 <= a && a <= 127)
-						{
-							*p++ = a;
-						}
-						else if (-128 <= b && b <= 127)
-						{
-							*p++ = b;
-						}
-						else if (-128 <= c && c <= 127)
-						{
-							*p++ = c;
-						}
-						else
-						{
-							ALERT( at_aiconsole, "Nodes need sorting (%d,%d)!\n", iLastNode, iFrom);
-						}
-					}
-					if (cSequence)
-					{
-						// Emit the Sequence phrase.
-						//
-						CompressedSize += 1;
-						*p++ = -cSequence;
-					}
+					int CompressedSize;
+					const int nRoute = CompressRoutingRow( BestNextNodes, iFrom, pRoute, CompressedSize );
 
-					// Go find a place to store this thing and point to it.
-					//
-					int nRoute = p - pRoute;
-					if (m_pRouteInfo)
-					{
-						int i;
-						for (i = 0; i < m_nRouteInfo - nRoute; i++)
-						{
-							if (memcmp(m_pRouteInfo + i, pRoute, nRoute) == 0)
-							{
-								break;
-							}
-						}
-						if (i < m_nRouteInfo - nRoute)
-						{
-							m_pNodes[ iFrom ].m_pNextBestNode[iHull][iCap] = i;
-						}
-						else
-						{
-							char *Tmp = (char *)calloc(sizeof(char), (m_nRouteInfo + nRoute));
-							memcpy(Tmp, m_pRouteInfo, m_nRouteInfo);
-							free(m_pRouteInfo);
-							m_pRouteInfo = Tmp;
-							memcpy(m_pRouteInfo + m_nRouteInfo, pRoute, nRoute);
-							m_pNodes[ iFrom ].m_pNextBestNode[iHull][iCap] = m_nRouteInfo;
-							m_nRouteInfo += nRoute;
-							nTotalCompressedSize += CompressedSize;
-						}
-					}
-					else
-					{
-						m_nRouteInfo = nRoute;
-						m_pRouteInfo = (char *)calloc(sizeof(char), nRoute);
-						memcpy(m_pRouteInfo, pRoute, nRoute);
-						m_pNodes[ iFrom ].m_pNextBestNode[iHull][iCap] = 0;
-						nTotalCompressedSize += CompressedSize;
-					}
+					StoreRoutingRow( routeInfo, pRoute, nRoute, CompressedSize, iFrom, iHull, iCap, nTotalCompressedSize );
 				}
 			}
 		}		
 		ALERT( at_aiconsole, "Size of Routes = %d\n", nTotalCompressedSize);
+
+		SetRouteInfo( routeInfo );
 	}
+#undef FROM_TO
 	if (Routes) delete[] Routes;
 	if (BestNextNodes) delete[] BestNextNodes;
 	if (pRoute) delete[] pRoute;
@@ -2453,11 +2031,223 @@ void CGraph :: ComputeStaticRoutingTables( void )
 	BestNextNodes = nullptr;
 	pRoute = nullptr;
 	pMyPath = nullptr;
+}
+
+int CGraph::CapMaskForIndex( const int iCap )
+{
+	switch( iCap )
+	{
+	default:
+	case 0:
+		return 0;
+
+	case 1:
+		return bits_CAP_OPEN_DOORS | bits_CAP_AUTO_DOORS | bits_CAP_USE;
+	}
+}
+
+int CGraph::CompressRoutingRow( const unsigned short* BestNextNodes, const int iFrom, char* pRoute, int& CompressedSize ) const
+{
+	// Compress this node's routing table.
+	//
+	int iLastNode = 9999999; // just really big.
+	int cSequence = 0;
+	int cRepeats = 0;
+	CompressedSize = 0;
+	char *p = pRoute;
+	for (int i = 0; i < m_cNodes; i++)
+	{
+		const bool CanRepeat = ((BestNextNodes[i] == iLastNode) && cRepeats < 127);
+		const bool CanSequence = (BestNextNodes[i] == i && cSequence < 128);
 
+		if (cRepeats)
+		{
+			if (CanRepeat)
+			{
+				cRepeats++;
+			}
+			else
+			{
+				// Emit the repeat phrase.
+				//
+				CompressedSize += 2; // (count-1, iLastNode-i)
+				*p++ = cRepeats - 1;
+				int a = iLastNode - iFrom;
+				int b = iLastNode - iFrom + m_cNodes;
+				int c = iLastNode - iFrom - m_cNodes;
+				if (-128 <= a && a <= 127)
+				{
+					*p++ = a;
+				}
+				else if (-128 <= b && b <= 127)
+				{
+					*p++ = b;
+				}
+				else if (-128 <= c && c <= 127)
+				{
+					*p++ = c;
+				}
+				else
+				{
+					ALERT( at_aiconsole, "Nodes need sorting (%d,%d)!\n", iLastNode, iFrom);
+				}
+				cRepeats = 0;
+
+				if (CanSequence)
+				{
+					// Start a sequence.
+					//
+					cSequence++;
+				}
+				else
+				{
+					// Start another repeat.
+					//
+					cRepeats++;
+				}
+			}
+		}
+		else if (cSequence)
+		{
+			if (CanSequence)
+			{
+				cSequence++;
+			}
+			else
+			{
+				// It may be advantageous to combine
+				// a single-entry sequence phrase with the
+				// next repeat phrase.
+				//
+				if (cSequence == 1 && CanRepeat)
+				{
+					// Combine with repeat phrase.
+					//
+					cRepeats = 2;
+					cSequence = 0;
+				}
+				else
+				{
+					// Emit the sequence phrase.
+					//
+					CompressedSize += 1; // (-count)
+					*p++ = -cSequence;
+					cSequence = 0;
+
+					// Start a repeat sequence.
+					//
+					cRepeats++;
+				}
+			}
+		}
+		else
+		{
+			if (CanSequence)
+			{
+				// Start a sequence phrase.
+				//
+				cSequence++;
+			}
+			else
+			{
+				// Start a repeat sequence.
+				//
+				cRepeats++;
+			}
+		}
+		iLastNode = BestNextNodes[i];
+	}
+	if (cRepeats)
+	{
+		// Emit the repeat phrase.
+		//
+		CompressedSize += 2;
+		*p++ = cRepeats - 1;
 #if 0
-	TestRoutingTables();
+		iLastNode = iFrom + *pRoute;
+		if (iLastNode >= m_cNodes) iLastNode -= m_cNodes;
+		else if (iLastNode < 0) iLastNode += m_cNodes;
 #endif
-	m_fRoutingComplete = true;
+		int a = iLastNode - iFrom;
+		int b = iLastNode - iFrom + m_cNodes;
+		int c = iLastNode - iFrom - m_cNodes;
+		if (-128 <= a && a <= 127)
+		{
+			*p++ = a;
+		}
+		else if (-128 <= b && b <= 127)
+		{
+			*p++ = b;
+		}
+		else if (-128 <= c && c <= 127)
+		{
+			*p++ = c;
+		}
+		else
+		{
+			ALERT( at_aiconsole, "Nodes need sorting (%d,%d)!\n", iLastNode, iFrom);
+		}
+	}
+	if (cSequence)
+	{
+		// Emit the Sequence phrase.
+		//
+		CompressedSize += 1;
+		*p++ = -cSequence;
+	}
+
+	return p - pRoute;
+}
+
+void CGraph::StoreRoutingRow( std::vector<char>& routeInfo, const char* pRoute, const int nRoute, const int CompressedSize,
+							  const int iFrom, const int iHull, const int iCap, int& nTotalCompressedSize )
+{
+	// Go find a place to store this thing and point to it.
+	// An existing sequence of bytes anywhere in the route info is reused, even if it spans multiple rows.
+	//
+	if( !routeInfo.empty() )
+	{
+		const char* const pStart = routeInfo.data();
+
+		//Note: the last possible position is never considered. This matches the original search.
+		const char* const pEnd = pStart + ( static_cast<int>( routeInfo.size() ) - nRoute );
+
+		for( const char* pSearch = pStart; pSearch < pEnd; ++pSearch )
+		{
+			//Skip ahead to the next candidate before doing a full compare.
+			pSearch = static_cast<const char*>( memchr( pSearch, pRoute[ 0 ], pEnd - pSearch ) );
+
+			if( !pSearch )
+				break;
+
+			if( memcmp( pSearch, pRoute, nRoute ) == 0 )
+			{
+				m_pNodes[ iFrom ].m_pNextBestNode[ iHull ][ iCap ] = pSearch - pStart;
+				return;
+			}
+		}
+	}
+
+	m_pNodes[ iFrom ].m_pNextBestNode[ iHull ][ iCap ] = routeInfo.size();
+	routeInfo.insert( routeInfo.end(), pRoute, pRoute + nRoute );
+	nTotalCompressedSize += CompressedSize;
+}
+
+void CGraph::SetRouteInfo( const std::vector<char>& routeInfo )
+{
+	if( m_pRouteInfo )
+	{
+		free( m_pRouteInfo );
+		m_pRouteInfo = nullptr;
+	}
+
+	m_nRouteInfo = routeInfo.size();
+
+	if( m_nRouteInfo )
+	{
+		m_pRouteInfo = ( char* ) calloc( sizeof( char ), m_nRouteInfo );
+		memcpy( m_pRouteInfo, routeInfo.data(), m_nRouteInfo );
+	}
 }
 
 // Test those routing tables. Doesn't really work, yet.
@@ -18,6 +18,8 @@
 #ifndef GAME_SERVER_NODES_CGRAPH_H
 #define GAME_SERVER_NODES_CGRAPH_H
 
+#include <vector>
+
 #include "CNode.h"
 #include "CLink.h"
 
@@ -69,6 +71,9 @@ public:
 	// search each range. After the search is exhausted, we know we have the closest
 	// node.
 	//
+	// FindNearestNode now uses CNearestNodeIndex instead. These are still built and saved
+	// since the graph is written to .nod files as is, and changing it would obsolete them.
+	//
 #define NODE_CACHE_SIZE 128
 #define NUM_RANGES 256
 	DIST_INFO *m_di;	// This is m_cNodes long, but the entries don't correspond to CNode entries.
@@ -119,12 +124,39 @@ public:
 	bool	FLoadGraph( const char* pszMapName );
 	bool	FSaveGraph( const char* pszMapName ) const;
 	bool	FSetGraphPointers();
-	void	CheckNode(Vector vecOrigin, int iNode);
 
 	void    BuildRegionTables(void);
 	void    ComputeStaticRoutingTables(void);
+	void    ComputeStaticRoutingTablesSerial();
 	void    TestRoutingTables(void);
 
+	/**
+	*	Gets the capability mask used to build the routing table for the given cap index. Inverse of CapIndex.
+	*/
+	static int CapMaskForIndex( const int iCap );
+
+	/**
+	*	Compresses a single row of the routing table.
+	*	@param BestNextNodes Next node to move to for every destination node, m_cNodes entries.
+	*	@param iFrom Node that this row belongs to.
+	*	@param pRoute Destination buffer. Must be at least m_cNodes * 2 bytes large.
+	*	@param CompressedSize Receives the number of bytes that count towards the total compressed size.
+	*	@return Number of bytes written to pRoute.
+	*/
+	int		CompressRoutingRow( const unsigned short* BestNextNodes, const int iFrom, char* pRoute, int& CompressedSize ) const;
+
+	/**
+	*	Stores a compressed routing row in routeInfo, reusing an existing identical sequence if there is one.
+	*	Sets the node's next best node offset for the given hull and cap.
+	*/
+	void	StoreRoutingRow( std::vector<char>& routeInfo, const char* pRoute, const int nRoute, const int CompressedSize,
+							 const int iFrom, const int iHull, const int iCap, int& nTotalCompressedSize );
+
+	/**
+	*	Replaces the route info with the given buffer.
+	*/
+	void	SetRouteInfo( const std::vector<char>& routeInfo );
+
 	void	HashInsert(int iSrcNode, int iDestNode, int iKey);
 	void    HashSearch(int iSrcNode, int iDestNode, int &iKey);
 	void	HashChoosePrimes(int TableSize);
@@ -0,0 +1,287 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   This source code contains proprietary and confidential information of
+*   Valve LLC and its suppliers.  Access to this code is restricted to
+*   persons who have executed a written SDK license with Valve.  Any access,
+*   use or distribution of this code by or to any unlicensed person is illegal.
+*
+****/
+#include <algorithm>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+
+#include "CNode.h"
+
+#include "CNearestNodeIndex.h"
+
+CNearestNodeIndex g_NearestNodeIndex;
+
+void CNearestNodeIndex::Build( const CNode* pNodes, const int cNodes )
+{
+	Clear();
+
+	if( !pNodes || cNodes <= 0 )
+		return;
+
+	m_pNodes = pNodes;
+
+	m_NodeIndices.resize( cNodes );
+
+	for( int i = 0; i < cNodes; ++i )
+		m_NodeIndices[ i ] = i;
+
+	//A tree with leaves of at least LEAF_SIZE / 2 nodes has fewer than this many tree nodes.
+	m_Tree.reserve( 4 * ( cNodes / LEAF_SIZE + 1 ) );
+
+	m_Tree.emplace_back();
+
+	BuildSubtree( 0, 0, cNodes );
+}
+
+void CNearestNodeIndex::Clear()
+{
+	m_pNodes = nullptr;
+
+	m_Tree.clear();
+	m_NodeIndices.clear();
+	m_Queue.clear();
+
+	m_CacheList.clear();
+	m_CacheMap.clear();
+}
+
+int CNearestNodeIndex::FindNearestVisible( const Vector& vecOrigin, const int afNodeTypes )
+{
+	++m_Stats.uiQueries;
+
+	const CacheKey key = MakeCacheKey( vecOrigin, afNodeTypes );
+
+	auto it = m_CacheMap.find( key );
+
+	if( it != m_CacheMap.end() )
+	{
+		++m_Stats.uiCacheHits;
+
+		m_CacheList.splice( m_CacheList.begin(), m_CacheList, it->second );
+
+		return it->second->iNode;
+	}
+
+	++m_Stats.uiCacheMisses;
+
+	int iNearest = -1;
+
+	BeginQuery( vecOrigin, afNodeTypes );
+
+	for( int iNode = NextNode(); iNode != -1; iNode = NextNode() )
+	{
+		++m_Stats.uiCandidates;
+
+		TraceResult tr;
+
+		// make sure that vecOrigin can trace to this node!
+		UTIL_TraceLine( vecOrigin, m_pNodes[ iNode ].m_vecOriginPeek, ignore_monsters, 0, &tr );
+
+		if( tr.flFraction == 1.0 )
+		{
+			iNearest = iNode;
+			break;
+		}
+	}
+
+	if( m_CacheMap.size() >= CACHE_SIZE )
+	{
+		//Reuse the least recently used entry.
+		m_CacheMap.erase( m_CacheList.back().key );
+		m_CacheList.splice( m_CacheList.begin(), m_CacheList, std::prev( m_CacheList.end() ) );
+		m_CacheList.front() = CacheEntry{ key, iNearest };
+	}
+	else
+	{
+		m_CacheList.push_front( CacheEntry{ key, iNearest } );
+	}
+
+	m_CacheMap.emplace( key, m_CacheList.begin() );
+
+	return iNearest;
+}
+
+void CNearestNodeIndex::BeginQuery( const Vector& vecOrigin, const int afNodeTypes )
+{
+	m_vecQueryOrigin = vecOrigin;
+	m_afQueryNodeTypes = afNodeTypes;
+
+	m_Queue.clear();
+
+	if( !m_Tree.empty() && ( m_Tree[ 0 ].afNodeTypes & afNodeTypes ) )
+		Push( BoxDistSqr( vecOrigin, m_Tree[ 0 ].vecMins, m_Tree[ 0 ].vecMaxs ), 0, false );
+}
+
+int CNearestNodeIndex::NextNode()
+{
+	while( !m_Queue.empty() )
+	{
+		std::pop_heap( m_Queue.begin(), m_Queue.end() );
+
+		const QueueEntry entry = m_Queue.back();
+
+		m_Queue.pop_back();
+
+		//Everything left in the queue is at least as far away as this node, so it's the next closest one.
+		if( entry.fIsGraphNode )
+			return entry.iIndex;
+
+		const TreeNode& treeNode = m_Tree[ entry.iIndex ];
+
+		if( treeNode.iCount )
+		{
+			for( int i = treeNode.iFirst; i < treeNode.iFirst + treeNode.iCount; ++i )
+			{
+				const CNode& node = m_pNodes[ m_NodeIndices[ i ] ];
+
+				if( node.m_afNodeInfo & m_afQueryNodeTypes )
+				{
+					const Vector vecDelta = m_vecQueryOrigin - node.m_vecOriginPeek;
+
+					Push( DotProduct( vecDelta, vecDelta ), m_NodeIndices[ i ], true );
+				}
+			}
+		}
+		else
+		{
+			for( int iChild = treeNode.iFirst; iChild <= treeNode.iFirst + 1; ++iChild )
+			{
+				const TreeNode& child = m_Tree[ iChild ];
+
+				if( child.afNodeTypes & m_afQueryNodeTypes )
+					Push( BoxDistSqr( m_vecQueryOrigin, child.vecMins, child.vecMaxs ), iChild, false );
+			}
+		}
+	}
+
+	return -1;
+}
+
+void CNearestNodeIndex::BuildSubtree( const int iTreeNode, const int iFirst, const int iCount )
+{
+	Vector vecMins = m_pNodes[ m_NodeIndices[ iFirst ] ].m_vecOriginPeek;
+	Vector vecMaxs = vecMins;
+	int afNodeTypes = 0;
+
+	for( int i = iFirst; i < iFirst + iCount; ++i )
+	{
+		const CNode& node = m_pNodes[ m_NodeIndices[ i ] ];
+
+		for( int iAxis = 0; iAxis < 3; ++iAxis )
+		{
+			vecMins[ iAxis ] = min( vecMins[ iAxis ], node.m_vecOriginPeek[ iAxis ] );
+			vecMaxs[ iAxis ] = max( vecMaxs[ iAxis ], node.m_vecOriginPeek[ iAxis ] );
+		}
+
+		afNodeTypes |= node.m_afNodeInfo;
+	}
+
+	{
+		auto& treeNode = m_Tree[ iTreeNode ];
+
+		treeNode.vecMins = vecMins;
+		treeNode.vecMaxs = vecMaxs;
+		treeNode.afNodeTypes = afNodeTypes;
+		treeNode.iFirst = iFirst;
+		treeNode.iCount = iCount;
+	}
+
+	if( iCount <= LEAF_SIZE )
+		return;
+
+	//Split the widest axis at the median.
+	const Vector vecSize = vecMaxs - vecMins;
+
+	int iAxis = 0;
+
+	if( vecSize.y > vecSize[ iAxis ] )
+		iAxis = 1;
+
+	if( vecSize.z > vecSize[ iAxis ] )
+		iAxis = 2;
+
+	const int iHalf = iCount / 2;
+
+	const CNode* pNodes = m_pNodes;
+
+	std::nth_element( m_NodeIndices.begin() + iFirst, m_NodeIndices.begin() + iFirst + iHalf, m_NodeIndices.begin() + iFirst + iCount,
+		[ = ]( const int lhs, const int rhs )
+		{
+			return pNodes[ lhs ].m_vecOriginPeek[ iAxis ] < pNodes[ rhs ].m_vecOriginPeek[ iAxis ];
+		}
+	);
+
+	//Children are allocated together so the second one is always iChild + 1.
+	const int iChild = static_cast<int>( m_Tree.size() );
+
+	m_Tree.emplace_back();
+	m_Tree.emplace_back();
+
+	m_Tree[ iTreeNode ].iFirst = iChild;
+	m_Tree[ iTreeNode ].iCount = 0;
+
+	BuildSubtree( iChild, iFirst, iHalf );
+	BuildSubtree( iChild + 1, iFirst + iHalf, iCount - iHalf );
+}
+
+void CNearestNodeIndex::Push( const float flDistSqr, const int iIndex, const bool fIsGraphNode )
+{
+	m_Queue.push_back( QueueEntry{ flDistSqr, iIndex, fIsGraphNode } );
+	std::push_heap( m_Queue.begin(), m_Queue.end() );
+}
+
+float CNearestNodeIndex::BoxDistSqr( const Vector& vecOrigin, const Vector& vecMins, const Vector& vecMaxs )
+{
+	float flDistSqr = 0;
+
+	for( int iAxis = 0; iAxis < 3; ++iAxis )
+	{
+		float flDelta = 0;
+
+		if( vecOrigin[ iAxis ] < vecMins[ iAxis ] )
+			flDelta = vecMins[ iAxis ] - vecOrigin[ iAxis ];
+		else if( vecOrigin[ iAxis ] > vecMaxs[ iAxis ] )
+			flDelta = vecOrigin[ iAxis ] - vecMaxs[ iAxis ];
+
+		flDistSqr += flDelta * flDelta;
+	}
+
+	return flDistSqr;
+}
+
+CNearestNodeIndex::CacheKey CNearestNodeIndex::MakeCacheKey( const Vector& vecOrigin, const int afNodeTypes )
+{
+	return CacheKey{
+		static_cast<int>( floor( vecOrigin.x / CACHE_GRID ) ),
+		static_cast<int>( floor( vecOrigin.y / CACHE_GRID ) ),
+		static_cast<int>( floor( vecOrigin.z / CACHE_GRID ) ),
+		afNodeTypes
+	};
+}
+
+void ServerCommand_NearestNodeStats()
+{
+	const auto& stats = g_NearestNodeIndex.GetStats();
+
+	ALERT( at_console, "FindNearestNode: %llu queries\n", static_cast<unsigned long long>( stats.uiQueries ) );
+	ALERT( at_console, "Cache hits: %llu (%.1f%%)\n", static_cast<unsigned long long>( stats.uiCacheHits ),
+		stats.uiQueries ? 100.0 * stats.uiCacheHits / stats.uiQueries : 0.0 );
+	ALERT( at_console, "Cache misses: %llu\n", static_cast<unsigned long long>( stats.uiCacheMisses ) );
+	ALERT( at_console, "Traces: %llu (%.2f per miss)\n", static_cast<unsigned long long>( stats.uiCandidates ),
+		stats.uiCacheMisses ? static_cast<double>( stats.uiCandidates ) / stats.uiCacheMisses : 0.0 );
+
+	g_NearestNodeIndex.ResetStats();
+}
@@ -0,0 +1,201 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   This source code contains proprietary and confidential information of
+*   Valve LLC and its suppliers.  Access to this code is restricted to
+*   persons who have executed a written SDK license with Valve.  Any access,
+*   use or distribution of this code by or to any unlicensed person is illegal.
+*
+****/
+#ifndef GAME_SERVER_NODES_CNEARESTNODEINDEX_H
+#define GAME_SERVER_NODES_CNEARESTNODEINDEX_H
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class CNode;
+
+/**
+*	Answers nearest node queries for the world graph.
+*	Node origins are stored in a static k-d tree that is built when the graph is loaded or generated. Queries walk the tree
+*	best first and return nodes of the requested types in order of increasing distance, so a query that needs a visible node
+*	stops tracing at the first one that is visible.
+*	Results are kept in an LRU cache keyed on the position, quantized to CACHE_GRID units, and the node types.
+*	This is kept outside of CGraph because CGraph is written to and read from .nod files as raw memory.
+*/
+class CNearestNodeIndex final
+{
+public:
+	struct Stats
+	{
+		uint64_t uiQueries = 0;
+		uint64_t uiCacheHits = 0;
+		uint64_t uiCacheMisses = 0;
+
+		/**
+		*	Number of nodes returned by the tree, i.e. number of visibility traces done.
+		*/
+		uint64_t uiCandidates = 0;
+	};
+
+	/**
+	*	Size of the position cells used as cache keys.
+	*/
+	static const int CACHE_GRID = 8;
+
+	static const size_t CACHE_SIZE = 1024;
+
+public:
+	CNearestNodeIndex() = default;
+
+	/**
+	*	Builds the tree for the given nodes and clears the cache.
+	*	The nodes must not change while the index is in use.
+	*/
+	void Build( const CNode* pNodes, const int cNodes );
+
+	/**
+	*	Frees the tree and the cache.
+	*/
+	void Clear();
+
+	bool IsBuilt() const { return m_pNodes != nullptr; }
+
+	/**
+	*	Finds the nearest node of the given types that can be traced to from vecOrigin.
+	*	@return Node index, or -1 if no node is visible.
+	*/
+	int FindNearestVisible( const Vector& vecOrigin, const int afNodeTypes );
+
+	/**
+	*	Starts a query for nodes of the given types, in order of increasing distance from vecOrigin.
+	*	Only one query can be in progress at a time.
+	*/
+	void BeginQuery( const Vector& vecOrigin, const int afNodeTypes );
+
+	/**
+	*	@return The next closest node in the current query, or -1 if there are no more nodes.
+	*/
+	int NextNode();
+
+	const Stats& GetStats() const { return m_Stats; }
+
+	void ResetStats()
+	{
+		m_Stats = Stats();
+	}
+
+private:
+	static const int LEAF_SIZE = 8;
+
+	/**
+	*	If iCount is not 0, this is a leaf containing m_NodeIndices[ iFirst ] to m_NodeIndices[ iFirst + iCount - 1 ].
+	*	Otherwise the children are iFirst and iFirst + 1.
+	*/
+	struct TreeNode
+	{
+		Vector vecMins;
+		Vector vecMaxs;
+		int afNodeTypes;	//All types of the nodes in this subtree.
+		int iFirst;
+		int iCount;
+	};
+
+	/**
+	*	Entry in the query's priority queue. Either a tree node, or a graph node with its exact distance.
+	*/
+	struct QueueEntry
+	{
+		float flDistSqr;
+		int iIndex;
+		bool fIsGraphNode;
+
+		bool operator<( const QueueEntry& other ) const
+		{
+			//Inverted so std::push_heap makes a min heap.
+			return flDistSqr > other.flDistSqr;
+		}
+	};
+
+	struct CacheKey
+	{
+		int x, y, z;
+		int afNodeTypes;
+
+		bool operator==( const CacheKey& other ) const
+		{
+			return x == other.x && y == other.y && z == other.z && afNodeTypes == other.afNodeTypes;
+		}
+	};
+
+	struct CacheKeyHash
+	{
+		size_t operator()( const CacheKey& key ) const
+		{
+			size_t uiHash = static_cast<size_t>( key.x ) * 73856093u;
+			uiHash ^= static_cast<size_t>( key.y ) * 19349663u;
+			uiHash ^= static_cast<size_t>( key.z ) * 83492791u;
+			uiHash ^= static_cast<size_t>( key.afNodeTypes ) * 2654435761u;
+			return uiHash;
+		}
+	};
+
+	struct CacheEntry
+	{
+		CacheKey key;
+		int iNode;
+	};
+
+	using CacheList = std::list<CacheEntry>;
+
+	/**
+	*	Builds the subtree for m_NodeIndices[ iFirst ] to m_NodeIndices[ iFirst + iCount - 1 ] into the given tree node.
+	*/
+	void BuildSubtree( const int iTreeNode, const int iFirst, const int iCount );
+
+	void Push( const float flDistSqr, const int iIndex, const bool fIsGraphNode );
+
+	static float BoxDistSqr( const Vector& vecOrigin, const Vector& vecMins, const Vector& vecMaxs );
+
+	static CacheKey MakeCacheKey( const Vector& vecOrigin, const int afNodeTypes );
+
+private:
+	const CNode* m_pNodes = nullptr;
+
+	std::vector<TreeNode> m_Tree;
+
+	std::vector<int> m_NodeIndices;
+
+	//Current query.
+	Vector m_vecQueryOrigin;
+	int m_afQueryNodeTypes = 0;
+	std::vector<QueueEntry> m_Queue;
+
+	/**
+	*	Most recently used entries first.
+	*/
+	CacheList m_CacheList;
+	std::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash> m_CacheMap;
+
+	Stats m_Stats;
+
+private:
+	CNearestNodeIndex( const CNearestNodeIndex& ) = delete;
+	CNearestNodeIndex& operator=( const CNearestNodeIndex& ) = delete;
+};
+
+extern CNearestNodeIndex g_NearestNodeIndex;
+
+/**
+*	Prints the nearest node cache hit rate and number of traces since the last time this was used, and resets the counters.
+*/
+void ServerCommand_NearestNodeStats();
+
+#endif //GAME_SERVER_NODES_CNEARESTNODEINDEX_H
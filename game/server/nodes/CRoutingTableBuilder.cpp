@@ -0,0 +1,428 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   This source code contains proprietary and confidential information of
+*   Valve LLC and its suppliers.  Access to this code is restricted to
+*   persons who have executed a written SDK license with Valve.  Any access,
+*   use or distribution of this code by or to any unlicensed person is illegal.
+*
+****/
+#include <algorithm>
+#include <chrono>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+#include "entities/NPCs/Monsters.h"
+#include "CGraph.h"
+#include "CQueuePriority.h"
+
+#include "CRoutingTableBuilder.h"
+
+namespace
+{
+//One table per hull and door capability.
+const int NUM_ROUTING_CAPS = 2;
+const int NUM_ROUTING_TABLES = MAX_NODE_HULLS * NUM_ROUTING_CAPS;
+
+const int HULL_LINK_MASKS[ MAX_NODE_HULLS ] =
+{
+	bits_LINK_SMALL_HULL,
+	bits_LINK_HUMAN_HULL,
+	bits_LINK_LARGE_HULL,
+	bits_LINK_FLY_HULL
+};
+
+//How many search results each worker can compute ahead of the routing table fill.
+const int RESULTS_PER_THREAD = 4;
+
+double MillisecondsSince( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+}
+}
+
+CRoutingTableBuilder::CRoutingTableBuilder( CGraph& graph, int cThreads )
+	: m_Graph( graph )
+	, m_cNodes( graph.m_cNodes )
+	, m_cLinks( graph.m_cLinks )
+{
+	if( cThreads <= 0 )
+	{
+		cThreads = std::thread::hardware_concurrency();
+
+		if( cThreads <= 0 )
+			cThreads = 1;
+	}
+
+	m_cThreads = cThreads;
+}
+
+CRoutingTableBuilder::~CRoutingTableBuilder()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+
+		//Stop any workers that are still waiting for work.
+		m_cItems = 0;
+	}
+
+	m_SlotFree.notify_all();
+
+	for( auto& thread : m_Threads )
+	{
+		thread.join();
+	}
+}
+
+void CRoutingTableBuilder::Build()
+{
+	if( m_cNodes <= 0 )
+		return;
+
+	const auto buildStart = std::chrono::steady_clock::now();
+
+	BuildPassableLinks();
+
+	m_cItems = NUM_ROUTING_TABLES * m_cNodes;
+
+	m_cThreads = std::min( m_cThreads, m_cItems );
+
+	const int cResults = std::min( m_cItems, m_cThreads * RESULTS_PER_THREAD );
+
+	m_Results.reserve( cResults );
+
+	for( int iResult = 0; iResult < cResults; ++iResult )
+	{
+		std::unique_ptr<SearchResult> result( new SearchResult );
+
+		result->flClosestSoFar.resize( m_cNodes );
+		result->iPreviousNode.resize( m_cNodes );
+
+		m_Results.emplace_back( std::move( result ) );
+	}
+
+	m_flClosestSoFar.resize( m_cNodes );
+	m_iPreviousNode.resize( m_cNodes );
+
+	m_Threads.reserve( m_cThreads );
+
+	for( int iThread = 0; iThread < m_cThreads; ++iThread )
+	{
+		m_Threads.emplace_back( &CRoutingTableBuilder::WorkerThread, this );
+	}
+
+#define FROM_TO(x,y) ((x)*m_cNodes+(y))
+	//The routing table has to be fully filled in before any row can be compressed, since later paths can overwrite earlier rows.
+	std::vector<short> routes( m_cNodes * m_cNodes );
+
+	//A path from a node to itself has 2 entries.
+	std::vector<int> path( std::max( m_cNodes, 2 ) );
+	std::vector<unsigned short> bestNextNodes( m_cNodes );
+	std::vector<char> route( m_cNodes * 2 );
+
+	std::vector<char> routeInfo( m_Graph.m_pRouteInfo, m_Graph.m_pRouteInfo + ( m_Graph.m_pRouteInfo ? m_Graph.m_nRouteInfo : 0 ) );
+
+	int nTotalCompressedSize = 0;
+
+	for( int iHull = 0; iHull < MAX_NODE_HULLS; ++iHull )
+	{
+		const auto hullStart = std::chrono::steady_clock::now();
+
+		double flSearchTime = 0;
+		double flCompressTime = 0;
+
+		for( int iCap = 0; iCap < NUM_ROUTING_CAPS; ++iCap )
+		{
+			const int iTable = iHull * NUM_ROUTING_CAPS + iCap;
+
+			// Initialize Routing table to uncalculated.
+			//
+			std::fill( routes.begin(), routes.end(), -1 );
+
+			for( int iFrom = 0; iFrom < m_cNodes; ++iFrom )
+			{
+				auto& result = WaitForItem( iTable * m_cNodes + iFrom );
+
+				flSearchTime += result.flSearchTime;
+
+				for( int iTo = m_cNodes - 1; iTo >= 0; --iTo )
+				{
+					if( routes[ FROM_TO( iFrom, iTo ) ] != -1 )
+						continue;
+
+					const int cPathSize = GetPath( iTable, result, iFrom, iTo, path.data() );
+
+					// Use the computed path to update the routing table.
+					//
+					if( cPathSize > 1 )
+					{
+						for( int iNode = 0; iNode < cPathSize - 1; ++iNode )
+						{
+							const int iStart = path[ iNode ];
+							const int iNext = path[ iNode + 1 ];
+
+							for( int iNode1 = iNode + 1; iNode1 < cPathSize; ++iNode1 )
+							{
+								routes[ FROM_TO( iStart, path[ iNode1 ] ) ] = iNext;
+							}
+						}
+					}
+					else
+					{
+						routes[ FROM_TO( iFrom, iTo ) ] = iFrom;
+						routes[ FROM_TO( iTo, iFrom ) ] = iTo;
+					}
+				}
+
+				ReleaseItem( result );
+			}
+
+			const auto compressStart = std::chrono::steady_clock::now();
+
+			for( int iFrom = 0; iFrom < m_cNodes; ++iFrom )
+			{
+				for( int iTo = 0; iTo < m_cNodes; ++iTo )
+				{
+					bestNextNodes[ iTo ] = routes[ FROM_TO( iFrom, iTo ) ];
+				}
+
+				int CompressedSize;
+				const int nRoute = m_Graph.CompressRoutingRow( bestNextNodes.data(), iFrom, route.data(), CompressedSize );
+
+				m_Graph.StoreRoutingRow( routeInfo, route.data(), nRoute, CompressedSize, iFrom, iHull, iCap, nTotalCompressedSize );
+			}
+
+			flCompressTime += MillisecondsSince( compressStart );
+		}
+
+		ALERT( at_console, "Routing tables for hull %d: %.2f ms (%.2f ms searching on %d threads, %.2f ms compressing)\n",
+			   iHull, MillisecondsSince( hullStart ), flSearchTime, m_cThreads, flCompressTime );
+	}
+#undef FROM_TO
+
+	ALERT( at_aiconsole, "Size of Routes = %d\n", nTotalCompressedSize );
+
+	m_Graph.SetRouteInfo( routeInfo );
+
+	ALERT( at_console, "Routing tables for %d nodes built in %.2f ms\n", m_cNodes, MillisecondsSince( buildStart ) );
+}
+
+void CRoutingTableBuilder::BuildPassableLinks()
+{
+	//Brush entities are evaluated once per capability, on this thread. Workers never touch entities.
+	std::vector<unsigned char> linkEntPassable( NUM_ROUTING_CAPS * m_cLinks, true );
+
+	for( int iCap = 0; iCap < NUM_ROUTING_CAPS; ++iCap )
+	{
+		const int iCapMask = CGraph::CapMaskForIndex( iCap );
+
+		for( int iLink = 0; iLink < m_cLinks; ++iLink )
+		{
+			const CLink& link = m_Graph.m_pLinkPool[ iLink ];
+
+			if( link.m_pLinkEnt != nullptr )
+			{
+				linkEntPassable[ iCap * m_cLinks + iLink ] = m_Graph.HandleLinkEnt( link.m_iSrcNode, link.m_pLinkEnt, iCapMask, CGraph::NODEGRAPH_STATIC );
+			}
+		}
+	}
+
+	m_Passable.resize( NUM_ROUTING_TABLES * m_cLinks );
+
+	for( int iHull = 0; iHull < MAX_NODE_HULLS; ++iHull )
+	{
+		const int iHullMask = HULL_LINK_MASKS[ iHull ];
+
+		for( int iCap = 0; iCap < NUM_ROUTING_CAPS; ++iCap )
+		{
+			const int iTable = iHull * NUM_ROUTING_CAPS + iCap;
+
+			for( int iLink = 0; iLink < m_cLinks; ++iLink )
+			{
+				m_Passable[ iTable * m_cLinks + iLink ] =
+					( m_Graph.m_pLinkPool[ iLink ].m_afLinkInfo & iHullMask ) == iHullMask &&
+					linkEntPassable[ iCap * m_cLinks + iLink ];
+			}
+		}
+	}
+}
+
+void CRoutingTableBuilder::WorkerThread()
+{
+	while( true )
+	{
+		int iItem;
+
+		{
+			std::unique_lock<std::mutex> lock( m_Mutex );
+
+			m_SlotFree.wait( lock, [ this ]()
+			{
+				return m_iNextItem >= m_cItems || m_iNextItem < m_cConsumedItems + static_cast<int>( m_Results.size() );
+			} );
+
+			if( m_iNextItem >= m_cItems )
+				return;
+
+			iItem = m_iNextItem++;
+		}
+
+		auto& result = *m_Results[ iItem % m_Results.size() ];
+
+		const auto searchStart = std::chrono::steady_clock::now();
+
+		result.fComplete = Search( iItem / m_cNodes, iItem % m_cNodes, NO_NODE, result.flClosestSoFar.data(), result.iPreviousNode.data(), true );
+
+		result.flSearchTime = MillisecondsSince( searchStart );
+
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+
+			result.iItem = iItem;
+			result.fReady = true;
+		}
+
+		m_ItemReady.notify_all();
+	}
+}
+
+bool CRoutingTableBuilder::Search( const int iTable, const int iStart, const int iDest, float* pflClosestSoFar, int* piPreviousNode, const bool fStopOnOverflow ) const
+{
+	const unsigned char* const pPassable = &m_Passable[ iTable * m_cLinks ];
+
+	CQueuePriority queue;
+
+	// Mark all the nodes as unvisited.
+	//
+	for( int i = 0; i < m_cNodes; ++i )
+	{
+		pflClosestSoFar[ i ] = -1.0;
+		piPreviousNode[ i ] = NO_NODE;
+	}
+
+	pflClosestSoFar[ iStart ] = 0.0;
+	piPreviousNode[ iStart ] = iStart;// tag this as the origin node
+	queue.Insert( iStart, 0.0 );// insert start node
+
+	while( !queue.Empty() )
+	{
+		// now pull a node out of the queue
+		float flCurrentDistance;
+		const int iCurrentNode = queue.Remove( flCurrentDistance );
+
+		// For straight-line weights, the following Shortcut works. For arbitrary weights,
+		// it doesn't.
+		// Full trees pass NO_NODE and never stop early. Paths to nodes that were already removed from the queue can't change after that.
+		//
+		if( iCurrentNode == iDest )
+			break;
+
+		const CNode& currentNode = m_Graph.m_pNodes[ iCurrentNode ];
+
+		for( int i = 0; i < currentNode.m_cNumLinks; ++i )
+		{
+			const int iLink = currentNode.m_iFirstLink + i;
+
+			if( !pPassable[ iLink ] )
+				continue;
+
+			const CLink& link = m_Graph.m_pLinkPool[ iLink ];
+
+			const int iVisitNode = link.m_iDestNode;
+
+			float flOurDistance = flCurrentDistance + link.m_flWeight;
+
+			if( pflClosestSoFar[ iVisitNode ] < -0.5
+				|| flOurDistance < pflClosestSoFar[ iVisitNode ] - 0.001 )
+			{
+				pflClosestSoFar[ iVisitNode ] = flOurDistance;
+				piPreviousNode[ iVisitNode ] = iCurrentNode;
+
+				//The queue drops nodes when it's full, which makes the result depend on the destination.
+				if( fStopOnOverflow && queue.Full() )
+					return false;
+
+				queue.Insert( iVisitNode, flOurDistance );
+			}
+		}
+	}
+
+	return true;
+}
+
+int CRoutingTableBuilder::GetPath( const int iTable, const SearchResult& result, const int iStart, const int iDest, int* piPath )
+{
+	if( iStart == iDest )
+	{
+		piPath[ 0 ] = iStart;
+		piPath[ 1 ] = iDest;
+		return 2;
+	}
+
+	const float* pflClosestSoFar = result.flClosestSoFar.data();
+	const int* piPreviousNode = result.iPreviousNode.data();
+
+	if( !result.fComplete )
+	{
+		Search( iTable, iStart, iDest, m_flClosestSoFar.data(), m_iPreviousNode.data(), false );
+
+		pflClosestSoFar = m_flClosestSoFar.data();
+		piPreviousNode = m_iPreviousNode.data();
+	}
+
+	if( pflClosestSoFar[ iDest ] < -0.5 )
+	{// Destination is unreachable, no path found.
+		return 0;
+	}
+
+	int iCurrentNode = iDest;
+	int iNumPathNodes = 1;// count the dest
+
+	while( iCurrentNode != iStart )
+	{
+		++iNumPathNodes;
+		iCurrentNode = piPreviousNode[ iCurrentNode ];
+	}
+
+	iCurrentNode = iDest;
+
+	for( int i = iNumPathNodes - 1; i >= 0; --i )
+	{
+		piPath[ i ] = iCurrentNode;
+		iCurrentNode = piPreviousNode[ iCurrentNode ];
+	}
+
+	return iNumPathNodes;
+}
+
+CRoutingTableBuilder::SearchResult& CRoutingTableBuilder::WaitForItem( const int iItem )
+{
+	auto& result = *m_Results[ iItem % m_Results.size() ];
+
+	std::unique_lock<std::mutex> lock( m_Mutex );
+
+	m_ItemReady.wait( lock, [ & ]()
+	{
+		return result.fReady && result.iItem == iItem;
+	} );
+
+	return result;
+}
+
+void CRoutingTableBuilder::ReleaseItem( SearchResult& result )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+
+		result.fReady = false;
+		++m_cConsumedItems;
+	}
+
+	m_SlotFree.notify_all();
+}
@@ -0,0 +1,119 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   This source code contains proprietary and confidential information of
+*   Valve LLC and its suppliers.  Access to this code is restricted to
+*   persons who have executed a written SDK license with Valve.  Any access,
+*   use or distribution of this code by or to any unlicensed person is illegal.
+*
+****/
+#ifndef GAME_SERVER_NODES_CROUTINGTABLEBUILDER_H
+#define GAME_SERVER_NODES_CROUTINGTABLEBUILDER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CGraph;
+
+/**
+*	Builds the static routing tables for a graph using a pool of worker threads.
+*	Workers compute a full shortest path tree for one (table, source node) pair at a time, using their own scratch state.
+*	The calling thread consumes the trees in order and fills and compresses the routing tables exactly like the serial builder,
+*	so the resulting route info is identical. Rows are compressed and stored as soon as a table has been filled.
+*/
+class CRoutingTableBuilder final
+{
+public:
+	/**
+	*	@param graph Graph to build routing tables for. Nodes and links must be present.
+	*	@param cThreads Number of worker threads to use. 0 uses the hardware thread count.
+	*/
+	CRoutingTableBuilder( CGraph& graph, int cThreads );
+	~CRoutingTableBuilder();
+
+	void Build();
+
+private:
+	/**
+	*	Result of a shortest path search from a single source node.
+	*/
+	struct SearchResult
+	{
+		int iItem = -1;
+		bool fReady = false;
+
+		/**
+		*	If false the search overflowed its queue and paths must be recomputed one destination at a time.
+		*/
+		bool fComplete = false;
+
+		std::vector<float> flClosestSoFar;
+		std::vector<int> iPreviousNode;
+
+		double flSearchTime = 0;
+	};
+
+	void BuildPassableLinks();
+
+	void WorkerThread();
+
+	/**
+	*	Dijkstra search that matches CGraph::FindShortestPath's non-routed path.
+	*	@param iDest Destination to stop at, or NO_NODE to compute the full tree.
+	*	@param fStopOnOverflow If true, the search stops and returns false if the queue overflows.
+	*/
+	bool Search( const int iTable, const int iStart, const int iDest, float* pflClosestSoFar, int* piPreviousNode, const bool fStopOnOverflow ) const;
+
+	/**
+	*	Gets the path from iStart to iDest, as FindShortestPath would have returned it.
+	*/
+	int GetPath( const int iTable, const SearchResult& result, const int iStart, const int iDest, int* piPath );
+
+	SearchResult& WaitForItem( const int iItem );
+
+	void ReleaseItem( SearchResult& result );
+
+private:
+	CGraph& m_Graph;
+
+	const int m_cNodes;
+	const int m_cLinks;
+
+	int m_cThreads;
+
+	int m_cItems = 0;
+
+	/**
+	*	For each table, whether each link can be used.
+	*/
+	std::vector<unsigned char> m_Passable;
+
+	std::vector<std::unique_ptr<SearchResult>> m_Results;
+
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_ItemReady;
+	std::condition_variable m_SlotFree;
+
+	int m_iNextItem = 0;
+	int m_cConsumedItems = 0;
+
+	//Scratch state used when a tree has to be recomputed per destination.
+	std::vector<float> m_flClosestSoFar;
+	std::vector<int> m_iPreviousNode;
+
+private:
+	CRoutingTableBuilder( const CRoutingTableBuilder& ) = delete;
+	CRoutingTableBuilder& operator=( const CRoutingTableBuilder& ) = delete;
+};
+
+#endif //GAME_SERVER_NODES_CROUTINGTABLEBUILDER_H
@@ -2,6 +2,7 @@
 #include "util.h"
 #include "cbase.h"
 
+#include "CSaveRestoreFieldIndex.h"
 #include "CRestore.h"
 
 bool CRestore::ReadEntVars( const char *pname, entvars_t *pev )
@@ -15,8 +16,10 @@ bool CRestore::ReadFields( const char *pname, void *pBaseData, const DataMap_t&
 	int		lastField, fileCount;
 	HEADER	header;
 
-	i = ReadShort();
-	ASSERT( i == sizeof( int ) );			// First entry should be an int
+	const unsigned short headerSize = ReadShort();
+
+	// First entry should be an int, or an int and the hashed format version
+	ASSERT( headerSize == sizeof( int ) || headerSize == sizeof( int ) * 2 );
 
 	token = ReadShort();
 
@@ -31,6 +34,21 @@ bool CRestore::ReadFields( const char *pname, void *pBaseData, const DataMap_t&
 	// Skip over the struct name
 	fileCount = ReadInt();						// Read field count
 
+	bool bHashed = false;
+
+	if( headerSize == sizeof( int ) * 2 )
+	{
+		const int version = ReadInt();
+
+		if( version != SAVE_FIELDS_HASHED_VERSION )
+		{
+			ALERT( at_error, "CRestore::ReadFields: %s was saved with unknown field format version %d\n", pname, version );
+			return false;
+		}
+
+		bHashed = true;
+	}
+
 	lastField = 0;								// Make searches faster, most data is read/written in the same order
 
 												// Clear out base data
@@ -42,6 +60,27 @@ bool CRestore::ReadFields( const char *pname, void *pBaseData, const DataMap_t&
 			memset( ( ( char * ) pBaseData + pFields[ i ].fieldOffset ), 0, pFields[ i ].fieldSize * g_SaveRestoreSizes[ pFields[ i ].fieldType ] );
 	}
 
+	if( bHashed )
+	{
+		const auto& fieldIndex = CSaveRestoreFieldIndex::Get( pFields, fieldCount );
+
+		for( i = 0; i < fileCount; i++ )
+		{
+			const unsigned short size = ReadShort();
+			const unsigned int uiHash = ReadUnsignedInt();
+			char* pData = BufferPointer();
+			BufferSkipBytes( size );
+
+			// Fields that no longer exist are skipped
+			const int fieldNumber = fieldIndex.Find( uiHash );
+
+			if( fieldNumber != -1 )
+				ReadFieldData( pBaseData, dataMap, pFields[ fieldNumber ], pData );
+		}
+
+		return true;
+	}
+
 	for( i = 0; i < fileCount; i++ )
 	{
 		BufferReadHeader( &header );
@@ -54,13 +93,41 @@ bool CRestore::ReadFields( const char *pname, void *pBaseData, const DataMap_t&
 
 int CRestore::ReadField( void *pBaseData, const DataMap_t& dataMap, const TYPEDESCRIPTION *pFields, int fieldCount, int startField, int size, char *pName, void *pData )
 {
-	int i, j, stringCount, fieldNumber, entityIndex;
+	int i, fieldNumber;
 	const TYPEDESCRIPTION *pTest;
+
+	for( i = 0; i < fieldCount; i++ )
+	{
+		fieldNumber = ( i + startField ) % fieldCount;
+		pTest = &pFields[ fieldNumber ];
+
+		//Only check fields marked for save/restore - Solokiller
+		if( ( pTest->flags & TypeDescFlag::SAVE ) && !stricmp( pTest->fieldName, pName ) )
+		{
+			ReadFieldData( pBaseData, dataMap, *pTest, pData );
+			return fieldNumber;
+		}
+	}
+
+	return -1;
+}
+
+void CRestore::ReadFieldData( void *pBaseData, const DataMap_t& dataMap, const TYPEDESCRIPTION& field, void *pData )
+{
+	int j, stringCount, entityIndex;
 	float	time, timeData;
 	Vector	position;
 	edict_t	*pent;
 	char	*pString;
 
+	if( m_global && ( field.flags & TypeDescFlag::GLOBAL ) )
+	{
+#if 0
+		ALERT( at_console, "Skipping global field %s\n", field.fieldName );
+#endif
+		return;
+	}
+
 	time = 0;
 	position = Vector( 0, 0, 0 );
 
@@ -71,155 +138,137 @@ int CRestore::ReadField( void *pBaseData, const DataMap_t& dataMap, const TYPEDE
 			position = m_pdata->vecLandmarkOffset;
 	}
 
-	for( i = 0; i < fieldCount; i++ )
+	for( j = 0; j < field.fieldSize; j++ )
 	{
-		fieldNumber = ( i + startField ) % fieldCount;
-		pTest = &pFields[ fieldNumber ];
+		void *pOutputData = ( ( char * ) pBaseData + field.fieldOffset + ( j*g_SaveRestoreSizes[ field.fieldType ] ) );
+		void *pInputData = ( char * ) pData + j * g_SaveRestoreSizes[ field.fieldType ];
 
-		//Only check fields marked for save/restore - Solokiller
-		if( ( pTest->flags & TypeDescFlag::SAVE ) && !stricmp( pTest->fieldName, pName ) )
+		switch( field.fieldType )
 		{
-			if( !m_global || !( pTest->flags & TypeDescFlag::GLOBAL ) )
+		case FIELD_TIME:
+			timeData = *( float * ) pInputData;
+			// Re-base time variables
+			timeData += time;
+			*( ( float * ) pOutputData ) = timeData;
+			break;
+		case FIELD_FLOAT:
+			*( ( float * ) pOutputData ) = *( float * ) pInputData;
+			break;
+		case FIELD_MODELNAME:
+		case FIELD_SOUNDNAME:
+		case FIELD_STRING:
+			// Skip over j strings
+			pString = ( char * ) pData;
+			for( stringCount = 0; stringCount < j; stringCount++ )
+			{
+				while( *pString )
+					pString++;
+				pString++;
+			}
+			pInputData = pString;
+			if( strlen( ( char * ) pInputData ) == 0 )
+				*( ( int * ) pOutputData ) = 0;
+			else
 			{
-				for( j = 0; j < pTest->fieldSize; j++ )
+				int string;
+
+				//Plain strings are interned, see UTIL_SetTypeDescValue.
+				if( field.fieldType == FIELD_STRING && !strchr( ( char * ) pInputData, '\\' ) )
+					string = POOL_STRING( ( char * ) pInputData );
+				else
+					string = ALLOC_STRING( ( char * ) pInputData );
+
+				*( ( int * ) pOutputData ) = string;
+
+				if( !FStringNull( string ) && m_precache )
 				{
-					void *pOutputData = ( ( char * ) pBaseData + pTest->fieldOffset + ( j*g_SaveRestoreSizes[ pTest->fieldType ] ) );
-					void *pInputData = ( char * ) pData + j * g_SaveRestoreSizes[ pTest->fieldType ];
-
-					switch( pTest->fieldType )
-					{
-					case FIELD_TIME:
-						timeData = *( float * ) pInputData;
-						// Re-base time variables
-						timeData += time;
-						*( ( float * ) pOutputData ) = timeData;
-						break;
-					case FIELD_FLOAT:
-						*( ( float * ) pOutputData ) = *( float * ) pInputData;
-						break;
-					case FIELD_MODELNAME:
-					case FIELD_SOUNDNAME:
-					case FIELD_STRING:
-						// Skip over j strings
-						pString = ( char * ) pData;
-						for( stringCount = 0; stringCount < j; stringCount++ )
-						{
-							while( *pString )
-								pString++;
-							pString++;
-						}
-						pInputData = pString;
-						if( strlen( ( char * ) pInputData ) == 0 )
-							*( ( int * ) pOutputData ) = 0;
-						else
-						{
-							int string;
-
-							string = ALLOC_STRING( ( char * ) pInputData );
-
-							*( ( int * ) pOutputData ) = string;
-
-							if( !FStringNull( string ) && m_precache )
-							{
-								if( pTest->fieldType == FIELD_MODELNAME )
-									PRECACHE_MODEL( ( char * ) STRING( string ) );
-								else if( pTest->fieldType == FIELD_SOUNDNAME )
-									PRECACHE_SOUND( ( char * ) STRING( string ) );
-							}
-						}
-						break;
-					case FIELD_EVARS:
-						entityIndex = *( int * ) pInputData;
-						pent = EntityFromIndex( entityIndex );
-						if( pent )
-							*( ( entvars_t ** ) pOutputData ) = VARS( pent );
-						else
-							*( ( entvars_t ** ) pOutputData ) = NULL;
-						break;
-					case FIELD_CLASSPTR:
-						entityIndex = *( int * ) pInputData;
-						pent = EntityFromIndex( entityIndex );
-						if( pent )
-							*( ( CBaseEntity ** ) pOutputData ) = CBaseEntity::Instance( pent );
-						else
-							*( ( CBaseEntity ** ) pOutputData ) = NULL;
-						break;
-					case FIELD_EDICT:
-						entityIndex = *( int * ) pInputData;
-						pent = EntityFromIndex( entityIndex );
-						*( ( edict_t ** ) pOutputData ) = pent;
-						break;
-					case FIELD_EHANDLE:
-						// Input and Output sizes are different!
-						pOutputData = ( char * ) pOutputData + j*( sizeof( EHANDLE ) - g_SaveRestoreSizes[ pTest->fieldType ] );
-						entityIndex = *( int * ) pInputData;
-						pent = EntityFromIndex( entityIndex );
-						if( pent )
-							*( ( EHANDLE * ) pOutputData ) = CBaseEntity::Instance( pent );
-						else
-							*( ( EHANDLE * ) pOutputData ) = NULL;
-						break;
-					case FIELD_ENTITY:
-						entityIndex = *( int * ) pInputData;
-						pent = EntityFromIndex( entityIndex );
-						if( pent )
-							*( ( EOFFSET * ) pOutputData ) = OFFSET( pent );
-						else
-							*( ( EOFFSET * ) pOutputData ) = 0;
-						break;
-					case FIELD_VECTOR:
-						( ( float * ) pOutputData )[ 0 ] = ( ( float * ) pInputData )[ 0 ];
-						( ( float * ) pOutputData )[ 1 ] = ( ( float * ) pInputData )[ 1 ];
-						( ( float * ) pOutputData )[ 2 ] = ( ( float * ) pInputData )[ 2 ];
-						break;
-					case FIELD_POSITION_VECTOR:
-						( ( float * ) pOutputData )[ 0 ] = ( ( float * ) pInputData )[ 0 ] + position.x;
-						( ( float * ) pOutputData )[ 1 ] = ( ( float * ) pInputData )[ 1 ] + position.y;
-						( ( float * ) pOutputData )[ 2 ] = ( ( float * ) pInputData )[ 2 ] + position.z;
-						break;
-
-					case FIELD_BOOLEAN:
-						*( ( bool* ) pOutputData ) = *( bool* ) pInputData;
-						break;
-
-					case FIELD_INTEGER:
-						*( ( int * ) pOutputData ) = *( int * ) pInputData;
-						break;
-
-					case FIELD_SHORT:
-						*( ( short * ) pOutputData ) = *( short * ) pInputData;
-						break;
-
-					case FIELD_CHARACTER:
-						*( ( char * ) pOutputData ) = *( char * ) pInputData;
-						break;
-
-					case FIELD_FUNCPTR:
-						if( strlen( ( char * ) pInputData ) == 0 )
-							*( ( int * ) pOutputData ) = 0;
-						else
-						{
-							//All member functions pointers should have the same size, so this should work fine. - Solokiller
-							*( ( BASEPTR * ) pOutputData ) = UTIL_FunctionFromName( dataMap, ( const char* ) pInputData );
-						}
-						break;
-
-					default:
-						ALERT( at_error, "Bad field type\n" );
-					}
+					if( field.fieldType == FIELD_MODELNAME )
+						PRECACHE_MODEL( ( char * ) STRING( string ) );
+					else if( field.fieldType == FIELD_SOUNDNAME )
+						PRECACHE_SOUND( ( char * ) STRING( string ) );
 				}
 			}
-#if 0
+			break;
+		case FIELD_EVARS:
+			entityIndex = *( int * ) pInputData;
+			pent = EntityFromIndex( entityIndex );
+			if( pent )
+				*( ( entvars_t ** ) pOutputData ) = VARS( pent );
+			else
+				*( ( entvars_t ** ) pOutputData ) = NULL;
+			break;
+		case FIELD_CLASSPTR:
+			entityIndex = *( int * ) pInputData;
+			pent = EntityFromIndex( entityIndex );
+			if( pent )
+				*( ( CBaseEntity ** ) pOutputData ) = CBaseEntity::Instance( pent );
+			else
+				*( ( CBaseEntity ** ) pOutputData ) = NULL;
+			break;
+		case FIELD_EDICT:
+			entityIndex = *( int * ) pInputData;
+			pent = EntityFromIndex( entityIndex );
+			*( ( edict_t ** ) pOutputData ) = pent;
+			break;
+		case FIELD_EHANDLE:
+			// Input and Output sizes are different!
+			pOutputData = ( char * ) pOutputData + j*( sizeof( EHANDLE ) - g_SaveRestoreSizes[ field.fieldType ] );
+			entityIndex = *( int * ) pInputData;
+			pent = EntityFromIndex( entityIndex );
+			if( pent )
+				*( ( EHANDLE * ) pOutputData ) = CBaseEntity::Instance( pent );
+			else
+				*( ( EHANDLE * ) pOutputData ) = NULL;
+			break;
+		case FIELD_ENTITY:
+			entityIndex = *( int * ) pInputData;
+			pent = EntityFromIndex( entityIndex );
+			if( pent )
+				*( ( EOFFSET * ) pOutputData ) = OFFSET( pent );
+			else
+				*( ( EOFFSET * ) pOutputData ) = 0;
+			break;
+		case FIELD_VECTOR:
+			( ( float * ) pOutputData )[ 0 ] = ( ( float * ) pInputData )[ 0 ];
+			( ( float * ) pOutputData )[ 1 ] = ( ( float * ) pInputData )[ 1 ];
+			( ( float * ) pOutputData )[ 2 ] = ( ( float * ) pInputData )[ 2 ];
+			break;
+		case FIELD_POSITION_VECTOR:
+			( ( float * ) pOutputData )[ 0 ] = ( ( float * ) pInputData )[ 0 ] + position.x;
+			( ( float * ) pOutputData )[ 1 ] = ( ( float * ) pInputData )[ 1 ] + position.y;
+			( ( float * ) pOutputData )[ 2 ] = ( ( float * ) pInputData )[ 2 ] + position.z;
+			break;
+
+		case FIELD_BOOLEAN:
+			*( ( bool* ) pOutputData ) = *( bool* ) pInputData;
+			break;
+
+		case FIELD_INTEGER:
+			*( ( int * ) pOutputData ) = *( int * ) pInputData;
+			break;
+
+		case FIELD_SHORT:
+			*( ( short * ) pOutputData ) = *( short * ) pInputData;
+			break;
+
+		case FIELD_CHARACTER:
+			*( ( char * ) pOutputData ) = *( char * ) pInputData;
+			break;
+
+		case FIELD_FUNCPTR:
+			if( strlen( ( char * ) pInputData ) == 0 )
+				*( ( int * ) pOutputData ) = 0;
 			else
 			{
-				ALERT( at_console, "Skipping global field %s\n", pName );
+				//All member functions pointers should have the same size, so this should work fine. - Solokiller
+				*( ( BASEPTR * ) pOutputData ) = UTIL_FunctionFromName( dataMap, ( const char* ) pInputData );
 			}
-#endif
-			return fieldNumber;
+			break;
+
+		default:
+			ALERT( at_error, "Bad field type\n" );
 		}
 	}
-
-	return -1;
 }
 
 int	CRestore::ReadInt( void )
@@ -231,6 +280,15 @@ int	CRestore::ReadInt( void )
 	return tmp;
 }
 
+unsigned int CRestore::ReadUnsignedInt()
+{
+	unsigned int tmp = 0;
+
+	BufferReadBytes( ( char * ) &tmp, sizeof( unsigned int ) );
+
+	return tmp;
+}
+
 short CRestore::ReadShort( void )
 {
 	short tmp = 0;
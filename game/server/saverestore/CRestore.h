@@ -31,7 +31,13 @@ public:
 	bool	ReadEntVars( const char *pname, entvars_t *pev );		// entvars_t
 	bool	ReadFields( const char *pname, void *pBaseData, const DataMap_t& dataMap, const TYPEDESCRIPTION *pFields, int fieldCount );
 	int		ReadField( void *pBaseData, const DataMap_t& dataMap, const TYPEDESCRIPTION *pFields, int fieldCount, int startField, int size, char *pName, void *pData );
+
+	/**
+	*	Reads the data of a single field. Global fields are skipped when restoring a global entity.
+	*/
+	void	ReadFieldData( void *pBaseData, const DataMap_t& dataMap, const TYPEDESCRIPTION& field, void *pData );
 	int		ReadInt( void );
+	unsigned int ReadUnsignedInt();
 	short	ReadShort( void );
 	int		ReadNamedInt( const char *pName );
 	char	*ReadNamedString( const char *pName );
@@ -2,8 +2,15 @@
 #include "util.h"
 #include "cbase.h"
 
+#include "CSaveRestoreFieldIndex.h"
 #include "CSave.h"
 
+CSave::CSave( SAVERESTOREDATA *pdata )
+	: CSaveRestoreBuffer( pdata )
+	, m_bHashedFormat( false )
+{
+}
+
 void CSave::WriteData( const char *pname, int size, const char *pdata )
 {
 	BufferField( pname, size, pdata );
@@ -141,6 +148,10 @@ bool CSave::WriteFields( const char *pname, void *pBaseData, const DataMap_t& da
 	const TYPEDESCRIPTION	*pTest;
 	int				entityArray[ MAX_ENTITYARRAY ];
 
+	const auto& fieldIndex = CSaveRestoreFieldIndex::Get( pFields, fieldCount );
+
+	const bool bHashed = m_bHashedFormat && fieldIndex.IsValid();
+
 	// Precalculate the number of empty fields
 	int actualCount = 0;
 	for( i = 0; i < fieldCount; i++ )
@@ -153,7 +164,13 @@ bool CSave::WriteFields( const char *pname, void *pBaseData, const DataMap_t& da
 	}
 
 	// Empty fields will not be written, write out the actual number of fields to be written
-	WriteInt( pname, &actualCount, 1 );
+	if( bHashed )
+	{
+		const int header[] = { actualCount, SAVE_FIELDS_HASHED_VERSION };
+		WriteInt( pname, header, ARRAYSIZE( header ) );
+	}
+	else
+		WriteInt( pname, &actualCount, 1 );
 
 	for( i = 0; i < fieldCount; i++ )
 	{
@@ -166,6 +183,9 @@ bool CSave::WriteFields( const char *pname, void *pBaseData, const DataMap_t& da
 		if( !( pTest->flags & TypeDescFlag::SAVE ) || DataEmpty( ( const char * ) pOutputData, pTest->fieldSize * g_SaveRestoreSizes[ pTest->fieldType ] ) )
 			continue;
 
+		m_bHashedHeader = bHashed;
+		m_uiFieldHash = fieldIndex.GetHash( i );
+
 		switch( pTest->fieldType )
 		{
 		case FIELD_FLOAT:
@@ -246,6 +266,8 @@ bool CSave::WriteFields( const char *pname, void *pBaseData, const DataMap_t& da
 		default:
 			ALERT( at_error, "Bad field type\n" );
 		}
+
+		m_bHashedHeader = false;
 	}
 
 	return true;
@@ -294,9 +316,17 @@ void CSave::BufferData( const char *pdata, int size )
 
 void CSave::BufferHeader( const char *pname, int size )
 {
-	short	hashvalue = TokenHash( pname );
 	if( size > 1 << ( sizeof( short ) * 8 ) )
 		ALERT( at_error, "CSave :: BufferHeader() size parameter exceeds 'short'!" );
+
+	if( m_bHashedHeader )
+	{
+		BufferData( ( const char * ) &size, sizeof( short ) );
+		BufferData( ( const char * ) &m_uiFieldHash, sizeof( m_uiFieldHash ) );
+		return;
+	}
+
+	short	hashvalue = TokenHash( pname );
 	BufferData( ( const char * ) &size, sizeof( short ) );
 	BufferData( ( const char * ) &hashvalue, sizeof( short ) );
 }
\ No newline at end of file
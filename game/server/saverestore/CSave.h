@@ -28,7 +28,17 @@ public:
 	static const size_t MAX_ENTITYARRAY = 64;
 
 public:
-	CSave( SAVERESTOREDATA *pdata ) : CSaveRestoreBuffer( pdata ) {};
+	CSave( SAVERESTOREDATA *pdata );
+
+	/**
+	*	@return Whether WriteFields uses the hashed format. Defaults to false, entity data is written in the format selected by sv_save_hashed_fields.
+	*/
+	bool IsHashedFormat() const { return m_bHashedFormat; }
+
+	void SetHashedFormat( const bool bHashedFormat )
+	{
+		m_bHashedFormat = bHashedFormat;
+	}
 
 	/**
 	*	Writes a boolean to the buffer.
@@ -58,6 +68,15 @@ private:
 	void	BufferString( char *pdata, int len );
 	void	BufferData( const char *pdata, int size );
 	void	BufferHeader( const char *pname, int size );
+
+private:
+	bool m_bHashedFormat;
+
+	/**
+	*	If set, BufferHeader writes a hashed field header using m_uiFieldHash instead of the name token.
+	*/
+	bool m_bHashedHeader = false;
+	unsigned int m_uiFieldHash = 0;
 };
 
 #endif //GAME_SERVER_SAVERESTORE_CSAVE_H
\ No newline at end of file
@@ -186,6 +186,12 @@ int	CSaveRestoreBuffer::EntityIndex( edict_t *pentLookup )
 	if( !m_pdata || pentLookup == NULL )
 		return -1;
 
+	// The table is normally in edict order, so check the entity's own slot first
+	const int iIndex = ENTINDEX( pentLookup );
+
+	if( iIndex >= 0 && iIndex < m_pdata->tableCount && m_pdata->pTable[ iIndex ].pent == pentLookup )
+		return iIndex;
+
 	int i;
 	ENTITYTABLE *pTable;
 
@@ -203,6 +209,10 @@ edict_t *CSaveRestoreBuffer::EntityFromIndex( int entityIndex )
 	if( !m_pdata || entityIndex < 0 )
 		return NULL;
 
+	// Ids are normally identical to the position in the table
+	if( entityIndex < m_pdata->tableCount && m_pdata->pTable[ entityIndex ].id == entityIndex )
+		return m_pdata->pTable[ entityIndex ].pent;
+
 	int i;
 	ENTITYTABLE *pTable;
 
@@ -28,6 +28,14 @@ extern const int g_SaveRestoreSizes[];
 
 extern const DataMap_t gEntvarsDataMap;
 
+/**
+*	Version of the hashed field format written by CSave::WriteFields.
+*	Legacy blocks start with only a field count, hashed blocks with a field count and this version.
+*	Hashed fields are identified by the hash of their name instead of a name token.
+*	@see CSaveRestoreFieldIndex
+*/
+const int SAVE_FIELDS_HASHED_VERSION = 1;
+
 /**
 *	A buffer that contains save/restore data.
 */
@@ -0,0 +1,72 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <memory>
+
+#include "extdll.h"
+#include "util.h"
+
+#include "StringUtils.h"
+
+#include "CSaveRestoreFieldIndex.h"
+
+const CSaveRestoreFieldIndex& CSaveRestoreFieldIndex::Get( const TYPEDESCRIPTION* pFields, const int fieldCount )
+{
+	//Type description arrays are static, so their address identifies them.
+	static std::unordered_map<const TYPEDESCRIPTION*, std::unique_ptr<CSaveRestoreFieldIndex>> tables;
+
+	auto it = tables.find( pFields );
+
+	if( it == tables.end() )
+	{
+		it = tables.emplace( pFields, std::make_unique<CSaveRestoreFieldIndex>( pFields, fieldCount ) ).first;
+	}
+
+	return *it->second;
+}
+
+unsigned int CSaveRestoreFieldIndex::HashFieldName( const char* pszName )
+{
+	return StringHashFNV1a( pszName, true );
+}
+
+CSaveRestoreFieldIndex::CSaveRestoreFieldIndex( const TYPEDESCRIPTION* pFields, const int fieldCount )
+{
+	m_Hashes.resize( fieldCount );
+
+	for( int i = 0; i < fieldCount; ++i )
+	{
+		m_Hashes[ i ] = HashFieldName( pFields[ i ].fieldName );
+
+		if( !( pFields[ i ].flags & TypeDescFlag::SAVE ) )
+			continue;
+
+		if( !m_Lookup.emplace( m_Hashes[ i ], i ).second )
+		{
+			ALERT( at_console, "CSaveRestoreFieldIndex: fields \"%s\" and \"%s\" have the same hash, using the legacy save format\n",
+				   pFields[ m_Lookup[ m_Hashes[ i ] ] ].fieldName, pFields[ i ].fieldName );
+			m_bValid = false;
+		}
+	}
+}
+
+int CSaveRestoreFieldIndex::Find( const unsigned int uiHash ) const
+{
+	auto it = m_Lookup.find( uiHash );
+
+	if( it == m_Lookup.end() )
+		return -1;
+
+	return it->second;
+}
@@ -0,0 +1,70 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_SAVERESTORE_CSAVERESTOREFIELDINDEX_H
+#define GAME_SERVER_SAVERESTORE_CSAVERESTOREFIELDINDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "SaveRestoreDefs.h"
+
+/**
+*	Lookup table for the saved fields in a type description array, used by the hashed save format.
+*	Fields are identified by a hash of their name, so saves still load after fields are added, removed or reordered.
+*	Tables are built the first time an array is saved or restored and are kept for the lifetime of the library.
+*/
+class CSaveRestoreFieldIndex final
+{
+public:
+	/**
+	*	Gets the table for the given type description array, building it if needed.
+	*/
+	static const CSaveRestoreFieldIndex& Get( const TYPEDESCRIPTION* pFields, const int fieldCount );
+
+	/**
+	*	Hashes a field name. Case insensitive, since the legacy format matches names with stricmp.
+	*/
+	static unsigned int HashFieldName( const char* pszName );
+
+	CSaveRestoreFieldIndex( const TYPEDESCRIPTION* pFields, const int fieldCount );
+
+	/**
+	*	@return Whether this table can be used. False if two saved fields have the same hash, in which case the legacy format must be used.
+	*/
+	bool IsValid() const { return m_bValid; }
+
+	/**
+	*	@return The hash of the given field.
+	*/
+	unsigned int GetHash( const int iField ) const { return m_Hashes[ iField ]; }
+
+	/**
+	*	@return Index of the saved field with the given hash, or -1 if there is no such field.
+	*/
+	int Find( const unsigned int uiHash ) const;
+
+private:
+	std::vector<unsigned int> m_Hashes;
+
+	std::unordered_map<unsigned int, int> m_Lookup;
+
+	bool m_bValid = true;
+
+private:
+	CSaveRestoreFieldIndex( const CSaveRestoreFieldIndex& ) = delete;
+	CSaveRestoreFieldIndex& operator=( const CSaveRestoreFieldIndex& ) = delete;
+};
+
+#endif //GAME_SERVER_SAVERESTORE_CSAVERESTOREFIELDINDEX_H
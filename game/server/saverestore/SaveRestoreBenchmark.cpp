@@ -0,0 +1,293 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+
+#include "CSave.h"
+#include "CRestore.h"
+
+#include "SaveRestoreBenchmark.h"
+
+namespace
+{
+/**
+*	Stands in for the class specific data of a typical entity.
+*/
+struct BenchmarkEntity
+{
+	float m_flNextAttack;
+	float m_flFieldOfView;
+	float m_flWaitFinished;
+	float m_flMoveWaitTime;
+	int m_iState;
+	int m_iTaskStatus;
+	int m_iScheduleIndex;
+	int m_iCapability;
+	int m_afConditions;
+	int m_afMemory;
+	int m_iHintNode;
+	int m_iTriggerCondition;
+	bool m_fSequenceFinished;
+	bool m_fSequenceLoops;
+	bool m_bActive;
+	short m_sFlags;
+	char m_cAmmoLoaded;
+	Vector m_vecEnemyLKP;
+	Vector m_vecLastPosition;
+	Vector m_vecPosition1;
+	Vector m_vecPosition2;
+	float m_flTimes[ 4 ];
+	int m_iCounters[ 8 ];
+	Vector m_vecRoute[ 8 ];
+};
+
+const TYPEDESCRIPTION g_BenchmarkEntityDescription[] =
+{
+	_FIELD( BenchmarkEntity, m_flNextAttack, FIELD_TIME, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_flFieldOfView, FIELD_FLOAT, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_flWaitFinished, FIELD_TIME, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_flMoveWaitTime, FIELD_TIME, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iState, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iTaskStatus, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iScheduleIndex, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iCapability, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_afConditions, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_afMemory, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iHintNode, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iTriggerCondition, FIELD_INTEGER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_fSequenceFinished, FIELD_BOOLEAN, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_fSequenceLoops, FIELD_BOOLEAN, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_bActive, FIELD_BOOLEAN, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_sFlags, FIELD_SHORT, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_cAmmoLoaded, FIELD_CHARACTER, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_vecEnemyLKP, FIELD_POSITION_VECTOR, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_vecLastPosition, FIELD_POSITION_VECTOR, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_vecPosition1, FIELD_POSITION_VECTOR, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_vecPosition2, FIELD_POSITION_VECTOR, 1, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_flTimes, FIELD_FLOAT, 4, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_iCounters, FIELD_INTEGER, 8, TypeDescFlag::SAVE ),
+	_FIELD( BenchmarkEntity, m_vecRoute, FIELD_VECTOR, 8, TypeDescFlag::SAVE ),
+};
+
+const DataMap_t g_BenchmarkEntityDataMap = { "BenchmarkEntity", nullptr, g_BenchmarkEntityDescription, ARRAYSIZE( g_BenchmarkEntityDescription ) };
+
+//Same size as the engine's token table.
+const int BENCHMARK_TOKEN_COUNT = 0xFFF;
+
+//Generous upper bound for the data written per entity.
+const int BENCHMARK_BYTES_PER_ENTITY = 4096;
+
+float RandomFloat()
+{
+	return static_cast<float>( rand() % 20000 ) / 10.0f - 1000.0f;
+}
+
+Vector RandomVector()
+{
+	return Vector( RandomFloat(), RandomFloat(), RandomFloat() );
+}
+
+/**
+*	Fills in the fields that are set on a typical entity. Strings and entity references are left empty so restoring doesn't allocate engine strings.
+*/
+void InitializeEntity( entvars_t& vars, BenchmarkEntity& entity, const int iIndex )
+{
+	memset( static_cast<void*>( &vars ), 0, sizeof( vars ) );
+	memset( static_cast<void*>( &entity ), 0, sizeof( entity ) );
+
+	vars.origin = RandomVector();
+	vars.angles = Vector( 0, static_cast<float>( rand() % 360 ), 0 );
+	vars.absmin = vars.origin - Vector( 16, 16, 0 );
+	vars.absmax = vars.origin + Vector( 16, 16, 72 );
+	vars.mins = Vector( -16, -16, 0 );
+	vars.maxs = Vector( 16, 16, 72 );
+	vars.size = vars.maxs - vars.mins;
+	vars.solid = SOLID_SLIDEBOX;
+	vars.movetype = MOVETYPE_STEP;
+	vars.modelindex = 1 + iIndex % 64;
+	vars.health = 100;
+	vars.max_health = 100;
+	vars.takedamage = DAMAGE_AIM;
+	vars.nextthink = 0.1f;
+	vars.animtime = 0.05f;
+	vars.framerate = 1;
+	vars.sequence = iIndex % 16;
+	vars.spawnflags = iIndex & 0xFF;
+	vars.flags = FL_MONSTER;
+	vars.view_ofs = Vector( 0, 0, 64 );
+	vars.yaw_speed = 90;
+
+	entity.m_flNextAttack = 1;
+	entity.m_flFieldOfView = 0.5f;
+	entity.m_iState = 1 + iIndex % 3;
+	entity.m_iScheduleIndex = iIndex % 8;
+	entity.m_iCapability = 0x10;
+	entity.m_afConditions = iIndex;
+	entity.m_iHintNode = -1;
+	entity.m_fSequenceLoops = true;
+	entity.m_bActive = ( iIndex & 1 ) != 0;
+	entity.m_sFlags = static_cast<short>( iIndex );
+	entity.m_cAmmoLoaded = 30;
+	entity.m_vecEnemyLKP = RandomVector();
+	entity.m_vecLastPosition = RandomVector();
+	entity.m_vecPosition1 = vars.origin;
+
+	for( auto& flTime : entity.m_flTimes )
+		flTime = RandomFloat();
+
+	for( int i = 0; i < 4; ++i )
+		entity.m_iCounters[ i ] = rand();
+
+	for( int i = 0; i < 4; ++i )
+		entity.m_vecRoute[ i ] = RandomVector();
+}
+
+struct BenchmarkResult
+{
+	double flSaveTime = 0;
+	double flRestoreTime = 0;
+	int iSize = 0;
+	bool bSuccess = true;
+};
+
+BenchmarkResult RunBenchmark( const bool bHashed, const int cIterations,
+							  std::vector<entvars_t>& vars, std::vector<BenchmarkEntity>& entities,
+							  std::vector<entvars_t>& restoredVars, std::vector<BenchmarkEntity>& restoredEntities )
+{
+	const int cEntities = static_cast<int>( vars.size() );
+
+	std::vector<char> buffer( cEntities * BENCHMARK_BYTES_PER_ENTITY );
+	std::vector<char*> tokens( BENCHMARK_TOKEN_COUNT );
+
+	SAVERESTOREDATA data;
+
+	memset( static_cast<void*>( &data ), 0, sizeof( data ) );
+
+	data.pBaseData = buffer.data();
+	data.tokenCount = BENCHMARK_TOKEN_COUNT;
+	data.pTokens = tokens.data();
+	data.time = gpGlobals->time;
+
+	BenchmarkResult result;
+
+	for( int iIteration = 0; iIteration < cIterations; ++iIteration )
+	{
+		data.pCurrentData = data.pBaseData;
+		data.size = 0;
+		data.bufferSize = static_cast<int>( buffer.size() );
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		CSave save( &data );
+
+		save.SetHashedFormat( bHashed );
+
+		for( int i = 0; i < cEntities; ++i )
+		{
+			save.WriteEntVars( "ENTVARS", &vars[ i ] );
+			save.WriteFields( g_BenchmarkEntityDataMap.pszClassName, &entities[ i ],
+							  g_BenchmarkEntityDataMap, g_BenchmarkEntityDataMap.pTypeDesc, g_BenchmarkEntityDataMap.uiNumDescriptors );
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		result.flSaveTime += std::chrono::duration<double>( end - start ).count();
+		result.iSize = data.size;
+
+		data.bufferSize = data.size;
+		data.pCurrentData = data.pBaseData;
+		data.size = 0;
+
+		start = std::chrono::high_resolution_clock::now();
+
+		CRestore restore( &data );
+
+		restore.PrecacheMode( false );
+
+		for( int i = 0; i < cEntities; ++i )
+		{
+			if( !restore.ReadEntVars( "ENTVARS", &restoredVars[ i ] ) ||
+				!restore.ReadFields( g_BenchmarkEntityDataMap.pszClassName, &restoredEntities[ i ],
+									 g_BenchmarkEntityDataMap, g_BenchmarkEntityDataMap.pTypeDesc, g_BenchmarkEntityDataMap.uiNumDescriptors ) )
+			{
+				result.bSuccess = false;
+				break;
+			}
+		}
+
+		end = std::chrono::high_resolution_clock::now();
+
+		result.flRestoreTime += std::chrono::duration<double>( end - start ).count();
+	}
+
+	result.flSaveTime /= cIterations;
+	result.flRestoreTime /= cIterations;
+
+	return result;
+}
+}
+
+void ServerCommand_SaveRestoreBenchmark()
+{
+	int cEntities = 5000;
+	int cIterations = 5;
+
+	if( CMD_ARGC() >= 2 )
+		cEntities = max( 1, atoi( CMD_ARGV( 1 ) ) );
+
+	if( CMD_ARGC() >= 3 )
+		cIterations = max( 1, atoi( CMD_ARGV( 2 ) ) );
+
+	//Use the same world for both formats.
+	srand( 0 );
+
+	std::vector<entvars_t> vars( cEntities );
+	std::vector<BenchmarkEntity> entities( cEntities );
+
+	for( int i = 0; i < cEntities; ++i )
+		InitializeEntity( vars[ i ], entities[ i ], i );
+
+	std::vector<entvars_t> legacyVars( cEntities );
+	std::vector<BenchmarkEntity> legacyEntities( cEntities );
+
+	std::vector<entvars_t> hashedVars( cEntities );
+	std::vector<BenchmarkEntity> hashedEntities( cEntities );
+
+	memset( static_cast<void*>( legacyVars.data() ), 0, sizeof( entvars_t ) * cEntities );
+	memset( static_cast<void*>( legacyEntities.data() ), 0, sizeof( BenchmarkEntity ) * cEntities );
+	memset( static_cast<void*>( hashedVars.data() ), 0, sizeof( entvars_t ) * cEntities );
+	memset( static_cast<void*>( hashedEntities.data() ), 0, sizeof( BenchmarkEntity ) * cEntities );
+
+	const auto legacy = RunBenchmark( false, cIterations, vars, entities, legacyVars, legacyEntities );
+	const auto hashed = RunBenchmark( true, cIterations, vars, entities, hashedVars, hashedEntities );
+
+	ALERT( at_console, "Save/restore benchmark: %d entities, %d iterations\n", cEntities, cIterations );
+	ALERT( at_console, "Legacy:  save %.2f ms, restore %.2f ms, %d bytes%s\n",
+		   legacy.flSaveTime * 1000, legacy.flRestoreTime * 1000, legacy.iSize, legacy.bSuccess ? "" : " (restore FAILED)" );
+	ALERT( at_console, "Hashed:  save %.2f ms, restore %.2f ms, %d bytes%s\n",
+		   hashed.flSaveTime * 1000, hashed.flRestoreTime * 1000, hashed.iSize, hashed.bSuccess ? "" : " (restore FAILED)" );
+
+	//Both formats must restore exactly the same data.
+	const bool bMatch =
+		!memcmp( legacyVars.data(), hashedVars.data(), sizeof( entvars_t ) * cEntities ) &&
+		!memcmp( legacyEntities.data(), hashedEntities.data(), sizeof( BenchmarkEntity ) * cEntities );
+
+	ALERT( at_console, "Restored data %s\n", bMatch ? "matches" : "DOES NOT MATCH" );
+}
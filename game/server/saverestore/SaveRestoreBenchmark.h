@@ -0,0 +1,24 @@
+/***
+*
+*	Copyright (c) 1996-2001, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef GAME_SERVER_SAVERESTORE_SAVERESTOREBENCHMARK_H
+#define GAME_SERVER_SAVERESTORE_SAVERESTOREBENCHMARK_H
+
+/**
+*	Server command that saves and restores a synthetic world in both the legacy and hashed field formats and reports the time taken.
+*	Usage: sv_saverestore_benchmark [entity count] [iterations]
+*/
+void ServerCommand_SaveRestoreBenchmark();
+
+#endif //GAME_SERVER_SAVERESTORE_SAVERESTOREBENCHMARK_H
@@ -66,6 +66,11 @@ enum TypeDescFlag : TypeDescFlags_t
 	*	This field can be automatically initialized by DispatchKeyValue. - Solokiller
 	*/
 	KEY		= 0x0004,
+
+	/**
+	*	This field's key name must match exactly, instead of ignoring case. - Solokiller
+	*/
+	KEY_CASE_SENSITIVE	= 0x0008,
 };
 }
 
@@ -174,6 +179,14 @@ inline TypeDescFlags_t _DEFINE_KEYFIELD_FLAGS( const int iDummy, const bool bSav
 #define DEFINE_KEYFIELD( name, fieldtype, szKVName, ... )																												\
 { fieldtype, #name, szKVName, static_cast<int>( OFFSETOF( ThisClass, name ) ), 1, static_cast<TypeDescFlags_t>( _DEFINE_KEYFIELD_FLAGS( 0, ##__VA_ARGS__ ) ), nullptr }
 
+/**
+*	Same as DEFINE_KEYFIELD, but the keyvalue name is matched case sensitively. - Solokiller
+*	Used for keys that used to be handled with FStrEq in KeyValue.
+*	@see DEFINE_KEYFIELD
+*/
+#define DEFINE_CASE_SENSITIVE_KEYFIELD( name, fieldtype, szKVName, ... )																									\
+{ fieldtype, #name, szKVName, static_cast<int>( OFFSETOF( ThisClass, name ) ), 1, static_cast<TypeDescFlags_t>( _DEFINE_KEYFIELD_FLAGS( 0, ##__VA_ARGS__ ) | TypeDescFlag::KEY_CASE_SENSITIVE ), nullptr }
+
 /**
 *	Defines a function for entry in the datadesc.
 *	@param name Name of the function. This is the name of the function without the class name or scope.
@@ -125,7 +125,6 @@ float TEXTURETYPE_PlaySound(const TraceResult& tr, Vector vecSrc, Vector vecEnd,
 {
 	// hit the world, try to play sound based on texture material type
 	
-	char szbuffer[64];
 	const texture_t* pTexture;
 
 	if ( !g_pGameRules->PlayTextureSounds() )
@@ -149,22 +148,10 @@ float TEXTURETYPE_PlaySound(const TraceResult& tr, Vector vecSrc, Vector vecEnd,
 			
 		if ( pTexture )
 		{
-			const char* pszTextureName = pTexture->name;
-
-			// strip leading '-0' or '+0~' or '{' or '!'
-			if (*pszTextureName == '-' || *pszTextureName == '+')
-				pszTextureName += 2;
-
-			if (*pszTextureName == '{' || *pszTextureName == '!' || *pszTextureName == '~' || *pszTextureName == ' ')
-				++pszTextureName;
-			// '}}'
-			strcpy( szbuffer, pszTextureName );
-			szbuffer[CBTEXTURENAMEMAX - 1] = 0;
-				
-			// ALERT ( at_console, "texture hit: %s\n", szbuffer);
-
-			// get texture type
-			chTextureType = g_MaterialsList.FindTextureType(szbuffer);	
+			// ALERT ( at_console, "texture hit: %s\n", pTexture->name);
+
+			// get texture type, cached per engine texture
+			chTextureType = g_MaterialsList.FindEngineTextureType( pTexture->name );
 		}
 	}
 
@@ -30,6 +30,9 @@
 #include "CBasePlayer.h"
 #include "Weapons.h"
 #include "gamerules/GameRules.h"
+#include "CEntityGrid.h"
+#include "CEntityNameIndex.h"
+#include "Server.h"
 
 void UTIL_ParametricRocket( CBaseEntity* pEntity, Vector vecOrigin, Vector vecAngles, CBaseEntity* pOwner )
 {	
@@ -122,92 +125,143 @@ bool UTIL_GetNextBestWeapon( CBasePlayer *pPlayer, CBasePlayerWeapon *pCurrentWe
 	return g_pGameRules->GetNextBestWeapon( pPlayer, pCurrentWeapon );
 }
 
-int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, const Vector &maxs, int flagMask )
+namespace
 {
-	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
-	CBaseEntity *pEntity;
-	int			count;
+bool UTIL_EntityInBox( const edict_t* pEdict, const Vector &mins, const Vector &maxs, int flagMask )
+{
+	if ( pEdict->free )	// Not in use
+		return false;
 
-	count = 0;
+	if ( flagMask && !(pEdict->v.flags & flagMask) )	// Does it meet the criteria?
+		return false;
 
-	if ( !pEdict )
-		return count;
+	if ( mins.x > pEdict->v.absmax.x ||
+		 mins.y > pEdict->v.absmax.y ||
+		 mins.z > pEdict->v.absmax.z ||
+		 maxs.x < pEdict->v.absmin.x ||
+		 maxs.y < pEdict->v.absmin.y ||
+		 maxs.z < pEdict->v.absmin.z )
+		 return false;
 
-	for ( int i = 1; i < gpGlobals->maxEntities; i++, pEdict++ )
+	return true;
+}
+
+bool UTIL_MonsterInSphere( const edict_t* pEdict, const Vector &center, float radiusSquared )
+{
+	float		distance, delta;
+
+	if ( pEdict->free )	// Not in use
+		return false;
+
+	if ( !(pEdict->v.flags & (FL_CLIENT|FL_MONSTER)) )	// Not a client/monster ?
+		return false;
+
+	// Use origin for X & Y since they are centered for all monsters
+	// Now X
+	delta = center.x - pEdict->v.origin.x;//(pEdict->v.absmin.x + pEdict->v.absmax.x)*0.5;
+	delta *= delta;
+
+	if ( delta > radiusSquared )
+		return false;
+	distance = delta;
+
+	// Now Y
+	delta = center.y - pEdict->v.origin.y;//(pEdict->v.absmin.y + pEdict->v.absmax.y)*0.5;
+	delta *= delta;
+
+	distance += delta;
+	if ( distance > radiusSquared )
+		return false;
+
+	// Now Z
+	delta = center.z - (pEdict->v.absmin.z + pEdict->v.absmax.z)*0.5;
+	delta *= delta;
+
+	distance += delta;
+	if ( distance > radiusSquared )
+		return false;
+
+	return true;
+}
+
+/**
+*	Matches the engine's FIND_ENTITY_IN_SPHERE test: distance from the center to the entity's bounds.
+*/
+bool UTIL_EntityInSphere( const int iIndex, edict_t* pEdict, const Vector &vecCenter, float flRadiusSquared )
+{
+	if( pEdict->free || !pEdict->v.classname )
+		return false;
+
+	//The engine skips inactive clients.
+	if( iIndex <= gpGlobals->maxClients )
 	{
-		if ( pEdict->free )	// Not in use
-			continue;
-		
-		if ( flagMask && !(pEdict->v.flags & flagMask) )	// Does it meet the criteria?
-			continue;
+		auto pPlayer = static_cast<CBasePlayer*>( CBaseEntity::Instance( pEdict ) );
 
-		if ( mins.x > pEdict->v.absmax.x ||
-			 mins.y > pEdict->v.absmax.y ||
-			 mins.z > pEdict->v.absmax.z ||
-			 maxs.x < pEdict->v.absmin.x ||
-			 maxs.y < pEdict->v.absmin.y ||
-			 maxs.z < pEdict->v.absmin.z )
-			 continue;
+		if( !pPlayer || !pPlayer->IsConnected() )
+			return false;
+	}
 
-		pEntity = CBaseEntity::Instance(pEdict);
-		if ( !pEntity )
-			continue;
+	float flDistSquared = 0;
 
-		pList[ count ] = pEntity;
-		count++;
+	for( int iAxis = 0; iAxis < 3 && flDistSquared <= flRadiusSquared; ++iAxis )
+	{
+		float flDelta;
 
-		if ( count >= listMax )
-			return count;
+		if( vecCenter[ iAxis ] < pEdict->v.absmin[ iAxis ] )
+			flDelta = vecCenter[ iAxis ] - pEdict->v.absmin[ iAxis ];
+		else if( vecCenter[ iAxis ] > pEdict->v.absmax[ iAxis ] )
+			flDelta = vecCenter[ iAxis ] - pEdict->v.absmax[ iAxis ];
+		else
+			flDelta = 0;
+
+		flDistSquared += flDelta * flDelta;
 	}
 
-	return count;
+	return flDistSquared <= flRadiusSquared;
 }
 
-
-int UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &center, float radius )
+/**
+*	Collects all entities that pass the filter, in entity index order. Uses the entity grid if enabled.
+*/
+template<typename FILTER>
+int UTIL_CollectEntities( CBaseEntity **pList, int listMax, const Vector& vecMins, const Vector& vecMaxs, const bool fUseGrid, FILTER filter )
 {
-	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
 	CBaseEntity *pEntity;
 	int			count;
-	float		distance, delta;
 
 	count = 0;
-	float radiusSquared = radius * radius;
-
-	if ( !pEdict )
-		return count;
 
-	for ( int i = 1; i < gpGlobals->maxEntities; i++, pEdict++ )
+	if( fUseGrid )
 	{
-		if ( pEdict->free )	// Not in use
-			continue;
-		
-		if ( !(pEdict->v.flags & (FL_CLIENT|FL_MONSTER)) )	// Not a client/monster ?
-			continue;
+		for( auto iIndex : g_EntityGrid.Query( vecMins, vecMaxs ) )
+		{
+			edict_t* pEdict = g_EntityGrid.GetEdict( iIndex );
 
-		// Use origin for X & Y since they are centered for all monsters
-		// Now X
-		delta = center.x - pEdict->v.origin.x;//(pEdict->v.absmin.x + pEdict->v.absmax.x)*0.5;
-		delta *= delta;
+			if( !filter( pEdict ) )
+				continue;
 
-		if ( delta > radiusSquared )
-			continue;
-		distance = delta;
-		
-		// Now Y
-		delta = center.y - pEdict->v.origin.y;//(pEdict->v.absmin.y + pEdict->v.absmax.y)*0.5;
-		delta *= delta;
+			pEntity = CBaseEntity::Instance( pEdict );
+			if( !pEntity )
+				continue;
 
-		distance += delta;
-		if ( distance > radiusSquared )
-			continue;
+			pList[ count ] = pEntity;
+			count++;
 
-		// Now Z
-		delta = center.z - (pEdict->v.absmin.z + pEdict->v.absmax.z)*0.5;
-		delta *= delta;
+			if( count >= listMax )
+				return count;
+		}
 
-		distance += delta;
-		if ( distance > radiusSquared )
+		return count;
+	}
+
+	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
+
+	if ( !pEdict )
+		return count;
+
+	for ( int i = 1; i < gpGlobals->maxEntities; i++, pEdict++ )
+	{
+		if( !filter( pEdict ) )
 			continue;
 
 		pEntity = CBaseEntity::Instance(pEdict);
@@ -221,9 +275,60 @@ int UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &cente
 			return count;
 	}
 
+	return count;
+}
+
+/**
+*	Runs a query using the configured method. If verification is enabled, the result is compared with a linear scan.
+*/
+template<typename FILTER>
+int UTIL_QueryEntities( const char* pszQuery, CBaseEntity **pList, int listMax, const Vector& vecMins, const Vector& vecMaxs, FILTER filter )
+{
+	if( sv_entity_grid.value <= 0 )
+		return UTIL_CollectEntities( pList, listMax, vecMins, vecMaxs, false, filter );
+
+	const int count = UTIL_CollectEntities( pList, listMax, vecMins, vecMaxs, true, filter );
+
+	if( sv_entity_grid.value >= 2 )
+	{
+		std::vector<CBaseEntity*> linearList( max( listMax, 1 ) );
+
+		const int linearCount = UTIL_CollectEntities( linearList.data(), listMax, vecMins, vecMaxs, false, filter );
+
+		if( count != linearCount || !std::equal( pList, pList + count, linearList.data() ) )
+		{
+			ALERT( at_console, "%s: entity grid returned %d entities, linear scan returned %d\n", pszQuery, count, linearCount );
+		}
+	}
 
 	return count;
 }
+}
+
+int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, const Vector &maxs, int flagMask )
+{
+	return UTIL_QueryEntities( "UTIL_EntitiesInBox", pList, listMax, mins, maxs,
+		[ & ]( const edict_t* pEdict )
+		{
+			return UTIL_EntityInBox( pEdict, mins, maxs, flagMask );
+		}
+	);
+}
+
+
+int UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &center, float radius )
+{
+	const float radiusSquared = radius * radius;
+
+	const Vector vecRadius( radius, radius, radius );
+
+	return UTIL_QueryEntities( "UTIL_MonstersInSphere", pList, listMax, center - vecRadius, center + vecRadius,
+		[ & ]( const edict_t* pEdict )
+		{
+			return UTIL_MonsterInSphere( pEdict, center, radiusSquared );
+		}
+	);
+}
 
 
 CBaseEntity *UTIL_FindEntityInSphere( CBaseEntity *pStartEntity, const Vector &vecCenter, float flRadius )
@@ -235,6 +340,45 @@ CBaseEntity *UTIL_FindEntityInSphere( CBaseEntity *pStartEntity, const Vector &v
 	else
 		pentEntity = NULL;
 
+	if( sv_entity_grid.value > 0 )
+	{
+		const int iStartIndex = pentEntity ? ENTINDEX( pentEntity ) : 0;
+		const float flRadiusSquared = flRadius * flRadius;
+
+		const Vector vecRadius( flRadius, flRadius, flRadius );
+
+		CBaseEntity* pResult = nullptr;
+
+		for( auto iIndex : g_EntityGrid.Query( vecCenter - vecRadius, vecCenter + vecRadius ) )
+		{
+			if( iIndex <= iStartIndex )
+				continue;
+
+			edict_t* pEdict = g_EntityGrid.GetEdict( iIndex );
+
+			if( UTIL_EntityInSphere( iIndex, pEdict, vecCenter, flRadiusSquared ) )
+			{
+				pResult = CBaseEntity::Instance( pEdict );
+				break;
+			}
+		}
+
+		if( sv_entity_grid.value >= 2 )
+		{
+			edict_t* pEngineResult = FIND_ENTITY_IN_SPHERE( pentEntity, vecCenter, flRadius );
+
+			CBaseEntity* pLinearResult = !FNullEnt( pEngineResult ) ? CBaseEntity::Instance( pEngineResult ) : nullptr;
+
+			if( pResult != pLinearResult )
+			{
+				ALERT( at_console, "UTIL_FindEntityInSphere: entity grid returned %d, engine returned %d\n",
+					   pResult ? pResult->entindex() : 0, pLinearResult ? pLinearResult->entindex() : 0 );
+			}
+		}
+
+		return pResult;
+	}
+
 	pentEntity = FIND_ENTITY_IN_SPHERE( pentEntity, vecCenter, flRadius);
 
 	if (!FNullEnt(pentEntity))
@@ -252,6 +396,28 @@ CBaseEntity *UTIL_FindEntityByString( CBaseEntity *pStartEntity, const char *szK
 	else
 		pentEntity = NULL;
 
+	EntityNameField field;
+
+	if( sv_entity_name_index.value > 0 && CEntityNameIndex::FieldFromKeyword( szKeyword, field ) )
+	{
+		CBaseEntity* pResult = g_EntityNameIndex.FindNext( field, pStartEntity, szValue );
+
+		if( sv_entity_name_index.value >= 2 )
+		{
+			edict_t* pEngineResult = FIND_ENTITY_BY_STRING( pentEntity, szKeyword, szValue );
+
+			CBaseEntity* pLinearResult = !FNullEnt( pEngineResult ) ? CBaseEntity::Instance( pEngineResult ) : nullptr;
+
+			if( pResult != pLinearResult )
+			{
+				ALERT( at_console, "UTIL_FindEntityByString: name index returned %d, engine returned %d for %s \"%s\"\n",
+					   pResult ? pResult->entindex() : 0, pLinearResult ? pLinearResult->entindex() : 0, szKeyword, szValue );
+			}
+		}
+
+		return pResult;
+	}
+
 	pentEntity = FIND_ENTITY_BY_STRING( pentEntity, szKeyword, szValue );
 
 	if (!FNullEnt(pentEntity))
@@ -671,12 +837,18 @@ TraceResult UTIL_GetGlobalTrace()
 void UTIL_SetSize( CBaseEntity* pEntity, const Vector& vecMin, const Vector& vecMax )
 {
 	SET_SIZE( pEntity->edict(), vecMin, vecMax );
+
+	g_EntityGrid.Link( pEntity->edict() );
 }
 	
 void UTIL_SetOrigin( CBaseEntity* pEntity, const Vector& vecOrigin )
 {
 	if ( auto pEnt = pEntity->edict() )
+	{
 		SET_ORIGIN( pEnt, vecOrigin );
+
+		g_EntityGrid.Link( pEnt );
+	}
 }
 
 void UTIL_ParticleEffect( const Vector &vecOrigin, const Vector &vecDirection, const unsigned int ulColor, const unsigned int ulCount )
@@ -955,7 +1127,8 @@ bool UTIL_TeamsMatch( const char *pTeamName1, const char *pTeamName2 )
 	// Both on a team?
 	if ( *pTeamName1 != 0 && *pTeamName2 != 0 )
 	{
-		if ( !stricmp( pTeamName1, pTeamName2 ) )	// Same Team?
+		// Pooled names are the same string if they're equal, but different strings can still differ only in case.
+		if ( pTeamName1 == pTeamName2 || !stricmp( pTeamName1, pTeamName2 ) )	// Same Team?
 			return true;
 	}
 
@@ -1064,10 +1237,17 @@ bool UTIL_SetTypeDescValue( void* pEntity, const TYPEDESCRIPTION& desc, const ch
 	{
 	case FIELD_MODELNAME:
 	case FIELD_SOUNDNAME:
-	case FIELD_STRING:
 		( *( int * ) ( ( char * ) pEntity + desc.fieldOffset ) ) = ALLOC_STRING( pszValue );
 		break;
 
+	case FIELD_STRING:
+		//The engine converts escape sequences, so leave those strings to it.
+		if( strchr( pszValue, '\\' ) )
+			( *( int * ) ( ( char * ) pEntity + desc.fieldOffset ) ) = ALLOC_STRING( pszValue );
+		else
+			( *( int * ) ( ( char * ) pEntity + desc.fieldOffset ) ) = POOL_STRING( pszValue );
+		break;
+
 	case FIELD_TIME:
 	case FIELD_FLOAT:
 		( *( float * ) ( ( char * ) pEntity + desc.fieldOffset ) ) = atof( pszValue );
@@ -1095,21 +1275,24 @@ bool UTIL_SetTypeDescValue( void* pEntity, const TYPEDESCRIPTION& desc, const ch
 
 void EntvarsKeyvalue( entvars_t *pev, KeyValueData *pkvd )
 {
-	const TYPEDESCRIPTION* pField;
+	//Entity variables are keys by field name.
+	static DataMapKeys_t fields;
 
-	for ( size_t i = 0; i < gEntvarsDataMap.uiNumDescriptors; i++ )
+	if( fields.empty() )
 	{
-		pField = &gEntvarsDataMap.pTypeDesc[i];
+		for( size_t i = 0; i < gEntvarsDataMap.uiNumDescriptors; i++ )
+			fields.emplace( gEntvarsDataMap.pTypeDesc[ i ].fieldName, &gEntvarsDataMap.pTypeDesc[ i ] );
+	}
 
-		if ( !stricmp( pField->fieldName, pkvd->szKeyName ) )
-		{
-			if( !UTIL_SetTypeDescValue( pev, *pField, pkvd->szValue ) )
-				ALERT( at_error, "Bad field in entity!!\n" );
+	auto it = fields.find( pkvd->szKeyName );
 
-			pkvd->fHandled = true;
-			return;
-		}
-	}
+	if( it == fields.end() )
+		return;
+
+	if( !UTIL_SetTypeDescValue( pev, *it->second, pkvd->szValue ) )
+		ALERT( at_error, "Bad field in entity!!\n" );
+
+	pkvd->fHandled = true;
 }
 
 CBaseEntity* UTIL_RandomTargetname( const char* const pszName )
@@ -5,6 +5,7 @@
 #include <string>
 
 #include <Angelscript/add_on/scriptbuilder.h>
+#include <Angelscript/CASModule.h>
 
 #include "extdll.h"
 #include "util.h"
@@ -98,13 +99,30 @@ bool CASBaseModuleBuilder::DefineWords( CScriptBuilder& builder )
 
 bool CASBaseModuleBuilder::AddScripts( CScriptBuilder& builder )
 {
+	m_StartTime = Clock::now();
+
+	m_ScriptSections.clear();
+	m_Includes.clear();
+	m_ContentHash = CASContentHash();
+	m_bUseCachedByteCode = false;
+	m_bCacheEntryStale = false;
+
+	//The entry is identified by what is being built, its contents by what it is built from.
+	CASContentHash entryHash;
+
+#ifdef CLIENT_DLL
+	entryHash.Add( "client" );
+#else
+	entryHash.Add( "server" );
+#endif
+
+	entryHash.Add( m_szModuleTypeName );
+	entryHash.Add( builder.GetModule()->GetName() );
+
 	for( auto& script : m_InternalScripts )
 	{
-		if( builder.AddSectionFromMemory( script.first.c_str(), script.second.c_str() ) < 0 )
-		{
-			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Error adding internal script \"%s\"\n", script.first.c_str() );
-			return false;
-		}
+		m_ContentHash.Add( script.first );
+		m_ContentHash.Add( script.second );
 	}
 
 	char szRelativePath[ MAX_PATH ];
@@ -121,22 +139,60 @@ bool CASBaseModuleBuilder::AddScripts( CScriptBuilder& builder )
 
 		char szAbsolutePath[ MAX_PATH ];
 
-		if( g_pFileSystem->GetLocalPath( szRelativePath, szAbsolutePath, sizeof( szAbsolutePath ) ) )
+		if( !g_pFileSystem->GetLocalPath( szRelativePath, szAbsolutePath, sizeof( szAbsolutePath ) ) )
 		{
-			if( builder.AddSectionFromFile( szAbsolutePath ) < 0 )
-			{
-				Alert( at_console, "CASBaseModuleBuilder::AddScripts: Error adding script \"%s\"!\n", szRelativePath );
-				return false;
-			}
+			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Couldn't find %s script \"%s\"!\n", m_szModuleTypeName.c_str(), szRelativePath );
+			return false;
 		}
-		else
+
+		CFile file( szAbsolutePath, "rb" );
+
+		if( !file.IsOpen() )
 		{
-			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Couldn't find %s script \"%s\"!\n", m_szModuleTypeName.c_str(), szRelativePath );
+			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Error adding script \"%s\"!\n", szRelativePath );
+			return false;
+		}
+
+		std::string szContents( file.Size(), '\0' );
+
+		if( !szContents.empty() && file.Read( &szContents[ 0 ], szContents.size() ) != static_cast<int>( szContents.size() ) )
+		{
+			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Error reading script \"%s\"!\n", szRelativePath );
 			return false;
 		}
+
+		entryHash.Add( script );
+
+		m_ContentHash.Add( script );
+		m_ContentHash.Add( szContents );
+
+		m_ScriptSections.emplace_back( szAbsolutePath, std::move( szContents ) );
 	}
 
-	return true;
+	char szEntryName[ MAX_PATH ];
+
+	snprintf( szEntryName, sizeof( szEntryName ), "%s/%s_%016llx.asbc",
+		AS_BYTECODE_CACHE_DIR, m_szModuleTypeName.c_str(), static_cast<unsigned long long>( entryHash.Get() ) );
+
+	m_szCacheEntryName = szEntryName;
+
+	if( g_ASBytecodeCache.LoadEntry( m_szCacheEntryName.c_str(), m_CacheEntry ) )
+	{
+		if( IsCacheEntryCurrent() )
+		{
+			//Nothing to compile; the bytecode is loaded in PostBuild.
+			m_bUseCachedByteCode = true;
+			return true;
+		}
+
+		m_bCacheEntryStale = true;
+	}
+	else
+	{
+		m_bCacheEntryStale = g_pFileSystem->FileExists( m_szCacheEntryName.c_str() );
+	}
+
+	return AddSections( builder );
 }
 
 bool CASBaseModuleBuilder::IncludeScript( CScriptBuilder& builder, const char* const pszIncludeFileName, const char* const pszFromFileName )
@@ -229,8 +285,15 @@ bool CASBaseModuleBuilder::IncludeScript( CScriptBuilder& builder, const char* c
 			if( result >= 0 )
 			{
 				if( result == 1 )
+				{
 					Alert( at_console, "CASBaseModuleBuilder::IncludeScript: Included script \"%s\"\n", szRelativePath.c_str() );
 
+					m_Includes.emplace_back( szRelativePath );
+
+					m_ContentHash.Add( szRelativePath );
+					m_ContentHash.Add( data.get(), size );
+				}
+
 				bSuccess = true;
 			}
 			else
@@ -255,14 +318,113 @@ bool CASBaseModuleBuilder::PreBuild( CScriptBuilder& builder )
 {
 	const auto& scripts = GetScripts();
 
-	Alert( at_console, "%u script%s\nCompiling...\n", scripts.size(), scripts.size() == 1 ? "" : "s" );
+	Alert( at_console, "%u script%s\n%s...\n", scripts.size(), scripts.size() == 1 ? "" : "s",
+		m_bUseCachedByteCode ? "Loading cached bytecode" : "Compiling" );
 
 	return true;
 }
 
 bool CASBaseModuleBuilder::PostBuild( CScriptBuilder& builder, const bool bSuccess, CASModule* pModule )
 {
-	Alert( at_console, "Done\n%s script compilation %s\n", m_szModuleTypeName.c_str(), bSuccess ? "succeeded" : "failed" );
+	bool bBuilt = bSuccess;
+
+	if( m_bUseCachedByteCode )
+	{
+		//The build only reset the module, so the cached bytecode can be loaded into it now.
+		if( bBuilt && g_ASBytecodeCache.LoadByteCode( *pModule->GetModule(), m_CacheEntry ) )
+		{
+			const double flLoadTime = GetElapsedTime();
+
+			g_ASBytecodeCache.AddHit( std::max( 0.0, m_CacheEntry.flCompileTime - flLoadTime ) );
+
+			Alert( at_console, "Loaded cached bytecode in %.2f ms (compiling took %.2f ms)\n", flLoadTime * 1000, m_CacheEntry.flCompileTime * 1000 );
+		}
+		else
+		{
+			Alert( at_console, "Couldn't load cached bytecode \"%s\", compiling...\n", m_szCacheEntryName.c_str() );
+
+			g_ASBytecodeCache.RemoveEntry( m_szCacheEntryName.c_str() );
+
+			m_bUseCachedByteCode = false;
+			m_bCacheEntryStale = true;
+
+			//Compile into the same module. If the empty build itself failed there is no module left to compile into.
+			if( bBuilt )
+				bBuilt = AddSections( builder ) && builder.BuildModule() >= 0;
+		}
+	}
+
+	if( !m_bUseCachedByteCode )
+	{
+		g_ASBytecodeCache.AddMiss( m_bCacheEntryStale );
+
+		if( bBuilt )
+		{
+			m_CacheEntry.uiContentHash = m_ContentHash.Get();
+			m_CacheEntry.flCompileTime = GetElapsedTime();
+			m_CacheEntry.Includes = m_Includes;
+
+			if( g_ASBytecodeCache.SaveByteCode( *pModule->GetModule(), m_CacheEntry ) )
+				g_ASBytecodeCache.SaveEntry( m_szCacheEntryName.c_str(), m_CacheEntry );
+		}
+	}
+
+	Alert( at_console, "Done\n%s script compilation %s\n", m_szModuleTypeName.c_str(), bBuilt ? "succeeded" : "failed" );
+
+	//Only discard the module if compiling after a failed load went wrong. The manager discards failed builds itself.
+	return bBuilt || !bSuccess;
+}
+
+bool CASBaseModuleBuilder::AddSections( CScriptBuilder& builder )
+{
+	for( auto& script : m_InternalScripts )
+	{
+		if( builder.AddSectionFromMemory( script.first.c_str(), script.second.c_str() ) < 0 )
+		{
+			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Error adding internal script \"%s\"\n", script.first.c_str() );
+			return false;
+		}
+	}
+
+	//Same as AddSectionFromFile, but with the contents that were hashed.
+	for( auto& section : m_ScriptSections )
+	{
+		if( builder.AddSectionFromMemory( section.first.c_str(), section.second.c_str(), section.second.size() ) < 0 )
+		{
+			Alert( at_console, "CASBaseModuleBuilder::AddScripts: Error adding script \"%s\"!\n", section.first.c_str() );
+			return false;
+		}
+	}
 
 	return true;
 }
+
+bool CASBaseModuleBuilder::IsCacheEntryCurrent() const
+{
+	CASContentHash hash = m_ContentHash;
+
+	for( const auto& szInclude : m_CacheEntry.Includes )
+	{
+		CFile file( szInclude.c_str(), "rb" );
+
+		if( !file.IsOpen() )
+			return false;
+
+		const auto size = file.Size();
+
+		auto data = std::make_unique<char[]>( size + 1 );
+
+		if( file.Read( data.get(), size ) != static_cast<int>( size ) )
+			return false;
+
+		hash.Add( szInclude );
+		hash.Add( data.get(), size );
+	}
+
+	return hash.Get() == m_CacheEntry.uiContentHash;
+}
+
+double CASBaseModuleBuilder::GetElapsedTime() const
+{
+	return std::chrono::duration<double>( Clock::now() - m_StartTime ).count();
+}
@@ -1,15 +1,19 @@
 #ifndef GAME_SHARED_ANGELSCRIPT_CASEBASEMODULEBUILDER_H
 #define GAME_SHARED_ANGELSCRIPT_CASEBASEMODULEBUILDER_H
 
+#include <chrono>
 #include <string>
 #include <vector>
 
 #include <Angelscript/IASModuleBuilder.h>
 
+#include "CASBytecodeCache.h"
+
 /**
 *	Base class for builders that handle internal and regular scripts.
 *	Internal scripts are scripts that the application itself defines. These usually contain base classes for extension classes.
 *	Regular scripts are loaded from disk.
+*	If the bytecode cache has an up to date entry for the module, no script sections are added and the cached bytecode is loaded once the (empty) build is done.
 */
 class CASBaseModuleBuilder : public IASModuleBuilder
 {
@@ -76,11 +80,45 @@ public:
 
 	bool PostBuild( CScriptBuilder& builder, const bool bSuccess, CASModule* pModule ) override;
 
+private:
+	using Clock = std::chrono::high_resolution_clock;
+
+	/**
+	*	Adds the internal scripts and the scripts read by AddScripts to the builder.
+	*/
+	bool AddSections( CScriptBuilder& builder );
+
+	/**
+	*	@return Whether the cache entry for this module is up to date with the scripts and their includes.
+	*/
+	bool IsCacheEntryCurrent() const;
+
+	double GetElapsedTime() const;
+
 private:
 	std::string m_szBasePath;
 	std::string m_szModuleTypeName;
 	InternalScripts_t m_InternalScripts;
 	std::vector<std::string> m_Scripts;
+
+	/**
+	*	Absolute path and contents of each script.
+	*/
+	std::vector<std::pair<std::string, std::string>> m_ScriptSections;
+
+	/**
+	*	Hash of the internal scripts and scripts, followed by each include as it is included.
+	*/
+	CASContentHash m_ContentHash;
+
+	std::vector<std::string> m_Includes;
+
+	std::string m_szCacheEntryName;
+	CASBytecodeCache::Entry m_CacheEntry;
+	bool m_bUseCachedByteCode = false;
+	bool m_bCacheEntryStale = false;
+
+	Clock::time_point m_StartTime;
 };
 
 #endif //GAME_SHARED_ANGELSCRIPT_CASEBASEMODULEBUILDER_H
\ No newline at end of file
@@ -0,0 +1,416 @@
+#include <cstring>
+
+#include <angelscript.h>
+
+#include "extdll.h"
+#include "util.h"
+
+#include "CFile.h"
+
+#include "CASBytecodeCache.h"
+
+/**
+*	Identifies a bytecode cache entry. "ASBC".
+*/
+#define AS_BYTECODE_CACHE_ID ( ( 'C' << 24 ) + ( 'B' << 16 ) + ( 'S' << 8 ) + 'A' )
+
+/**
+*	Increment when the entry layout changes.
+*/
+#define AS_BYTECODE_CACHE_VERSION 1
+
+namespace
+{
+/**
+*	Fixed size part of an entry, followed by the includes and the bytecode.
+*/
+struct EntryHeader
+{
+	uint32_t uiID;
+	uint32_t uiVersion;
+	uint64_t uiAPIHash;
+	uint64_t uiVersionHash;
+	uint64_t uiContentHash;
+	uint64_t uiByteCodeHash;
+	double flCompileTime;
+	uint32_t uiIncludeCount;
+	uint32_t uiByteCodeSize;
+};
+
+class CByteCodeWriter final : public asIBinaryStream
+{
+public:
+	CByteCodeWriter( std::vector<uint8_t>& data )
+		: m_Data( data )
+	{
+	}
+
+	void Read( void*, asUINT ) override
+	{
+	}
+
+	void Write( const void* ptr, asUINT size ) override
+	{
+		auto pData = reinterpret_cast<const uint8_t*>( ptr );
+
+		m_Data.insert( m_Data.end(), pData, pData + size );
+	}
+
+private:
+	std::vector<uint8_t>& m_Data;
+};
+
+class CByteCodeReader final : public asIBinaryStream
+{
+public:
+	CByteCodeReader( const std::vector<uint8_t>& data )
+		: m_Data( data )
+	{
+	}
+
+	bool HasOverflowed() const { return m_bOverflowed; }
+
+	void Read( void* ptr, asUINT size ) override
+	{
+		if( size > m_Data.size() - m_uiOffset )
+		{
+			//Truncated data; hand out zeroes and let the caller reject the result.
+			memset( ptr, 0, size );
+			m_uiOffset = m_Data.size();
+			m_bOverflowed = true;
+			return;
+		}
+
+		memcpy( ptr, m_Data.data() + m_uiOffset, size );
+		m_uiOffset += size;
+	}
+
+	void Write( const void*, asUINT ) override
+	{
+	}
+
+private:
+	const std::vector<uint8_t>& m_Data;
+	size_t m_uiOffset = 0;
+	bool m_bOverflowed = false;
+};
+
+void HashFunction( CASContentHash& hash, const asIScriptFunction* pFunction )
+{
+	if( !pFunction )
+		return;
+
+	hash.Add( pFunction->GetDeclaration( true, true, false ) );
+	hash.Add( static_cast<uint64_t>( pFunction->GetAccessMask() ) );
+}
+}
+
+CASBytecodeCache g_ASBytecodeCache;
+
+void CASContentHash::Add( const void* pData, const size_t uiSize )
+{
+	auto pBytes = reinterpret_cast<const uint8_t*>( pData );
+
+	for( size_t uiIndex = 0; uiIndex < uiSize; ++uiIndex )
+	{
+		m_uiHash ^= pBytes[ uiIndex ];
+		m_uiHash *= 1099511628211ULL;
+	}
+}
+
+void CASContentHash::Add( const char* const pszString )
+{
+	Add( pszString ? pszString : "", ( pszString ? strlen( pszString ) : 0 ) + 1 );
+}
+
+void CASBytecodeCache::Initialize( asIScriptEngine& engine )
+{
+	m_pEngine = &engine;
+	m_bHasAPIHash = false;
+}
+
+void CASBytecodeCache::Shutdown()
+{
+	m_pEngine = nullptr;
+	m_bHasAPIHash = false;
+}
+
+uint64_t CASBytecodeCache::GetAPIHash()
+{
+	if( m_bHasAPIHash || !m_pEngine )
+		return m_uiAPIHash;
+
+	auto& engine = *m_pEngine;
+
+	CASContentHash hash;
+
+	//Engine properties change how scripts are compiled.
+	for( int iProperty = asEP_ALLOW_UNSAFE_REFERENCES; iProperty < asEP_LAST_PROPERTY; ++iProperty )
+	{
+		hash.Add( static_cast<uint64_t>( engine.GetEngineProperty( static_cast<asEEngineProp>( iProperty ) ) ) );
+	}
+
+	for( asUINT uiIndex = 0; uiIndex < engine.GetObjectTypeCount(); ++uiIndex )
+	{
+		const auto pType = engine.GetObjectTypeByIndex( uiIndex );
+
+		hash.Add( pType->GetNamespace() );
+		hash.Add( pType->GetName() );
+		hash.Add( static_cast<uint64_t>( pType->GetFlags() ) );
+		hash.Add( static_cast<uint64_t>( pType->GetSize() ) );
+		hash.Add( static_cast<uint64_t>( pType->GetAccessMask() ) );
+
+		for( asUINT uiFactory = 0; uiFactory < pType->GetFactoryCount(); ++uiFactory )
+		{
+			HashFunction( hash, pType->GetFactoryByIndex( uiFactory ) );
+		}
+
+		for( asUINT uiBehaviour = 0; uiBehaviour < pType->GetBehaviourCount(); ++uiBehaviour )
+		{
+			asEBehaviours behaviour;
+
+			const auto pFunction = pType->GetBehaviourByIndex( uiBehaviour, &behaviour );
+
+			hash.Add( static_cast<uint64_t>( behaviour ) );
+			HashFunction( hash, pFunction );
+		}
+
+		for( asUINT uiMethod = 0; uiMethod < pType->GetMethodCount(); ++uiMethod )
+		{
+			HashFunction( hash, pType->GetMethodByIndex( uiMethod ) );
+		}
+
+		for( asUINT uiProperty = 0; uiProperty < pType->GetPropertyCount(); ++uiProperty )
+		{
+			hash.Add( pType->GetPropertyDeclaration( uiProperty, true ) );
+		}
+
+		for( asUINT uiFuncdef = 0; uiFuncdef < pType->GetChildFuncdefCount(); ++uiFuncdef )
+		{
+			HashFunction( hash, pType->GetChildFuncdef( uiFuncdef )->GetFuncdefSignature() );
+		}
+	}
+
+	for( asUINT uiIndex = 0; uiIndex < engine.GetGlobalFunctionCount(); ++uiIndex )
+	{
+		HashFunction( hash, engine.GetGlobalFunctionByIndex( uiIndex ) );
+	}
+
+	for( asUINT uiIndex = 0; uiIndex < engine.GetGlobalPropertyCount(); ++uiIndex )
+	{
+		const char* pszName = nullptr;
+		const char* pszNamespace = nullptr;
+		int iTypeId = 0;
+		bool bIsConst = false;
+		asDWORD accessMask = 0;
+
+		engine.GetGlobalPropertyByIndex( uiIndex, &pszName, &pszNamespace, &iTypeId, &bIsConst, nullptr, nullptr, &accessMask );
+
+		hash.Add( pszNamespace );
+		hash.Add( pszName );
+		hash.Add( engine.GetTypeDeclaration( iTypeId, true ) );
+		hash.Add( static_cast<uint64_t>( bIsConst ) );
+		hash.Add( static_cast<uint64_t>( accessMask ) );
+	}
+
+	for( asUINT uiIndex = 0; uiIndex < engine.GetEnumCount(); ++uiIndex )
+	{
+		const auto pEnum = engine.GetEnumByIndex( uiIndex );
+
+		hash.Add( pEnum->GetNamespace() );
+		hash.Add( pEnum->GetName() );
+
+		for( asUINT uiValue = 0; uiValue < pEnum->GetEnumValueCount(); ++uiValue )
+		{
+			int iValue = 0;
+
+			hash.Add( pEnum->GetEnumValueByIndex( uiValue, &iValue ) );
+			hash.Add( static_cast<uint64_t>( iValue ) );
+		}
+	}
+
+	for( asUINT uiIndex = 0; uiIndex < engine.GetFuncdefCount(); ++uiIndex )
+	{
+		HashFunction( hash, engine.GetFuncdefByIndex( uiIndex )->GetFuncdefSignature() );
+	}
+
+	for( asUINT uiIndex = 0; uiIndex < engine.GetTypedefCount(); ++uiIndex )
+	{
+		const auto pTypedef = engine.GetTypedefByIndex( uiIndex );
+
+		hash.Add( pTypedef->GetNamespace() );
+		hash.Add( pTypedef->GetName() );
+		hash.Add( engine.GetTypeDeclaration( pTypedef->GetTypedefTypeId(), true ) );
+	}
+
+	if( engine.GetDefaultArrayTypeId() >= 0 )
+		hash.Add( engine.GetTypeDeclaration( engine.GetDefaultArrayTypeId(), true ) );
+
+	m_uiAPIHash = hash.Get();
+	m_bHasAPIHash = true;
+
+	return m_uiAPIHash;
+}
+
+uint64_t CASBytecodeCache::GetVersionHash() const
+{
+	CASContentHash hash;
+
+	//The headers the game was built against and the library it was linked with.
+	hash.Add( ANGELSCRIPT_VERSION_STRING );
+	hash.Add( asGetLibraryVersion() );
+	hash.Add( asGetLibraryOptions() );
+	hash.Add( static_cast<uint64_t>( sizeof( void* ) ) );
+
+	return hash.Get();
+}
+
+bool CASBytecodeCache::LoadEntry( const char* const pszFileName, Entry& entry )
+{
+	CFile file( pszFileName, "rb" );
+
+	if( !file.IsOpen() )
+		return false;
+
+	const auto uiFileSize = file.Size();
+
+	EntryHeader header;
+
+	if( uiFileSize < sizeof( header ) || file.Read( &header, sizeof( header ) ) != sizeof( header ) )
+		return false;
+
+	if( header.uiID != AS_BYTECODE_CACHE_ID || header.uiVersion != AS_BYTECODE_CACHE_VERSION )
+		return false;
+
+	if( header.uiAPIHash != GetAPIHash() || header.uiVersionHash != GetVersionHash() )
+		return false;
+
+	//Lengths are validated against the file size before anything is allocated.
+	unsigned int uiBytesLeft = uiFileSize - sizeof( header );
+
+	entry.Includes.clear();
+	entry.Includes.reserve( header.uiIncludeCount );
+
+	for( uint32_t uiIndex = 0; uiIndex < header.uiIncludeCount; ++uiIndex )
+	{
+		uint32_t uiLength;
+
+		if( uiBytesLeft < sizeof( uiLength ) || file.Read( &uiLength, sizeof( uiLength ) ) != sizeof( uiLength ) )
+			return false;
+
+		uiBytesLeft -= sizeof( uiLength );
+
+		if( uiBytesLeft < uiLength )
+			return false;
+
+		std::string szInclude( uiLength, '\0' );
+
+		if( file.Read( &szInclude[ 0 ], uiLength ) != static_cast<int>( uiLength ) )
+			return false;
+
+		uiBytesLeft -= uiLength;
+
+		entry.Includes.emplace_back( std::move( szInclude ) );
+	}
+
+	if( uiBytesLeft != header.uiByteCodeSize )
+		return false;
+
+	entry.ByteCode.resize( header.uiByteCodeSize );
+
+	if( file.Read( entry.ByteCode.data(), header.uiByteCodeSize ) != static_cast<int>( header.uiByteCodeSize ) )
+		return false;
+
+	CASContentHash byteCodeHash;
+
+	byteCodeHash.Add( entry.ByteCode.data(), entry.ByteCode.size() );
+
+	if( byteCodeHash.Get() != header.uiByteCodeHash )
+		return false;
+
+	entry.uiAPIHash = header.uiAPIHash;
+	entry.uiVersionHash = header.uiVersionHash;
+	entry.uiContentHash = header.uiContentHash;
+	entry.flCompileTime = header.flCompileTime;
+
+	return true;
+}
+
+bool CASBytecodeCache::SaveEntry( const char* const pszFileName, Entry& entry )
+{
+	entry.uiAPIHash = GetAPIHash();
+	entry.uiVersionHash = GetVersionHash();
+
+	g_pFileSystem->CreateDirHierarchy( AS_BYTECODE_CACHE_DIR, nullptr );
+
+	CFile file( pszFileName, "wb" );
+
+	if( !file.IsOpen() )
+	{
+		Alert( at_console, "CASBytecodeCache::SaveEntry: Couldn't open \"%s\" for writing\n", pszFileName );
+		return false;
+	}
+
+	CASContentHash byteCodeHash;
+
+	byteCodeHash.Add( entry.ByteCode.data(), entry.ByteCode.size() );
+
+	EntryHeader header;
+
+	memset( &header, 0, sizeof( header ) );
+
+	header.uiID = AS_BYTECODE_CACHE_ID;
+	header.uiVersion = AS_BYTECODE_CACHE_VERSION;
+	header.uiAPIHash = entry.uiAPIHash;
+	header.uiVersionHash = entry.uiVersionHash;
+	header.uiContentHash = entry.uiContentHash;
+	header.uiByteCodeHash = byteCodeHash.Get();
+	header.flCompileTime = entry.flCompileTime;
+	header.uiIncludeCount = entry.Includes.size();
+	header.uiByteCodeSize = entry.ByteCode.size();
+
+	bool bSuccess = file.Write( &header, sizeof( header ) ) == sizeof( header );
+
+	for( const auto& szInclude : entry.Includes )
+	{
+		const uint32_t uiLength = szInclude.length();
+
+		bSuccess = bSuccess &&
+			file.Write( &uiLength, sizeof( uiLength ) ) == sizeof( uiLength ) &&
+			file.Write( szInclude.data(), uiLength ) == static_cast<int>( uiLength );
+	}
+
+	bSuccess = bSuccess && file.Write( entry.ByteCode.data(), entry.ByteCode.size() ) == static_cast<int>( entry.ByteCode.size() );
+
+	file.Close();
+
+	if( !bSuccess )
+	{
+		Alert( at_console, "CASBytecodeCache::SaveEntry: Error writing \"%s\"\n", pszFileName );
+		RemoveEntry( pszFileName );
+	}
+
+	return bSuccess;
+}
+
+void CASBytecodeCache::RemoveEntry( const char* const pszFileName )
+{
+	g_pFileSystem->RemoveFile( pszFileName, nullptr );
+}
+
+bool CASBytecodeCache::LoadByteCode( asIScriptModule& module, const Entry& entry ) const
+{
+	CByteCodeReader reader( entry.ByteCode );
+
+	return module.LoadByteCode( &reader ) >= 0 && !reader.HasOverflowed();
+}
+
+bool CASBytecodeCache::SaveByteCode( const asIScriptModule& module, Entry& entry ) const
+{
+	entry.ByteCode.clear();
+
+	CByteCodeWriter writer( entry.ByteCode );
+
+	//Debug info is kept so runtime errors still report script sections and line numbers.
+	return module.SaveByteCode( &writer, false ) >= 0;
+}
@@ -0,0 +1,180 @@
+#ifndef GAME_SHARED_ANGELSCRIPT_CASBYTECODECACHE_H
+#define GAME_SHARED_ANGELSCRIPT_CASBYTECODECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class asIScriptEngine;
+class asIScriptModule;
+
+/**
+*	Directory that cached bytecode is stored in, relative to the game directory.
+*/
+#define AS_BYTECODE_CACHE_DIR "scripts/cache"
+
+/**
+*	64 bit FNV-1a hash used to key cached bytecode.
+*/
+class CASContentHash final
+{
+public:
+	CASContentHash() = default;
+
+	uint64_t Get() const { return m_uiHash; }
+
+	void Add( const void* pData, const size_t uiSize );
+
+	/**
+	*	Adds the string, including its terminator so that consecutive strings can't run together.
+	*/
+	void Add( const char* const pszString );
+
+	void Add( const std::string& szString )
+	{
+		Add( szString.c_str(), szString.length() + 1 );
+	}
+
+	void Add( const uint64_t uiValue )
+	{
+		Add( &uiValue, sizeof( uiValue ) );
+	}
+
+private:
+	uint64_t m_uiHash = 14695981039346656037ULL;
+};
+
+/**
+*	On disk cache of compiled module bytecode.
+*	An entry is only used if the scripts it was compiled from, the API registered with the engine and the Angelscript version all match.
+*	Otherwise the module is compiled from source and the entry is replaced.
+*/
+class CASBytecodeCache final
+{
+public:
+	/**
+	*	A single cached module.
+	*/
+	struct Entry
+	{
+		uint64_t uiAPIHash = 0;
+		uint64_t uiVersionHash = 0;
+
+		/**
+		*	Hash of the internal scripts, the scripts and the includes, in that order.
+		*/
+		uint64_t uiContentHash = 0;
+
+		/**
+		*	Time it took to compile the module, in seconds.
+		*/
+		double flCompileTime = 0;
+
+		/**
+		*	Files included by the scripts, in the order they were included.
+		*/
+		std::vector<std::string> Includes;
+
+		std::vector<uint8_t> ByteCode;
+	};
+
+	struct Stats
+	{
+		uint64_t uiHits = 0;
+		uint64_t uiMisses = 0;
+
+		/**
+		*	Number of entries that existed but were out of date or couldn't be loaded.
+		*/
+		uint64_t uiStale = 0;
+
+		/**
+		*	Compile time saved by loading from the cache, in seconds.
+		*/
+		double flTimeSaved = 0;
+	};
+
+public:
+	CASBytecodeCache() = default;
+	~CASBytecodeCache() = default;
+
+	/**
+	*	Sets the engine whose API keys the cache. The API hash is computed when the cache is first used, after all API has been registered.
+	*/
+	void Initialize( asIScriptEngine& engine );
+
+	void Shutdown();
+
+	/**
+	*	@return Hash of every function, type, property and engine property registered with the engine.
+	*/
+	uint64_t GetAPIHash();
+
+	/**
+	*	@return Hash of the Angelscript version and library options.
+	*/
+	uint64_t GetVersionHash() const;
+
+	/**
+	*	Reads an entry from disk.
+	*	@param pszFileName Entry file name, relative to the game directory.
+	*	@param entry Entry to read into.
+	*	@return true if the entry exists and was compiled against the current API and version, false otherwise.
+	*/
+	bool LoadEntry( const char* const pszFileName, Entry& entry );
+
+	/**
+	*	Writes an entry to disk. The API and version hashes are filled in.
+	*/
+	bool SaveEntry( const char* const pszFileName, Entry& entry );
+
+	void RemoveEntry( const char* const pszFileName );
+
+	/**
+	*	Loads the entry's bytecode into the given module.
+	*/
+	bool LoadByteCode( asIScriptModule& module, const Entry& entry ) const;
+
+	/**
+	*	Stores the given module's bytecode in the entry.
+	*/
+	bool SaveByteCode( const asIScriptModule& module, Entry& entry ) const;
+
+	const Stats& GetStats() const { return m_Stats; }
+
+	void ResetStats()
+	{
+		m_Stats = Stats();
+	}
+
+	void AddHit( const double flTimeSaved )
+	{
+		++m_Stats.uiHits;
+		m_Stats.flTimeSaved += flTimeSaved;
+	}
+
+	void AddMiss( const bool bStale )
+	{
+		++m_Stats.uiMisses;
+
+		if( bStale )
+			++m_Stats.uiStale;
+	}
+
+private:
+	asIScriptEngine* m_pEngine = nullptr;
+
+	bool m_bHasAPIHash = false;
+	uint64_t m_uiAPIHash = 0;
+
+	Stats m_Stats;
+
+private:
+	CASBytecodeCache( const CASBytecodeCache& ) = delete;
+	CASBytecodeCache& operator=( const CASBytecodeCache& ) = delete;
+};
+
+extern CASBytecodeCache g_ASBytecodeCache;
+
+#endif //GAME_SHARED_ANGELSCRIPT_CASBYTECODECACHE_H
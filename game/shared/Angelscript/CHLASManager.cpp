@@ -5,6 +5,8 @@
 
 #include "Angelscript/ScriptAPI/Extensions/CASGameRules.h"
 
+#include "CASBytecodeCache.h"
+
 #include "CHLASManager.h"
 
 void CHLASManager::MessageCallback( asSMessageInfo* pMsg )
@@ -54,10 +56,14 @@ bool CHLASManager::InitializeManager( IASInitializer& initializer )
 		return false;
 	}
 
+	g_ASBytecodeCache.Initialize( *m_Manager.GetEngine() );
+
 	return true;
 }
 
 void CHLASManager::Shutdown()
 {
+	g_ASBytecodeCache.Shutdown();
+
 	m_Manager.Shutdown();
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 
 #include "extdll.h"
@@ -58,6 +59,94 @@ static void EntityClassifications_WriteToFile_ServerCommand()
 
 	EntityClassifications().WriteToFile( szPath );
 }
+
+/**
+*	Compares relationship lookups through the matrix with resolving them from the classifications,
+*	for every pair of default classifications.
+*/
+static void EntityClassifications_Benchmark_ServerCommand()
+{
+	int cIterations = 100000;
+
+	if( CMD_ARGC() >= 2 )
+		cIterations = max( 1, atoi( CMD_ARGV( 1 ) ) );
+
+	const auto& manager = EntityClassifications();
+
+	std::vector<EntityClassification_t> classIds;
+
+	for( size_t index = 0; index < classify::MAX_DEFAULT_CLASSIFICATIONS; ++index )
+	{
+		const auto classId = manager.GetClassificationId( classify::DEFAULT_CLASSIFICATIONS[ index ] );
+
+		if( manager.IsClassIdValid( classId ) )
+			classIds.push_back( classId );
+	}
+
+	if( classIds.empty() )
+	{
+		Alert( at_console, "No default classifications to benchmark\n" );
+		return;
+	}
+
+	size_t uiMismatches = 0;
+
+	for( auto source : classIds )
+	{
+		for( auto target : classIds )
+		{
+			for( auto bBidirectional : { false, true } )
+			{
+				if( manager.GetRelationshipBetween( source, target, bBidirectional ) != manager.GetRelationshipBetweenUncached( source, target, bBidirectional ) )
+					++uiMismatches;
+			}
+		}
+	}
+
+	//Sum the results so the lookups can't be optimized out.
+	int iMatrixSum = 0;
+	int iUncachedSum = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for( int iteration = 0; iteration < cIterations; ++iteration )
+	{
+		for( auto source : classIds )
+		{
+			for( auto target : classIds )
+				iMatrixSum += manager.GetRelationshipBetween( source, target );
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	const double flMatrixTime = std::chrono::duration<double>( end - start ).count();
+
+	start = std::chrono::high_resolution_clock::now();
+
+	for( int iteration = 0; iteration < cIterations; ++iteration )
+	{
+		for( auto source : classIds )
+		{
+			for( auto target : classIds )
+				iUncachedSum += manager.GetRelationshipBetweenUncached( source, target );
+		}
+	}
+
+	end = std::chrono::high_resolution_clock::now();
+
+	const double flUncachedTime = std::chrono::duration<double>( end - start ).count();
+
+	const double flLookups = static_cast<double>( cIterations ) * classIds.size() * classIds.size();
+
+	Alert( at_console, "%u classifications, %.0f lookups per method, %u mismatches\n",
+		static_cast<unsigned int>( classIds.size() ), flLookups, static_cast<unsigned int>( uiMismatches ) );
+	Alert( at_console, "Matrix: %.3f ms (%.2f ns per lookup)\n", flMatrixTime * 1000, flMatrixTime * 1e9 / flLookups );
+	Alert( at_console, "Uncached: %.3f ms (%.2f ns per lookup)\n", flUncachedTime * 1000, flUncachedTime * 1e9 / flLookups );
+
+	if( iMatrixSum != iUncachedSum )
+		Alert( at_console, "Lookup results differ\n" );
+}
 #endif
 
 bool CEntityClassificationData::HasRelationshipToClassification( EntityClassification_t targetClassId ) const
@@ -65,7 +154,7 @@ bool CEntityClassificationData::HasRelationshipToClassification( EntityClassific
 	return binary_find( m_Relationships.begin(), m_Relationships.end(), targetClassId ) != m_Relationships.end();
 }
 
-bool CEntityClassificationData::GetRelationshipToClassification( EntityClassification_t targetClassId, Relationship& outRelationship )
+bool CEntityClassificationData::GetRelationshipToClassification( EntityClassification_t targetClassId, Relationship& outRelationship ) const
 {
 	auto it = binary_find( m_Relationships.begin(), m_Relationships.end(), targetClassId );
 
@@ -120,6 +209,7 @@ void CEntityClassificationsManager::Initialize()
 {
 #ifdef SERVER_DLL
 	g_engfuncs.pfnAddServerCommand( "entityclassifications_writetofile", &EntityClassifications_WriteToFile_ServerCommand );
+	g_engfuncs.pfnAddServerCommand( "entityclassifications_benchmark", &EntityClassifications_Benchmark_ServerCommand );
 #endif
 }
 
@@ -128,6 +218,8 @@ void CEntityClassificationsManager::Reset()
 	m_ClassMap.clear();
 	m_ClassList.clear();
 
+	InvalidateRelationshipMatrix();
+
 	m_NoneId = AddClassification( classify::NONE );
 }
 
@@ -173,6 +265,8 @@ EntityClassification_t CEntityClassificationsManager::AddClassification( std::st
 				classification->m_DefaultSourceRelationship = defaultSourceRelationship;
 				classification->m_DefaultTargetRelationship = defaultTargetRelationship;
 				classification->m_bHasDefaultTargetRelationship = bHasDefaultTargetRelationship;
+
+				InvalidateRelationshipMatrix();
 			}
 			else
 			{
@@ -197,6 +291,8 @@ EntityClassification_t CEntityClassificationsManager::AddClassification( std::st
 
 	m_ClassMap.emplace( data->m_szName, std::make_pair( m_ClassList.size() - 1, false ) );
 
+	InvalidateRelationshipMatrix();
+
 	return classId;
 }
 
@@ -230,6 +326,8 @@ bool CEntityClassificationsManager::RemoveClassification( EntityClassification_t
 			classification->RemoveRelationship( classId );
 	}
 
+	InvalidateRelationshipMatrix();
+
 	//TODO: reclaim freed Ids? - Solokiller
 	return true;
 }
@@ -352,6 +450,8 @@ void CEntityClassificationsManager::AddRelationship( EntityClassification_t sour
 		auto& to = m_ClassList[ IdToIndex( targetClassId ) ];
 		to->AddRelationship( sourceClassId, relationship );
 	}
+
+	InvalidateRelationshipMatrix();
 }
 
 void CEntityClassificationsManager::AddRelationship( const std::string& sourceClassName, const std::string& targetClassName, Relationship relationship, bool bBidirectional )
@@ -384,6 +484,8 @@ void CEntityClassificationsManager::RemoveRelationship( EntityClassification_t s
 		auto& to = m_ClassList[ IdToIndex( targetClassId ) ];
 		to->RemoveRelationship( sourceClassId );
 	}
+
+	InvalidateRelationshipMatrix();
 }
 
 void CEntityClassificationsManager::RemoveRelationship( const std::string& sourceClassName, const std::string& targetClassName, bool bBidirectional )
@@ -408,34 +510,21 @@ Relationship CEntityClassificationsManager::GetRelationshipBetween( EntityClassi
 		return R_NO;
 	}
 
-	Relationship result = R_NO;
-
-	auto& from = m_ClassList[ IdToIndex( sourceClassId ) ];
-	auto& to = m_ClassList[ IdToIndex( targetClassId ) ];
+	if( m_bRelationshipMatrixDirty )
+		RebuildRelationshipMatrix();
 
-	//If there exists a relationship from source to target, return relationship.
-	if( from->GetRelationshipToClassification( targetClassId, result ) )
-	{
-		return result;
-	}
-
-	//No relationship from source to target, should we check for target to source?
-	if( bBidirectional )
-	{
-		//There is a relationship, return value.
-		if( to->GetRelationshipToClassification( sourceClassId, result ) )
-		{
-			return result;
-		}
-	}
+	return static_cast<Relationship>( m_RelationshipMatrix[ MatrixIndex( IdToIndex( sourceClassId ), IdToIndex( targetClassId ), bBidirectional ) ] );
+}
 
-	if( to->m_bHasDefaultTargetRelationship )
+Relationship CEntityClassificationsManager::GetRelationshipBetweenUncached( EntityClassification_t sourceClassId, EntityClassification_t targetClassId, bool bBidirectional ) const
+{
+	if( !IsClassIdValid( sourceClassId ) || !IsClassIdValid( targetClassId ) )
 	{
-		return to->m_DefaultTargetRelationship;
+		Alert( at_error, "CEntityClassificationsManager::GetRelationshipBetweenUncached: One or both class Ids (\"%u\" and \"%u\") are invalid\n", sourceClassId, targetClassId );
+		return R_NO;
 	}
 
-	//No explicit relationship, return default.
-	return from->m_DefaultSourceRelationship;
+	return ResolveRelationship( *m_ClassList[ IdToIndex( sourceClassId ) ], *m_ClassList[ IdToIndex( targetClassId ) ], bBidirectional );
 }
 
 Relationship CEntityClassificationsManager::GetRelationshipBetween( const std::string& sourceClassName, const std::string& targetClassName, bool bBidirectional ) const
@@ -566,6 +655,61 @@ void CEntityClassificationsManager::WriteToFile( const char* pszFilename ) const
 	Alert( at_console, "Written entity classifications to file \"%s\"\n", pszFilename );
 }
 
+Relationship CEntityClassificationsManager::ResolveRelationship( const CEntityClassificationData& from, const CEntityClassificationData& to, bool bBidirectional ) const
+{
+	Relationship result = R_NO;
+
+	//If there exists a relationship from source to target, return relationship.
+	if( from.GetRelationshipToClassification( to.m_ClassId, result ) )
+	{
+		return result;
+	}
+
+	//No relationship from source to target, should we check for target to source?
+	if( bBidirectional )
+	{
+		//There is a relationship, return value.
+		if( to.GetRelationshipToClassification( from.m_ClassId, result ) )
+		{
+			return result;
+		}
+	}
+
+	if( to.m_bHasDefaultTargetRelationship )
+	{
+		return to.m_DefaultTargetRelationship;
+	}
+
+	//No explicit relationship, return default.
+	return from.m_DefaultSourceRelationship;
+}
+
+void CEntityClassificationsManager::RebuildRelationshipMatrix() const
+{
+	m_RelationshipMatrix.assign( 2 * MAX_ENTITY_CLASSIFICATIONS * MAX_ENTITY_CLASSIFICATIONS, R_NO );
+
+	for( size_t sourceIndex = 0; sourceIndex < m_ClassList.size(); ++sourceIndex )
+	{
+		const auto& from = m_ClassList[ sourceIndex ];
+
+		if( !from )
+			continue;
+
+		for( size_t targetIndex = 0; targetIndex < m_ClassList.size(); ++targetIndex )
+		{
+			const auto& to = m_ClassList[ targetIndex ];
+
+			if( !to )
+				continue;
+
+			m_RelationshipMatrix[ MatrixIndex( sourceIndex, targetIndex, false ) ] = ResolveRelationship( *from, *to, false );
+			m_RelationshipMatrix[ MatrixIndex( sourceIndex, targetIndex, true ) ] = ResolveRelationship( *from, *to, true );
+		}
+	}
+
+	m_bRelationshipMatrixDirty = false;
+}
+
 size_t CEntityClassificationsManager::IdToIndex( EntityClassification_t classId )
 {
 	return classId - FIRST_ID_OFFSET;
@@ -84,7 +84,7 @@ public:
 	*	@param[ out ] outRelationship The relationship between this class and the target class, or R_NO if no relationship is defined
 	*	@return Whether a relationship was found between the classifications
 	*/
-	bool GetRelationshipToClassification( EntityClassification_t targetClassId, Relationship& outRelationship );
+	bool GetRelationshipToClassification( EntityClassification_t targetClassId, Relationship& outRelationship ) const;
 
 	void AddRelationship( EntityClassification_t targetClassId, Relationship relationship );
 
@@ -205,9 +205,16 @@ public:
 
 	/**
 	*	Returns the relationship between 2 classifications. Returns R_NO if either class Id is invalid.
+	*	Looked up in the relationship matrix, which is rebuilt first if anything changed since it was last built.
 	*/
 	Relationship GetRelationshipBetween( EntityClassification_t sourceClassId, EntityClassification_t targetClassId, bool bBidirectional = false ) const;
 
+	/**
+	*	Works like GetRelationshipBetween, but resolves the relationship from the classifications instead of the matrix.
+	*	Used to verify and benchmark the matrix.
+	*/
+	Relationship GetRelationshipBetweenUncached( EntityClassification_t sourceClassId, EntityClassification_t targetClassId, bool bBidirectional = false ) const;
+
 	Relationship GetRelationshipBetween( const std::string& sourceClassName, const std::string& targetClassName, bool bBidirectional = false ) const;
 
 	/**
@@ -238,6 +245,23 @@ private:
 
 	static EntityClassification_t IndexToId( size_t index );
 
+	Relationship ResolveRelationship( const CEntityClassificationData& from, const CEntityClassificationData& to, bool bBidirectional ) const;
+
+	/**
+	*	Must be called whenever a classification or relationship changes.
+	*/
+	void InvalidateRelationshipMatrix()
+	{
+		m_bRelationshipMatrixDirty = true;
+	}
+
+	void RebuildRelationshipMatrix() const;
+
+	static size_t MatrixIndex( size_t sourceIndex, size_t targetIndex, bool bBidirectional )
+	{
+		return ( bBidirectional ? MAX_ENTITY_CLASSIFICATIONS * MAX_ENTITY_CLASSIFICATIONS : 0 ) + sourceIndex * MAX_ENTITY_CLASSIFICATIONS + targetIndex;
+	}
+
 private:
 	//TODO: use a CUtlDict - Solokiller
 	ClassList_t m_ClassList;
@@ -245,6 +269,14 @@ private:
 
 	EntityClassification_t m_NoneId = INVALID_ENTITY_CLASSIFICATION;
 
+	/**
+	*	Relationships between all classifications, indexed with MatrixIndex.
+	*	Holds one matrix for one way relationships followed by one for bidirectional relationships.
+	*/
+	mutable std::vector<int8_t> m_RelationshipMatrix;
+
+	mutable bool m_bRelationshipMatrixDirty = true;
+
 private:
 	CEntityClassificationsManager( const CEntityClassificationsManager& ) = delete;
 	CEntityClassificationsManager& operator=( const CEntityClassificationsManager& ) = delete;
@@ -63,6 +63,12 @@ CBaseEntity
 
 using CEntBitSet = CBitSet<int>;
 
+/**
+*	Notify the server when an entity's classname, targetname or target changes, so its name index stays up to date.
+*	@see Server_EntityCreated
+*/
+void Server_EntityNamesChanged( entvars_t* pev );
+
 //
 // Base Entity.  All entity types derive from this
 //
@@ -97,6 +103,7 @@ public:
 	void SetClassname( const char* pszClassName )
 	{
 		pev->classname = MAKE_STRING( pszClassName );
+		Server_EntityNamesChanged( pev );
 	}
 
 	/**
@@ -174,6 +181,7 @@ public:
 	void SetTargetname( const string_t iszTargetName )
 	{
 		pev->targetname = iszTargetName;
+		Server_EntityNamesChanged( pev );
 	}
 
 	/**
@@ -191,6 +199,7 @@ public:
 	void ClearTargetname()
 	{
 		pev->targetname = iStringNull;
+		Server_EntityNamesChanged( pev );
 	}
 
 	/**
@@ -213,6 +222,7 @@ public:
 	void SetTarget( const string_t iszTarget )
 	{
 		pev->target = iszTarget;
+		Server_EntityNamesChanged( pev );
 	}
 
 	/**
@@ -230,6 +240,7 @@ public:
 	void ClearTarget()
 	{
 		pev->target = iStringNull;
+		Server_EntityNamesChanged( pev );
 	}
 
 	/**
@@ -2210,7 +2221,7 @@ public:
 	/**
 	*	@return Whether this entity has the given target.
 	*/
-	virtual bool HasTarget( string_t targetname ) const { return FStrEq( STRING( targetname ), GetTargetname() ); }
+	virtual bool HasTarget( string_t targetname ) const { return FStringsEqual( targetname, pev->targetname ); }
 
 	/**
 	*	@return Whether this entity has the given target.
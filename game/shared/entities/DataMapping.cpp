@@ -40,6 +40,41 @@ const TYPEDESCRIPTION* UTIL_FindTypeDescInDataMap( const DataMap_t& dataMap, con
 	return nullptr;
 }
 
+const TYPEDESCRIPTION* UTIL_FindKeyTypeDescInDataMap( const DataMap_t& dataMap, const char* const pszKeyName )
+{
+	ASSERT( pszKeyName );
+
+	if( !dataMap.pKeys )
+	{
+		auto pKeys = std::make_unique<DataMapKeys_t>();
+
+		for( const DataMap_t* pMap = &dataMap; pMap; pMap = pMap->pParent )
+		{
+			for( size_t uiIndex = 0; uiIndex < pMap->uiNumDescriptors; ++uiIndex )
+			{
+				const TYPEDESCRIPTION* pDesc = &pMap->pTypeDesc[ uiIndex ];
+
+				//Maps are added from child to parent, so this won't replace overridden keys.
+				if( pDesc->pszPublicName && ( pDesc->flags & TypeDescFlag::KEY ) )
+					pKeys->emplace( pDesc->pszPublicName, pDesc );
+			}
+		}
+
+		dataMap.pKeys = std::move( pKeys );
+	}
+
+	auto it = dataMap.pKeys->find( pszKeyName );
+
+	if( it == dataMap.pKeys->end() )
+		return nullptr;
+
+	//Keys that were compared with FStrEq must still match exactly.
+	if( ( it->second->flags & TypeDescFlag::KEY_CASE_SENSITIVE ) && strcmp( it->second->pszPublicName, pszKeyName ) != 0 )
+		return nullptr;
+
+	return it->second;
+}
+
 const char* UTIL_NameFromFunctionSingle( const DataMap_t& dataMap, BASEPTR pFunction )
 {
 	ASSERT( pFunction );
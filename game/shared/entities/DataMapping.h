@@ -1,11 +1,21 @@
 #ifndef GAME_SHARED_ENTITIES_DATAMAPPING_H
 #define GAME_SHARED_ENTITIES_DATAMAPPING_H
 
+#include <memory>
+#include <unordered_map>
+
+#include "StringUtils.h"
+
 #include "CBaseForward.h"
 #include "saverestore/SaveRestoreDefs.h"
 
 struct TYPEDESCRIPTION;
 
+/**
+*	Maps key names to type descriptions. Case insensitive.
+*/
+typedef std::unordered_map<const char*, const TYPEDESCRIPTION*, RawCharHashI, RawCharEqualToI> DataMapKeys_t;
+
 #define DECLARE_CLASS_NOBASE( thisClass )	\
 typedef thisClass ThisClass
 
@@ -37,6 +47,13 @@ struct DataMap_t final
 	*	Number of descriptors in the type description array.
 	*/
 	size_t uiNumDescriptors;
+
+	/**
+	*	Fields that can be initialized by DispatchKeyValue in this map and all parent maps, by public name.
+	*	Built the first time a key is looked up.
+	*	@see UTIL_FindKeyTypeDescInDataMap
+	*/
+	mutable std::unique_ptr<const DataMapKeys_t> pKeys;
 };
 
 /**
@@ -180,6 +197,15 @@ const TYPEDESCRIPTION* UTIL_FindTypeDescInSingleDataMap( const DataMap_t& dataMa
 */
 const TYPEDESCRIPTION* UTIL_FindTypeDescInDataMap( const DataMap_t& dataMap, const char* const pszFieldName, const bool bComparePublicName = false );
 
+/**
+*	Finds a field that can be initialized by DispatchKeyValue. Will search in all parent data maps.
+*	Fields in a map take precedence over fields in its parent maps.
+*	@param dataMap Data map to search in.
+*	@param pszKeyName Public name of the field. Case insensitive.
+*	@return If found, returns the type description. Otherwise, returns nullptr.
+*/
+const TYPEDESCRIPTION* UTIL_FindKeyTypeDescInDataMap( const DataMap_t& dataMap, const char* const pszKeyName );
+
 /**
 *	Gets the name of a function out of a single data map from an address.
 *	@param dataMap Data map to search in.
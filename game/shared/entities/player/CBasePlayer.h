@@ -745,12 +745,20 @@ public:
 
 	const CHudColors& GetHudColors() const { return m_HudColors; }
 
+	/**
+	*	@return The model index of the third person weapon model. Cached until the weapon model changes.
+	*/
+	int GetWeaponModelIndex();
+
 private:
 	bool m_bUseCustomHudColors = false;
 
 	float m_flLastHudColorChangeTime = 0;
 
 	CHudColors m_HudColors;
+
+	string_t m_iszCachedWeaponModel = iStringNull;
+	int m_iCachedWeaponModelIndex = -1;
 };
 
 extern int	gmsgHudText;
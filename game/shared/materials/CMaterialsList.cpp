@@ -1,22 +1,24 @@
+#include <memory>
+
 #include "extdll.h"
 #include "util.h"
 #include "sound/Sound.h"
 
+#include "StringUtils.h"
+
 #include "CMaterialsList.h"
 
 bool CMaterialsList::LoadFromFile( const char* const pszFileName )
 {
 	ASSERT( pszFileName );
 
-	//Zero out any data that might still be there
-	m_iTextures = 0;
-	memset( m_szTextureName, 0, sizeof( m_szTextureName ) );
-	memset( m_chTextureType, 0, sizeof( m_chTextureType ) );
-
 	FileHandle_t hFile = g_pFileSystem->Open( pszFileName, "r" );
 
 	if( hFile == FILESYSTEM_INVALID_HANDLE )
+	{
+		LoadFromBuffer( "" );
 		return false;
+	}
 
 	{
 		char szPath[ MAX_PATH ];
@@ -27,18 +29,55 @@ bool CMaterialsList::LoadFromFile( const char* const pszFileName )
 		ALERT( at_aiconsole, "CMaterialsList::LoadFromFile: Loading materials file \"%s\"\n", szPath );
 	}
 
+	const unsigned int uiSize = g_pFileSystem->Size( hFile );
+
+	std::unique_ptr<char[]> buffer( new char[ uiSize + 1 ] );
+
+	//Text mode reads can return less than the file size.
+	const int iRead = g_pFileSystem->Read( buffer.get(), uiSize, hFile );
+
+	buffer[ iRead > 0 ? iRead : 0 ] = '\0';
+
+	g_pFileSystem->Close( hFile );
+
+	return LoadFromBuffer( buffer.get() );
+}
+
+bool CMaterialsList::LoadFromBuffer( const char* pszBuffer )
+{
+	ASSERT( pszBuffer );
+
+	//Zero out any data that might still be there
+	m_Materials.clear();
+	ResizeTable( MIN_TABLE_SIZE );
+
+	//Cached types may have changed.
+	ClearTextureCache();
+
 	char buffer[ 512 ];
 	int i, j;
 
 	char texType;
 
-	int iFound;
-
 	memset( buffer, 0, sizeof( buffer ) );
 
-	// for each line in the file...
-	while( g_pFileSystem->ReadLine( buffer, sizeof( buffer ), hFile ) && ( m_iTextures < CTEXTURESMAX ) )
+	// for each line in the buffer...
+	while( *pszBuffer )
 	{
+		//Lines keep their newline, like ReadLine does. Long lines are split.
+		size_t uiLength = 0;
+
+		while( pszBuffer[ uiLength ] && pszBuffer[ uiLength ] != '\n' && uiLength < sizeof( buffer ) - 2 )
+			++uiLength;
+
+		if( pszBuffer[ uiLength ] == '\n' )
+			++uiLength;
+
+		memcpy( buffer, pszBuffer, uiLength );
+		buffer[ uiLength ] = '\0';
+
+		pszBuffer += uiLength;
+
 		// skip whitespace
 		i = 0;
 		while( buffer[ i ] && isspace( buffer[ i ] ) )
@@ -73,121 +112,140 @@ bool CMaterialsList::LoadFromFile( const char* const pszFileName )
 		j = min( j, CBTEXTURENAMEMAX - 1 + i );
 		buffer[ j ] = '\0';
 
-		iFound = FindTextureLinear( &( buffer[ i ] ) );
+		const uint32_t uiHash = Hash( &( buffer[ i ] ) );
+
+		size_t uiSlot = FindSlot( &( buffer[ i ] ), uiHash );
 
 		//Duplicate entry, just update the type. - Solokiller
-		if( iFound != -1 )
+		if( m_Table[ uiSlot ] != INVALID_TEX_INDEX )
 		{
+			auto& material = m_Materials[ m_Table[ uiSlot ] ];
+
 			//Notify the developer.
-			ALERT( at_console, "CMaterialsList::LoadFromFile: Duplicate material entry for texture \"%s\": old type: \'%c\', new type: \'%c\'\n", 
-				   &( buffer[ i ] ), m_chTextureType[ iFound ], texType );
+			ALERT( at_console, "CMaterialsList::LoadFromBuffer: Duplicate material entry for texture \"%s\": old type: \'%c\', new type: \'%c\'\n", 
+				   &( buffer[ i ] ), material.chType, texType );
 
-			m_chTextureType[ iFound ] = texType;
+			material.chType = texType;
 		}
 		else
 		{
-			m_chTextureType[ m_iTextures ] = texType;
-			strcpy( &( m_szTextureName[ m_iTextures++ ][ 0 ] ), &( buffer[ i ] ) );
-		}
-	}
+			//Keep the load factor at or below 0.5.
+			if( ( m_Materials.size() + 1 ) * 2 > m_Table.size() )
+			{
+				ResizeTable( m_Table.size() * 2 );
+				uiSlot = FindSlot( &( buffer[ i ] ), uiHash );
+			}
 
-	g_pFileSystem->Close( hFile );
+			Material material;
 
-	SortTextures();
+			strcpy( material.szName, &( buffer[ i ] ) );
+			material.chType = texType;
+			material.uiHash = uiHash;
+
+			m_Table[ uiSlot ] = static_cast<int>( m_Materials.size() );
+
+			m_Materials.push_back( material );
+		}
+	}
 
 	return true;
 }
 
 char CMaterialsList::FindTextureType( const char* const pszName ) const
 {
-	int left = 0;
-	int right = m_iTextures - 1;
+	ASSERT( pszName );
 
-	int pivot;
-	int val;
+	//Nothing has been loaded yet.
+	if( m_Table.empty() )
+		return CHAR_TEX_CONCRETE;
 
-	while( left <= right )
-	{
-		pivot = ( left + right ) / 2;
+	const int iIndex = m_Table[ FindSlot( pszName, Hash( pszName ) ) ];
 
-		val = strnicmp( pszName, m_szTextureName[ pivot ], CBTEXTURENAMEMAX - 1 );
-		if( val == 0 )
-		{
-			return m_chTextureType[ pivot ];
-		}
-		else if( val > 0 )
-		{
-			left = pivot + 1;
-		}
-		else if( val < 0 )
-		{
-			right = pivot - 1;
-		}
-	}
+	if( iIndex != INVALID_TEX_INDEX )
+		return m_Materials[ iIndex ].chType;
 
 	return CHAR_TEX_CONCRETE;
 }
 
+char CMaterialsList::FindEngineTextureType( const char* const pszEngineName )
+{
+	ASSERT( pszEngineName );
+
+	auto it = m_TextureCache.find( pszEngineName );
+
+	if( it != m_TextureCache.end() )
+		return it->second;
+
+	const char chType = FindTextureType( StripTexturePrefix( pszEngineName ) );
+
+	m_TextureCache.emplace( pszEngineName, chType );
+
+	return chType;
+}
+
 int CMaterialsList::FindTextureByType( int iPrevious, const char chType ) const
 {
-	for( int iIndex = iPrevious == INVALID_TEX_INDEX ? 0 : iPrevious + 1;
-		 iIndex < m_iTextures; ++iIndex )
+	for( size_t uiIndex = iPrevious == INVALID_TEX_INDEX ? 0 : iPrevious + 1;
+		 uiIndex < m_Materials.size(); ++uiIndex )
 	{
-		if( m_chTextureType[ iIndex ] == chType )
-			return iIndex;
+		if( m_Materials[ uiIndex ].chType == chType )
+			return static_cast<int>( uiIndex );
 	}
 
 	return INVALID_TEX_INDEX;
 }
 
-void CMaterialsList::SwapTextures( int i, int j )
+const char* CMaterialsList::StripTexturePrefix( const char* pszName )
 {
-	ASSERT( i < m_iTextures );
-	ASSERT( j < m_iTextures );
+	ASSERT( pszName );
 
-	char chTemp;
-	char szTemp[ CBTEXTURENAMEMAX ];
+	// strip leading '-0' or '+0~' or '{' or '!'
+	if( *pszName == '-' || *pszName == '+' )
+		pszName += 2;
 
-	strcpy( szTemp, m_szTextureName[ i ] );
-	chTemp = m_chTextureType[ i ];
+	if( *pszName == '{' || *pszName == '!' || *pszName == '~' || *pszName == ' ' )
+		++pszName;
 
-	strcpy( m_szTextureName[ i ], m_szTextureName[ j ] );
-	m_chTextureType[ i ] = m_chTextureType[ j ];
+	return pszName;
+}
 
-	strcpy( m_szTextureName[ j ], szTemp );
-	m_chTextureType[ j ] = chTemp;
+uint32_t CMaterialsList::Hash( const char* pszName )
+{
+	//Only hash the characters that are compared.
+	return StringHashFNV1a( pszName, true, CBTEXTURENAMEMAX - 1 );
 }
 
-void CMaterialsList::SortTextures()
+size_t CMaterialsList::FindSlot( const char* pszName, const uint32_t uiHash ) const
 {
-	// Bubble sort, yuck, but this only occurs at startup and it's only 512 elements...
-	//
+	const size_t uiMask = m_Table.size() - 1;
 
-	for( int i = 0; i < m_iTextures; i++ )
+	for( size_t uiSlot = uiHash & uiMask; ; uiSlot = ( uiSlot + 1 ) & uiMask )
 	{
-		for( int j = i + 1; j < m_iTextures; j++ )
-		{
-			if( stricmp( m_szTextureName[ i ], m_szTextureName[ j ] ) > 0 )
-			{
-				// Swap
-				//
-				SwapTextures( i, j );
-			}
-		}
+		const int iIndex = m_Table[ uiSlot ];
+
+		if( iIndex == INVALID_TEX_INDEX )
+			return uiSlot;
+
+		const Material& material = m_Materials[ iIndex ];
+
+		if( material.uiHash == uiHash && !strnicmp( pszName, material.szName, CBTEXTURENAMEMAX - 1 ) )
+			return uiSlot;
 	}
 }
 
-int CMaterialsList::FindTextureLinear( const char* const pszName ) const
+void CMaterialsList::ResizeTable( const size_t uiSize )
 {
-	ASSERT( pszName );
+	m_Table.assign( uiSize, static_cast<int>( INVALID_TEX_INDEX ) );
+
+	const size_t uiMask = uiSize - 1;
 
-	for( int i = 0; i < m_iTextures; i++ )
+	for( size_t uiIndex = 0; uiIndex < m_Materials.size(); ++uiIndex )
 	{
-		if( stricmp( m_szTextureName[ i ], pszName ) == 0 )
-		{
-			return i;
-		}
-	}
+		size_t uiSlot = m_Materials[ uiIndex ].uiHash & uiMask;
+
+		while( m_Table[ uiSlot ] != INVALID_TEX_INDEX )
+			uiSlot = ( uiSlot + 1 ) & uiMask;
 
-	return -1;
-}
\ No newline at end of file
+		m_Table[ uiSlot ] = static_cast<int>( uiIndex );
+	}
+}
@@ -1,6 +1,11 @@
 #ifndef GAME_SHARED_MATERIALS_CMATERIALSLIST_H
 #define GAME_SHARED_MATERIALS_CMATERIALSLIST_H
 
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 #include "MaterialsConst.h"
 
 /**
@@ -22,16 +27,37 @@ public:
 	*/
 	bool LoadFromFile( const char* const pszFileName );
 
+	/**
+	*	Loads materials data from the contents of a materials file.
+	*	Used by tools that run without the engine's filesystem.
+	*	@param pszBuffer Null terminated file contents.
+	*	@return true on success, false otherwise.
+	*/
+	bool LoadFromBuffer( const char* pszBuffer );
+
 	/**
 	*	Given texture name, find texture type.
 	*	If not found, return type 'concrete'.
-	*
-	*	NOTE: this routine should ONLY be called if the current texture under the player changes!
+	*	Names are compared without regard to case, up to CBTEXTURENAMEMAX - 1 characters.
 	*	@param pszName Texture name.
 	*	@return Texture type.
 	*/
 	char FindTextureType( const char* const pszName ) const;
 
+	/**
+	*	Finds the type of a texture returned by the engine's texture traces. The texture's prefix is skipped.
+	*	The engine returns the name stored in its texture_t, so the pointer identifies the texture.
+	*	Types are cached by pointer, repeated hits on the same surface don't look at the name again.
+	*	@param pszEngineName Name pointer returned by the engine.
+	*	@return Texture type.
+	*/
+	char FindEngineTextureType( const char* const pszEngineName );
+
+	/**
+	*	Forgets the types of engine textures. Must be called whenever the engine frees its textures, which it does on map change.
+	*/
+	void ClearTextureCache() { m_TextureCache.clear(); }
+
 	/**
 	*	Finds a texture by material type.
 	*	@param iPrevious The previous texture to start looking after.
@@ -41,23 +67,50 @@ public:
 	*/
 	int FindTextureByType( int iPrevious, const char chType ) const;
 
+	/**
+	*	Skips the prefixes of random tiling ('-'), animated ('+'), transparent ('{'), water ('!', '~') and hint (' ') textures.
+	*	@param pszName Texture name.
+	*	@return Name without its prefix.
+	*/
+	static const char* StripTexturePrefix( const char* pszName );
+
 private:
-	void SwapTextures( int i, int j );
+	struct Material
+	{
+		char szName[ CBTEXTURENAMEMAX ];
+		char chType;
+		uint32_t uiHash;
+	};
 
-	void SortTextures();
+	/**
+	*	Case insensitive hash of up to CBTEXTURENAMEMAX - 1 characters of a name.
+	*/
+	static uint32_t Hash( const char* pszName );
 
 	/**
-	*	Finds a texture. Searches linearly.
-	*	Should only be used during load time.
-	*	@param pszName Texture name.
-	*	@return Index, or -1 if it wasn't found.
+	*	@return Slot holding the given texture, or the empty slot where it would be inserted.
 	*/
-	int FindTextureLinear( const char* const pszName ) const;
+	size_t FindSlot( const char* pszName, const uint32_t uiHash ) const;
+
+	void ResizeTable( const size_t uiSize );
 
 private:
-	int m_iTextures = 0;
-	char m_szTextureName[ CTEXTURESMAX ][ CBTEXTURENAMEMAX ];
-	char m_chTextureType[ CTEXTURESMAX ];
+	static const size_t MIN_TABLE_SIZE = 256;
+
+	/**
+	*	Materials in file order.
+	*/
+	std::vector<Material> m_Materials;
+
+	/**
+	*	Open addressed hash table of indices into m_Materials, INVALID_TEX_INDEX for empty slots. The size is a power of 2.
+	*/
+	std::vector<int> m_Table;
+
+	/**
+	*	Engine texture name to texture type.
+	*/
+	std::unordered_map<const char*, char> m_TextureCache;
 
 private:
 	CMaterialsList( const CMaterialsList& ) = delete;
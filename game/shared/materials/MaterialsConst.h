@@ -15,11 +15,6 @@
 #ifndef GAME_SHARED_MATERIALS_MATERIALSCONST_H
 #define GAME_SHARED_MATERIALS_MATERIALSCONST_H
 
-/**
-*	Max number of textures loaded.
-*/
-#define CTEXTURESMAX		512
-
 /**
 *	Now matches the maximum name length of a WAD lump. - Solokiller
 */
@@ -26,6 +26,8 @@ extern engine_studio_api_t IEngineStudio;
 #include "CStudioBlending.h"
 #endif
 
+#include "ssemath.h"
+
 #include "StudioUtils.h"
 
 namespace studio
@@ -115,11 +117,14 @@ void CalcBoneAdj( studiohdr_t* pHeader, float dadt, float *adj, const byte *pcon
 	}
 }
 
-void CalcBoneQuaterion( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *panim, float *adj, Vector4D& q )
+namespace
+{
+/**
+*	Decodes the rotation of a bone in the given frame and the frame after it.
+*/
+void CalcBoneAngles( int frame, mstudiobone_t *pbone, mstudioanim_t *panim, float *adj, Vector& angle1, Vector& angle2 )
 {
 	int					j, k;
-	Vector4D			q1, q2;
-	Vector				angle1, angle2;
 	mstudioanimvalue_t	*panimvalue;
 
 	for( j = 0; j < 3; j++ )
@@ -182,6 +187,68 @@ void CalcBoneQuaterion( int frame, float s, mstudiobone_t *pbone, mstudioanim_t
 			angle2[ j ] += adj[ pbone->bonecontroller[ j + 3 ] ];
 		}
 	}
+}
+
+float ClampFrame( float f, const mstudioseqdesc_t *pseqdesc )
+{
+	if( f > pseqdesc->numframes - 1 )
+	{
+		f = 0;	// bah, fix this bug with changing sequences too fast
+	}
+	// BUG ( somewhere else ) but this code should validate this data.
+	// This could cause a crash if the frame # is negative, so we'll go ahead
+	//  and clamp it here
+	else if( f < -0.01 )
+	{
+		f = -0.01;
+	}
+
+	return f;
+}
+
+/**
+*	Applies the sequence's motion to the motion bone.
+*/
+void ApplyMotion( Vector* vecPos, const mstudioseqdesc_t *pseqdesc, float f, float framerate )
+{
+	float s;
+
+	if( pseqdesc->motiontype & STUDIO_X )
+	{
+		vecPos[ pseqdesc->motionbone ][ 0 ] = 0.0;
+	}
+	if( pseqdesc->motiontype & STUDIO_Y )
+	{
+		vecPos[ pseqdesc->motionbone ][ 1 ] = 0.0;
+	}
+	if( pseqdesc->motiontype & STUDIO_Z )
+	{
+		vecPos[ pseqdesc->motionbone ][ 2 ] = 0.0;
+	}
+
+	s = 0 * ( ( 1.0 - ( f - ( int ) ( f ) ) ) / ( pseqdesc->numframes ) ) * framerate;
+
+	if( pseqdesc->motiontype & STUDIO_LX )
+	{
+		vecPos[ pseqdesc->motionbone ][ 0 ] += s * pseqdesc->linearmovement[ 0 ];
+	}
+	if( pseqdesc->motiontype & STUDIO_LY )
+	{
+		vecPos[ pseqdesc->motionbone ][ 1 ] += s * pseqdesc->linearmovement[ 1 ];
+	}
+	if( pseqdesc->motiontype & STUDIO_LZ )
+	{
+		vecPos[ pseqdesc->motionbone ][ 2 ] += s * pseqdesc->linearmovement[ 2 ];
+	}
+}
+}
+
+void CalcBoneQuaterion( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *panim, float *adj, Vector4D& q )
+{
+	Vector4D			q1, q2;
+	Vector				angle1, angle2;
+
+	CalcBoneAngles( frame, pbone, panim, adj, angle1, angle2 );
 
 	if( angle1 != angle2 )
 	{
@@ -257,6 +324,8 @@ void CalcBonePosition( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *
 	}
 }
 
+namespace scalar
+{
 void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate )
 {
 	int					i;
@@ -266,27 +335,10 @@ void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudiose
 	float				s;
 	float				adj[ MAXSTUDIOCONTROLLERS ];
 
-	if( f > pseqdesc->numframes - 1 )
-	{
-		f = 0;	// bah, fix this bug with changing sequences too fast
-	}
-	// BUG ( somewhere else ) but this code should validate this data.
-	// This could cause a crash if the frame # is negative, so we'll go ahead
-	//  and clamp it here
-	else if( f < -0.01 )
-	{
-		f = -0.01;
-	}
+	f = ClampFrame( f, pseqdesc );
 
 	frame = ( int ) f;
 
-	// Con_DPrintf("%d %.4f %.4f %.4f %.4f %d\n", m_pCurrentEntity->curstate.sequence, m_clTime, m_pCurrentEntity->animtime, m_pCurrentEntity->frame, f, frame );
-
-	// Con_DPrintf( "%f %f %f\n", m_pCurrentEntity->angles[ROLL], m_pCurrentEntity->angles[PITCH], m_pCurrentEntity->angles[YAW] );
-
-	// Con_DPrintf("frame %d %d\n", frame1, frame2 );
-
-
 	s = ( f - frame );
 
 	// add in programtic controllers
@@ -299,37 +351,9 @@ void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudiose
 		CalcBoneQuaterion( frame, s, pbone, panim, adj, q[ i ] );
 
 		CalcBonePosition( frame, s, pbone, panim, adj, vecPos[ i ] );
-		// if (0 && i == 0)
-		//	Con_DPrintf("%d %d %d %d\n", m_pCurrentEntity->curstate.sequence, frame, j, k );
 	}
 
-	if( pseqdesc->motiontype & STUDIO_X )
-	{
-		vecPos[ pseqdesc->motionbone ][ 0 ] = 0.0;
-	}
-	if( pseqdesc->motiontype & STUDIO_Y )
-	{
-		vecPos[ pseqdesc->motionbone ][ 1 ] = 0.0;
-	}
-	if( pseqdesc->motiontype & STUDIO_Z )
-	{
-		vecPos[ pseqdesc->motionbone ][ 2 ] = 0.0;
-	}
-
-	s = 0 * ( ( 1.0 - ( f - ( int ) ( f ) ) ) / ( pseqdesc->numframes ) ) * framerate;
-
-	if( pseqdesc->motiontype & STUDIO_LX )
-	{
-		vecPos[ pseqdesc->motionbone ][ 0 ] += s * pseqdesc->linearmovement[ 0 ];
-	}
-	if( pseqdesc->motiontype & STUDIO_LY )
-	{
-		vecPos[ pseqdesc->motionbone ][ 1 ] += s * pseqdesc->linearmovement[ 1 ];
-	}
-	if( pseqdesc->motiontype & STUDIO_LZ )
-	{
-		vecPos[ pseqdesc->motionbone ][ 2 ] += s * pseqdesc->linearmovement[ 2 ];
-	}
+	ApplyMotion( vecPos, pseqdesc, f, framerate );
 }
 
 void SlerpBones( studiohdr_t* pHeader, Vector4D* q1, Vector* vecPos1, Vector4D* q2, const Vector* vecPos2, float s )
@@ -356,3 +380,214 @@ void SlerpBones( studiohdr_t* pHeader, Vector4D* q1, Vector* vecPos1, Vector4D*
 	}
 }
 }
+
+#if MATHLIB_USE_SSE2
+void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate )
+{
+	const int numbones = pHeader->numbones;
+
+	if( numbones > MAXSTUDIOBONES )
+	{
+		scalar::CalcRotations( pHeader, vecPos, q, pseqdesc, panim, f, dadt, pcontroller1, pcontroller2, mouthopen, framerate );
+		return;
+	}
+
+	//Rotations of each bone in the current and next frame, one array per component.
+	alignas( 16 ) float angles1[ 3 ][ MAXSTUDIOBONES ];
+	alignas( 16 ) float angles2[ 3 ][ MAXSTUDIOBONES ];
+
+	float adj[ MAXSTUDIOCONTROLLERS ];
+
+	f = ClampFrame( f, pseqdesc );
+
+	const int frame = ( int ) f;
+
+	const float s = ( f - frame );
+
+	mstudiobone_t* pbone = ( mstudiobone_t * ) ( ( byte * ) pHeader + pHeader->boneindex );
+
+	CalcBoneAdj( pHeader, dadt, adj, pcontroller1, pcontroller2, mouthopen );
+
+	//Animation values are run length encoded per bone, so they are decoded one bone at a time.
+	int i;
+
+	for( i = 0; i < numbones; ++i, ++pbone, ++panim )
+	{
+		Vector angle1, angle2;
+
+		CalcBoneAngles( frame, pbone, panim, adj, angle1, angle2 );
+
+		for( int j = 0; j < 3; ++j )
+		{
+			angles1[ j ][ i ] = angle1[ j ];
+			angles2[ j ][ i ] = angle2[ j ];
+		}
+
+		CalcBonePosition( frame, s, pbone, panim, adj, vecPos[ i ] );
+	}
+
+	//Pad to a multiple of 4 bones.
+	for( ; i & 3; ++i )
+	{
+		for( int j = 0; j < 3; ++j )
+		{
+			angles1[ j ][ i ] = angles2[ j ][ i ] = 0;
+		}
+	}
+
+	for( i = 0; i < numbones; i += 4 )
+	{
+		const __m128 angle10 = _mm_load_ps( &angles1[ 0 ][ i ] );
+		const __m128 angle11 = _mm_load_ps( &angles1[ 1 ][ i ] );
+		const __m128 angle12 = _mm_load_ps( &angles1[ 2 ][ i ] );
+		const __m128 angle20 = _mm_load_ps( &angles2[ 0 ][ i ] );
+		const __m128 angle21 = _mm_load_ps( &angles2[ 1 ][ i ] );
+		const __m128 angle22 = _mm_load_ps( &angles2[ 2 ][ i ] );
+
+		__m128 x, y, z, w;
+
+		SSE_AngleQuaternion( angle10, angle11, angle12, x, y, z, w );
+
+		//Bones that don't rotate between the 2 frames use the first rotation as is.
+		const __m128 same = _mm_and_ps( _mm_and_ps( _mm_cmpeq_ps( angle10, angle20 ), _mm_cmpeq_ps( angle11, angle21 ) ), _mm_cmpeq_ps( angle12, angle22 ) );
+
+		if( _mm_movemask_ps( same ) != 0xF )
+		{
+			__m128 x2, y2, z2, w2;
+
+			SSE_AngleQuaternion( angle20, angle21, angle22, x2, y2, z2, w2 );
+
+			__m128 slerpX, slerpY, slerpZ, slerpW;
+
+			SSE_QuaternionSlerp( x, y, z, w, x2, y2, z2, w2, s, slerpX, slerpY, slerpZ, slerpW );
+
+			x = SSE_Select( same, x, slerpX );
+			y = SSE_Select( same, y, slerpY );
+			z = SSE_Select( same, z, slerpZ );
+			w = SSE_Select( same, w, slerpW );
+		}
+
+		if( i + 4 <= numbones )
+		{
+			SSE_StoreQuaternions( &q[ i ].x, x, y, z, w );
+		}
+		else
+		{
+			alignas( 16 ) Vector4D tail[ 4 ];
+
+			SSE_StoreQuaternions( &tail[ 0 ].x, x, y, z, w );
+
+			for( int j = 0; i + j < numbones; ++j )
+				q[ i + j ] = tail[ j ];
+		}
+	}
+
+	ApplyMotion( vecPos, pseqdesc, f, framerate );
+}
+
+void SlerpBones( studiohdr_t* pHeader, Vector4D* q1, Vector* vecPos1, Vector4D* q2, const Vector* vecPos2, float s )
+{
+	static_assert( sizeof( Vector ) == 3 * sizeof( vec_t ), "Bone positions must be tightly packed" );
+	static_assert( sizeof( Vector4D ) == 4 * sizeof( vec_t ), "Bone rotations must be tightly packed" );
+
+	if( s < 0 ) s = 0;
+	else if( s > 1.0 ) s = 1.0;
+
+	const float s1 = 1.0 - s;
+
+	const int numbones = pHeader->numbones;
+
+	int i;
+
+	for( i = 0; i + 4 <= numbones; i += 4 )
+	{
+		__m128 px, py, pz, pw;
+		__m128 qx, qy, qz, qw;
+
+		SSE_LoadQuaternions( &q1[ i ].x, px, py, pz, pw );
+		SSE_LoadQuaternions( &q2[ i ].x, qx, qy, qz, qw );
+
+		__m128 x, y, z, w;
+
+		SSE_QuaternionSlerp( px, py, pz, pw, qx, qy, qz, qw, s, x, y, z, w );
+
+		SSE_StoreQuaternions( &q1[ i ].x, x, y, z, w );
+
+		//QuaternionSlerp flips q2 in place, so do the same.
+		SSE_StoreQuaternions( &q2[ i ].x, qx, qy, qz, qw );
+	}
+
+	for( ; i < numbones; ++i )
+	{
+		Vector4D q3;
+
+		QuaternionSlerp( q1[ i ], q2[ i ], s, q3 );
+		q1[ i ] = q3;
+	}
+
+	//Positions are contiguous, so they're interpolated as one array of floats.
+	float* pflPos1 = &vecPos1[ 0 ].x;
+	const float* pflPos2 = &vecPos2[ 0 ].x;
+
+	const int iCount = numbones * 3;
+
+	const __m128 vecS = _mm_set1_ps( s );
+	const __m128 vecS1 = _mm_set1_ps( s1 );
+
+	for( i = 0; i + 4 <= iCount; i += 4 )
+	{
+		const __m128 pos1 = _mm_loadu_ps( pflPos1 + i );
+		const __m128 pos2 = _mm_loadu_ps( pflPos2 + i );
+
+		_mm_storeu_ps( pflPos1 + i, _mm_add_ps( _mm_mul_ps( pos1, vecS1 ), _mm_mul_ps( pos2, vecS ) ) );
+	}
+
+	for( ; i < iCount; ++i )
+	{
+		pflPos1[ i ] = pflPos1[ i ] * s1 + pflPos2[ i ] * s;
+	}
+}
+#else
+void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate )
+{
+	scalar::CalcRotations( pHeader, vecPos, q, pseqdesc, panim, f, dadt, pcontroller1, pcontroller2, mouthopen, framerate );
+}
+
+void SlerpBones( studiohdr_t* pHeader, Vector4D* q1, Vector* vecPos1, Vector4D* q2, const Vector* vecPos2, float s )
+{
+	scalar::SlerpBones( pHeader, q1, vecPos1, q2, vecPos2, s );
+}
+#endif
+
+void CalcChainRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate, const int* pChain, int iChainLength )
+{
+	float adj[ MAXSTUDIOCONTROLLERS ];
+
+	f = ClampFrame( f, pseqdesc );
+
+	const int frame = ( int ) f;
+
+	const float s = ( f - frame );
+
+	mstudiobone_t* pbones = ( mstudiobone_t * ) ( ( byte * ) pHeader + pHeader->boneindex );
+
+	CalcBoneAdj( pHeader, dadt, adj, pcontroller1, pcontroller2, mouthopen );
+
+	bool bHasMotionBone = false;
+
+	for( int i = 0; i < iChainLength; ++i )
+	{
+		const int iBone = pChain[ i ];
+
+		CalcBoneQuaterion( frame, s, &pbones[ iBone ], &panim[ iBone ], adj, q[ iBone ] );
+
+		CalcBonePosition( frame, s, &pbones[ iBone ], &panim[ iBone ], adj, vecPos[ iBone ] );
+
+		if( iBone == pseqdesc->motionbone )
+			bHasMotionBone = true;
+	}
+
+	if( bHasMotionBone )
+		ApplyMotion( vecPos, pseqdesc, f, framerate );
+}
+}
@@ -25,9 +25,33 @@ void CalcBoneQuaterion( int frame, float s, mstudiobone_t *pbone, mstudioanim_t
 
 void CalcBonePosition( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *panim, float *adj, Vector& vecPos );
 
+/**
+*	Computes the positions and rotations of all bones in the given frame.
+*	If SSE2 is available, the rotations of 4 bones are computed at a time.
+*/
 void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate );
 
+/**
+*	Blends the bones in q2 and vecPos2 into q1 and vecPos1. Rotations in q2 may be negated.
+*	If SSE2 is available, 4 bones are blended at a time.
+*/
 void SlerpBones( studiohdr_t* pHeader, Vector4D* q1, Vector* vecPos1, Vector4D* q2, const Vector* vecPos2, float s );
+
+/**
+*	Computes the positions and rotations of the iChainLength bones listed in pChain, the same way CalcRotations does.
+*	Other bones are left untouched.
+*/
+void CalcChainRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate, const int* pChain, int iChainLength );
+
+/**
+*	Scalar versions of the above. Used if SSE2 isn't available, and to verify the SSE2 versions.
+*/
+namespace scalar
+{
+void CalcRotations( studiohdr_t* pHeader, Vector* vecPos, Vector4D *q, mstudioseqdesc_t *pseqdesc, mstudioanim_t *panim, float f, float dadt, const byte* pcontroller1, const byte* pcontroller2, byte mouthopen, float framerate );
+
+void SlerpBones( studiohdr_t* pHeader, Vector4D* q1, Vector* vecPos1, Vector4D* q2, const Vector* vecPos2, float s );
+}
 }
 
 #endif //GAME_SHARED_STUDIO_STUDIOUTILS_H
@@ -42,6 +42,28 @@ extern globalvars_t				*gpGlobals;
 #define STRING(offset)		((const char *)(gpGlobals->pStringBase + (unsigned int)(offset)))
 #define MAKE_STRING(str)	((uint64)(str) - (uint64)(STRING(0)))	
 
+// Interns str in g_StringPool. Strings allocated this way can be compared with FStringsEqual without comparing their contents.
+#define POOL_STRING(str)	MAKE_STRING( g_StringPool.Allocate( str ) )
+
+/**
+*	Compares the contents of two strings.
+*	Pooled strings are only equal if they are the same string, so only strings that don't both come from g_StringPool are compared by contents.
+*	Checking whether a string is pooled costs a scan over the pool's blocks, see CHashStringPool::Owns.
+*/
+inline bool FStringsEqual( string_t iString1, string_t iString2 )
+{
+	if( iString1 == iString2 )
+		return true;
+
+	const char* pszString1 = STRING( iString1 );
+	const char* pszString2 = STRING( iString2 );
+
+	if( g_StringPool.Owns( pszString1 ) && g_StringPool.Owns( pszString2 ) )
+		return false;
+
+	return strcmp( pszString1, pszString2 ) == 0;
+}
+
 // Keeps clutter down a bit, when using a float as a bit-vector
 #define SetBits(flBitVector, bits)		((flBitVector) = (int)(flBitVector) | (bits))
 #define ClearBits(flBitVector, bits)	((flBitVector) = (int)(flBitVector) & ~(bits))
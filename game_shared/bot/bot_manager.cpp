@@ -24,6 +24,7 @@
 #include "bot.h"
 #include "bot_manager.h"
 #include "nav_area.h"
+#include "nav_analysis.h"
 #include "bot_util.h"
 #include "hostage.h"
 
@@ -103,6 +104,13 @@ void CBotManager::RestartRound( void )
  */
 void CBotManager::StartFrame( void )
 {
+	// advance any nav mesh analysis in progress
+	UpdateNavigationAnalysis();
+
+	// pick up any changes made to the nav mesh since the last frame - analysis jobs may be searching it
+	if (!IsNavigationAnalysisRunning())
+		CNavArea::UpdateCompactAdjacency();
+
 	// debug smoke grenade visualization
 	if (cv_bot_debug.value == 5)
 	{
@@ -198,6 +206,53 @@ void CBotManager::StartFrame( void )
 #endif
 }
 
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Register the server commands shared by all bot games
+ */
+void CBotManager::AddServerCommands( void )
+{
+	AddServerCommand( "bot_nav_benchmark" );
+	AddServerCommand( "bot_nav_analyze" );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Handle the server commands shared by all bot games
+ */
+void CBotManager::ServerCommand( const char *pcmd )
+{
+	if (FStrEq( pcmd, "bot_nav_benchmark" ))
+	{
+		if (CMD_ARGC() < 2)
+		{
+			CONSOLE_ECHO( "Usage: bot_nav_benchmark <query count> [seed]\n" );
+			return;
+		}
+
+		int count = atoi( CMD_ARGV( 1 ) );
+		unsigned int seed = (CMD_ARGC() > 2) ? (unsigned int)strtoul( CMD_ARGV( 2 ), NULL, 10 ) : 0;
+
+		NavAreaBuildPathBenchmark( count, seed );
+	}
+	else if (FStrEq( pcmd, "bot_nav_analyze" ))
+	{
+		// "bot_nav_analyze compare" also runs the serial analysis, and reports any differences
+		if (CMD_ARGC() > 1 && FStrEq( CMD_ARGV( 1 ), "compare" ))
+		{
+			int threadCount = (CMD_ARGC() > 2) ? atoi( CMD_ARGV( 2 ) ) : 0;
+
+			CompareNavigationAnalysis( threadCount );
+		}
+		else
+		{
+			int threadCount = (CMD_ARGC() > 1) ? atoi( CMD_ARGV( 1 ) ) : 0;
+
+			StartNavigationAnalysis( threadCount );
+		}
+	}
+}
+
 //--------------------------------------------------------------------------------------------------------------
 /**
  * Return the filename for this map's "nav map" file
@@ -75,9 +75,9 @@ public:
 
 	virtual void ServerActivate( void ) = 0;
 	virtual void ServerDeactivate( void ) = 0;
-	virtual void ServerCommand( const char * pcmd ) = 0;
+	virtual void ServerCommand( const char * pcmd );			///< (EXTEND) handle the server commands shared by all bot games
 	virtual void AddServerCommand( const char *cmd ) = 0;
-	virtual void AddServerCommands( void ) = 0;
+	virtual void AddServerCommands( void );						///< (EXTEND) register the server commands shared by all bot games
 
 	virtual void RestartRound( void );							///< (EXTEND) invoked when a new round begins
 	virtual void StartFrame( void );							///< (EXTEND) called each frame
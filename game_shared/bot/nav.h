@@ -27,6 +27,7 @@ const float HalfHumanHeight = 36.0f;
 const float HumanHeight = 72.0f;
 
 #define NAV_MAGIC_NUMBER 0xFEEDFACE				///< to help identify nav files
+#define NAV_VERSION 6									///< version of the nav files we write - see SaveNavigationMap()
 
 /**
  * A place is a named group of navigation areas
@@ -0,0 +1,1038 @@
+// nav_analysis.cpp
+// Multithreaded analysis of the navigation mesh
+//
+// The per-area analysis phases only read the mesh and the map's geometry, so each area is a job that can
+// run on its own thread. Jobs write their results to their own area, or to a slot indexed by the area, and
+// anything that depends on the order areas are processed in (such as hiding spot IDs) is done by the main
+// thread once the phase is done, in TheNavAreaList order. The results are the same as the serial analysis.
+
+#pragma warning( disable : 4530 )					// STL uses exceptions, but we are not compiling with them - ignore warning
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "extdll.h"
+#include "util.h"
+#include "cbase.h"
+#include "bot_util.h"
+#include "bot_manager.h"
+
+#include "com_model.h"
+#include "MiniBSPFile.h"
+
+#include "nav.h"
+#include "nav_area.h"
+#include "nav_analysis.h"
+#include "nav_file.h"
+
+extern DLL_GLOBAL CBotManager *TheBots;
+
+CEngineNavTrace TheEngineNavTrace;
+
+//--------------------------------------------------------------------------------------------------------------
+void CEngineNavTrace::TraceLine( const Vector &start, const Vector &end, IGNORE_GLASS glass, NavTraceResult *result ) const
+{
+	TraceResult tr;
+	UTIL_TraceLine( start, end, ignore_monsters, glass, NULL, &tr );
+
+	result->fraction = tr.flFraction;
+	result->startSolid = (tr.fStartSolid) ? true : false;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Return true if the given lump is within the file and holds a whole number of 'size' byte elements
+ */
+inline bool IsValidLump( const lump_t *lump, int fileLength, size_t size )
+{
+	if (lump->fileofs < 0 || lump->filelen < 0 || lump->fileofs + lump->filelen > fileLength)
+		return false;
+
+	return (lump->filelen % size) == 0;
+}
+
+/**
+ * Load the point hull of the given map, and take a snapshot of the solid brush entities.
+ * Hull 0 is built from the BSP nodes and leaf contents, the same way the engine does it.
+ */
+bool CBspNavTrace::Load( const char *mapName )
+{
+	Clear();
+
+	char filename[ 256 ];
+	_snprintf( filename, sizeof( filename ), "maps/%s.bsp", mapName );
+	filename[ sizeof( filename ) - 1 ] = '\000';
+
+	int length;
+	byte *data = LOAD_FILE_FOR_ME( filename, &length );
+	if (data == NULL)
+		return false;
+
+	const dheader_t *header = reinterpret_cast<const dheader_t *>( data );
+
+	if (length < (int)sizeof( dheader_t ) || header->version != BSPVERSION ||
+		!IsValidLump( &header->lumps[ LUMP_PLANES ], length, sizeof( dplane_t ) ) ||
+		!IsValidLump( &header->lumps[ LUMP_NODES ], length, sizeof( dnode_t ) ) ||
+		!IsValidLump( &header->lumps[ LUMP_LEAFS ], length, sizeof( dleaf_t ) ) ||
+		!IsValidLump( &header->lumps[ LUMP_MODELS ], length, sizeof( dmodel_t ) ))
+	{
+		CONSOLE_ECHO( "ERROR: '%s' is not a valid BSP file.\n", filename );
+		FREE_FILE( data );
+		return false;
+	}
+
+	const dplane_t *plane = reinterpret_cast<const dplane_t *>( data + header->lumps[ LUMP_PLANES ].fileofs );
+	int planeCount = header->lumps[ LUMP_PLANES ].filelen / sizeof( dplane_t );
+
+	m_plane.resize( planeCount );
+	for( int i=0; i<planeCount; ++i )
+	{
+		m_plane[i].normal = Vector( plane[i].normal[0], plane[i].normal[1], plane[i].normal[2] );
+		m_plane[i].dist = plane[i].dist;
+		m_plane[i].type = plane[i].type;
+	}
+
+	const dleaf_t *leaf = reinterpret_cast<const dleaf_t *>( data + header->lumps[ LUMP_LEAFS ].fileofs );
+	int leafCount = header->lumps[ LUMP_LEAFS ].filelen / sizeof( dleaf_t );
+
+	const dnode_t *node = reinterpret_cast<const dnode_t *>( data + header->lumps[ LUMP_NODES ].fileofs );
+	int nodeCount = header->lumps[ LUMP_NODES ].filelen / sizeof( dnode_t );
+
+	bool isValid = true;
+
+	m_node.resize( nodeCount );
+	for( int i=0; i<nodeCount && isValid; ++i )
+	{
+		m_node[i].plane = node[i].planenum;
+		if (m_node[i].plane < 0 || m_node[i].plane >= planeCount)
+			isValid = false;
+
+		for( int j=0; j<2; ++j )
+		{
+			int child = node[i].children[j];
+
+			if (child >= 0)
+			{
+				if (child >= nodeCount)
+					isValid = false;
+
+				m_node[i].children[j] = child;
+			}
+			else
+			{
+				// the point hull has no leafs, only their contents
+				int leafIndex = -1 - child;
+				if (leafIndex >= leafCount)
+				{
+					isValid = false;
+					break;
+				}
+
+				m_node[i].children[j] = leaf[ leafIndex ].contents;
+			}
+		}
+	}
+
+	const dmodel_t *model = reinterpret_cast<const dmodel_t *>( data + header->lumps[ LUMP_MODELS ].fileofs );
+	int modelCount = header->lumps[ LUMP_MODELS ].filelen / sizeof( dmodel_t );
+
+	m_submodelHeadNode.resize( modelCount );
+	for( int i=0; i<modelCount; ++i )
+	{
+		m_submodelHeadNode[i] = model[i].headnode[0];
+		if (m_submodelHeadNode[i] >= nodeCount)
+			isValid = false;
+	}
+
+	FREE_FILE( data );
+
+	if (!isValid || modelCount == 0)
+	{
+		CONSOLE_ECHO( "ERROR: '%s' is not a valid BSP file.\n", filename );
+		Clear();
+		return false;
+	}
+
+	// the world is always first
+	Model world;
+	world.headNode = m_submodelHeadNode[0];
+	world.origin = Vector( 0, 0, 0 );
+	world.absMin = Vector( 0, 0, 0 );
+	world.absMax = Vector( 0, 0, 0 );
+	world.isRotated = false;
+	world.isGlass = false;
+	m_model.push_back( world );
+
+	// take a snapshot of the brush entities that block ignore_monsters traces
+	for( int i=1; i<gpGlobals->maxEntities; ++i )
+	{
+		edict_t *ent = INDEXENT( i );
+
+		if (ent == NULL || ent->free)
+			continue;
+
+		if (ent->v.solid != SOLID_BSP)
+			continue;
+
+		const char *modelName = STRING( ent->v.model );
+		if (modelName[0] != '*')
+			continue;
+
+		int modelIndex = atoi( modelName + 1 );
+		if (modelIndex <= 0 || modelIndex >= modelCount)
+			continue;
+
+		Model brush;
+		brush.headNode = m_submodelHeadNode[ modelIndex ];
+		brush.origin = ent->v.origin;
+		brush.absMin = ent->v.absmin;
+		brush.absMax = ent->v.absmax;
+		brush.isRotated = (ent->v.angles.x != 0.0f || ent->v.angles.y != 0.0f || ent->v.angles.z != 0.0f);
+
+		if (brush.isRotated)
+			UTIL_MakeVectorsPrivate( ent->v.angles, &brush.forward, &brush.right, &brush.up );
+
+		// the engine skips transparent brushes when ignoring glass, unless they are part of the world
+		brush.isGlass = (ent->v.rendermode != kRenderNormal && !(ent->v.flags & FL_WORLDBRUSH));
+
+		m_model.push_back( brush );
+	}
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CBspNavTrace::Clear( void )
+{
+	m_plane.clear();
+	m_node.clear();
+	m_submodelHeadNode.clear();
+	m_model.clear();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Return the contents at 'pos' in the subtree starting at node 'num'
+ */
+int CBspNavTrace::PointContents( int num, const Vector &pos ) const
+{
+	while( num >= 0 )
+	{
+		const Node &node = m_node[ num ];
+		const Plane &plane = m_plane[ node.plane ];
+
+		float d;
+		if (plane.type < 3)
+			d = pos[ plane.type ] - plane.dist;
+		else
+			d = DotProduct( plane.normal, pos ) - plane.dist;
+
+		num = node.children[ (d < 0.0f) ? 1 : 0 ];
+	}
+
+	return num;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Trace the line from p1 to p2 thru the subtree starting at node 'num'.
+ * This is the engine's hull check, and stops at the same fraction the engine does.
+ * Returns false once the impact point has been found.
+ */
+bool CBspNavTrace::RecursiveHullCheck( int num, float p1f, float p2f, const Vector &p1, const Vector &p2, HullTrace *trace ) const
+{
+	// check for empty
+	if (num < 0)
+	{
+		if (num != CONTENTS_SOLID)
+			trace->allSolid = false;
+		else
+			trace->startSolid = true;
+
+		return true;
+	}
+
+	const Node &node = m_node[ num ];
+	const Plane &plane = m_plane[ node.plane ];
+
+	float t1, t2;
+	if (plane.type < 3)
+	{
+		t1 = p1[ plane.type ] - plane.dist;
+		t2 = p2[ plane.type ] - plane.dist;
+	}
+	else
+	{
+		t1 = DotProduct( plane.normal, p1 ) - plane.dist;
+		t2 = DotProduct( plane.normal, p2 ) - plane.dist;
+	}
+
+	if (t1 >= 0.0f && t2 >= 0.0f)
+		return RecursiveHullCheck( node.children[0], p1f, p2f, p1, p2, trace );
+
+	if (t1 < 0.0f && t2 < 0.0f)
+		return RecursiveHullCheck( node.children[1], p1f, p2f, p1, p2, trace );
+
+	// put the crosspoint just on the near side of the plane
+	const float distEpsilon = 0.03125f;
+
+	float frac;
+	if (t1 < 0.0f)
+		frac = (t1 + distEpsilon) / (t1 - t2);
+	else
+		frac = (t1 - distEpsilon) / (t1 - t2);
+
+	if (frac < 0.0f)
+		frac = 0.0f;
+	else if (frac > 1.0f)
+		frac = 1.0f;
+
+	float midf = p1f + (p2f - p1f) * frac;
+	Vector mid = p1 + frac * (p2 - p1);
+
+	int side = (t1 < 0.0f) ? 1 : 0;
+
+	// move up to the node
+	if (!RecursiveHullCheck( node.children[ side ], p1f, midf, p1, mid, trace ))
+		return false;
+
+	// go past the node
+	if (PointContents( node.children[ side ^ 1 ], mid ) != CONTENTS_SOLID)
+		return RecursiveHullCheck( node.children[ side ^ 1 ], midf, p2f, mid, p2, trace );
+
+	// never got out of the solid area
+	if (trace->allSolid)
+		return false;
+
+	// the other side of the node is solid, this is the impact point
+	while( PointContents( trace->headNode, mid ) == CONTENTS_SOLID )
+	{
+		// shouldn't really happen, but does occasionally
+		frac -= 0.1f;
+		if (frac < 0.0f)
+		{
+			trace->fraction = midf;
+			return false;
+		}
+
+		midf = p1f + (p2f - p1f) * frac;
+		mid = p1 + frac * (p2 - p1);
+	}
+
+	trace->fraction = midf;
+	return false;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Trace the line against a single model, in the model's own space
+ */
+void CBspNavTrace::ClipToModel( const Model &model, const Vector &start, const Vector &end, HullTrace *trace ) const
+{
+	Vector localStart = start - model.origin;
+	Vector localEnd = end - model.origin;
+
+	if (model.isRotated)
+	{
+		Vector temp = localStart;
+		localStart.x = DotProduct( temp, model.forward );
+		localStart.y = -DotProduct( temp, model.right );
+		localStart.z = DotProduct( temp, model.up );
+
+		temp = localEnd;
+		localEnd.x = DotProduct( temp, model.forward );
+		localEnd.y = -DotProduct( temp, model.right );
+		localEnd.z = DotProduct( temp, model.up );
+	}
+
+	trace->headNode = model.headNode;
+	trace->fraction = 1.0f;
+	trace->allSolid = true;
+	trace->startSolid = false;
+
+	RecursiveHullCheck( model.headNode, 0.0f, 1.0f, localStart, localEnd, trace );
+
+	if (trace->allSolid)
+		trace->startSolid = true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Trace against the world and the brush entities, combining the results like the engine does.
+ */
+void CBspNavTrace::TraceLine( const Vector &start, const Vector &end, IGNORE_GLASS glass, NavTraceResult *result ) const
+{
+	result->fraction = 1.0f;
+	result->startSolid = false;
+
+	if (m_model.empty())
+		return;
+
+	HullTrace best;
+	ClipToModel( m_model[0], start, end, &best );
+
+	Vector lo, hi;
+	for( int i=0; i<3; ++i )
+	{
+		lo[i] = (start[i] < end[i]) ? start[i] : end[i];
+		hi[i] = (start[i] < end[i]) ? end[i] : start[i];
+	}
+
+	for( size_t m=1; m<m_model.size() && !best.allSolid; ++m )
+	{
+		const Model &model = m_model[m];
+
+		if (glass == ignore_glass && model.isGlass)
+			continue;
+
+		if (lo.x > model.absMax.x || lo.y > model.absMax.y || lo.z > model.absMax.z ||
+			hi.x < model.absMin.x || hi.y < model.absMin.y || hi.z < model.absMin.z)
+			continue;
+
+		HullTrace trace;
+		ClipToModel( model, start, end, &trace );
+
+		if (trace.allSolid || trace.startSolid || trace.fraction < best.fraction)
+		{
+			bool wasStartSolid = best.startSolid;
+
+			best = trace;
+
+			if (wasStartSolid)
+				best.startSolid = true;
+		}
+		else if (trace.startSolid)
+		{
+			best.startSolid = true;
+		}
+	}
+
+	result->fraction = best.fraction;
+	result->startSolid = best.startSolid;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+CNavJobPool::CNavJobPool( void ) : m_jobCount( 0 ), m_nextJob( 0 ), m_doneCount( 0 ), m_isCancelled( false )
+{
+}
+
+CNavJobPool::~CNavJobPool()
+{
+	Cancel();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Start running 'jobCount' jobs on 'threadCount' worker threads.
+ * If threadCount is zero, nothing is run until Run() or Wait() is called.
+ */
+void CNavJobPool::Start( int jobCount, int threadCount, const JobFunction &func )
+{
+	Wait();
+
+	m_func = func;
+	m_jobCount = jobCount;
+	m_nextJob = 0;
+	m_doneCount = 0;
+	m_isCancelled = false;
+
+	if (threadCount > jobCount)
+		threadCount = jobCount;
+
+	for( int i=0; i<threadCount; ++i )
+		m_thread.push_back( std::thread( &CNavJobPool::Worker, this, i ) );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Run the next job on the calling thread.
+ * Returns false if there are no more jobs to run.
+ */
+bool CNavJobPool::RunNextJob( int worker )
+{
+	if (m_isCancelled)
+		return false;
+
+	int job = m_nextJob++;
+	if (job >= m_jobCount)
+		return false;
+
+	m_func( job, worker );
+
+	++m_doneCount;
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CNavJobPool::Worker( int worker )
+{
+	while( RunNextJob( worker ) )
+		;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CNavJobPool::Run( float maxTime )
+{
+	if (!m_thread.empty())
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	while( RunNextJob( 0 ) )
+	{
+		std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= maxTime)
+			break;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CNavJobPool::Wait( void )
+{
+	for( size_t i=0; i<m_thread.size(); ++i )
+		m_thread[i].join();
+
+	m_thread.clear();
+
+	// with no worker threads, the remaining jobs are run here
+	while( RunNextJob( 0 ) )
+		;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CNavJobPool::Cancel( void )
+{
+	m_isCancelled = true;
+
+	Wait();
+
+	m_jobCount = 0;
+	m_doneCount = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------
+enum NavAnalysisPhase
+{
+	ANALYZE_HIDING_SPOTS,
+	ANALYZE_SNIPER_SPOTS,
+	ANALYZE_SPOT_ENCOUNTERS,
+	ANALYZE_APPROACH_AREAS,
+
+	NUM_ANALYZE_PHASES,
+	ANALYZE_IDLE = NUM_ANALYZE_PHASES
+};
+
+static const char *analysisPhaseName[ NUM_ANALYZE_PHASES ] =
+{
+	"Finding hiding spots",
+	"Finding sniper spots",
+	"Computing encounter spots",
+	"Computing approach areas"
+};
+
+/**
+ * Hiding spots found for one area, waiting to be added in area order
+ */
+struct AreaHidingSpots
+{
+	HidingSpotCandidate candidate[ NUM_CORNERS ];
+	int count;
+};
+
+static NavAnalysisPhase analysisPhase = ANALYZE_IDLE;
+static CNavJobPool analysisJobs;
+static CBspNavTrace analysisBspTrace;
+static const CNavTrace *analysisTrace = NULL;
+static int analysisThreadCount = 0;							///< zero if jobs are run on the main thread
+
+static std::vector< CNavArea * > analysisArea;				///< the areas being analyzed, in TheNavAreaList order
+static std::vector< AreaHidingSpots > analysisHidingSpots;	///< indexed like analysisArea
+static HidingSpotVector analysisCoverSpots;
+static std::vector< Vector > analysisEye;					///< indexed like analysisArea
+static std::vector< bool > analysisHasEye;
+static std::vector< CNavAreaSearch > analysisSearch;		///< one per worker
+
+static std::chrono::steady_clock::time_point analysisPhaseStart;
+static float analysisPhaseTime[ NUM_ANALYZE_PHASES ];
+static float analysisProgressTimestamp = 0.0f;
+static int analysisProgress = -1;
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Show a progress bar for the current phase
+ */
+static void DrawAnalysisProgress( bool force )
+{
+	int total = analysisJobs.GetJobCount();
+	int progress = (total > 0) ? 100 * analysisJobs.GetDoneCount() / total : 100;
+
+	// don't flood the clients
+	const float updateInterval = 0.5f;
+	if (!force && (progress == analysisProgress || gpGlobals->time - analysisProgressTimestamp < updateInterval))
+		return;
+
+	analysisProgress = progress;
+	analysisProgressTimestamp = gpGlobals->time;
+
+	const int barLength = 40;
+	char bar[ barLength + 1 ];
+	int filled = barLength * progress / 100;
+	for( int i=0; i<barLength; ++i )
+		bar[i] = (i < filled) ? '|' : '.';
+	bar[ barLength ] = '\000';
+
+	char msg[ 256 ];
+	_snprintf( msg, sizeof( msg ), "Analyzing navigation mesh (%d of %d)\n%s\n[%s] %d%%",
+				analysisPhase + 1, NUM_ANALYZE_PHASES, analysisPhaseName[ analysisPhase ], bar, progress );
+	msg[ sizeof( msg ) - 1 ] = '\000';
+
+	HintMessageToAllPlayers( msg );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Serial setup for a phase, then start its jobs
+ */
+static void StartAnalysisPhase( NavAnalysisPhase phase )
+{
+	analysisPhase = phase;
+	analysisPhaseStart = std::chrono::steady_clock::now();
+	analysisProgress = -1;
+
+	int areaCount = (int)analysisArea.size();
+
+	switch( phase )
+	{
+		case ANALYZE_HIDING_SPOTS:
+		{
+			analysisHidingSpots.resize( areaCount );
+
+			analysisJobs.Start( areaCount, analysisThreadCount, []( int job, int worker )
+			{
+				AreaHidingSpots *spots = &analysisHidingSpots[ job ];
+				spots->count = analysisArea[ job ]->FindHidingSpots( analysisTrace, spots->candidate );
+			} );
+			break;
+		}
+
+		case ANALYZE_SNIPER_SPOTS:
+		{
+			analysisJobs.Start( areaCount, analysisThreadCount, []( int job, int worker )
+			{
+				analysisArea[ job ]->ComputeSniperSpots( analysisTrace );
+			} );
+			break;
+		}
+
+		case ANALYZE_SPOT_ENCOUNTERS:
+		{
+			analysisCoverSpots.clear();
+			for( HidingSpotList::iterator iter = TheHidingSpotList.begin(); iter != TheHidingSpotList.end(); ++iter )
+				if ((*iter)->HasGoodCover())
+					analysisCoverSpots.push_back( *iter );
+
+			analysisJobs.Start( areaCount, analysisThreadCount, []( int job, int worker )
+			{
+				analysisArea[ job ]->ComputeSpotEncounters( analysisTrace, analysisCoverSpots );
+			} );
+			break;
+		}
+
+		case ANALYZE_APPROACH_AREAS:
+		{
+			ApproachAreaAnalysisPrep();
+
+			// finding the ground needs the engine's entity info, so eye positions are computed here
+			analysisEye.resize( areaCount );
+			analysisHasEye.resize( areaCount );
+			for( int i=0; i<areaCount; ++i )
+				analysisHasEye[i] = analysisArea[i]->ComputeApproachEye( &analysisEye[i] );
+
+			// each worker builds paths in its own search arena
+			analysisSearch.clear();
+			analysisSearch.resize( (analysisThreadCount > 0) ? analysisThreadCount : 1 );
+
+			analysisJobs.Start( areaCount, analysisThreadCount, []( int job, int worker )
+			{
+				CNavAreaSearch::Scope scope( analysisSearch[ worker ] );
+				analysisArea[ job ]->ComputeApproachAreas( analysisTrace, (analysisHasEye[ job ]) ? &analysisEye[ job ] : NULL );
+			} );
+			break;
+		}
+	}
+
+	DrawAnalysisProgress( true );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Serial work once all jobs of the current phase are done
+ */
+static void FinishAnalysisPhase( void )
+{
+	analysisJobs.Wait();
+
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - analysisPhaseStart;
+	analysisPhaseTime[ analysisPhase ] = elapsed.count();
+
+	CONSOLE_ECHO( "  %s: %.2f seconds\n", analysisPhaseName[ analysisPhase ], analysisPhaseTime[ analysisPhase ] );
+
+	switch( analysisPhase )
+	{
+		case ANALYZE_HIDING_SPOTS:
+		{
+			// add the spots in area order, so they get the same IDs as in a serial analysis
+			for( size_t i=0; i<analysisArea.size(); ++i )
+				analysisArea[i]->AddHidingSpots( analysisHidingSpots[i].candidate, analysisHidingSpots[i].count );
+
+			analysisHidingSpots.clear();
+			break;
+		}
+
+		case ANALYZE_SPOT_ENCOUNTERS:
+		{
+			analysisCoverSpots.clear();
+			break;
+		}
+
+		case ANALYZE_APPROACH_AREAS:
+		{
+			CleanupApproachAreaAnalysisPrep();
+
+			analysisEye.clear();
+			analysisHasEye.clear();
+			analysisSearch.clear();
+			break;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Report the phase timings and save the results
+ */
+static void FinishNavigationAnalysis( void )
+{
+	analysisPhase = ANALYZE_IDLE;
+	analysisArea.clear();
+	analysisBspTrace.Clear();
+
+	float total = 0.0f;
+	char msg[ 512 ];
+	int len = _snprintf( msg, sizeof( msg ), "Navigation analysis complete (%d %s)\n",
+							(analysisThreadCount > 0) ? analysisThreadCount : 1, (analysisThreadCount > 1) ? "threads" : "thread" );
+
+	for( int p=0; p<NUM_ANALYZE_PHASES && len > 0 && len < (int)sizeof( msg ); ++p )
+	{
+		len += _snprintf( msg + len, sizeof( msg ) - len, "%s: %.1f s\n", analysisPhaseName[p], analysisPhaseTime[p] );
+		total += analysisPhaseTime[p];
+	}
+
+	if (len > 0 && len < (int)sizeof( msg ))
+		_snprintf( msg + len, sizeof( msg ) - len, "Total: %.1f s", total );
+
+	msg[ sizeof( msg ) - 1 ] = '\000';
+
+	HintMessageToAllPlayers( msg );
+	CONSOLE_ECHO( "Navigation analysis complete in %.2f seconds.\n", total );
+
+	if (TheBots)
+	{
+		if (SaveNavigationMap( TheBots->GetNavMapFilename() ))
+			CONSOLE_ECHO( "Navigation map '%s' saved.\n", TheBots->GetNavMapFilename() );
+		else
+			CONSOLE_ECHO( "ERROR: Cannot save navigation map '%s'.\n", TheBots->GetNavMapFilename() );
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Start analyzing the current nav mesh - this is the work of "bot_nav_analyze".
+ * If the map's BSP file can be loaded the analysis is traced against a snapshot of it on 'threadCount' worker
+ * threads, otherwise it is traced thru the engine on the main thread, a few jobs each frame.
+ */
+bool StartNavigationAnalysis( int threadCount )
+{
+	if (IsNavigationAnalysisRunning())
+	{
+		CONSOLE_ECHO( "Navigation analysis is already running.\n" );
+		return false;
+	}
+
+	if (TheNavAreaList.empty())
+	{
+		CONSOLE_ECHO( "ERROR: No navigation mesh to analyze.\n" );
+		return false;
+	}
+
+	if (threadCount <= 0)
+		threadCount = std::thread::hardware_concurrency();
+
+	if (threadCount <= 0)
+		threadCount = 1;
+
+	if (analysisBspTrace.Load( STRING( gpGlobals->mapname ) ))
+	{
+		analysisTrace = &analysisBspTrace;
+		analysisThreadCount = threadCount;
+	}
+	else
+	{
+		CONSOLE_ECHO( "WARNING: Cannot load the map's BSP file - analyzing on the main thread.\n" );
+		analysisTrace = &TheEngineNavTrace;
+		analysisThreadCount = 0;
+	}
+
+	CONSOLE_ECHO( "Analyzing %d navigation areas...\n", (int)TheNavAreaList.size() );
+
+	// the jobs search the mesh, so the compact adjacency must not be rebuilt while they run
+	CNavArea::UpdateCompactAdjacency();
+
+	analysisArea.assign( TheNavAreaList.begin(), TheNavAreaList.end() );
+
+	for( int p=0; p<NUM_ANALYZE_PHASES; ++p )
+		analysisPhaseTime[p] = 0.0f;
+
+	// the analysis starts from scratch
+	DestroyHidingSpots();
+
+	StartAnalysisPhase( ANALYZE_HIDING_SPOTS );
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Invoked every frame. Runs jobs if there are no worker threads, and moves on to the next phase when
+ * the current one is done.
+ */
+void UpdateNavigationAnalysis( void )
+{
+	if (!IsNavigationAnalysisRunning())
+		return;
+
+	// when tracing thru the engine, the jobs are run here
+	const float maxFrameTime = 0.05f;
+	analysisJobs.Run( maxFrameTime );
+
+	if (!analysisJobs.IsDone())
+	{
+		DrawAnalysisProgress( false );
+		return;
+	}
+
+	FinishAnalysisPhase();
+
+	if (analysisPhase + 1 < NUM_ANALYZE_PHASES)
+		StartAnalysisPhase( (NavAnalysisPhase)(analysisPhase + 1) );
+	else
+		FinishNavigationAnalysis();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CancelNavigationAnalysis( void )
+{
+	if (!IsNavigationAnalysisRunning())
+		return;
+
+	analysisJobs.Cancel();
+
+	if (analysisPhase == ANALYZE_APPROACH_AREAS)
+		CleanupApproachAreaAnalysisPrep();
+
+	analysisPhase = ANALYZE_IDLE;
+	analysisArea.clear();
+	analysisHidingSpots.clear();
+	analysisCoverSpots.clear();
+	analysisEye.clear();
+	analysisHasEye.clear();
+	analysisSearch.clear();
+	analysisBspTrace.Clear();
+
+	CONSOLE_ECHO( "Navigation analysis cancelled.\n" );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+bool IsNavigationAnalysisRunning( void )
+{
+	return (analysisPhase != ANALYZE_IDLE);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Analyze the nav mesh the way it was done before the analysis was split into jobs: each phase runs over
+ * all areas in order, tracing thru the engine on the main thread.
+ * Returns the time taken in seconds.
+ */
+static float RunSerialNavigationAnalysis( void )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	DestroyHidingSpots();
+
+	NavAreaList::iterator iter;
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+		(*iter)->ComputeHidingSpots();
+
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+		(*iter)->ComputeSniperSpots();
+
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+		(*iter)->ComputeSpotEncounters();
+
+	ApproachAreaAnalysisPrep();
+
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+		(*iter)->ComputeApproachAreas();
+
+	CleanupApproachAreaAnalysisPrep();
+
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Run every phase of the job based analysis to completion before returning.
+ * Uses 'analysisTrace' and 'analysisThreadCount', which must already be set.
+ * Returns the time taken in seconds.
+ */
+static float RunNavigationAnalysisJobs( void )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	analysisArea.assign( TheNavAreaList.begin(), TheNavAreaList.end() );
+
+	DestroyHidingSpots();
+
+	for( int p=0; p<NUM_ANALYZE_PHASES; ++p )
+	{
+		StartAnalysisPhase( (NavAnalysisPhase)p );
+		FinishAnalysisPhase();
+	}
+
+	analysisPhase = ANALYZE_IDLE;
+	analysisArea.clear();
+
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Count the entries of one nav file array that differ between two analyses
+ */
+template < typename T >
+static int CompareNavFileSection( const char *name, const std::vector< T > &expected, const std::vector< T > &actual )
+{
+	size_t count = (expected.size() < actual.size()) ? expected.size() : actual.size();
+	int differences = 0;
+
+	for( size_t i=0; i<count; ++i )
+		if (memcmp( &expected[i], &actual[i], sizeof(T) ) != 0)
+			++differences;
+
+	// entries that only one analysis has are differences too
+	differences += (int)(expected.size() + actual.size() - 2 * count);
+
+	if (differences)
+		CONSOLE_ECHO( "    %s: %d differences (%d and %d entries)\n", name, differences, (int)expected.size(), (int)actual.size() );
+
+	return differences;
+}
+
+/**
+ * Compare everything an analysis produces, as it would be saved to the nav file.
+ * Returns the number of differences.
+ */
+static int CompareNavFileData( const NavFileData &expected, const NavFileData &actual )
+{
+	int differences = 0;
+
+	differences += CompareNavFileSection( "areas", expected.areas, actual.areas );
+	differences += CompareNavFileSection( "hiding spots", expected.spots, actual.spots );
+	differences += CompareNavFileSection( "approach areas", expected.approaches, actual.approaches );
+	differences += CompareNavFileSection( "encounter paths", expected.encounters, actual.encounters );
+	differences += CompareNavFileSection( "encounter spots", expected.spotOrders, actual.spotOrders );
+
+	return differences;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Check the job based analysis against the serial one - this is the work of "bot_nav_analyze compare".
+ * The current nav mesh is analyzed three times: serially thru the engine, with jobs against the BSP on the
+ * main thread, and with jobs against the BSP on 'threadCount' worker threads. Differences between the first
+ * two come from the traces, and differences between the last two come from running the jobs in parallel.
+ * The mesh is left with the results of the parallel analysis, which are not saved.
+ * Returns true if all three analyses produced the same results.
+ */
+bool CompareNavigationAnalysis( int threadCount )
+{
+	if (IsNavigationAnalysisRunning())
+	{
+		CONSOLE_ECHO( "Navigation analysis is already running.\n" );
+		return false;
+	}
+
+	if (TheNavAreaList.empty())
+	{
+		CONSOLE_ECHO( "ERROR: No navigation mesh to analyze.\n" );
+		return false;
+	}
+
+	if (threadCount <= 0)
+		threadCount = std::thread::hardware_concurrency();
+
+	if (threadCount <= 0)
+		threadCount = 1;
+
+	if (!analysisBspTrace.Load( STRING( gpGlobals->mapname ) ))
+	{
+		CONSOLE_ECHO( "ERROR: Cannot load the map's BSP file - there is no parallel analysis to compare.\n" );
+		return false;
+	}
+
+	CONSOLE_ECHO( "Comparing the analysis of %d navigation areas...\n", (int)TheNavAreaList.size() );
+
+	// the jobs search the mesh, so the compact adjacency must be current before they start
+	CNavArea::UpdateCompactAdjacency();
+
+	NavFileData serialData, mainThreadData, parallelData;
+
+	float serialTime = RunSerialNavigationAnalysis();
+	BuildNavigationMapData( &serialData );
+	CONSOLE_ECHO( "Serial, engine traces: %.2f seconds\n", serialTime );
+
+	analysisTrace = &analysisBspTrace;
+
+	analysisThreadCount = 0;
+	float mainThreadTime = RunNavigationAnalysisJobs();
+	BuildNavigationMapData( &mainThreadData );
+	CONSOLE_ECHO( "Jobs on the main thread, BSP traces: %.2f seconds\n", mainThreadTime );
+
+	analysisThreadCount = threadCount;
+	float parallelTime = RunNavigationAnalysisJobs();
+	BuildNavigationMapData( &parallelData );
+	CONSOLE_ECHO( "Jobs on %d %s, BSP traces: %.2f seconds\n", threadCount, (threadCount > 1) ? "threads" : "thread", parallelTime );
+
+	analysisBspTrace.Clear();
+
+	CONSOLE_ECHO( "  BSP traces against engine traces:\n" );
+	int traceDifferences = CompareNavFileData( serialData, mainThreadData );
+
+	CONSOLE_ECHO( "  Worker threads against the main thread:\n" );
+	int threadDifferences = CompareNavFileData( mainThreadData, parallelData );
+
+	if (traceDifferences == 0 && threadDifferences == 0)
+	{
+		CONSOLE_ECHO( "The parallel analysis matches the serial analysis (%.2f seconds against %.2f seconds serially).\n", parallelTime, serialTime );
+		return true;
+	}
+
+	CONSOLE_ECHO( "The parallel analysis differs from the serial analysis: %d differences from the traces, %d from threading.\n", traceDifferences, threadDifferences );
+	return false;
+}
@@ -0,0 +1,149 @@
+// nav_analysis.h
+// Multithreaded analysis of the navigation mesh
+
+#ifndef _NAV_ANALYSIS_H_
+#define _NAV_ANALYSIS_H_
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * The result of a CNavTrace line trace
+ */
+struct NavTraceResult
+{
+	float fraction;											///< how far along the line we got before hitting something - 1.0 if nothing was hit
+	bool startSolid;										///< true if the line started inside of a solid
+};
+
+/**
+ * Line traces used to analyze the nav mesh.
+ * These behave like UTIL_TraceLine() with ignore_monsters, and never modify the world.
+ */
+class CNavTrace
+{
+public:
+	virtual ~CNavTrace() { }
+
+	virtual void TraceLine( const Vector &start, const Vector &end, IGNORE_GLASS glass, NavTraceResult *result ) const = 0;
+	virtual bool IsThreadSafe( void ) const = 0;			///< if true, TraceLine() may be called from several threads at once
+};
+
+/**
+ * Traces thru the engine. These are exact, but may only be used by the main thread.
+ */
+class CEngineNavTrace : public CNavTrace
+{
+public:
+	virtual void TraceLine( const Vector &start, const Vector &end, IGNORE_GLASS glass, NavTraceResult *result ) const;
+	virtual bool IsThreadSafe( void ) const					{ return false; }
+};
+
+extern CEngineNavTrace TheEngineNavTrace;
+
+/**
+ * Traces against a read-only copy of the map's point hull.
+ * The world is loaded from the map's BSP file, and the solid brush entities are copied from the engine
+ * when the snapshot is taken. Entities that move after that are traced at the position they had at the time.
+ */
+class CBspNavTrace : public CNavTrace
+{
+public:
+	bool Load( const char *mapName );						///< load the world and take a snapshot of the brush entities - return false on failure
+	void Clear( void );
+
+	virtual void TraceLine( const Vector &start, const Vector &end, IGNORE_GLASS glass, NavTraceResult *result ) const;
+	virtual bool IsThreadSafe( void ) const					{ return true; }
+
+private:
+	struct Plane
+	{
+		Vector normal;
+		float dist;
+		int type;											///< 0-2 if the plane is axial
+	};
+
+	struct Node
+	{
+		int plane;
+		int children[2];									///< negative numbers are contents
+	};
+
+	struct Model
+	{
+		int headNode;
+		Vector origin;
+		Vector absMin, absMax;
+		bool isRotated;
+		Vector forward, right, up;							///< only valid if isRotated
+		bool isGlass;										///< if true, this model is skipped by traces that ignore glass
+	};
+
+	struct HullTrace
+	{
+		int headNode;
+		float fraction;
+		bool allSolid;
+		bool startSolid;
+	};
+
+	int PointContents( int num, const Vector &pos ) const;
+	bool RecursiveHullCheck( int num, float p1f, float p2f, const Vector &p1, const Vector &p2, HullTrace *trace ) const;
+	void ClipToModel( const Model &model, const Vector &start, const Vector &end, HullTrace *trace ) const;
+
+	std::vector< Plane > m_plane;
+	std::vector< Node > m_node;
+	std::vector< int > m_submodelHeadNode;					///< indexed by brush model number
+	std::vector< Model > m_model;							///< the world, followed by the solid brush entities
+};
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Runs a set of independent jobs on worker threads.
+ * Jobs are handed out in index order, and each call is told which worker is running it, so jobs can use
+ * per-worker scratch state. With no worker threads, jobs are run by the main thread in Run().
+ */
+class CNavJobPool
+{
+public:
+	typedef std::function< void (int job, int worker) > JobFunction;
+
+	CNavJobPool( void );
+	~CNavJobPool();
+
+	void Start( int jobCount, int threadCount, const JobFunction &func );	///< start running jobs - threadCount may be zero
+	void Run( float maxTime );								///< if there are no worker threads, run jobs on this thread for up to maxTime seconds
+	void Wait( void );										///< block until all jobs are done and the workers have exited
+	void Cancel( void );									///< skip the jobs that have not started yet, and wait for the workers to exit
+
+	bool IsDone( void ) const								{ return m_doneCount.load() >= m_jobCount; }
+	int GetJobCount( void ) const							{ return m_jobCount; }
+	int GetDoneCount( void ) const							{ return m_doneCount.load(); }
+	int GetWorkerCount( void ) const						{ return (m_thread.empty()) ? 1 : (int)m_thread.size(); }
+
+private:
+	bool RunNextJob( int worker );							///< run the next job on this thread - return false if there are none left
+	void Worker( int worker );
+
+	JobFunction m_func;
+	int m_jobCount;
+	std::atomic< int > m_nextJob;
+	std::atomic< int > m_doneCount;
+	std::atomic< bool > m_isCancelled;
+	std::vector< std::thread > m_thread;
+};
+
+//--------------------------------------------------------------------------------------------------------------
+//
+// Function prototypes
+//
+extern bool StartNavigationAnalysis( int threadCount = 0 );	///< analyze the current nav mesh in the background - 0 threads uses one per CPU
+extern void UpdateNavigationAnalysis( void );				///< advance the analysis - invoked every frame
+extern void CancelNavigationAnalysis( void );				///< stop the analysis - must be called before the nav mesh is destroyed
+extern bool IsNavigationAnalysisRunning( void );
+extern bool CompareNavigationAnalysis( int threadCount = 0 );	///< analyze the current nav mesh serially and in parallel, and report any differences
+
+#endif // _NAV_ANALYSIS_H_
@@ -8,6 +8,7 @@
 #include <list>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -38,20 +39,27 @@
 #include "nav.h"
 #include "nav_node.h"
 #include "nav_area.h"
+#include "nav_analysis.h"
+#include "nav_file.h"
 
 #include "pm_shared.h" // for OBS_ROAMING
 
 extern void HintMessageToAllPlayers( const char *message );
 
 unsigned int CNavArea::m_nextID = 1;
+NavBulkStorage CNavArea::m_storage;
 NavAreaList TheNavAreaList;
 
 NavLadderList TheNavLadderList;
 
-unsigned int CNavArea::m_masterMarker = 1;
-CNavArea *CNavArea::m_openList = NULL;
+CNavAreaSearch TheNavAreaSearch;
+thread_local CNavAreaSearch *CNavAreaSearch::m_active = NULL;
+CNavAreaSearch::SearchNode CNavAreaSearch::m_emptyNode = { NULL, NULL, GO_NORTH, 0.0f, 0.0f, 0, 0, 0, 0.0f, -1 };
 
 bool CNavArea::m_isReset = false;
+bool CNavArea::m_isCompactCurrent = false;
+std::vector< CNavArea * > CNavArea::m_compactAreaStorage;
+std::vector< CNavLadder * > CNavArea::m_compactLadderStorage;
 static float lastDrawTimestamp = 0.0f;
 
 //--------------------------------------------------------------------------------------------------------------
@@ -83,7 +91,56 @@ static void buildGoodSizedList( void )
 HidingSpotList TheHidingSpotList;
 unsigned int HidingSpot::m_nextID = 1;
 unsigned int HidingSpot::m_masterMarker = 0;
+NavBulkStorage HidingSpot::m_storage;
 
+//--------------------------------------------------------------------------------------------------------------
+void NavBulkStorage::Reserve( unsigned int count, size_t objectSize )
+{
+	Release();
+
+	size_t size = count * RoundUp( objectSize );
+	if (size == 0)
+		return;
+
+	m_block = (char *)malloc( size );
+	if (m_block)
+		m_size = size;
+}
+
+void NavBulkStorage::Release( void )
+{
+	if (m_block)
+		free( m_block );
+
+	m_block = NULL;
+	m_size = 0;
+	m_used = 0;
+}
+
+void *NavBulkStorage::Allocate( size_t size )
+{
+	size = RoundUp( size );
+
+	if (m_used + size <= m_size)
+	{
+		void *ptr = m_block + m_used;
+		m_used += size;
+		return ptr;
+	}
+
+	return malloc( size );
+}
+
+void NavBulkStorage::Free( void *ptr )
+{
+	// memory in the block is freed by Release()
+	if (ptr >= m_block && ptr < m_block + m_size)
+		return;
+
+	free( ptr );
+}
+
+//--------------------------------------------------------------------------------------------------------------
 void DestroyHidingSpots( void )
 {
 	// remove all hiding spot references from the nav areas
@@ -101,6 +158,8 @@ void DestroyHidingSpots( void )
 		delete *iter;
 
 	TheHidingSpotList.clear();
+
+	HidingSpot::m_storage.Release();
 }
 
 /**
@@ -127,13 +186,6 @@ HidingSpot::HidingSpot( const Vector *pos, unsigned char flags )
 	TheHidingSpotList.push_back( this );
 }
 
-void HidingSpot::Save( int fd, unsigned int version ) const
-{
-	_write( fd, &m_id, sizeof(unsigned int) );
-	_write( fd, &m_pos, 3 * sizeof(float) );
-	_write( fd, &m_flags, sizeof(unsigned char) );
-}
-
 void HidingSpot::Load( SteamFile *file, unsigned int version )
 {
 	file->Read( &m_id, sizeof(unsigned int) );
@@ -145,6 +197,17 @@ void HidingSpot::Load( SteamFile *file, unsigned int version )
 		m_nextID = m_id+1;
 }
 
+void HidingSpot::Load( const NavFileHidingSpot *data )
+{
+	m_id = data->id;
+	m_pos = Vector( data->pos[0], data->pos[1], data->pos[2] );
+	m_flags = data->flags;
+
+	// update next ID to avoid ID collisions by later spots
+	if (m_id >= m_nextID)
+		m_nextID = m_id+1;
+}
+
 /**
  * Given a HidingSpot ID, return the associated HidingSpot
  */
@@ -168,9 +231,6 @@ HidingSpot *GetHidingSpotByID( unsigned int id )
  */
 void CNavArea::Initialize( void )
 {
-	m_marker = 0;
-	m_parent = NULL;
-	m_parentHow = GO_NORTH;
 	m_attributeFlags = 0;
 	m_place = 0;
 
@@ -189,6 +249,14 @@ void CNavArea::Initialize( void )
 
 	m_prevHash = NULL;
 	m_nextHash = NULL;
+
+	m_compactArea = NULL;
+	m_compactLadder = NULL;
+	memset( m_compactAreaStart, 0, sizeof(m_compactAreaStart) );
+	memset( m_compactLadderStart, 0, sizeof(m_compactLadderStart) );
+
+	// this area is not in the compact arrays yet
+	InvalidateCompactAdjacency();
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -298,6 +366,8 @@ CNavArea::~CNavArea()
 	if (m_isReset)
 		return;
 
+	InvalidateCompactAdjacency();
+
 	// tell the other areas we are going away
 	NavAreaList::iterator iter;
 	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
@@ -337,6 +407,8 @@ void CNavArea::OnDestroyNotify( CNavArea *dead )
 	for( int d=0; d<NUM_DIRECTIONS; ++d )
 		m_connect[ d ].remove( con );
 
+	InvalidateCompactAdjacency();
+
 	m_overlapList.remove( dead );
 }
 
@@ -355,6 +427,8 @@ void CNavArea::ConnectTo( CNavArea *area, NavDirType dir )
 	con.area = area;
 	m_connect[ dir ].push_back( con );
 
+	InvalidateCompactAdjacency();
+
 	//static char *dirName[] = { "NORTH", "EAST", "SOUTH", "WEST" };
 	//CONSOLE_ECHO( "  Connected area #%d to #%d, %s\n", m_id, area->m_id, dirName[ dir ] );
 }
@@ -370,6 +444,8 @@ void CNavArea::Disconnect( CNavArea *area )
 
 	for( int dir = 0; dir<NUM_DIRECTIONS; dir++ )
 		m_connect[ dir ].remove( connect );
+
+	InvalidateCompactAdjacency();
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -407,6 +483,8 @@ void CNavArea::FinishMerge( CNavArea *adjArea )
  */
 void CNavArea::MergeAdjacentConnections( CNavArea *adjArea )
 {
+	InvalidateCompactAdjacency();
+
 	// merge adjacency links - we gain all the connections that adjArea had
 	NavConnectList::iterator iter;
 	int dir;
@@ -979,6 +1057,8 @@ void CleanupApproachAreaAnalysisPrep( void )
  */
 void DestroyLadders( void )
 {
+	CNavArea::InvalidateCompactAdjacency();
+
 	while( !TheNavLadderList.empty() )
 	{
 		CNavLadder *ladder = TheNavLadderList.front();
@@ -993,6 +1073,9 @@ void DestroyLadders( void )
  */
 void DestroyNavigationMap( void )
 {
+	// analysis jobs may still be using the areas
+	CancelNavigationAnalysis();
+
 	CNavArea::m_isReset = true;
 
 	// remove each element of the list and delete them
@@ -1005,6 +1088,16 @@ void DestroyNavigationMap( void )
 
 	CNavArea::m_isReset = false;
 
+	// free the areas loaded from the nav file
+	CNavArea::m_storage.Release();
+
+	CNavArea::InvalidateCompactAdjacency();
+	CNavArea::m_compactAreaStorage.clear();
+	CNavArea::m_compactLadderStorage.clear();
+
+	// search state refers to the areas by ID, and IDs are reused by the next map
+	TheNavAreaSearch.Reset();
+
 	// destroy ladder representations
 	DestroyLadders();
 
@@ -2297,20 +2390,78 @@ float CNavArea::GetDistanceSquaredToPoint( const Vector *pos ) const
 //--------------------------------------------------------------------------------------------------------------
 CNavArea *CNavArea::GetRandomAdjacentArea( NavDirType dir ) const
 {
-	int count = m_connect[ dir ].size();
+	int count = GetAdjacentCount( dir );
 	int which = RANDOM_LONG( 0, count-1 );
 
-	int i = 0;
-	NavConnectList::const_iterator iter;
-	for( iter = m_connect[ dir ].begin(); iter != m_connect[ dir ].end(); ++iter )
+	return GetAdjacentArea( dir, which );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Rebuild the compact adjacency arrays from the adjacency and ladder lists.
+ * The lists remain the editable form of the mesh. Once an edit is finished, this copies them into two
+ * arrays shared by all areas, so searches read each area's neighbors from consecutive memory.
+ */
+void CNavArea::UpdateCompactAdjacency( void )
+{
+	if (m_isCompactCurrent)
+		return;
+
+	// size the arrays first, so they are not reallocated while the areas point into them
+	size_t areaCount = 0;
+	size_t ladderCount = 0;
+
+	NavAreaList::iterator iter;
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
 	{
-		if (i == which)
-			return (*iter).area;
+		CNavArea *area = *iter;
 
-		i++;
+		for( int d=0; d<NUM_DIRECTIONS; ++d )
+			areaCount += area->m_connect[d].size();
+
+		for( int l=0; l<NUM_LADDER_DIRECTIONS; ++l )
+			ladderCount += area->m_ladder[l].size();
 	}
 
-	return NULL;
+	m_compactAreaStorage.clear();
+	m_compactAreaStorage.reserve( areaCount );
+	m_compactLadderStorage.clear();
+	m_compactLadderStorage.reserve( ladderCount );
+
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+	{
+		CNavArea *area = *iter;
+
+		area->m_compactArea = m_compactAreaStorage.data() + m_compactAreaStorage.size();
+		area->m_compactAreaStart[0] = 0;
+
+		for( int d=0; d<NUM_DIRECTIONS; ++d )
+		{
+			for( NavConnectList::iterator citer = area->m_connect[d].begin(); citer != area->m_connect[d].end(); ++citer )
+				m_compactAreaStorage.push_back( (*citer).area );
+
+			area->m_compactAreaStart[ d+1 ] = (unsigned short)(m_compactAreaStorage.data() + m_compactAreaStorage.size() - area->m_compactArea);
+		}
+
+		area->m_compactLadder = m_compactLadderStorage.data() + m_compactLadderStorage.size();
+		area->m_compactLadderStart[0] = 0;
+
+		for( int l=0; l<NUM_LADDER_DIRECTIONS; ++l )
+		{
+			for( NavLadderList::iterator liter = area->m_ladder[l].begin(); liter != area->m_ladder[l].end(); ++liter )
+				m_compactLadderStorage.push_back( *liter );
+
+			area->m_compactLadderStart[ l+1 ] = (unsigned short)(m_compactLadderStorage.data() + m_compactLadderStorage.size() - area->m_compactLadder);
+		}
+	}
+
+	m_isCompactCurrent = true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+size_t CNavArea::GetCompactAdjacencyBytes( void )
+{
+	return m_compactAreaStorage.capacity() * sizeof(CNavArea *) + m_compactLadderStorage.capacity() * sizeof(CNavLadder *);
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -2627,113 +2778,207 @@ void CNavArea::DrawMarkedCorner( NavCornerType corner, byte red, byte green, byt
 	}
 }
 
+//--------------------------------------------------------------------------------------------------------------
+CNavAreaSearch::CNavAreaSearch( void )
+{
+	m_marker = 1;
+	m_openOrder = 0;
+}
+
 //--------------------------------------------------------------------------------------------------------------
 /**
- * Add to open list in decreasing value order
+ * Forget all search state - must be called when the nav mesh is destroyed
  */
-void CNavArea::AddToOpenList( void )
+void CNavAreaSearch::Reset( void )
 {
-	// mark as being on open list for quick check
-	m_openMarker = m_masterMarker;
+	m_node.clear();
+	m_openList.clear();
+	m_marker = 1;
+	m_openOrder = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+void CNavAreaSearch::MakeNewMarker( void )
+{
+	++m_marker;
 
-	// if list is empty, add and return
-	if (m_openList == NULL)
+	if (m_marker == 0)
 	{
-		m_openList = this;
-		this->m_prevOpen = NULL;
-		this->m_nextOpen = NULL;
-		return;
+		// wrapped around - old markers could match again, so clear them
+		for( unsigned int i=0; i<m_node.size(); ++i )
+		{
+			m_node[i].marker = 0;
+			m_node[i].openMarker = 0;
+		}
+
+		m_marker = 1;
 	}
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Return true if area 'id' should come off the open list before area 'otherID'.
+ * Areas with the same cost come off in the order they were added.
+ */
+inline bool CNavAreaSearch::IsCheaper( unsigned int id, unsigned int otherID ) const
+{
+	const SearchNode &node = m_node[ id ];
+	const SearchNode &other = m_node[ otherID ];
+
+	if (node.totalCost != other.totalCost)
+		return (node.totalCost < other.totalCost);
 
-	// insert self in ascending cost order
-	CNavArea *area, *last = NULL;
-	for( area = m_openList; area; area = area->m_nextOpen )
+	return (node.openOrder < other.openOrder);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+inline void CNavAreaSearch::SetHeapEntry( int index, unsigned int id )
+{
+	m_openList[ index ] = id;
+	m_node[ id ].heapIndex = index;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Move the entry at 'index' towards the root until its parent is cheaper
+ */
+void CNavAreaSearch::HeapUp( int index )
+{
+	unsigned int id = m_openList[ index ];
+
+	while( index > 0 )
 	{
-		if (this->GetTotalCost() < area->GetTotalCost())
+		int parent = (index - 1) / 2;
+
+		if (!IsCheaper( id, m_openList[ parent ] ))
 			break;
 
-		last = area;
+		SetHeapEntry( index, m_openList[ parent ] );
+		index = parent;
 	}
 
-	if (area)
-	{
-		// insert before this area
-		this->m_prevOpen = area->m_prevOpen;
-		if (this->m_prevOpen)
-			this->m_prevOpen->m_nextOpen = this;
-		else
-			m_openList = this;
+	SetHeapEntry( index, id );
+}
 
-		this->m_nextOpen = area;
-		area->m_prevOpen = this;
-	}
-	else
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Move the entry at 'index' towards the leaves until both children are more expensive
+ */
+void CNavAreaSearch::HeapDown( int index )
+{
+	int count = m_openList.size();
+	unsigned int id = m_openList[ index ];
+
+	while( true )
 	{
-		// append to end of list
-		last->m_nextOpen = this;
+		int child = 2 * index + 1;
+
+		if (child >= count)
+			break;
 
-		this->m_prevOpen = last;
-		this->m_nextOpen = NULL;
+		if (child + 1 < count && IsCheaper( m_openList[ child + 1 ], m_openList[ child ] ))
+			++child;
+
+		if (!IsCheaper( m_openList[ child ], id ))
+			break;
+
+		SetHeapEntry( index, m_openList[ child ] );
+		index = child;
 	}
+
+	SetHeapEntry( index, id );
 }
 
 //--------------------------------------------------------------------------------------------------------------
 /**
- * A smaller value has been found, update this area on the open list
- * @todo "bubbling" does unnecessary work, since the order of all other nodes will be unchanged - only this node is altered
+ * Add to open list in increasing cost order
  */
-void CNavArea::UpdateOnOpenList( void )
+void CNavAreaSearch::AddToOpenList( CNavArea *area )
 {
-	// since value can only decrease, bubble this area up from current spot
-	while( m_prevOpen && 
-				 this->GetTotalCost() < m_prevOpen->GetTotalCost() )
-	{
-		// swap position with predecessor
-		CNavArea *other = m_prevOpen;
-		CNavArea *before = other->m_prevOpen;
-		CNavArea *after  = this->m_nextOpen;
+	SearchNode &node = GetNode( area );
+
+	// mark as being on open list for quick check
+	node.area = area;
+	node.openMarker = m_marker;
+	node.openOrder = m_openOrder++;
+	node.openCost = node.totalCost;
+
+	m_openList.push_back( area->GetID() );
+	HeapUp( m_openList.size() - 1 );
+}
 
-		this->m_nextOpen = other;
-		this->m_prevOpen = before;
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * A smaller cost has been found, update this area on the open list.
+ * The area goes behind other areas with its new cost, as if it had just been added.
+ */
+void CNavAreaSearch::UpdateOnOpenList( CNavArea *area )
+{
+	SearchNode &node = GetNode( area );
 
-		other->m_prevOpen = this;
-		other->m_nextOpen = after;
+	// an unchanged cost keeps its place
+	if (node.totalCost < node.openCost)
+		node.openOrder = m_openOrder++;
 
-		if (before)
-			before->m_nextOpen = this;
-		else
-			m_openList = this;
+	node.openCost = node.totalCost;
 
-		if (after)
-			after->m_prevOpen = other;
-	}
+	HeapUp( node.heapIndex );
 }
 
 //--------------------------------------------------------------------------------------------------------------
-void CNavArea::RemoveFromOpenList( void )
+void CNavAreaSearch::RemoveFromOpenList( CNavArea *area )
 {
-	if (m_prevOpen)
-		m_prevOpen->m_nextOpen = m_nextOpen;
-	else
-		m_openList = m_nextOpen;
+	SearchNode &node = GetNode( area );
 
-	if (m_nextOpen)
-		m_nextOpen->m_prevOpen = m_prevOpen;
+	int index = node.heapIndex;
 
 	// zero is an invalid marker
-	m_openMarker = 0;
+	node.openMarker = 0;
+	node.heapIndex = -1;
+
+	unsigned int last = m_openList.back();
+	m_openList.pop_back();
+
+	if (index == (int)m_openList.size())
+		return;
+
+	// fill the hole with the last entry and restore the heap around it
+	SetHeapEntry( index, last );
+
+	if (index > 0 && IsCheaper( last, m_openList[ (index - 1) / 2 ] ))
+		HeapUp( index );
+	else
+		HeapDown( index );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Remove and return the cheapest area on the open list
+ */
+CNavArea *CNavAreaSearch::PopOpenList( void )
+{
+	if (m_openList.empty())
+		return NULL;
+
+	CNavArea *area = m_node[ m_openList.front() ].area;
+
+	// disconnect from list
+	RemoveFromOpenList( area );
+
+	return area;
 }
 
 //--------------------------------------------------------------------------------------------------------------
 /**
  * Clears the open and closed lists for a new search
  */
-void CNavArea::ClearSearchLists( void )
+void CNavAreaSearch::ClearSearchLists( void )
 {
-	// effectively clears all open list pointers and closed flags
-	CNavArea::MakeNewMarker();
+	// effectively clears all open list entries and closed flags
+	MakeNewMarker();
 
-	m_openList = NULL;
+	m_openList.clear();
+	m_openOrder = 0;
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -2743,7 +2988,7 @@ void CNavArea::ClearSearchLists( void )
  */
 const Vector *CNavArea::GetCorner( NavCornerType corner ) const
 {
-	static Vector pos;
+	static thread_local Vector pos;		// the analysis calls this from worker threads
 
 	switch( corner )
 	{
@@ -2789,10 +3034,10 @@ bool CNavArea::IsHidingSpotCollision( const Vector *pos ) const
 }
 
 //--------------------------------------------------------------------------------------------------------------
-bool IsHidingSpotInCover( const Vector *spot )
+bool IsHidingSpotInCover( const CNavTrace *trace, const Vector *spot )
 {
 	int coverCount = 0;
-	TraceResult result;
+	NavTraceResult result;
 
 	Vector from = *spot;
 	from.z += HalfHumanHeight;
@@ -2801,8 +3046,8 @@ bool IsHidingSpotInCover( const Vector *spot )
 
 	// if we are crouched underneath something, that counts as good cover
 	to = from + Vector( 0, 0, 20.0f );
-	UTIL_TraceLine( from, to, ignore_monsters, NULL, &result );
-	if (result.flFraction != 1.0f)
+	trace->TraceLine( from, to, dont_ignore_glass, &result );
+	if (result.fraction != 1.0f)
 		return true;
 
 	const float coverRange = 100.0f;
@@ -2812,10 +3057,10 @@ bool IsHidingSpotInCover( const Vector *spot )
 	{
 		to = from + Vector( coverRange * cos(angle), coverRange * sin(angle), HalfHumanHeight );
 
-		UTIL_TraceLine( from, to, ignore_monsters, NULL, &result );
+		trace->TraceLine( from, to, dont_ignore_glass, &result );
 
 		// if traceline hit something, it hit "cover"
-		if (result.flFraction != 1.0f)
+		if (result.fraction != 1.0f)
 			++coverCount;
 	}
 
@@ -2832,6 +3077,21 @@ bool IsHidingSpotInCover( const Vector *spot )
  * Analyze local area neighborhood to find "hiding spots" for this area
  */
 void CNavArea::ComputeHidingSpots( void )
+{
+	HidingSpotCandidate candidate[ NUM_CORNERS ];
+
+	int count = FindHidingSpots( &TheEngineNavTrace, candidate );
+
+	AddHidingSpots( candidate, count );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Find the "hiding spots" for this area, but don't add them yet.
+ * This only reads the nav mesh, so it is safe to run for several areas at once.
+ * Returns the number of spots found.
+ */
+int CNavArea::FindHidingSpots( const CNavTrace *trace, HidingSpotCandidate *candidate ) const
 {
 	struct
 	{
@@ -2841,7 +3101,7 @@ void CNavArea::ComputeHidingSpots( void )
 
 	// "jump areas" cannot have hiding spots
 	if (GetAttributes() & NAV_JUMP)
-		return;
+		return 0;
 
 	int cornerCount[NUM_CORNERS];
 	for( int i=0; i<NUM_CORNERS; ++i )
@@ -2857,7 +3117,7 @@ void CNavArea::ComputeHidingSpots( void )
 
 		bool isHoriz = (d == NORTH || d == SOUTH) ? true : false;
 
-		for( NavConnectList::iterator iter = m_connect[d].begin(); iter != m_connect[d].end(); ++iter )
+		for( NavConnectList::const_iterator iter = m_connect[d].begin(); iter != m_connect[d].end(); ++iter )
 		{
 			NavConnect connect = *iter;
 
@@ -2927,44 +3187,74 @@ void CNavArea::ComputeHidingSpots( void )
 	// if a corner count is 2, then it really is a corner (walls on both sides)
 	float offset = 12.5f;
 
-	if (cornerCount[ NORTH_WEST ] == 2)
+	static const float cornerOffset[ NUM_CORNERS ][2] =
 	{
-		Vector pos = *GetCorner( NORTH_WEST ) + Vector(  offset,  offset, 0.0f );
+		{  1.0f,  1.0f },		// NORTH_WEST
+		{ -1.0f,  1.0f },		// NORTH_EAST
+		{ -1.0f, -1.0f },		// SOUTH_EAST
+		{  1.0f, -1.0f }		// SOUTH_WEST
+	};
 
-		m_hidingSpotList.push_back( new HidingSpot( &pos, (IsHidingSpotInCover( &pos )) ? HidingSpot::IN_COVER : 0 ) );
-	}
+	// the corners are checked in the order they have always been added in, so spot IDs don't change
+	static const NavCornerType cornerOrder[ NUM_CORNERS ] = { NORTH_WEST, NORTH_EAST, SOUTH_WEST, SOUTH_EAST };
 
-	if (cornerCount[ NORTH_EAST ] == 2)
-	{
-		Vector pos = *GetCorner( NORTH_EAST ) + Vector( -offset,  offset, 0.0f );
-		if (!IsHidingSpotCollision( &pos ))
-			m_hidingSpotList.push_back( new HidingSpot( &pos, (IsHidingSpotInCover( &pos )) ? HidingSpot::IN_COVER : 0 ) );
-	}
+	int count = 0;
 
-	if (cornerCount[ SOUTH_WEST ] == 2)
+	for( int i=0; i<NUM_CORNERS; ++i )
 	{
-		Vector pos = *GetCorner( SOUTH_WEST ) + Vector(  offset, -offset, 0.0f );
-		if (!IsHidingSpotCollision( &pos ))
-			m_hidingSpotList.push_back( new HidingSpot( &pos, (IsHidingSpotInCover( &pos )) ? HidingSpot::IN_COVER : 0 ) );
-	}
+		NavCornerType corner = cornerOrder[i];
 
-	if (cornerCount[ SOUTH_EAST ] == 2)
-	{
-		Vector pos = *GetCorner( SOUTH_EAST ) + Vector( -offset, -offset, 0.0f );
-		if (!IsHidingSpotCollision( &pos ))
-			m_hidingSpotList.push_back( new HidingSpot( &pos, (IsHidingSpotInCover( &pos )) ? HidingSpot::IN_COVER : 0 ) );
+		if (cornerCount[ corner ] != 2)
+			continue;
+
+		Vector pos = *GetCorner( corner ) + Vector( offset * cornerOffset[ corner ][0], offset * cornerOffset[ corner ][1], 0.0f );
+
+		// the first spot never collides with another one of ours
+		if (corner != NORTH_WEST)
+		{
+			if (IsHidingSpotCollision( &pos ))
+				continue;
+
+			const float collisionRange = 30.0f;
+
+			int c;
+			for( c=0; c<count; ++c )
+				if ((candidate[c].pos - pos).IsLengthLessThan( collisionRange ))
+					break;
+
+			if (c < count)
+				continue;
+		}
+
+		candidate[ count ].pos = pos;
+		candidate[ count ].flags = (IsHidingSpotInCover( trace, &pos )) ? HidingSpot::IN_COVER : 0;
+		++count;
 	}
+
+	return count;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Add hiding spots found by FindHidingSpots() to this area.
+ * Spot IDs are allocated in the order spots are added, so areas must be done in the same order each time.
+ */
+void CNavArea::AddHidingSpots( const HidingSpotCandidate *candidate, int count )
+{
+	for( int i=0; i<count; ++i )
+		m_hidingSpotList.push_back( new HidingSpot( &candidate[i].pos, candidate[i].flags ) );
 }
 
 //--------------------------------------------------------------------------------------------------------------
 /**
  * Determine how much walkable area we can see from the spot, and how far away we can see.
+ * Returns the sniper flags the spot should have.
  */
-void ClassifySniperSpot( HidingSpot *spot )
+unsigned char ClassifySniperSpot( const CNavTrace *trace, const HidingSpot *spot )
 {
 	Vector eye = *spot->GetPosition() + Vector( 0, 0, HalfHumanHeight );		// assume we are crouching
 	Vector walkable;
-	TraceResult result;
+	NavTraceResult result;
 
 	Extent sniperExtent;
 	float farthestRangeSq = 0.0f;
@@ -2985,9 +3275,9 @@ void ClassifySniperSpot( HidingSpot *spot )
 				walkable.z = area->GetZ( &walkable ) + HalfHumanHeight;
 				
 				// check line of sight
-				UTIL_TraceLine( eye, walkable, ignore_monsters, ignore_glass, NULL, &result );
+				trace->TraceLine( eye, walkable, ignore_glass, &result );
 
-				if (result.flFraction == 1.0f && !result.fStartSolid)
+				if (result.fraction == 1.0f && !result.startSolid)
 				{
 					// can see this spot
 
@@ -3035,10 +3325,12 @@ void ClassifySniperSpot( HidingSpot *spot )
 		const float longSniperRangeSq = 1500.0f * 1500.0f;
 
 		if (snipableArea >= minIdealSniperArea || farthestRangeSq >= longSniperRangeSq)
-			spot->SetFlags( HidingSpot::IDEAL_SNIPER_SPOT );
+			return HidingSpot::IDEAL_SNIPER_SPOT;
 		else
-			spot->SetFlags( HidingSpot::GOOD_SNIPER_SPOT );
+			return HidingSpot::GOOD_SNIPER_SPOT;
 	}
+
+	return 0;
 }
 
 
@@ -3047,6 +3339,14 @@ void ClassifySniperSpot( HidingSpot *spot )
  * Analyze local area neighborhood to find "sniper spots" for this area
  */
 void CNavArea::ComputeSniperSpots( void )
+{
+	ComputeSniperSpots( &TheEngineNavTrace );
+}
+
+/**
+ * Only this area's spots are changed, so this is safe to run for several areas at once.
+ */
+void CNavArea::ComputeSniperSpots( const CNavTrace *trace )
 {
 	if (cv_bot_quicksave.value > 0.0f)
 		return;
@@ -3055,7 +3355,7 @@ void CNavArea::ComputeSniperSpots( void )
 	{
 		HidingSpot *spot = *iter;
 
-		ClassifySniperSpot( spot );
+		spot->SetFlags( ClassifySniperSpot( trace, spot ) );
 	}
 }
 
@@ -3085,7 +3385,7 @@ SpotEncounter *CNavArea::GetSpotEncounter( const CNavArea *from, const CNavArea
 /**
  * Add spot encounter data when moving from area to area
  */
-void CNavArea::AddSpotEncounters( const CNavArea *from, NavDirType fromDir, const CNavArea *to, NavDirType toDir )
+void CNavArea::AddSpotEncounters( const CNavTrace *trace, const HidingSpotVector &coverSpots, const CNavArea *from, NavDirType fromDir, const CNavArea *to, NavDirType toDir )
 {
 	SpotEncounter e;
 
@@ -3107,12 +3407,12 @@ void CNavArea::AddSpotEncounters( const CNavArea *from, NavDirType fromDir, cons
 	Vector dir = e.path.to - e.path.from;
 	float length = dir.NormalizeInPlace();
 
-	// create unique marker to flag used spots
-	HidingSpot::ChangeMasterMarker();
+	// flag used spots - this is kept here instead of in the spots, so several areas can be done at once
+	std::vector<bool> isEncountered( coverSpots.size(), false );
 
 	const float stepSize = 25.0f;		// 50
 	const float seeSpotRange = 2000.0f;	// 3000
-	TraceResult result;
+	NavTraceResult result;
 
 	Vector eye, delta;
 	HidingSpot *spot;
@@ -3132,17 +3432,13 @@ void CNavArea::AddSpotEncounters( const CNavArea *from, NavDirType fromDir, cons
 		// move the eyepoint along the path segment
 		eye = e.path.from + along * dir;
 
-		// check each hiding spot for visibility
-		for( HidingSpotList::iterator iter = TheHidingSpotList.begin(); iter != TheHidingSpotList.end(); ++iter )
+		// check each hiding spot with cover for visibility (others are out in the open and easily seen)
+		for( size_t s=0; s<coverSpots.size(); ++s )
 		{
-			spot = *iter;
-
-			// only look at spots with cover (others are out in the open and easily seen)
-			if (!spot->HasGoodCover())
+			if (isEncountered[s])
 				continue;
 
-			if (spot->IsMarked())
-				continue;
+			spot = coverSpots[s];
 
 			const Vector *spotPos = spot->GetPosition();
 
@@ -3155,8 +3451,8 @@ void CNavArea::AddSpotEncounters( const CNavArea *from, NavDirType fromDir, cons
 				continue;
 
 			// check if we have LOS
-			UTIL_TraceLine( eye, Vector( spotPos->x, spotPos->y, spotPos->z + HalfHumanHeight ), ignore_monsters, ignore_glass, NULL, &result );
-			if (result.flFraction != 1.0f)
+			trace->TraceLine( eye, Vector( spotPos->x, spotPos->y, spotPos->z + HalfHumanHeight ), ignore_glass, &result );
+			if (result.fraction != 1.0f)
 				continue;
 
 			// if spot is in front of us along our path, ignore it
@@ -3176,7 +3472,7 @@ void CNavArea::AddSpotEncounters( const CNavArea *from, NavDirType fromDir, cons
 			}
 
 			// mark spot as encountered
-			spot->Mark();
+			isEncountered[s] = true;
 		}
 	}
 
@@ -3190,6 +3486,20 @@ void CNavArea::AddSpotEncounters( const CNavArea *from, NavDirType fromDir, cons
  * for each possible path thru a nav area.
  */
 void CNavArea::ComputeSpotEncounters( void )
+{
+	HidingSpotVector coverSpots;
+
+	for( HidingSpotList::iterator iter = TheHidingSpotList.begin(); iter != TheHidingSpotList.end(); ++iter )
+		if ((*iter)->HasGoodCover())
+			coverSpots.push_back( *iter );
+
+	ComputeSpotEncounters( &TheEngineNavTrace, coverSpots );
+}
+
+/**
+ * Only this area's encounter list is changed, so this is safe to run for several areas at once.
+ */
+void CNavArea::ComputeSpotEncounters( const CNavTrace *trace, const HidingSpotVector &coverSpots )
 {
 	m_spotEncounterList.clear();
 
@@ -3214,7 +3524,7 @@ void CNavArea::ComputeSpotEncounters( void )
 						continue;
 
 					// just do our direction, as we'll loop around for other direction
-					AddSpotEncounters( fromCon->area, (NavDirType)fromDir, toCon->area, (NavDirType)toDir );
+					AddSpotEncounters( trace, coverSpots, fromCon->area, (NavDirType)fromDir, toCon->area, (NavDirType)toDir );
 				}
 			}
 		}
@@ -3997,9 +4307,9 @@ private:
 
 //--------------------------------------------------------------------------------------------------------------
 /**
- * Draw navigation areas and edit them
+ * Draw navigation areas and apply the given edit command
  */
-void EditNavAreas( NavEditCmdType cmd )
+static void ApplyNavEdit( NavEditCmdType cmd )
 {
 	CCSBotManager *ctrl = static_cast<CCSBotManager *>( TheBots );
 
@@ -4627,6 +4937,18 @@ void EditNavAreas( NavEditCmdType cmd )
 		isCreatingNavArea = false;
 }
 
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Draw navigation areas and edit them
+ */
+void EditNavAreas( NavEditCmdType cmd )
+{
+	ApplyNavEdit( cmd );
+
+	// the edit is finished - searches use the compact adjacency arrays, so bring them up to date
+	CNavArea::UpdateCompactAdjacency();
+}
+
 //--------------------------------------------------------------------------------------------------------------
 /**
  * Return the ground height below this point in "height".
@@ -4745,8 +5067,8 @@ bool GetSimpleGroundHeight( const Vector *pos, float *height, Vector *normal )
 
 //--------------------------------------------------------------------------------------------------------------
 enum { MAX_BLOCKED_AREAS = 256 };
-static unsigned int BlockedID[ MAX_BLOCKED_AREAS ];
-static int BlockedIDCount = 0;
+static thread_local unsigned int BlockedID[ MAX_BLOCKED_AREAS ];	// per thread, so approach areas can be computed for several areas at once
+static thread_local int BlockedIDCount = 0;
 
 /**
  * Shortest path cost, paying attention to "blocked" areas
@@ -4788,18 +5110,18 @@ public:
  * For now, if we can see any corner, we can see the area
  * @todo Need to check LOS to more than the corners for large and/or long areas
  */
-inline bool IsAreaVisible( const Vector *pos, const CNavArea *area )
+inline bool IsAreaVisible( const CNavTrace *trace, const Vector *pos, const CNavArea *area )
 {
 	Vector corner;
-	TraceResult result;
+	NavTraceResult result;
 
 	for( int c=0; c<NUM_CORNERS; ++c )
 	{
 		corner = *area->GetCorner( (NavCornerType)c );
 		corner.z += 0.75f * HumanHeight;
 
-		UTIL_TraceLine( *pos, corner, ignore_monsters, NULL, &result );
-		if (result.flFraction == 1.0f)
+		trace->TraceLine( *pos, corner, dont_ignore_glass, &result );
+		if (result.fraction == 1.0f)
 		{
 			// we can see this area
 			return true;
@@ -4821,16 +5143,43 @@ void CNavArea::ComputeApproachAreas( void )
 	if (cv_bot_quicksave.value > 0.0f)
 		return;
 
-	// use the center of the nav area as the "view" point
-	Vector eye = m_center;
-	if (GetGroundHeight( &eye, &eye.z ) == false)
+	Vector eye;
+	if (ComputeApproachEye( &eye ) == false)
 		return;
 
+	ComputeApproachAreas( &TheEngineNavTrace, &eye );
+}
+
+/**
+ * Use the center of the nav area as the "view" point.
+ * This traces thru the engine, so it must be called from the main thread.
+ */
+bool CNavArea::ComputeApproachEye( Vector *eye ) const
+{
+	*eye = m_center;
+	if (GetGroundHeight( eye, &eye->z ) == false)
+		return false;
+
 	// approximate eye position
 	if (GetAttributes() & NAV_CROUCH)
-		eye.z += 0.9f * HalfHumanHeight;
+		eye->z += 0.9f * HalfHumanHeight;
 	else
-		eye.z += 0.9f * HumanHeight;
+		eye->z += 0.9f * HumanHeight;
+
+	return true;
+}
+
+/**
+ * Determine the approach areas as seen from 'eye', which is computed by ComputeApproachEye().
+ * Paths are built with the search arena that is active on this thread, and only this area is changed,
+ * so this is safe to run for several areas at once as long as each thread has its own arena.
+ */
+void CNavArea::ComputeApproachAreas( const CNavTrace *trace, const Vector *eye )
+{
+	m_approachCount = 0;
+
+	if (cv_bot_quicksave.value > 0.0f || eye == NULL)
+		return;
 
 	enum { MAX_PATH_LENGTH = 256 };
 	CNavArea *path[ MAX_PATH_LENGTH ];
@@ -4848,7 +5197,7 @@ void CNavArea::ComputeApproachAreas( void )
 		BlockedIDCount = 0;
 
 		// if we can see 'farArea', try again - the whole point is to go "around the bend", so to speak
-		if (IsAreaVisible( &eye, farArea ))
+		if (IsAreaVisible( trace, eye, farArea ))
 			continue;
 	
 		// make first path to far away area
@@ -4881,7 +5230,7 @@ void CNavArea::ComputeApproachAreas( void )
 			for( i=1; i<count; ++i )
 			{
 				// if we see this area, continue on
-				if (IsAreaVisible( &eye, path[i] ))
+				if (IsAreaVisible( trace, eye, path[i] ))
 					continue;
 
 				// we can't see this area.
@@ -5217,3 +5566,130 @@ unsigned int CNavAreaGrid::GetPlace( const Vector *pos ) const
 }
 
 
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * The result of one benchmark query: the area the path ends in, and the path's areas from that area back to the start.
+ */
+struct NavAreaBenchmarkPath
+{
+	bool found;
+	const CNavArea *endArea;			///< the goal if a path was found, otherwise the closest area reached
+	std::vector< const CNavArea * > areas;
+
+	bool operator==( const NavAreaBenchmarkPath &other ) const
+	{
+		return found == other.found && endArea == other.endArea && areas == other.areas;
+	}
+};
+
+/**
+ * Record the path ending at 'endArea' by following parents in the given search arena
+ */
+static void NavAreaRecordPath( const CNavAreaSearch &search, bool found, const CNavArea *endArea, NavAreaBenchmarkPath *path )
+{
+	path->found = found;
+	path->endArea = endArea;
+	path->areas.clear();
+
+	for( const CNavArea *area = endArea; area && path->areas.size() <= TheNavAreaList.size(); area = search.GetParent( area ) )
+		path->areas.push_back( area );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Time 'count' random shortest-path queries on the nav mesh that is already loaded for the current map.
+ * Queries are generated from 'seed' so runs can be compared before and after a change.
+ * The queries are timed using the compact adjacency arrays, then again through a private search arena
+ * using the adjacency lists, and any difference between the two is reported.
+ */
+void NavAreaBuildPathBenchmark( int count, unsigned int seed )
+{
+	if (TheNavAreaList.empty())
+	{
+		CONSOLE_ECHO( "ERROR: No navigation map is loaded.\n" );
+		return;
+	}
+
+	std::vector< CNavArea * > areas( TheNavAreaList.begin(), TheNavAreaList.end() );
+
+	if (areas.size() < 2 || count <= 0)
+		return;
+
+	// pick the query pairs up front so only the searches are timed
+	std::vector< CNavArea * > queries( 2 * count );
+	unsigned int random = seed;
+
+	for( int i=0; i<2*count; ++i )
+	{
+		random = random * 1664525 + 1013904223;
+		queries[i] = areas[ (random >> 8) % areas.size() ];
+	}
+
+	ShortestPathCost cost;
+	CNavAreaSearch privateSearch;
+
+	std::vector< NavAreaBenchmarkPath > compactPaths( count );
+	std::vector< NavAreaBenchmarkPath > listPaths( count );
+	int found = 0;
+
+	CNavArea::UpdateCompactAdjacency();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for( int i=0; i<count; ++i )
+	{
+		CNavArea *closestArea = NULL;
+		bool isFound = NavAreaBuildPath( queries[ 2*i ], queries[ 2*i + 1 ], NULL, cost, &closestArea );
+
+		NavAreaRecordPath( TheNavAreaSearch, isFound, closestArea, &compactPaths[i] );
+
+		if (isFound)
+			++found;
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	// run the same queries with the adjacency lists
+	CNavArea::InvalidateCompactAdjacency();
+
+	std::chrono::steady_clock::time_point listStart = std::chrono::steady_clock::now();
+
+	for( int i=0; i<count; ++i )
+	{
+		CNavArea *closestArea = NULL;
+		bool isFound = NavAreaBuildPath( privateSearch, queries[ 2*i ], queries[ 2*i + 1 ], NULL, cost, &closestArea );
+
+		NavAreaRecordPath( privateSearch, isFound, closestArea, &listPaths[i] );
+	}
+
+	std::chrono::steady_clock::time_point listEnd = std::chrono::steady_clock::now();
+
+	CNavArea::UpdateCompactAdjacency();
+
+	double seconds = std::chrono::duration< double >( end - start ).count();
+	double listSeconds = std::chrono::duration< double >( listEnd - listStart ).count();
+
+	CONSOLE_ECHO( "%d areas, %d path queries, %d paths found\n", (int)areas.size(), count, found );
+	CONSOLE_ECHO( "compact adjacency: %.3f seconds total, %.4f ms per query, %u bytes\n",
+					seconds, 1000.0 * seconds / count, (unsigned int)CNavArea::GetCompactAdjacencyBytes() );
+	CONSOLE_ECHO( "adjacency lists:   %.3f seconds total, %.4f ms per query\n", listSeconds, 1000.0 * listSeconds / count );
+
+	int mismatches = 0;
+	for( int i=0; i<count; ++i )
+	{
+		if (compactPaths[i] == listPaths[i])
+			continue;
+
+		if (mismatches == 0)
+			CONSOLE_ECHO( "ERROR: query %d from area #%d to area #%d ends in area #%d (%d areas), but area #%d (%d areas) with the adjacency lists.\n",
+							i, queries[ 2*i ]->GetID(), queries[ 2*i + 1 ]->GetID(),
+							(compactPaths[i].endArea) ? compactPaths[i].endArea->GetID() : 0, (int)compactPaths[i].areas.size(),
+							(listPaths[i].endArea) ? listPaths[i].endArea->GetID() : 0, (int)listPaths[i].areas.size() );
+
+		++mismatches;
+	}
+
+	if (mismatches)
+		CONSOLE_ECHO( "ERROR: %d queries gave different paths with the adjacency lists.\n", mismatches );
+}
+
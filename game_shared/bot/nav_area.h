@@ -6,10 +6,15 @@
 #define _NAV_AREA_H_
 
 #include <list>
+#include <vector>
 #include "nav.h"
 #include "steam_util.h"
 
 class CNavArea;
+class CNavTrace;
+struct NavFileSections;
+struct NavFileHidingSpot;
+struct NavFileData;
 
 void DestroyHidingSpots( void );
 void StripNavigationAreas( void );
@@ -44,6 +49,33 @@ union NavConnect
 };
 typedef std::list<NavConnect> NavConnectList;
 
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * A block of memory that the objects of one class are carved out of when a nav file is bulk loaded.
+ * Objects allocated once the block is full come from the heap. Deleting an object in the block frees
+ * nothing - the whole block is freed by Release(), once every object in it has been destroyed.
+ */
+class NavBulkStorage
+{
+public:
+	NavBulkStorage( void )						{ m_block = NULL; m_size = 0; m_used = 0; }
+
+	void Reserve( unsigned int count, size_t objectSize );	///< allocate a block for the next 'count' objects - the previous block must be empty
+	void Release( void );									///< free the block
+
+	void *Allocate( size_t size );
+	void Free( void *ptr );
+
+	static size_t RoundUp( size_t size )		{ return (size + 15) & ~(size_t)15; }	///< objects in the block are 16 byte aligned
+
+	size_t GetSize( void ) const				{ return m_size; }
+
+private:
+	char *m_block;
+	size_t m_size;
+	size_t m_used;
+};
+
 //--------------------------------------------------------------------------------------------------------------
 enum LadderDirectionType
 {
@@ -130,8 +162,12 @@ public:
 	void SetFlags( unsigned char flags )		{ m_flags |= flags; }		///< FOR INTERNAL USE ONLY
 	unsigned char GetFlags( void ) const		{ return m_flags; }
 
-	void Save( int fd, unsigned int version ) const;
 	void Load( SteamFile *file, unsigned int version );
+	void Load( const NavFileHidingSpot *data );				///< load from a version 6 nav file
+
+	static void *operator new( size_t size )	{ return m_storage.Allocate( size ); }
+	static void operator delete( void *ptr )	{ m_storage.Free( ptr ); }
+	static void ReserveBulkStorage( unsigned int count )	{ m_storage.Reserve( count, sizeof(HidingSpot) ); }	///< allocate the next 'count' spots as one block
 
 	const Vector *GetPosition( void ) const		{ return &m_pos; }	///< get the position of the hiding spot
 	unsigned int GetID( void ) const			{ return m_id; }
@@ -151,10 +187,23 @@ private:
 
 	static unsigned int m_nextID;							///< used when allocating spot ID's
 	static unsigned int m_masterMarker;						///< used to mark spots
+
+	static NavBulkStorage m_storage;						///< spots loaded from a version 6 nav file
 };
 typedef std::list<HidingSpot *> HidingSpotList;
 extern HidingSpotList TheHidingSpotList;
 
+typedef std::vector<HidingSpot *> HidingSpotVector;
+
+/**
+ * A hiding spot found by analysis that has not been added to the map yet
+ */
+struct HidingSpotCandidate
+{
+	Vector pos;
+	unsigned char flags;
+};
+
 extern HidingSpot *GetHidingSpotByID( unsigned int id );
 
 //--------------------------------------------------------------------------------------------------------------
@@ -206,9 +255,15 @@ public:
 	void Disconnect( CNavArea *area );							///< disconnect this area from given area
 
 	void Save( FILE *fp ) const;
-	void Save( int fd, unsigned int version );
 	void Load( SteamFile *file, unsigned int version );
 	NavErrorType PostLoad( void );
+	NavErrorType Load( const NavFileSections *file, unsigned int index, CNavArea **area, HidingSpot **spot );	///< load from a version 6 nav file, given every area and spot in it
+	void BuildOverlapList( void );							///< find the areas that overlap this one
+	void ComputeEncounterPaths( void );						///< compute the path segment of each spot encounter
+
+	static void *operator new( size_t size )		{ return m_storage.Allocate( size ); }
+	static void operator delete( void *ptr )		{ m_storage.Free( ptr ); }
+	static void ReserveBulkStorage( unsigned int count )	{ m_storage.Reserve( count, sizeof(CNavArea) ); }	///< allocate the next 'count' areas as one block
 
 	unsigned int GetID( void ) const						{ return m_id; }
 
@@ -233,7 +288,7 @@ public:
 
 	bool IsEdge( NavDirType dir ) const;						///< return true if there are no bi-directional links on the given side
 
-	int GetAdjacentCount( NavDirType dir ) const	{ return m_connect[ dir ].size(); }	///< return number of connected areas in given direction
+	int GetAdjacentCount( NavDirType dir ) const;				///< return number of connected areas in given direction
 	CNavArea *GetAdjacentArea( NavDirType dir, int i ) const;	/// return the i'th adjacent area in the given direction
 	CNavArea *GetRandomAdjacentArea( NavDirType dir ) const;
 
@@ -242,6 +297,13 @@ public:
 	float ComputeHeightChange( const CNavArea *area );			///< compute change in height from this area to given area
 
 	const NavLadderList *GetLadderList( LadderDirectionType dir ) const	{ return &m_ladder[dir]; }
+	int GetLadderCount( LadderDirectionType dir ) const;		///< return number of ladders in given direction
+	CNavLadder *GetLadder( LadderDirectionType dir, int i ) const;	///< return the i'th ladder in the given direction
+
+	static void UpdateCompactAdjacency( void );				///< rebuild the compact adjacency arrays if the mesh has changed - must not be called while the mesh is being searched
+	static void InvalidateCompactAdjacency( void )	{ m_isCompactCurrent = false; }	///< fall back to the adjacency lists until the next update
+	static bool IsCompactAdjacencyCurrent( void )	{ return m_isCompactCurrent; }
+	static size_t GetCompactAdjacencyBytes( void );		///< memory used by the compact adjacency arrays
 
 	void ComputePortal( const CNavArea *to, NavDirType dir, Vector *center, float *halfWidth ) const;		///< compute portal to adjacent area
 	void ComputeClosestPointInPortal( const CNavArea *to, NavDirType dir, const Vector *fromPos, Vector *closePos ) const; ///< compute closest point within the "portal" between to adjacent areas
@@ -254,10 +316,14 @@ public:
 	//- hiding spots ------------------------------------------------------------------------------------
 	const HidingSpotList *GetHidingSpotList( void ) const	{ return &m_hidingSpotList; }
 	void ComputeHidingSpots( void );							///< analyze local area neighborhood to find "hiding spots" in this area - for map learning
+	int FindHidingSpots( const CNavTrace *trace, HidingSpotCandidate *candidate ) const;	///< find "hiding spots" without adding them - returns the number found, at most NUM_CORNERS
+	void AddHidingSpots( const HidingSpotCandidate *candidate, int count );	///< add hiding spots found by FindHidingSpots() - assigns unique IDs
 	void ComputeSniperSpots( void );							///< analyze local area neighborhood to find "sniper spots" in this area - for map learning
+	void ComputeSniperSpots( const CNavTrace *trace );
 
 	SpotEncounter *GetSpotEncounter( const CNavArea *from, const CNavArea *to );	///< given the areas we are moving between, return the spots we will encounter
 	void ComputeSpotEncounters( void );							///< compute spot encounter data - for map learning
+	void ComputeSpotEncounters( const CNavTrace *trace, const HidingSpotVector &coverSpots );	///< 'coverSpots' are all spots in cover, in TheHidingSpotList order
 
 	//- "danger" ----------------------------------------------------------------------------------------
 	void IncreaseDanger( int teamID, float amount );			///< increase the danger of this area for the given team
@@ -281,15 +347,17 @@ public:
 	const ApproachInfo *GetApproachInfo( int i ) const	{ return &m_approach[i]; }
 	int GetApproachInfoCount( void ) const							{ return m_approachCount; }
 	void ComputeApproachAreas( void );							///< determine the set of "approach areas" - for map learning
+	bool ComputeApproachEye( Vector *eye ) const;				///< compute the view point used to find approach areas - return false if there is no ground
+	void ComputeApproachAreas( const CNavTrace *trace, const Vector *eye );	///< if 'eye' is NULL the area has no approach areas - uses the search arena active on this thread
 
 	//- A* pathfinding algorithm ------------------------------------------------------------------------
-	static void MakeNewMarker( void )					{ ++m_masterMarker; if (m_masterMarker == 0) m_masterMarker = 1; }
-	void Mark( void )													{ m_marker = m_masterMarker; }
-	BOOL IsMarked( void ) const								{ return (m_marker == m_masterMarker) ? true : false; }
+	static void MakeNewMarker( void );
+	void Mark( void );
+	BOOL IsMarked( void ) const;
 	
-	void SetParent( CNavArea *parent, NavTraverseType how = NUM_TRAVERSE_TYPES )	{ m_parent = parent; m_parentHow = how; }
-	CNavArea *GetParent( void ) const						{ return m_parent; }
-	NavTraverseType GetParentHow( void ) const	{ return m_parentHow; }
+	void SetParent( CNavArea *parent, NavTraverseType how = NUM_TRAVERSE_TYPES );
+	CNavArea *GetParent( void ) const;
+	NavTraverseType GetParentHow( void ) const;
 
 	bool IsOpen( void ) const;								///< true if on "open list"
 	void AddToOpenList( void );								///< add to open list in decreasing value order
@@ -304,11 +372,11 @@ public:
 
 	static void ClearSearchLists( void );					///< clears the open and closed lists for a new search
 
-	void SetTotalCost( float value )							{ m_totalCost = value; }
-	float GetTotalCost( void ) const							{ return m_totalCost; }
+	void SetTotalCost( float value );
+	float GetTotalCost( void ) const;
 
-	void SetCostSoFar( float value )							{ m_costSoFar = value; }
-	float GetCostSoFar( void ) const							{ return m_costSoFar; }
+	void SetCostSoFar( float value );
+	float GetCostSoFar( void ) const;
 
 	//- editing -----------------------------------------------------------------------------------------
 	void Draw( byte red, byte green, byte blue, int duration = 50 );	///< draw area for debugging & editing
@@ -320,14 +388,15 @@ public:
 	void RaiseCorner( NavCornerType corner, int amount );	///< raise/lower a corner (or all corners if corner == NUM_CORNERS)
 
 	//- ladders -----------------------------------------------------------------------------------------
-	void AddLadderUp( CNavLadder *ladder )				{ m_ladder[ LADDER_UP ].push_back( ladder ); }
-	void AddLadderDown( CNavLadder *ladder )			{ m_ladder[ LADDER_DOWN ].push_back( ladder ); }
+	void AddLadderUp( CNavLadder *ladder )				{ m_ladder[ LADDER_UP ].push_back( ladder ); InvalidateCompactAdjacency(); }
+	void AddLadderDown( CNavLadder *ladder )			{ m_ladder[ LADDER_DOWN ].push_back( ladder ); InvalidateCompactAdjacency(); }
 
 private:
 	friend void ConnectGeneratedAreas( void );
 	friend void MergeGeneratedAreas( void );
 	friend void MarkJumpAreas( void );
 	friend bool SaveNavigationMap( const char *filename );
+	friend void BuildNavigationMapData( NavFileData *data );
 	friend NavErrorType LoadNavigationMap( void );
 	friend void DestroyNavigationMap( void );
 	friend void DestroyHidingSpots( void );
@@ -339,6 +408,8 @@ private:
 	static bool m_isReset;									///< if true, don't bother cleaning up in destructor since everything is going away
 
 	static unsigned int m_nextID;							///< used to allocate unique IDs
+	static NavBulkStorage m_storage;						///< areas loaded from a version 6 nav file
+
 	unsigned int m_id;										///< unique area ID
 	Extent m_extent;										///< extents of area in world coords (NOTE: lo.z is not necessarily the minimum Z, but corresponds to Z at point (lo.x, lo.y), etc
 	Vector m_center;										///< centroid of area
@@ -365,7 +436,7 @@ private:
 
 	//- encounter spots ---------------------------------------------------------------------------------
 	SpotEncounterList m_spotEncounterList;					///< list of possible ways to move thru this area, and the spots to look at as we do
-	void AddSpotEncounters( const CNavArea *from, NavDirType fromDir, const CNavArea *to, NavDirType toDir );	///< add spot encounter data when moving from area to area
+	void AddSpotEncounters( const CNavTrace *trace, const HidingSpotVector &coverSpots, const CNavArea *from, NavDirType fromDir, const CNavArea *to, NavDirType toDir );	///< add spot encounter data when moving from area to area
 
 	//- approach areas ----------------------------------------------------------------------------------
 	enum { MAX_APPROACH_AREAS = 16 };
@@ -374,22 +445,21 @@ private:
 
 	void Strip( void );										///< remove "analyzed" data from nav area
 
-	//- A* pathfinding algorithm ------------------------------------------------------------------------
-	static unsigned int m_masterMarker;
-	unsigned int m_marker;									///< used to flag the area as visited
-	CNavArea *m_parent;										///< the area just prior to this on in the search path
-	NavTraverseType m_parentHow;							///< how we get from parent to us
-	float m_totalCost;										///< the distance so far plus an estimate of the distance left
-	float m_costSoFar;										///< distance travelled so far
-
-	static CNavArea *m_openList;
-	CNavArea *m_nextOpen, *m_prevOpen;						///< only valid if m_openMarker == m_masterMarker
-	unsigned int m_openMarker;								///< if this equals the current marker value, we are on the open list
-
 	//- connections to adjacent areas -------------------------------------------------------------------
 	NavConnectList m_connect[ NUM_DIRECTIONS ];				///< a list of adjacent areas for each direction
 	NavLadderList m_ladder[ NUM_LADDER_DIRECTIONS ];		///< list of ladders leading up and down from this area
 
+	/// The same connections as m_connect and m_ladder, stored contiguously for searching.
+	/// These are only valid while m_isCompactCurrent is true - editing the mesh invalidates them.
+	CNavArea **m_compactArea;								///< adjacent areas, in the enum order NORTH, EAST, SOUTH, WEST
+	unsigned short m_compactAreaStart[ NUM_DIRECTIONS + 1 ];	///< where each direction starts in m_compactArea
+	CNavLadder **m_compactLadder;							///< up ladders, followed by down ladders
+	unsigned short m_compactLadderStart[ NUM_LADDER_DIRECTIONS + 1 ];
+
+	static bool m_isCompactCurrent;							///< true if the compact arrays match the lists
+	static std::vector< CNavArea * > m_compactAreaStorage;	///< the compact arrays of every area
+	static std::vector< CNavLadder * > m_compactLadderStorage;
+
 	//---------------------------------------------------------------------------------------------------
 	CNavNode *m_node[ NUM_CORNERS ];						///< nav nodes at each corner of the area
 
@@ -409,6 +479,127 @@ private:
 typedef std::list<CNavArea *> NavAreaList;
 extern NavAreaList TheNavAreaList;
 
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * The CNavAreaSearch holds the per-area state of an A* search - markers, parents, costs, and the open list.
+ * State is stored in arrays indexed by area ID, and the open list is an indexed binary heap, so adding and
+ * updating an area is O(log n) instead of a walk along a sorted list.
+ * Ties are broken by the order areas were added, which pops areas in exactly the same order the old sorted
+ * list did (this matters for the breadth-first SearchSurroundingAreas, where every area has a cost of zero).
+ * The arrays are kept between searches, so a search does not allocate once the arena has grown to the mesh size.
+ *
+ * The CNavArea search accessors use the arena that is active on the calling thread, which is TheNavAreaSearch
+ * unless a CNavAreaSearch::Scope says otherwise. Each thread that runs searches concurrently must use its own arena.
+ */
+class CNavAreaSearch
+{
+public:
+	CNavAreaSearch( void );
+
+	void Reset( void );										///< forget all search state - must be called when the nav mesh is destroyed
+
+	void MakeNewMarker( void );
+	void Mark( const CNavArea *area )						{ GetNode( area ).marker = m_marker; }
+	bool IsMarked( const CNavArea *area ) const				{ return (FindNode( area ).marker == m_marker) ? true : false; }
+
+	void SetParent( const CNavArea *area, CNavArea *parent, NavTraverseType how = NUM_TRAVERSE_TYPES )	{ SearchNode &node = GetNode( area ); node.parent = parent; node.parentHow = how; }
+	CNavArea *GetParent( const CNavArea *area ) const		{ return FindNode( area ).parent; }
+	NavTraverseType GetParentHow( const CNavArea *area ) const	{ return FindNode( area ).parentHow; }
+
+	void SetTotalCost( const CNavArea *area, float value )	{ GetNode( area ).totalCost = value; }
+	float GetTotalCost( const CNavArea *area ) const		{ return FindNode( area ).totalCost; }
+
+	void SetCostSoFar( const CNavArea *area, float value )	{ GetNode( area ).costSoFar = value; }
+	float GetCostSoFar( const CNavArea *area ) const		{ return FindNode( area ).costSoFar; }
+
+	bool IsOpen( const CNavArea *area ) const				{ return (FindNode( area ).openMarker == m_marker) ? true : false; }
+	void AddToOpenList( CNavArea *area );					///< add to open list in increasing cost order
+	void UpdateOnOpenList( CNavArea *area );				///< a smaller cost has been found, update this area on the open list
+	void RemoveFromOpenList( CNavArea *area );
+	bool IsOpenListEmpty( void ) const						{ return m_openList.empty(); }
+	CNavArea *PopOpenList( void );							///< remove and return the cheapest area on the open list
+
+	bool IsClosed( const CNavArea *area ) const				{ return (IsMarked( area ) && !IsOpen( area )) ? true : false; }
+	void AddToClosedList( const CNavArea *area )			{ Mark( area ); }
+
+	void ClearSearchLists( void );							///< clears the open and closed lists for a new search
+
+	static CNavAreaSearch *GetActive( void );				///< the arena used by the CNavArea search accessors on this thread
+
+	/**
+	 * Makes an arena the active one on this thread for the lifetime of the scope
+	 */
+	class Scope
+	{
+	public:
+		Scope( CNavAreaSearch &search ) : m_prev( m_active )	{ m_active = &search; }
+		~Scope()											{ m_active = m_prev; }
+
+	private:
+		CNavAreaSearch *m_prev;
+	};
+
+private:
+	struct SearchNode
+	{
+		CNavArea *area;
+		CNavArea *parent;									///< the area just prior to this on in the search path
+		NavTraverseType parentHow;							///< how we get from parent to us
+		float totalCost;									///< the distance so far plus an estimate of the distance left
+		float costSoFar;									///< distance travelled so far
+		unsigned int marker;								///< used to flag the area as visited
+		unsigned int openMarker;							///< if this equals the current marker value, we are on the open list
+		unsigned int openOrder;								///< when this area was added to the open list, to break ties
+		float openCost;										///< total cost when this area was last placed on the open list
+		int heapIndex;										///< position in m_openList, only valid when open
+	};
+
+	SearchNode &GetNode( const CNavArea *area );			///< grows the arena if needed
+	const SearchNode &FindNode( const CNavArea *area ) const;
+
+	bool IsCheaper( unsigned int id, unsigned int otherID ) const;
+	void SetHeapEntry( int index, unsigned int id );
+	void HeapUp( int index );
+	void HeapDown( int index );
+
+	std::vector< SearchNode > m_node;						///< indexed by area ID
+	std::vector< unsigned int > m_openList;					///< binary heap of area IDs
+	unsigned int m_marker;
+	unsigned int m_openOrder;
+
+	static SearchNode m_emptyNode;							///< returned for areas the arena has never seen
+
+	static thread_local CNavAreaSearch *m_active;			///< if NULL, TheNavAreaSearch is active
+};
+
+extern CNavAreaSearch TheNavAreaSearch;
+
+inline CNavAreaSearch *CNavAreaSearch::GetActive( void )
+{
+	return (m_active) ? m_active : &TheNavAreaSearch;
+}
+
+inline CNavAreaSearch::SearchNode &CNavAreaSearch::GetNode( const CNavArea *area )
+{
+	unsigned int id = area->GetID();
+
+	if (id >= m_node.size())
+		m_node.resize( id + 1, m_emptyNode );
+
+	return m_node[ id ];
+}
+
+inline const CNavAreaSearch::SearchNode &CNavAreaSearch::FindNode( const CNavArea *area ) const
+{
+	unsigned int id = area->GetID();
+
+	if (id >= m_node.size())
+		return m_emptyNode;
+
+	return m_node[ id ];
+}
+
+
 
 //
 // Inlines
@@ -419,8 +610,22 @@ inline bool CNavArea::IsDegenerate( void ) const
 	return (m_extent.lo.x >= m_extent.hi.x || m_extent.lo.y >= m_extent.hi.y);
 }
 
+inline int CNavArea::GetAdjacentCount( NavDirType dir ) const
+{
+	if (m_isCompactCurrent)
+		return m_compactAreaStart[ dir+1 ] - m_compactAreaStart[ dir ];
+
+	return m_connect[ dir ].size();
+}
+
 inline CNavArea *CNavArea::GetAdjacentArea( NavDirType dir, int i ) const
 {
+	if (m_isCompactCurrent)
+	{
+		int index = m_compactAreaStart[ dir ] + i;
+		return (index < m_compactAreaStart[ dir+1 ]) ? m_compactArea[ index ] : NULL;
+	}
+
 	NavConnectList::const_iterator iter;
 	for( iter = m_connect[dir].begin(); iter != m_connect[dir].end(); ++iter )
 	{
@@ -432,49 +637,64 @@ inline CNavArea *CNavArea::GetAdjacentArea( NavDirType dir, int i ) const
 	return NULL;
 }
 
-inline bool CNavArea::IsOpen( void ) const
+inline int CNavArea::GetLadderCount( LadderDirectionType dir ) const
 {
-	return (m_openMarker == m_masterMarker) ? true : false;
-}
+	if (m_isCompactCurrent)
+		return m_compactLadderStart[ dir+1 ] - m_compactLadderStart[ dir ];
 
-inline bool CNavArea::IsOpenListEmpty( void )
-{
-	return (m_openList) ? false : true;
+	return m_ladder[ dir ].size();
 }
 
-inline CNavArea *CNavArea::PopOpenList( void )
+inline CNavLadder *CNavArea::GetLadder( LadderDirectionType dir, int i ) const
 {
-	if (m_openList)
+	if (m_isCompactCurrent)
 	{
-		CNavArea *area = m_openList;
-	
-		// disconnect from list
-		area->RemoveFromOpenList();
+		int index = m_compactLadderStart[ dir ] + i;
+		return (index < m_compactLadderStart[ dir+1 ]) ? m_compactLadder[ index ] : NULL;
+	}
 
-		return area;
+	NavLadderList::const_iterator iter;
+	for( iter = m_ladder[dir].begin(); iter != m_ladder[dir].end(); ++iter )
+	{
+		if (i == 0)
+			return *iter;
+		--i;
 	}
 
 	return NULL;
 }
 
-inline bool CNavArea::IsClosed( void ) const
-{
-	if (IsMarked() && !IsOpen())
-		return true;
+inline void CNavArea::MakeNewMarker( void )				{ CNavAreaSearch::GetActive()->MakeNewMarker(); }
+inline void CNavArea::Mark( void )						{ CNavAreaSearch::GetActive()->Mark( this ); }
+inline BOOL CNavArea::IsMarked( void ) const				{ return CNavAreaSearch::GetActive()->IsMarked( this ); }
 
-	return false;
-}
+inline void CNavArea::SetParent( CNavArea *parent, NavTraverseType how )	{ CNavAreaSearch::GetActive()->SetParent( this, parent, how ); }
+inline CNavArea *CNavArea::GetParent( void ) const		{ return CNavAreaSearch::GetActive()->GetParent( this ); }
+inline NavTraverseType CNavArea::GetParentHow( void ) const	{ return CNavAreaSearch::GetActive()->GetParentHow( this ); }
 
-inline void CNavArea::AddToClosedList( void )
-{
-	Mark();
-}
+inline bool CNavArea::IsOpen( void ) const				{ return CNavAreaSearch::GetActive()->IsOpen( this ); }
+inline void CNavArea::AddToOpenList( void )				{ CNavAreaSearch::GetActive()->AddToOpenList( this ); }
+inline void CNavArea::UpdateOnOpenList( void )			{ CNavAreaSearch::GetActive()->UpdateOnOpenList( this ); }
+inline void CNavArea::RemoveFromOpenList( void )			{ CNavAreaSearch::GetActive()->RemoveFromOpenList( this ); }
+inline bool CNavArea::IsOpenListEmpty( void )				{ return CNavAreaSearch::GetActive()->IsOpenListEmpty(); }
+inline CNavArea *CNavArea::PopOpenList( void )			{ return CNavAreaSearch::GetActive()->PopOpenList(); }
+
+inline bool CNavArea::IsClosed( void ) const				{ return CNavAreaSearch::GetActive()->IsClosed( this ); }
+inline void CNavArea::AddToClosedList( void )				{ CNavAreaSearch::GetActive()->AddToClosedList( this ); }
 
 inline void CNavArea::RemoveFromClosedList( void )
 {
 	// since "closed" is defined as visited (marked) and not on open list, do nothing
 }
 
+inline void CNavArea::ClearSearchLists( void )			{ CNavAreaSearch::GetActive()->ClearSearchLists(); }
+
+inline void CNavArea::SetTotalCost( float value )			{ CNavAreaSearch::GetActive()->SetTotalCost( this, value ); }
+inline float CNavArea::GetTotalCost( void ) const			{ return CNavAreaSearch::GetActive()->GetTotalCost( this ); }
+
+inline void CNavArea::SetCostSoFar( float value )			{ CNavAreaSearch::GetActive()->SetCostSoFar( this, value ); }
+inline float CNavArea::GetCostSoFar( void ) const			{ return CNavAreaSearch::GetActive()->GetCostSoFar( this ); }
+
 //--------------------------------------------------------------------------------------------------------------
 
 /**
@@ -549,6 +769,8 @@ extern CNavAreaGrid TheNavAreaGrid;
 extern NavErrorType LoadNavigationMap( void );
 extern void GenerateNavigationAreaMesh( void );
 
+extern void NavAreaBuildPathBenchmark( int count, unsigned int seed = 0 );	///< Times random path queries on the loaded nav mesh - "bot_nav_benchmark"
+
 extern void SanityCheckNavigationMap( const char *mapName );	///< Performs a lightweight sanity-check of the specified map's nav mesh
 
 extern void ApproachAreaAnalysisPrep( void );
@@ -674,10 +896,14 @@ public:
  * If 'goalArea' is NULL, will compute a path as close as possible to 'goalPos'.
  * If 'goalPos' is NULL, will use the center of 'goalArea' as the goal position.
  * Returns true if a path exists.
+ * The search state is kept in 'search', which is made the active arena for the duration of the search so
+ * cost functors that call CNavArea::GetCostSoFar() see it. Read the path back with search.GetParent().
  */
 template< typename CostFunctor >
-bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *goalPos, CostFunctor &costFunc, CNavArea **closestArea = NULL )
+bool NavAreaBuildPath( CNavAreaSearch &search, CNavArea *startArea, CNavArea *goalArea, const Vector *goalPos, CostFunctor &costFunc, CNavArea **closestArea = NULL )
 {
+	CNavAreaSearch::Scope scope( search );
+
 	if (closestArea)
 		*closestArea = NULL;
 
@@ -693,12 +919,12 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 		return false;
 	}
 
-	startArea->SetParent( NULL );
+	search.SetParent( startArea, NULL );
 
 	// if we are already in the goal area, build trivial path
 	if (startArea == goalArea)
 	{
-		goalArea->SetParent( NULL );
+		search.SetParent( goalArea, NULL );
 
 		if (closestArea)
 			*closestArea = goalArea;
@@ -710,29 +936,29 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 	Vector actualGoalPos = (goalPos) ? *goalPos : *goalArea->GetCenter();
 
 	// start search
-	CNavArea::ClearSearchLists();
+	search.ClearSearchLists();
 
 	// compute estimate of path length
 	/// @todo Cost might work as "manhattan distance"
-	startArea->SetTotalCost( (*startArea->GetCenter() - actualGoalPos).Length() );
+	search.SetTotalCost( startArea, (*startArea->GetCenter() - actualGoalPos).Length() );
 
 	float initCost = costFunc( startArea, NULL, NULL );	
 	if (initCost < 0.0f)
 		return false;
-	startArea->SetCostSoFar( initCost );
+	search.SetCostSoFar( startArea, initCost );
 
-	startArea->AddToOpenList();
+	search.AddToOpenList( startArea );
 
 	// keep track of the area we visit that is closest to the goal
 	if (closestArea)
 		*closestArea = startArea;
-	float closestAreaDist = startArea->GetTotalCost();
+	float closestAreaDist = search.GetTotalCost( startArea );
 
 	// do A* search
-	while( !CNavArea::IsOpenListEmpty() )
+	while( !search.IsOpenListEmpty() )
 	{
 		// get next area to check
-		CNavArea *area = CNavArea::PopOpenList();
+		CNavArea *area = search.PopOpenList();
 
 		// check if we have found the goal area
 		if (area == goalArea)
@@ -746,12 +972,12 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 		// search adjacent areas
 		bool searchFloor = true;
 		int dir = NORTH;
-		const NavConnectList *floorList = area->GetAdjacentList( NORTH );
-		NavConnectList::const_iterator floorIter = floorList->begin();
+		int floorIndex = 0;
+		int floorCount = area->GetAdjacentCount( NORTH );
 
 		bool ladderUp = true;
-		const NavLadderList *ladderList = NULL;
-		NavLadderList::const_iterator ladderIter;
+		int ladderIndex = 0;
+		int ladderCount = 0;
 		enum { AHEAD = 0, LEFT, RIGHT, BEHIND, NUM_TOP_DIRECTIONS };
 		int ladderTopDir;
 
@@ -767,7 +993,7 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 			if (searchFloor)
 			{
 				// if exhausted adjacent connections in current direction, begin checking next direction
-				if (floorIter == floorList->end())
+				if (floorIndex == floorCount)
 				{
 					++dir;
 
@@ -776,27 +1002,27 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 						// checked all directions on floor - check ladders next
 						searchFloor = false;
 
-						ladderList = area->GetLadderList( LADDER_UP );
-						ladderIter = ladderList->begin();
+						ladderIndex = 0;
+						ladderCount = area->GetLadderCount( LADDER_UP );
 						ladderTopDir = AHEAD;
 					}
 					else
 					{
 						// start next direction
-						floorList = area->GetAdjacentList( (NavDirType)dir );
-						floorIter = floorList->begin();
+						floorIndex = 0;
+						floorCount = area->GetAdjacentCount( (NavDirType)dir );
 					}
 
 					continue;
 				}
 
-				newArea = (*floorIter).area;
+				newArea = area->GetAdjacentArea( (NavDirType)dir, floorIndex );
 				how = (NavTraverseType)dir;
-				++floorIter;
+				++floorIndex;
 			}
 			else	// search ladders
 			{
-				if (ladderIter == ladderList->end())
+				if (ladderIndex == ladderCount)
 				{
 					if (!ladderUp)
 					{
@@ -807,20 +1033,20 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 					{
 						// check down ladders
 						ladderUp = false;
-						ladderList = area->GetLadderList( LADDER_DOWN );
-						ladderIter = ladderList->begin();
+						ladderIndex = 0;
+						ladderCount = area->GetLadderCount( LADDER_DOWN );
 					}
 					continue;
 				}
 
 				if (ladderUp)
 				{
-					ladder = *ladderIter;
+					ladder = area->GetLadder( LADDER_UP, ladderIndex );
 
 					// cannot use this ladder if the ladder bottom is hanging above our head
 					if (ladder->m_isDangling)
 					{
-						++ladderIter;
+						++ladderIndex;
 						continue;
 					}
 
@@ -833,7 +1059,7 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 						newArea = ladder->m_topRightArea;
 					else
 					{
-						++ladderIter;
+						++ladderIndex;
 						continue;
 					}
 
@@ -842,10 +1068,10 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 				}
 				else
 				{
-					newArea = (*ladderIter)->m_bottomArea;
+					ladder = area->GetLadder( LADDER_DOWN, ladderIndex );
+					newArea = ladder->m_bottomArea;
 					how = GO_LADDER_DOWN;
-					ladder = (*ladderIter);
-					++ladderIter;
+					++ladderIndex;
 				}
 
 				if (newArea == NULL)
@@ -862,7 +1088,7 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 			if (newCostSoFar < 0.0f)
 				continue;
 
-			if ((newArea->IsOpen() || newArea->IsClosed()) && newArea->GetCostSoFar() <= newCostSoFar)
+			if ((search.IsOpen( newArea ) || search.IsClosed( newArea )) && search.GetCostSoFar( newArea ) <= newCostSoFar)
 			{
 				// this is a worse path - skip it
 				continue;
@@ -879,33 +1105,42 @@ bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *go
 					closestAreaDist = newCostRemaining;
 				}
 				
-				newArea->SetParent( area, how );
-				newArea->SetCostSoFar( newCostSoFar );
-				newArea->SetTotalCost( newCostSoFar + newCostRemaining );
+				search.SetParent( newArea, area, how );
+				search.SetCostSoFar( newArea, newCostSoFar );
+				search.SetTotalCost( newArea, newCostSoFar + newCostRemaining );
 
-				if (newArea->IsClosed())
-					newArea->RemoveFromClosedList();
-
-				if (newArea->IsOpen())
+				if (search.IsOpen( newArea ))
 				{
 					// area already on open list, update the list order to keep costs sorted
-					newArea->UpdateOnOpenList();
+					search.UpdateOnOpenList( newArea );
 				}
 				else
 				{
-					newArea->AddToOpenList();
+					search.AddToOpenList( newArea );
 				}
 			}
 		}
 
 		// we have searched this area
-		area->AddToClosedList();
+		search.AddToClosedList( area );
 	}
 
 	return false;
 }
 
 
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Find path from startArea to goalArea via an A* search, using the active search arena.
+ * The path is defined by following CNavArea::GetParent() back from goalArea to startArea.
+ */
+template< typename CostFunctor >
+bool NavAreaBuildPath( CNavArea *startArea, CNavArea *goalArea, const Vector *goalPos, CostFunctor &costFunc, CNavArea **closestArea = NULL )
+{
+	return NavAreaBuildPath( *CNavAreaSearch::GetActive(), startArea, goalArea, goalPos, costFunc, closestArea );
+}
+
+
 //--------------------------------------------------------------------------------------------------------------
 /**
  * Compute distance between two areas. Return -1 if can't reach 'endArea' from 'startArea'.
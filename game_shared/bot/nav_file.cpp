@@ -7,12 +7,18 @@
 
 #include <list>
 #include <vector>
+#include <map>
 #include <algorithm>
+#include <chrono>
 
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <assert.h>
 
+#if defined( _WIN32 ) || defined( __linux__ )
+#include <malloc.h>
+#endif
+
 #ifdef _WIN32
 #include <io.h>
 
@@ -38,6 +44,7 @@
 #include "nav.h"
 #include "nav_node.h"
 #include "nav_area.h"
+#include "nav_file.h"
 
 
 //
@@ -118,23 +125,21 @@ public:
 		return m_directory[ i ];
 	}
 
-	/// store the directory
-	void Save( int fd )
+	/// return the number of entries in the directory
+	unsigned int GetCount( void ) const
 	{
-		// store number of entries in directory
-		EntryType count = m_directory.size();
-		_write( fd, &count, sizeof(EntryType) );
+		return m_directory.size();
+	}
 
-		// store entries		
-		std::vector<Place>::iterator it;
+	/// store the directory as a sequence of NUL terminated place names
+	void Save( std::vector<char> *names ) const
+	{
+		std::vector<Place>::const_iterator it;
 		for( it = m_directory.begin(); it != m_directory.end(); ++it )
 		{
 			const char *placeName = TheBotPhrases->IDToName( *it );
 
-			// store string length followed by string itself
-			unsigned short len = strlen(placeName)+1;
-			_write( fd, &len, sizeof(unsigned short) );
-			_write( fd, placeName, len );
+			names->insert( names->end(), placeName, placeName + strlen(placeName) + 1 );
 		}
 	}
 
@@ -159,6 +164,19 @@ public:
 		}
 	}
 
+	/// load the directory from 'count' NUL terminated place names
+	void Load( const char *names, unsigned int count )
+	{
+		m_directory.reserve( count );
+
+		// keep unknown places, so the entries of the places after them are unchanged
+		for( unsigned int i=0; i<count; ++i )
+		{
+			m_directory.push_back( TheBotPhrases->NameToID( names ) );
+			names += strlen( names ) + 1;
+		}
+	}
+
 private:
 	std::vector<Place> m_directory;
 };
@@ -205,173 +223,6 @@ void CNavArea::Save( FILE *fp ) const
 	base += 4;
 }
 
-//--------------------------------------------------------------------------------------------------------------
-/**
- * Save a navigation area to the opened binary stream
- */
-void CNavArea::Save( int fd, unsigned int version )
-{
-	// save ID
-	_write( fd, &m_id, sizeof(unsigned int) );
-
-	// save attribute flags
-	_write( fd, &m_attributeFlags, sizeof(unsigned char) );
-
-	// save extent of area
-	_write( fd, &m_extent, 6*sizeof(float) );
-
-	// save heights of implicit corners
-	_write( fd, &m_neZ, sizeof(float) );
-	_write( fd, &m_swZ, sizeof(float) );
-
-	// save connections to adjacent areas
-	// in the enum order NORTH, EAST, SOUTH, WEST
-	for( int d=0; d<NUM_DIRECTIONS; d++ )
-	{
-		// save number of connections for this direction
-		unsigned int count = m_connect[d].size();
-		_write( fd, &count, sizeof(unsigned int) );
-
-		NavConnectList::const_iterator iter;
-		for( iter = m_connect[d].begin(); iter != m_connect[d].end(); ++iter )
-		{
-			NavConnect connect = *iter;
-			_write( fd, &connect.area->m_id, sizeof(unsigned int) );
-		}
-	}
-
-	//
-	// Store hiding spots for this area
-	//
-	unsigned char count;
-	if (m_hidingSpotList.size() > 255)
-	{
-		count = 255;
-		CONSOLE_ECHO( "Warning: NavArea #%d: Truncated hiding spot list to 255\n", m_id );
-	}
-	else
-	{
-		count = m_hidingSpotList.size();
-	}
-	_write( fd, &count, sizeof(unsigned char) );
-
-	// store HidingSpot objects
-	unsigned int saveCount = 0;
-	for( HidingSpotList::iterator iter = m_hidingSpotList.begin(); iter != m_hidingSpotList.end(); ++iter )
-	{
-		HidingSpot *spot = *iter;
-		
-		spot->Save( fd, version );
-
-		// overflow check
-		if (++saveCount == count)
-			break;
-	}
-
-	//
-	// Save the approach areas for this area
-	//
-
-	// save number of approach areas
-	_write( fd, &m_approachCount, sizeof(unsigned char) );
-	if (cv_bot_debug.value > 0.0f)
-		CONSOLE_ECHO( "  m_approachCount = %d\n", m_approachCount );
-
-	// save approach area info
-	unsigned char type;
-	unsigned int zero = 0;
-	for( int a=0; a<m_approachCount; ++a )
-	{
-		if (m_approach[a].here.area)
-			_write( fd, &m_approach[a].here.area->m_id, sizeof(unsigned int) );
-		else
-			_write( fd, &zero, sizeof(unsigned int) );
-
-		if (m_approach[a].prev.area)
-			_write( fd, &m_approach[a].prev.area->m_id, sizeof(unsigned int) );
-		else
-			_write( fd, &zero, sizeof(unsigned int) );
-		type = (unsigned char)m_approach[a].prevToHereHow;
-		_write( fd, &type, sizeof(unsigned char) );
-
-		if (m_approach[a].next.area)
-			_write( fd, &m_approach[a].next.area->m_id, sizeof(unsigned int) );
-		else
-			_write( fd, &zero, sizeof(unsigned int) );
-		type = (unsigned char)m_approach[a].hereToNextHow;
-		_write( fd, &type, sizeof(unsigned char) );
-	}
-
-	//
-	// Save encounter spots for this area
-	//
-	{
-		// save number of encounter paths for this area
-		unsigned int count = m_spotEncounterList.size();
-		_write( fd, &count, sizeof(unsigned int) );
-
-		if (cv_bot_debug.value > 0.0f)
-			CONSOLE_ECHO( "  m_spotEncounterList.size() = %d\n", count );
-
-		SpotEncounter *e;
-		for( SpotEncounterList::iterator iter = m_spotEncounterList.begin(); iter != m_spotEncounterList.end(); ++iter )
-		{
-			e = &(*iter);
-
-			if (e->from.area)
-				_write( fd, &e->from.area->m_id, sizeof(unsigned int) );
-			else
-				_write( fd, &zero, sizeof(unsigned int) );
-
-			unsigned char dir = e->fromDir;
-			_write( fd, &dir, sizeof(unsigned char) );
-
-			if (e->to.area)
-				_write( fd, &e->to.area->m_id, sizeof(unsigned int) );
-			else
-				_write( fd, &zero, sizeof(unsigned int) );
-
-			dir = e->toDir;
-			_write( fd, &dir, sizeof(unsigned char) );
-
-			// write list of spots along this path
-			unsigned char spotCount;
-			if (e->spotList.size() > 255)
-			{
-				spotCount = 255;
-				CONSOLE_ECHO( "Warning: NavArea #%d: Truncated encounter spot list to 255\n", m_id );
-			}
-			else
-			{
-				spotCount = e->spotList.size();
-			}
-			_write( fd, &spotCount, sizeof(unsigned char) );
-		
-			saveCount = 0;
-			for( SpotOrderList::iterator oiter = e->spotList.begin(); oiter != e->spotList.end(); ++oiter )
-			{
-				SpotOrder *order = &(*oiter);
-
-				// order->spot may be NULL if we've loaded a nav mesh that has been edited but not re-analyzed
-				unsigned int id = (order->spot) ? order->spot->GetID() : 0;
-				_write( fd, &id, sizeof(unsigned int) );
-
-				unsigned char t = 255 * order->t;
-				_write( fd, &t, sizeof(unsigned char) );
-
-				// overflow check
-				if (++saveCount == spotCount)
-					break;
-			}
-		}
-	}
-
-	// store place dictionary entry
-	PlaceDirectory::EntryType entry = placeDirectory.GetEntry( GetPlace() );
-	_write( fd, &entry, sizeof(entry) );
-
-}
-
 //--------------------------------------------------------------------------------------------------------------
 /**
  * Load a navigation area from the file
@@ -626,18 +477,6 @@ NavErrorType CNavArea::PostLoad( void )
 			error = NAV_CORRUPT_DATA;
 		}
 
-		if (e->from.area && e->to.area)
-		{
-			// compute path
-			float halfWidth;
-			ComputePortal( e->to.area, e->toDir, &e->path.to, &halfWidth );
-			ComputePortal( e->from.area, e->fromDir, &e->path.from, &halfWidth );
-
-			const float eyeHeight = HalfHumanHeight;
-			e->path.from.z = e->from.area->GetZ( &e->path.from ) + eyeHeight;
-			e->path.to.z = e->to.area->GetZ( &e->path.to ) + eyeHeight;
-		}
-
 		// resolve HidingSpot IDs
 		for( SpotOrderList::iterator oiter = e->spotList.begin(); oiter != e->spotList.end(); ++oiter )
 		{
@@ -652,8 +491,137 @@ NavErrorType CNavArea::PostLoad( void )
 		}
 	}
 
-	// build overlap list
-	/// @todo Optimize this
+	ComputeEncounterPaths();
+
+	BuildOverlapList();
+
+	return error;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Load a navigation area from a version 6 nav file.
+ * The file refers to areas and hiding spots by index into 'area' and 'spot', so no IDs need to be resolved later.
+ */
+NavErrorType CNavArea::Load( const NavFileSections *file, unsigned int index, CNavArea **area, HidingSpot **spot )
+{
+	const NavFileArea *data = &file->area[ index ];
+
+	m_id = data->id;
+
+	// update nextID to avoid collisions
+	if (m_id >= m_nextID)
+		m_nextID = m_id+1;
+
+	m_attributeFlags = data->attributeFlags;
+
+	m_extent.lo = Vector( data->extent[0], data->extent[1], data->extent[2] );
+	m_extent.hi = Vector( data->extent[3], data->extent[4], data->extent[5] );
+
+	m_center.x = (m_extent.lo.x + m_extent.hi.x)/2.0f;
+	m_center.y = (m_extent.lo.y + m_extent.hi.y)/2.0f;
+	m_center.z = (m_extent.lo.z + m_extent.hi.z)/2.0f;
+
+	m_neZ = data->neZ;
+	m_swZ = data->swZ;
+
+	// connections to adjacent areas, in the enum order NORTH, EAST, SOUTH, WEST
+	const unsigned int *connection = &file->connection[ data->firstConnection ];
+	for( int d=0; d<NUM_DIRECTIONS; d++ )
+	{
+		for( unsigned int i=0; i<data->connectionCount[d]; ++i )
+		{
+			NavConnect connect;
+			connect.area = area[ *connection++ ];
+
+			m_connect[d].push_back( connect );
+		}
+	}
+
+	// hiding spots
+	for( unsigned int h=0; h<data->hidingSpotCount; ++h )
+		m_hidingSpotList.push_back( spot[ data->firstHidingSpot + h ] );
+
+	// approach areas
+	if (data->approachCount > MAX_APPROACH_AREAS)
+	{
+		CONSOLE_ECHO( "ERROR: Corrupt navigation data. Too many Approach Areas.\n" );
+		return NAV_CORRUPT_DATA;
+	}
+
+	m_approachCount = data->approachCount;
+	for( int a=0; a<m_approachCount; ++a )
+	{
+		const NavFileApproach *approach = &file->approach[ data->firstApproach + a ];
+
+		m_approach[a].here.area = (approach->here == NAV_NO_INDEX) ? NULL : area[ approach->here ];
+		m_approach[a].prev.area = (approach->prev == NAV_NO_INDEX) ? NULL : area[ approach->prev ];
+		m_approach[a].next.area = (approach->next == NAV_NO_INDEX) ? NULL : area[ approach->next ];
+		m_approach[a].prevToHereHow = (NavTraverseType)approach->prevToHereHow;
+		m_approach[a].hereToNextHow = (NavTraverseType)approach->hereToNextHow;
+	}
+
+	// encounter paths
+	for( unsigned int e=0; e<data->encounterCount; ++e )
+	{
+		const NavFileEncounter *fileEncounter = &file->encounter[ data->firstEncounter + e ];
+
+		m_spotEncounterList.push_back( SpotEncounter() );
+		SpotEncounter *encounter = &m_spotEncounterList.back();
+
+		encounter->from.area = (fileEncounter->from == NAV_NO_INDEX) ? NULL : area[ fileEncounter->from ];
+		encounter->fromDir = static_cast<NavDirType>( fileEncounter->fromDir );
+		encounter->to.area = (fileEncounter->to == NAV_NO_INDEX) ? NULL : area[ fileEncounter->to ];
+		encounter->toDir = static_cast<NavDirType>( fileEncounter->toDir );
+
+		// the spot may be missing if the nav mesh was edited but not re-analyzed
+		for( unsigned int s=0; s<fileEncounter->spotOrderCount; ++s )
+		{
+			const NavFileSpotOrder *fileOrder = &file->spotOrder[ fileEncounter->firstSpotOrder + s ];
+
+			SpotOrder order;
+			order.spot = (fileOrder->spot == NAV_NO_INDEX) ? NULL : spot[ fileOrder->spot ];
+			order.t = fileOrder->t;
+
+			encounter->spotList.push_back( order );
+		}
+	}
+
+	SetPlace( placeDirectory.EntryToPlace( data->place ) );
+
+	return NAV_OK;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Compute the path segment of each spot encounter, once all areas are loaded
+ */
+void CNavArea::ComputeEncounterPaths( void )
+{
+	for( SpotEncounterList::iterator iter = m_spotEncounterList.begin(); iter != m_spotEncounterList.end(); ++iter )
+	{
+		SpotEncounter *e = &(*iter);
+
+		if (e->from.area == NULL || e->to.area == NULL)
+			continue;
+
+		float halfWidth;
+		ComputePortal( e->to.area, e->toDir, &e->path.to, &halfWidth );
+		ComputePortal( e->from.area, e->fromDir, &e->path.from, &halfWidth );
+
+		const float eyeHeight = HalfHumanHeight;
+		e->path.from.z = e->from.area->GetZ( &e->path.from ) + eyeHeight;
+		e->path.to.z = e->to.area->GetZ( &e->path.to ) + eyeHeight;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Find the areas that overlap this one, once all areas are loaded
+ * @todo Optimize this
+ */
+void CNavArea::BuildOverlapList( void )
+{
 	for( NavAreaList::iterator oiter = TheNavAreaList.begin(); oiter != TheNavAreaList.end(); ++oiter )
 	{
 		CNavArea *area = *oiter;
@@ -664,8 +632,117 @@ NavErrorType CNavArea::PostLoad( void )
 		if (IsOverlapping( area ))
 			m_overlapList.push_back( area );
 	}
+}
 
-	return error;
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Point 'section' at the next 'count' elements of the file, and advance 'cursor' past them.
+ * Sections start on 4 byte boundaries. Return false if the file is too short.
+ */
+template < typename T >
+static bool GetSection( const unsigned char **cursor, const unsigned char *end, unsigned int count, const T **section )
+{
+	unsigned long long size = (unsigned long long)count * sizeof(T);
+	size = (size + 3) & ~3ULL;
+
+	if (size > (unsigned long long)(end - *cursor))
+		return false;
+
+	*section = reinterpret_cast<const T *>( *cursor );
+	*cursor += size;
+
+	return true;
+}
+
+/// return true if [first, first+count) is within an array of 'size' elements
+inline bool IsValidRange( unsigned int first, unsigned int count, unsigned int size )
+{
+	return ((unsigned long long)first + count <= size) ? true : false;
+}
+
+/// return true if 'index' refers to an element of an array of 'size' elements, or to nothing
+inline bool IsValidIndex( unsigned int index, unsigned int size )
+{
+	return (index < size || index == NAV_NO_INDEX) ? true : false;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Find the sections of a version 6 nav file, and check that every index in it is in range,
+ * so that loading the file needs no further checks.
+ */
+bool NavFileSections::Parse( const unsigned char *data, unsigned int length )
+{
+	const unsigned char *cursor = data;
+	const unsigned char *end = data + length;
+
+	if (!GetSection( &cursor, end, 1, &header ))
+		return false;
+
+	if (!GetSection( &cursor, end, header->placeNameBytes, &placeNames ) ||
+		!GetSection( &cursor, end, header->areaCount, &area ) ||
+		!GetSection( &cursor, end, header->connectionCount, &connection ) ||
+		!GetSection( &cursor, end, header->hidingSpotCount, &hidingSpot ) ||
+		!GetSection( &cursor, end, header->approachCount, &approach ) ||
+		!GetSection( &cursor, end, header->encounterCount, &encounter ) ||
+		!GetSection( &cursor, end, header->spotOrderCount, &spotOrder ))
+		return false;
+
+	// there must be exactly one NUL terminated name per place
+	unsigned int nameCount = 0;
+	for( unsigned int c=0; c<header->placeNameBytes; ++c )
+		if (placeNames[c] == '\0')
+			++nameCount;
+
+	if (nameCount != header->placeCount || (header->placeNameBytes && placeNames[ header->placeNameBytes-1 ] != '\0'))
+		return false;
+
+	unsigned int i;
+	for( i=0; i<header->areaCount; ++i )
+	{
+		const NavFileArea *a = &area[i];
+
+		unsigned int connectionCount = 0;
+		for( int d=0; d<NUM_DIRECTIONS; ++d )
+			connectionCount += a->connectionCount[d];
+
+		if (!IsValidRange( a->firstConnection, connectionCount, header->connectionCount ) ||
+			!IsValidRange( a->firstHidingSpot, a->hidingSpotCount, header->hidingSpotCount ) ||
+			!IsValidRange( a->firstApproach, a->approachCount, header->approachCount ) ||
+			!IsValidRange( a->firstEncounter, a->encounterCount, header->encounterCount ) ||
+			a->place > header->placeCount)
+			return false;
+	}
+
+	for( i=0; i<header->connectionCount; ++i )
+		if (connection[i] >= header->areaCount)
+			return false;
+
+	for( i=0; i<header->approachCount; ++i )
+	{
+		const NavFileApproach *a = &approach[i];
+
+		if (!IsValidIndex( a->here, header->areaCount ) ||
+			!IsValidIndex( a->prev, header->areaCount ) ||
+			!IsValidIndex( a->next, header->areaCount ))
+			return false;
+	}
+
+	for( i=0; i<header->encounterCount; ++i )
+	{
+		const NavFileEncounter *e = &encounter[i];
+
+		if (!IsValidIndex( e->from, header->areaCount ) || !IsValidIndex( e->to, header->areaCount ) ||
+			e->fromDir >= NUM_DIRECTIONS || e->toDir >= NUM_DIRECTIONS ||
+			!IsValidRange( e->firstSpotOrder, e->spotOrderCount, header->spotOrderCount ))
+			return false;
+	}
+
+	for( i=0; i<header->spotOrderCount; ++i )
+		if (!IsValidIndex( spotOrder[i].spot, header->hidingSpotCount ))
+			return false;
+
+	return true;
 }
 
 
@@ -696,6 +773,213 @@ inline void COM_FixSlashes( char *pname )
 #endif
 }
 
+/**
+ * Write one array of a version 6 nav file, padded to a 4 byte boundary
+ */
+static bool WriteSection( int fd, const void *data, unsigned int size )
+{
+	if (size && _write( fd, data, size ) != (int)size)
+		return false;
+
+	static const char pad[3] = { 0, 0, 0 };
+	unsigned int padSize = (4 - (size & 3)) & 3;
+
+	if (padSize && _write( fd, pad, padSize ) != (int)padSize)
+		return false;
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Build the arrays of a version 6 nav file from the current nav mesh
+ */
+void BuildNavigationMapData( NavFileData *data )
+{
+	//
+	// Build a directory of the Places in this map
+	//
+	placeDirectory.Reset();
+
+	NavAreaList::iterator it;
+	for( it = TheNavAreaList.begin(); it != TheNavAreaList.end(); ++it )
+	{
+		CNavArea *area = *it;
+
+		Place place = area->GetPlace();
+
+		if (place)
+		{
+			placeDirectory.AddPlace( place );
+		}
+	}
+
+	std::vector< char > &placeNames = data->placeNames;
+	placeNames.clear();
+	placeDirectory.Save( &placeNames );
+
+
+	//
+	// Number the areas and the hiding spots, so they can refer to each other by index
+	//
+	std::map< const CNavArea *, unsigned int > areaIndex;
+	std::map< const HidingSpot *, unsigned int > spotIndex;
+
+	for( it = TheNavAreaList.begin(); it != TheNavAreaList.end(); ++it )
+	{
+		CNavArea *area = *it;
+
+		areaIndex.insert( std::make_pair( area, (unsigned int)areaIndex.size() ) );
+
+		for( HidingSpotList::iterator spotIter = area->m_hidingSpotList.begin(); spotIter != area->m_hidingSpotList.end(); ++spotIter )
+			spotIndex.insert( std::make_pair( *spotIter, (unsigned int)spotIndex.size() ) );
+	}
+
+
+	//
+	// Build the arrays
+	//
+	std::vector< NavFileArea > &areas = data->areas;
+	std::vector< unsigned int > &connections = data->connections;
+	std::vector< NavFileHidingSpot > &spots = data->spots;
+	std::vector< NavFileApproach > &approaches = data->approaches;
+	std::vector< NavFileEncounter > &encounters = data->encounters;
+	std::vector< NavFileSpotOrder > &spotOrders = data->spotOrders;
+
+	areas.clear();
+	connections.clear();
+	spots.clear();
+	approaches.clear();
+	encounters.clear();
+	spotOrders.clear();
+
+	areas.reserve( TheNavAreaList.size() );
+	spots.reserve( spotIndex.size() );
+
+	for( it = TheNavAreaList.begin(); it != TheNavAreaList.end(); ++it )
+	{
+		CNavArea *area = *it;
+
+		NavFileArea fileArea;
+		memset( &fileArea, 0, sizeof(fileArea) );
+
+		fileArea.id = area->m_id;
+		fileArea.attributeFlags = area->m_attributeFlags;
+
+		fileArea.extent[0] = area->m_extent.lo.x;
+		fileArea.extent[1] = area->m_extent.lo.y;
+		fileArea.extent[2] = area->m_extent.lo.z;
+		fileArea.extent[3] = area->m_extent.hi.x;
+		fileArea.extent[4] = area->m_extent.hi.y;
+		fileArea.extent[5] = area->m_extent.hi.z;
+
+		fileArea.neZ = area->m_neZ;
+		fileArea.swZ = area->m_swZ;
+
+		// connections to adjacent areas, in the enum order NORTH, EAST, SOUTH, WEST
+		fileArea.firstConnection = connections.size();
+		for( int d=0; d<NUM_DIRECTIONS; d++ )
+		{
+			fileArea.connectionCount[d] = area->m_connect[d].size();
+
+			for( NavConnectList::iterator iter = area->m_connect[d].begin(); iter != area->m_connect[d].end(); ++iter )
+				connections.push_back( areaIndex[ iter->area ] );
+		}
+
+		// hiding spots
+		fileArea.firstHidingSpot = spots.size();
+		fileArea.hidingSpotCount = area->m_hidingSpotList.size();
+
+		for( HidingSpotList::iterator spotIter = area->m_hidingSpotList.begin(); spotIter != area->m_hidingSpotList.end(); ++spotIter )
+		{
+			const HidingSpot *spot = *spotIter;
+
+			NavFileHidingSpot fileSpot;
+			memset( &fileSpot, 0, sizeof(fileSpot) );
+
+			fileSpot.id = spot->GetID();
+			fileSpot.pos[0] = spot->GetPosition()->x;
+			fileSpot.pos[1] = spot->GetPosition()->y;
+			fileSpot.pos[2] = spot->GetPosition()->z;
+			fileSpot.flags = spot->GetFlags();
+
+			spots.push_back( fileSpot );
+		}
+
+		// approach areas
+		fileArea.firstApproach = approaches.size();
+		fileArea.approachCount = area->m_approachCount;
+
+		for( int a=0; a<area->m_approachCount; ++a )
+		{
+			const CNavArea::ApproachInfo *info = &area->m_approach[a];
+
+			NavFileApproach approach;
+			memset( &approach, 0, sizeof(approach) );
+
+			approach.here = (info->here.area) ? areaIndex[ info->here.area ] : NAV_NO_INDEX;
+			approach.prev = (info->prev.area) ? areaIndex[ info->prev.area ] : NAV_NO_INDEX;
+			approach.next = (info->next.area) ? areaIndex[ info->next.area ] : NAV_NO_INDEX;
+			approach.prevToHereHow = (unsigned char)info->prevToHereHow;
+			approach.hereToNextHow = (unsigned char)info->hereToNextHow;
+
+			approaches.push_back( approach );
+		}
+
+		// encounter paths
+		fileArea.firstEncounter = encounters.size();
+		fileArea.encounterCount = area->m_spotEncounterList.size();
+
+		for( SpotEncounterList::iterator iter = area->m_spotEncounterList.begin(); iter != area->m_spotEncounterList.end(); ++iter )
+		{
+			const SpotEncounter *e = &(*iter);
+
+			NavFileEncounter encounter;
+			memset( &encounter, 0, sizeof(encounter) );
+
+			encounter.from = (e->from.area) ? areaIndex[ e->from.area ] : NAV_NO_INDEX;
+			encounter.to = (e->to.area) ? areaIndex[ e->to.area ] : NAV_NO_INDEX;
+			encounter.fromDir = (unsigned char)e->fromDir;
+			encounter.toDir = (unsigned char)e->toDir;
+			encounter.firstSpotOrder = spotOrders.size();
+			encounter.spotOrderCount = e->spotList.size();
+
+			for( SpotOrderList::const_iterator oiter = e->spotList.begin(); oiter != e->spotList.end(); ++oiter )
+			{
+				NavFileSpotOrder order;
+
+				// order->spot may be NULL if we've loaded a nav mesh that has been edited but not re-analyzed
+				std::map< const HidingSpot *, unsigned int >::const_iterator spotIter = spotIndex.find( oiter->spot );
+				order.spot = (spotIter != spotIndex.end()) ? spotIter->second : NAV_NO_INDEX;
+				order.t = oiter->t;
+
+				spotOrders.push_back( order );
+			}
+
+			encounters.push_back( encounter );
+		}
+
+		fileArea.place = placeDirectory.GetEntry( area->GetPlace() );
+
+		areas.push_back( fileArea );
+	}
+
+
+	//
+	// Fill in the header
+	//
+	NavFileHeader &header = data->header;
+	header.areaCount = areas.size();
+	header.connectionCount = connections.size();
+	header.hidingSpotCount = spots.size();
+	header.approachCount = approaches.size();
+	header.encounterCount = encounters.size();
+	header.spotOrderCount = spotOrders.size();
+	header.placeCount = placeDirectory.GetCount();
+	header.placeNameBytes = placeNames.size();
+}
+
+//--------------------------------------------------------------------------------------------------------------
 /**
  * Store AI navigation data to a file
  */
@@ -730,7 +1014,8 @@ bool SaveNavigationMap( const char *filename )
 	// 4 = Includes size of source bsp file to verify nav data correlation
 	// ---- Beta Release at V4 -----
 	// 5 = Added Place info
-	unsigned int version = 5;
+	// 6 = Flat arrays that refer to each other by index (see nav_file.h)
+	unsigned int version = NAV_VERSION;
 	_write( fd, &version, sizeof(unsigned int) );
 
 
@@ -747,44 +1032,25 @@ bool SaveNavigationMap( const char *filename )
 
 
 	//
-	// Build a directory of the Places in this map
+	// Store the header, followed by each array
 	//
-	placeDirectory.Reset();
-
-	NavAreaList::iterator it;
-	for( it = TheNavAreaList.begin(); it != TheNavAreaList.end(); ++it )
-	{
-		CNavArea *area = *it;
-
-		Place place = area->GetPlace();
-
-		if (place)
-		{
-			placeDirectory.AddPlace( place );
-		}
-	}
-
-	placeDirectory.Save( fd );
-
-
-	//
-	// Store navigation areas
-	//
-
-	// store number of areas
-	unsigned int count = TheNavAreaList.size();
-	_write( fd, &count, sizeof(unsigned int) );
-
-	// store each area
-	for( it = TheNavAreaList.begin(); it != TheNavAreaList.end(); ++it )
-	{
-		CNavArea *area = *it;
-
-		area->Save( fd, version );
-	}
+	NavFileData data;
+	BuildNavigationMapData( &data );
+
+	bool result = WriteSection( fd, &data.header, sizeof(data.header) ) &&
+				  WriteSection( fd, data.placeNames.data(), data.placeNames.size() ) &&
+				  WriteSection( fd, data.areas.data(), data.areas.size() * sizeof(NavFileArea) ) &&
+				  WriteSection( fd, data.connections.data(), data.connections.size() * sizeof(unsigned int) ) &&
+				  WriteSection( fd, data.spots.data(), data.spots.size() * sizeof(NavFileHidingSpot) ) &&
+				  WriteSection( fd, data.approaches.data(), data.approaches.size() * sizeof(NavFileApproach) ) &&
+				  WriteSection( fd, data.encounters.data(), data.encounters.size() * sizeof(NavFileEncounter) ) &&
+				  WriteSection( fd, data.spotOrders.data(), data.spotOrders.size() * sizeof(NavFileSpotOrder) );
 
 	_close( fd );
 
+	if (!result)
+		return false;
+
 
 #ifdef _WIN32
 	// output a simple Wavefront file to visualize the generated areas in 3DSMax
@@ -909,7 +1175,7 @@ void SanityCheckNavigationMap( const char *mapName )
 	// read file version number
 	unsigned int version;
 	result = navFile.Read( &version, sizeof(unsigned int) );
-	if (!result || version > 5)
+	if (!result || version > NAV_VERSION)
 	{
 		CONSOLE_ECHO( "ERROR: Unknown version in navigation file %s.\n", navFilename );
 		return;
@@ -942,26 +1208,138 @@ void SanityCheckNavigationMap( const char *mapName )
 
 //--------------------------------------------------------------------------------------------------------------
 /**
- * Load AI navigation data from a file
+ * Return the number of bytes allocated from the heap, or zero if it is not known on this platform
  */
-NavErrorType LoadNavigationMap( void )
+static size_t GetHeapUsage( void )
 {
-	// since the navigation map is destroyed on map change,
-	// if it exists it has already been loaded for this map
-	if (!TheNavAreaList.empty())
-		return NAV_OK;
+#if defined( _WIN32 )
+	size_t used = 0;
 
-	// nav filename is derived from map filename
-	char filename[256];
-	sprintf( filename, "maps\\%s.nav", STRING( gpGlobals->mapname ) );
+	_HEAPINFO info;
+	info._pentry = NULL;
+	while( _heapwalk( &info ) == _HEAPOK )
+	{
+		if (info._useflag == _USEDENTRY)
+			used += info._size;
+	}
 
+	return used;
+#elif defined( __GLIBC__ )
+#if __GLIBC_PREREQ( 2, 33 )
+	return mallinfo2().uordblks;
+#else
+	return (unsigned int)mallinfo().uordblks;
+#endif
+#else
+	return 0;
+#endif
+}
 
-	// free previous navigation map data
-	DestroyNavigationMap();
-	placeDirectory.Reset();
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Compute the total extent of the loaded areas, and add them to the grid
+ */
+static void AddNavAreasToGrid( void )
+{
+	Extent extent;
+	extent.lo.x = 9999999999.9f;
+	extent.lo.y = 9999999999.9f;
+	extent.hi.x = -9999999999.9f;
+	extent.hi.y = -9999999999.9f;
 
-	CNavArea::m_nextID = 1;
+	NavAreaList::iterator iter;
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+	{
+		CNavArea *area = *iter;
+
+		const Extent *areaExtent = area->GetExtent();
+
+		// check validity of nav area
+		if (areaExtent->lo.x >= areaExtent->hi.x || areaExtent->lo.y >= areaExtent->hi.y)
+			CONSOLE_ECHO( "WARNING: Degenerate Navigation Area #%d at ( %g, %g, %g )\n", 
+											area->GetID(), area->GetCenter()->x, area->GetCenter()->y, area->GetCenter()->z );
+
+		if (areaExtent->lo.x < extent.lo.x)
+			extent.lo.x = areaExtent->lo.x;
+		if (areaExtent->lo.y < extent.lo.y)
+			extent.lo.y = areaExtent->lo.y;
+		if (areaExtent->hi.x > extent.hi.x)
+			extent.hi.x = areaExtent->hi.x;
+		if (areaExtent->hi.y > extent.hi.y)
+			extent.hi.y = areaExtent->hi.y;
+	}
+
+	TheNavAreaGrid.Initialize( extent.lo.x, extent.hi.x, extent.lo.y, extent.hi.y );
+
+	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
+		TheNavAreaGrid.AddNavArea( *iter );
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Load the areas of a version 6 nav file, using the file's data in place.
+ * The hiding spots and the areas are each allocated as one block, and refer to each other by index,
+ * so there are no IDs to resolve afterwards.
+ */
+static NavErrorType LoadNavigationSections( SteamFile *navFile, const char *filename )
+{
+	NavFileSections file;
+	if (!file.Parse( navFile->GetCursor(), navFile->GetBytesLeft() ))
+	{
+		CONSOLE_ECHO( "ERROR: Corrupt navigation file '%s'.\n", filename );
+		return NAV_CORRUPT_DATA;
+	}
 
+	const NavFileHeader *header = file.header;
+
+	// load Place directory
+	placeDirectory.Load( file.placeNames, header->placeCount );
+
+	// create all of the hiding spots and areas first, so they can be found by index
+	std::vector< HidingSpot * > spot( header->hidingSpotCount );
+	std::vector< CNavArea * > area( header->areaCount );
+
+	HidingSpot::ReserveBulkStorage( header->hidingSpotCount );
+	for( unsigned int h=0; h<header->hidingSpotCount; ++h )
+	{
+		spot[h] = new HidingSpot;
+		spot[h]->Load( &file.hidingSpot[h] );
+	}
+
+	CNavArea::ReserveBulkStorage( header->areaCount );
+	for( unsigned int i=0; i<header->areaCount; ++i )
+	{
+		area[i] = new CNavArea;
+		TheNavAreaList.push_back( area[i] );
+	}
+
+	for( unsigned int i=0; i<header->areaCount; ++i )
+	{
+		NavErrorType error = area[i]->Load( &file, i, area.data(), spot.data() );
+		if (error != NAV_OK)
+		{
+			DestroyNavigationMap();
+			return error;
+		}
+	}
+
+	AddNavAreasToGrid();
+
+	for( unsigned int i=0; i<header->areaCount; ++i )
+	{
+		area[i]->ComputeEncounterPaths();
+		area[i]->BuildOverlapList();
+	}
+
+	return NAV_OK;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Load the nav file, returning its version in 'version'
+ */
+static NavErrorType LoadNavigationFile( const char *filename, unsigned int *version )
+{
 	SteamFile navFile( filename );
 
 	if (!navFile.IsValid())
@@ -978,15 +1356,14 @@ NavErrorType LoadNavigationMap( void )
 	}
 
 	// read file version number
-	unsigned int version;
-	result = navFile.Read( &version, sizeof(unsigned int) );
-	if (!result || version > 5)
+	result = navFile.Read( version, sizeof(unsigned int) );
+	if (!result || *version > NAV_VERSION)
 	{
 		CONSOLE_ECHO( "ERROR: Unknown navigation file version.\n" );
 		return NAV_BAD_FILE_VERSION;
 	}
 
-	if (version >= 4)
+	if (*version >= 4)
 	{
 		// get size of source bsp file and verify that the bsp hasn't changed
 		unsigned int saveBspSize;
@@ -1010,8 +1387,11 @@ NavErrorType LoadNavigationMap( void )
 		}
 	}
 
+	if (*version >= 6)
+		return LoadNavigationSections( &navFile, filename );
+
 	// load Place directory
-	if (version >= 5)
+	if (*version >= 5)
 	{
 		placeDirectory.Load( &navFile );
 	}
@@ -1020,45 +1400,19 @@ NavErrorType LoadNavigationMap( void )
 	unsigned int count;
 	result = navFile.Read( &count, sizeof(unsigned int) );
 
-	Extent extent;
-	extent.lo.x = 9999999999.9f;
-	extent.lo.y = 9999999999.9f;
-	extent.hi.x = -9999999999.9f;
-	extent.hi.y = -9999999999.9f;
-
-	// load the areas and compute total extent
+	// load the areas
 	for( unsigned int i=0; i<count; ++i )
 	{
 		CNavArea *area = new CNavArea;
-		area->Load( &navFile, version );
+		area->Load( &navFile, *version );
 		TheNavAreaList.push_back( area );
-
-		const Extent *areaExtent = area->GetExtent();
-
-		// check validity of nav area
-		if (areaExtent->lo.x >= areaExtent->hi.x || areaExtent->lo.y >= areaExtent->hi.y)
-			CONSOLE_ECHO( "WARNING: Degenerate Navigation Area #%d at ( %g, %g, %g )\n", 
-											area->GetID(), area->m_center.x, area->m_center.y, area->m_center.z );
-
-		if (areaExtent->lo.x < extent.lo.x)
-			extent.lo.x = areaExtent->lo.x;
-		if (areaExtent->lo.y < extent.lo.y)
-			extent.lo.y = areaExtent->lo.y;
-		if (areaExtent->hi.x > extent.hi.x)
-			extent.hi.x = areaExtent->hi.x;
-		if (areaExtent->hi.y > extent.hi.y)
-			extent.hi.y = areaExtent->hi.y;
 	}
 
 	// add the areas to the grid
-	TheNavAreaGrid.Initialize( extent.lo.x, extent.hi.x, extent.lo.y, extent.hi.y );
-
-	NavAreaList::iterator iter;
-	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
-		TheNavAreaGrid.AddNavArea( *iter );
-
+	AddNavAreasToGrid();
 
 	// allow areas to connect to each other, etc
+	NavAreaList::iterator iter;
 	for( iter = TheNavAreaList.begin(); iter != TheNavAreaList.end(); ++iter )
 	{
 		CNavArea *area = *iter;
@@ -1066,15 +1420,58 @@ NavErrorType LoadNavigationMap( void )
 	}
 
 	// load legacy location file (Places)
-	if (version < 5)
+	if (*version < 5)
 	{
 		LoadLocationFile( filename );
 	}
 
+	return NAV_OK;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+/**
+ * Load AI navigation data from a file
+ */
+NavErrorType LoadNavigationMap( void )
+{
+	// since the navigation map is destroyed on map change,
+	// if it exists it has already been loaded for this map
+	if (!TheNavAreaList.empty())
+		return NAV_OK;
+
+	// nav filename is derived from map filename
+	char filename[256];
+	sprintf( filename, "maps\\%s.nav", STRING( gpGlobals->mapname ) );
+
+
+	// free previous navigation map data
+	DestroyNavigationMap();
+	placeDirectory.Reset();
+
+	CNavArea::m_nextID = 1;
+
+	// measure the cost of loading, so the file versions can be compared
+	size_t startHeap = GetHeapUsage();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	unsigned int version = 0;
+	NavErrorType error = LoadNavigationFile( filename, &version );
+	if (error != NAV_OK)
+		return error;
+
 	//
 	// Set up all the ladders
 	//
 	BuildLadders();
 
+	CNavArea::UpdateCompactAdjacency();
+
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+	size_t endHeap = GetHeapUsage();
+
+	CONSOLE_ECHO( "Loaded %d navigation areas and %d hiding spots from version %u nav file in %.1f ms, using %u KB of heap.\n",
+					(int)TheNavAreaList.size(), (int)TheHidingSpotList.size(), version, 1000.0f * elapsed.count(),
+					(endHeap > startHeap) ? (unsigned int)((endHeap - startHeap) / 1024) : 0 );
+
 	return NAV_OK;
 }
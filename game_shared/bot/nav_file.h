@@ -0,0 +1,129 @@
+// nav_file.h
+// Layout of version 6 nav files
+//
+// Version 6 files are a header followed by flat arrays. Areas, hiding spots and spot encounters refer to
+// each other by index into these arrays instead of by ID, so a file can be used in place once it has been
+// read into memory, without parsing it field by field. Each array starts on a 4 byte boundary.
+//
+//   magic, version, bsp size		unsigned int x 3
+//   NavFileHeader
+//   place names					'placeCount' strings, each NUL terminated - 'placeNameBytes' bytes in all, padded to 4 bytes
+//   NavFileArea[ areaCount ]
+//   unsigned int[ connectionCount ]	area index of each connection
+//   NavFileHidingSpot[ hidingSpotCount ]
+//   NavFileApproach[ approachCount ]
+//   NavFileEncounter[ encounterCount ]
+//   NavFileSpotOrder[ spotOrderCount ]
+
+#ifndef _NAV_FILE_H_
+#define _NAV_FILE_H_
+
+#include <vector>
+
+#include "nav.h"
+
+#define NAV_NO_INDEX 0xFFFFFFFF							///< an index that refers to nothing
+
+struct NavFileHeader
+{
+	unsigned int areaCount;
+	unsigned int connectionCount;
+	unsigned int hidingSpotCount;
+	unsigned int approachCount;
+	unsigned int encounterCount;
+	unsigned int spotOrderCount;
+	unsigned int placeCount;
+	unsigned int placeNameBytes;						///< size of the place names, not including padding
+};
+
+struct NavFileArea
+{
+	unsigned int id;
+	float extent[6];									///< lo.x, lo.y, lo.z, hi.x, hi.y, hi.z
+	float neZ, swZ;										///< heights of the implicit corners
+
+	unsigned int firstConnection;						///< connections in the order NORTH, EAST, SOUTH, WEST
+	unsigned short connectionCount[ NUM_DIRECTIONS ];
+
+	unsigned int firstHidingSpot;
+	unsigned int hidingSpotCount;
+
+	unsigned int firstApproach;
+	unsigned int firstEncounter;
+	unsigned int encounterCount;
+
+	unsigned short place;								///< place directory entry, 0 = no place
+	unsigned char attributeFlags;
+	unsigned char approachCount;
+};
+
+struct NavFileHidingSpot
+{
+	unsigned int id;
+	float pos[3];
+	unsigned char flags;
+	unsigned char pad[3];
+};
+
+struct NavFileApproach
+{
+	unsigned int here;									///< area indices - may be NAV_NO_INDEX
+	unsigned int prev;
+	unsigned int next;
+	unsigned char prevToHereHow;
+	unsigned char hereToNextHow;
+	unsigned char pad[2];
+};
+
+struct NavFileEncounter
+{
+	unsigned int from;									///< area indices - may be NAV_NO_INDEX
+	unsigned int to;
+	unsigned char fromDir;
+	unsigned char toDir;
+	unsigned char pad[2];
+	unsigned int firstSpotOrder;
+	unsigned int spotOrderCount;
+};
+
+struct NavFileSpotOrder
+{
+	unsigned int spot;									///< hiding spot index - may be NAV_NO_INDEX
+	float t;
+};
+
+/**
+ * The arrays of a version 6 nav file, pointing into the file's data
+ */
+struct NavFileSections
+{
+	const NavFileHeader *header;
+	const char *placeNames;
+	const NavFileArea *area;
+	const unsigned int *connection;
+	const NavFileHidingSpot *hidingSpot;
+	const NavFileApproach *approach;
+	const NavFileEncounter *encounter;
+	const NavFileSpotOrder *spotOrder;
+
+	bool Parse( const unsigned char *data, unsigned int length );	///< 'data' starts after the bsp size - return false if the file is truncated or any index is out of range
+};
+
+/**
+ * The arrays of a version 6 nav file, built from the current nav mesh
+ */
+struct NavFileData
+{
+	NavFileHeader header;
+	std::vector< char > placeNames;
+	std::vector< NavFileArea > areas;
+	std::vector< unsigned int > connections;
+	std::vector< NavFileHidingSpot > spots;
+	std::vector< NavFileApproach > approaches;
+	std::vector< NavFileEncounter > encounters;
+	std::vector< NavFileSpotOrder > spotOrders;
+};
+
+extern void BuildNavigationMapData( NavFileData *data );	///< fill in the arrays that SaveNavigationMap() writes
+
+#endif // _NAV_FILE_H_
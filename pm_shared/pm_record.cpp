@@ -0,0 +1,912 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "extdll.h"
+
+#include "usercmd.h"
+#include "pm_defs.h"
+#include "pm_movevars.h"
+
+#include "com_model.h"
+
+#include "pm_record.h"
+
+namespace
+{
+enum class FieldType
+{
+	INT,
+	FLOAT,
+	VECTOR,
+	CHAR,
+	STRING
+};
+
+struct StateField
+{
+	const char* pszName;
+	FieldType type;
+	size_t uiStateOffset;
+	size_t uiMoveOffset;
+	size_t uiSize;
+};
+
+#define STATE_FIELD( name, type ) { #name, FieldType::type, offsetof( PMoveRecordState, name ), offsetof( playermove_t, name ), sizeof( PMoveRecordState::name ) }
+
+const StateField g_StateFields[] =
+{
+	STATE_FIELD( time, FLOAT ),
+	STATE_FIELD( frametime, FLOAT ),
+	STATE_FIELD( origin, VECTOR ),
+	STATE_FIELD( angles, VECTOR ),
+	STATE_FIELD( oldangles, VECTOR ),
+	STATE_FIELD( velocity, VECTOR ),
+	STATE_FIELD( movedir, VECTOR ),
+	STATE_FIELD( basevelocity, VECTOR ),
+	STATE_FIELD( view_ofs, VECTOR ),
+	STATE_FIELD( flDuckTime, FLOAT ),
+	STATE_FIELD( bInDuck, INT ),
+	STATE_FIELD( flTimeStepSound, INT ),
+	STATE_FIELD( iStepLeft, INT ),
+	STATE_FIELD( flFallVelocity, FLOAT ),
+	STATE_FIELD( punchangle, VECTOR ),
+	STATE_FIELD( flSwimTime, FLOAT ),
+	STATE_FIELD( flNextPrimaryAttack, FLOAT ),
+	STATE_FIELD( effects, INT ),
+	STATE_FIELD( flags, INT ),
+	STATE_FIELD( usehull, INT ),
+	STATE_FIELD( gravity, FLOAT ),
+	STATE_FIELD( friction, FLOAT ),
+	STATE_FIELD( oldbuttons, INT ),
+	STATE_FIELD( waterjumptime, FLOAT ),
+	STATE_FIELD( dead, INT ),
+	STATE_FIELD( deadflag, INT ),
+	STATE_FIELD( spectator, INT ),
+	STATE_FIELD( movetype, INT ),
+	STATE_FIELD( onground, INT ),
+	STATE_FIELD( waterlevel, INT ),
+	STATE_FIELD( watertype, INT ),
+	STATE_FIELD( oldwaterlevel, INT ),
+	STATE_FIELD( sztexturename, STRING ),
+	STATE_FIELD( chtexturetype, CHAR ),
+	STATE_FIELD( maxspeed, FLOAT ),
+	STATE_FIELD( clientmaxspeed, FLOAT ),
+	STATE_FIELD( iuser1, INT ),
+	STATE_FIELD( iuser2, INT ),
+	STATE_FIELD( iuser3, INT ),
+	STATE_FIELD( iuser4, INT ),
+	STATE_FIELD( fuser1, FLOAT ),
+	STATE_FIELD( fuser2, FLOAT ),
+	STATE_FIELD( fuser3, FLOAT ),
+	STATE_FIELD( fuser4, FLOAT ),
+	STATE_FIELD( vuser1, VECTOR ),
+	STATE_FIELD( vuser2, VECTOR ),
+	STATE_FIELD( vuser3, VECTOR ),
+	STATE_FIELD( vuser4, VECTOR ),
+	STATE_FIELD( numtouch, INT ),
+};
+
+#undef STATE_FIELD
+
+/**
+*	Numeric movevars, in the order they're written. The sky name is written after them.
+*/
+const size_t g_MoveVarsFloats[] =
+{
+	offsetof( movevars_t, gravity ),
+	offsetof( movevars_t, stopspeed ),
+	offsetof( movevars_t, maxspeed ),
+	offsetof( movevars_t, spectatormaxspeed ),
+	offsetof( movevars_t, accelerate ),
+	offsetof( movevars_t, airaccelerate ),
+	offsetof( movevars_t, wateraccelerate ),
+	offsetof( movevars_t, friction ),
+	offsetof( movevars_t, edgefriction ),
+	offsetof( movevars_t, waterfriction ),
+	offsetof( movevars_t, entgravity ),
+	offsetof( movevars_t, bounce ),
+	offsetof( movevars_t, stepsize ),
+	offsetof( movevars_t, maxvelocity ),
+	offsetof( movevars_t, zmax ),
+	offsetof( movevars_t, waveHeight ),
+	offsetof( movevars_t, rollangle ),
+	offsetof( movevars_t, rollspeed ),
+	offsetof( movevars_t, skycolor_r ),
+	offsetof( movevars_t, skycolor_g ),
+	offsetof( movevars_t, skycolor_b ),
+	offsetof( movevars_t, skyvec_x ),
+	offsetof( movevars_t, skyvec_y ),
+	offsetof( movevars_t, skyvec_z ),
+};
+
+/**
+*	Marks an empty string, so every value is one token.
+*/
+const char EMPTY_STRING[] = "-";
+
+const char* StringOrEmpty( const char* pszString )
+{
+	return *pszString ? pszString : EMPTY_STRING;
+}
+
+void CopyString( char* pszDest, const size_t uiSize, const std::string& szSource )
+{
+	if( szSource == EMPTY_STRING )
+	{
+		*pszDest = '\0';
+		return;
+	}
+
+	strncpy( pszDest, szSource.c_str(), uiSize - 1 );
+	pszDest[ uiSize - 1 ] = '\0';
+}
+
+void WriteVector( FILE* pFile, const Vector& vec )
+{
+	fprintf( pFile, " %.9g %.9g %.9g", vec.x, vec.y, vec.z );
+}
+
+void WriteState( FILE* pFile, const char* const pszName, const PMoveRecordState& state )
+{
+	fputs( pszName, pFile );
+
+	for( const auto& field : g_StateFields )
+	{
+		const byte* pData = reinterpret_cast<const byte*>( &state ) + field.uiStateOffset;
+
+		switch( field.type )
+		{
+		case FieldType::INT:	fprintf( pFile, " %d", *reinterpret_cast<const int*>( pData ) ); break;
+		case FieldType::FLOAT:	fprintf( pFile, " %.9g", *reinterpret_cast<const float*>( pData ) ); break;
+		case FieldType::VECTOR:	WriteVector( pFile, *reinterpret_cast<const Vector*>( pData ) ); break;
+		case FieldType::CHAR:	fprintf( pFile, " %d", *reinterpret_cast<const char*>( pData ) ); break;
+		case FieldType::STRING:	fprintf( pFile, " %s", StringOrEmpty( reinterpret_cast<const char*>( pData ) ) ); break;
+		}
+	}
+
+	fputc( '\n', pFile );
+}
+
+void WritePhysEnts( FILE* pFile, const char* const pszName, const std::vector<PMoveRecordPhysEnt>& list )
+{
+	for( const auto& ent : list )
+	{
+		fprintf( pFile, "%s %s %s %d", pszName, StringOrEmpty( ent.szModel ), StringOrEmpty( ent.name ), ent.player );
+		WriteVector( pFile, ent.origin );
+		WriteVector( pFile, ent.mins );
+		WriteVector( pFile, ent.maxs );
+		WriteVector( pFile, ent.angles );
+		WriteVector( pFile, ent.velocity );
+		fprintf( pFile, " %d %d %d %d %d\n", ent.info, ent.solid, ent.skin, ent.rendermode, ent.movetype );
+	}
+}
+
+/**
+*	Reads whitespace separated values from a line.
+*/
+class CLineParser final
+{
+public:
+	explicit CLineParser( const char* pszLine )
+		: m_pszCursor( pszLine )
+	{
+	}
+
+	bool Token( std::string& szToken )
+	{
+		while( *m_pszCursor && isspace( static_cast<unsigned char>( *m_pszCursor ) ) )
+			++m_pszCursor;
+
+		const char* pszStart = m_pszCursor;
+
+		while( *m_pszCursor && !isspace( static_cast<unsigned char>( *m_pszCursor ) ) )
+			++m_pszCursor;
+
+		szToken.assign( pszStart, m_pszCursor );
+
+		return !szToken.empty();
+	}
+
+	bool Int( int& iValue )
+	{
+		if( !Token( m_szToken ) )
+			return false;
+
+		char* pszEnd;
+		iValue = strtol( m_szToken.c_str(), &pszEnd, 10 );
+
+		return *pszEnd == '\0';
+	}
+
+	bool Float( float& flValue )
+	{
+		if( !Token( m_szToken ) )
+			return false;
+
+		char* pszEnd;
+		flValue = strtof( m_szToken.c_str(), &pszEnd );
+
+		return *pszEnd == '\0';
+	}
+
+	bool Double( double& flValue )
+	{
+		if( !Token( m_szToken ) )
+			return false;
+
+		char* pszEnd;
+		flValue = strtod( m_szToken.c_str(), &pszEnd );
+
+		return *pszEnd == '\0';
+	}
+
+	bool Vec( Vector& vec )
+	{
+		return Float( vec.x ) && Float( vec.y ) && Float( vec.z );
+	}
+
+	/**
+	*	@return The rest of the line, without the separating space.
+	*/
+	const char* Rest()
+	{
+		if( *m_pszCursor == ' ' )
+			++m_pszCursor;
+
+		return m_pszCursor;
+	}
+
+	bool AtEnd()
+	{
+		return !Token( m_szToken );
+	}
+
+private:
+	const char* m_pszCursor;
+	std::string m_szToken;
+};
+
+bool ReadPhysEnt( CLineParser& parser, PMoveRecordPhysEnt& ent )
+{
+	std::string szToken;
+
+	if( !parser.Token( szToken ) )
+		return false;
+
+	CopyString( ent.szModel, sizeof( ent.szModel ), szToken );
+
+	if( !parser.Token( szToken ) )
+		return false;
+
+	CopyString( ent.name, sizeof( ent.name ), szToken );
+
+	return parser.Int( ent.player ) &&
+		parser.Vec( ent.origin ) &&
+		parser.Vec( ent.mins ) &&
+		parser.Vec( ent.maxs ) &&
+		parser.Vec( ent.angles ) &&
+		parser.Vec( ent.velocity ) &&
+		parser.Int( ent.info ) &&
+		parser.Int( ent.solid ) &&
+		parser.Int( ent.skin ) &&
+		parser.Int( ent.rendermode ) &&
+		parser.Int( ent.movetype ) &&
+		parser.AtEnd();
+}
+
+void ClearState( PMoveRecordState& state )
+{
+	for( const auto& field : g_StateFields )
+	{
+		memset( reinterpret_cast<byte*>( &state ) + field.uiStateOffset, 0, field.uiSize );
+	}
+}
+
+bool ReadState( CLineParser& parser, const std::vector<size_t>& fields, PMoveRecordState& state )
+{
+	ClearState( state );
+
+	std::string szToken;
+
+	for( auto uiField : fields )
+	{
+		const auto& field = g_StateFields[ uiField ];
+
+		byte* pData = reinterpret_cast<byte*>( &state ) + field.uiStateOffset;
+
+		bool bSuccess = false;
+
+		switch( field.type )
+		{
+		case FieldType::INT:	bSuccess = parser.Int( *reinterpret_cast<int*>( pData ) ); break;
+		case FieldType::FLOAT:	bSuccess = parser.Float( *reinterpret_cast<float*>( pData ) ); break;
+		case FieldType::VECTOR:	bSuccess = parser.Vec( *reinterpret_cast<Vector*>( pData ) ); break;
+
+		case FieldType::CHAR:
+			{
+				int iValue = 0;
+				bSuccess = parser.Int( iValue );
+				*reinterpret_cast<char*>( pData ) = static_cast<char>( iValue );
+				break;
+			}
+
+		case FieldType::STRING:
+			{
+				bSuccess = parser.Token( szToken );
+
+				if( bSuccess )
+					CopyString( reinterpret_cast<char*>( pData ), field.uiSize, szToken );
+
+				break;
+			}
+		}
+
+		if( !bSuccess )
+			return false;
+	}
+
+	return parser.AtEnd();
+}
+}
+
+void PM_SaveRecordState( const playermove_t& pmove, PMoveRecordState& state )
+{
+	for( const auto& field : g_StateFields )
+	{
+		memcpy( reinterpret_cast<byte*>( &state ) + field.uiStateOffset, reinterpret_cast<const byte*>( &pmove ) + field.uiMoveOffset, field.uiSize );
+	}
+}
+
+void PM_RestoreRecordState( const PMoveRecordState& state, playermove_t& pmove )
+{
+	for( const auto& field : g_StateFields )
+	{
+		memcpy( reinterpret_cast<byte*>( &pmove ) + field.uiMoveOffset, reinterpret_cast<const byte*>( &state ) + field.uiStateOffset, field.uiSize );
+	}
+}
+
+PMoveRecordDifference PM_CompareRecordStates( const PMoveRecordState& lhs, const PMoveRecordState& rhs )
+{
+	PMoveRecordDifference difference;
+
+	for( const auto& field : g_StateFields )
+	{
+		const byte* pLHS = reinterpret_cast<const byte*>( &lhs ) + field.uiStateOffset;
+		const byte* pRHS = reinterpret_cast<const byte*>( &rhs ) + field.uiStateOffset;
+
+		float flDifference = 0;
+
+		switch( field.type )
+		{
+		case FieldType::FLOAT:
+			{
+				flDifference = fabs( *reinterpret_cast<const float*>( pLHS ) - *reinterpret_cast<const float*>( pRHS ) );
+				break;
+			}
+
+		case FieldType::VECTOR:
+			{
+				const auto& vecLHS = *reinterpret_cast<const Vector*>( pLHS );
+				const auto& vecRHS = *reinterpret_cast<const Vector*>( pRHS );
+
+				for( int i = 0; i < 3; ++i )
+					flDifference = max( flDifference, static_cast<float>( fabs( vecLHS[ i ] - vecRHS[ i ] ) ) );
+
+				break;
+			}
+
+		case FieldType::STRING:
+			{
+				if( strncmp( reinterpret_cast<const char*>( pLHS ), reinterpret_cast<const char*>( pRHS ), field.uiSize ) )
+					flDifference = std::numeric_limits<float>::infinity();
+
+				break;
+			}
+
+		default:
+			{
+				if( memcmp( pLHS, pRHS, field.uiSize ) )
+					flDifference = std::numeric_limits<float>::infinity();
+
+				break;
+			}
+		}
+
+		//NaN never compares as larger, treat it as a mismatch.
+		if( flDifference != flDifference )
+			flDifference = std::numeric_limits<float>::infinity();
+
+		if( flDifference > difference.flDifference )
+		{
+			difference.pszField = field.pszName;
+			difference.flDifference = flDifference;
+		}
+	}
+
+	return difference;
+}
+
+void PM_SaveRecordPhysEnts( const physent_t* pPhysEnts, const int iCount, std::vector<PMoveRecordPhysEnt>& list )
+{
+	list.resize( iCount );
+
+	for( int i = 0; i < iCount; ++i )
+	{
+		const auto& pe = pPhysEnts[ i ];
+		auto& ent = list[ i ];
+
+		if( pe.model )
+		{
+			strncpy( ent.szModel, pe.model->name, sizeof( ent.szModel ) );
+			ent.szModel[ sizeof( ent.szModel ) - 1 ] = '\0';
+		}
+		else
+		{
+			ent.szModel[ 0 ] = '\0';
+		}
+
+		strncpy( ent.name, pe.name, sizeof( ent.name ) );
+		ent.name[ sizeof( ent.name ) - 1 ] = '\0';
+
+		ent.player = pe.player;
+		ent.origin = pe.origin;
+		ent.mins = pe.mins;
+		ent.maxs = pe.maxs;
+		ent.angles = pe.angles;
+		ent.velocity = Vector( 0, 0, 0 );
+		ent.info = pe.info;
+		ent.solid = pe.solid;
+		ent.skin = pe.skin;
+		ent.rendermode = pe.rendermode;
+		ent.movetype = pe.movetype;
+	}
+}
+
+void PM_SaveRecordFrame( const playermove_t& pmove, PMoveRecordFrame& frame )
+{
+	frame.iPlayerIndex = pmove.player_index;
+	frame.bServer = pmove.server;
+	frame.bMultiplayer = pmove.multiplayer;
+	frame.bRunFuncs = pmove.runfuncs;
+
+	frame.movevars = *pmove.movevars;
+
+	strncpy( frame.szPhysInfo, pmove.physinfo, sizeof( frame.szPhysInfo ) );
+	frame.szPhysInfo[ sizeof( frame.szPhysInfo ) - 1 ] = '\0';
+
+	frame.cmd = pmove.cmd;
+
+	PM_SaveRecordPhysEnts( pmove.physents, pmove.numphysent, frame.PhysEnts );
+	PM_SaveRecordPhysEnts( pmove.moveents, pmove.nummoveent, frame.MoveEnts );
+
+	frame.RandomLongs.clear();
+	frame.FloatTimes.clear();
+
+	PM_SaveRecordState( pmove, frame.Pre );
+}
+
+CPMoveRecordWriter::~CPMoveRecordWriter()
+{
+	Close();
+}
+
+bool CPMoveRecordWriter::Open( const char* const pszFileName, const PMoveRecordHeader& header )
+{
+	Close();
+
+	m_pFile = fopen( pszFileName, "w" );
+
+	if( !m_pFile )
+		return false;
+
+	m_uiFrames = 0;
+	m_bWroteMoveVars = false;
+	m_szPhysInfo.clear();
+
+	fprintf( m_pFile, "pmoverecord %d\n", PM_RECORD_VERSION );
+	fprintf( m_pFile, "map %s\n", StringOrEmpty( header.szMapName ) );
+
+	for( int iHull = 0; iHull < 4; ++iHull )
+	{
+		fprintf( m_pFile, "hull %d", iHull );
+		WriteVector( m_pFile, header.player_mins[ iHull ] );
+		WriteVector( m_pFile, header.player_maxs[ iHull ] );
+		fputc( '\n', m_pFile );
+	}
+
+	fputs( "state", m_pFile );
+
+	for( const auto& field : g_StateFields )
+	{
+		fprintf( m_pFile, " %s", field.pszName );
+	}
+
+	fputc( '\n', m_pFile );
+
+	return true;
+}
+
+void CPMoveRecordWriter::Close()
+{
+	if( m_pFile )
+	{
+		fclose( m_pFile );
+		m_pFile = nullptr;
+	}
+}
+
+void CPMoveRecordWriter::WriteFrame( const PMoveRecordFrame& frame )
+{
+	if( !m_pFile )
+		return;
+
+	fprintf( m_pFile, "frame %d %d %d %d\n", frame.iPlayerIndex, frame.bServer, frame.bMultiplayer, frame.bRunFuncs );
+
+	if( !m_bWroteMoveVars || memcmp( &m_MoveVars, &frame.movevars, sizeof( movevars_t ) ) )
+	{
+		m_bWroteMoveVars = true;
+		m_MoveVars = frame.movevars;
+
+		fputs( "movevars", m_pFile );
+
+		for( auto uiOffset : g_MoveVarsFloats )
+		{
+			fprintf( m_pFile, " %.9g", *reinterpret_cast<const float*>( reinterpret_cast<const byte*>( &frame.movevars ) + uiOffset ) );
+		}
+
+		char szSkyName[ sizeof( frame.movevars.skyName ) ];
+		strncpy( szSkyName, frame.movevars.skyName, sizeof( szSkyName ) );
+		szSkyName[ sizeof( szSkyName ) - 1 ] = '\0';
+
+		fprintf( m_pFile, " %d %s\n", frame.movevars.footsteps, StringOrEmpty( szSkyName ) );
+	}
+
+	if( m_uiFrames == 0 || m_szPhysInfo != frame.szPhysInfo )
+	{
+		m_szPhysInfo = frame.szPhysInfo;
+
+		fprintf( m_pFile, "physinfo %s\n", frame.szPhysInfo );
+	}
+
+	const auto& cmd = frame.cmd;
+
+	fprintf( m_pFile, "cmd %d %d", cmd.lerp_msec, cmd.msec );
+	WriteVector( m_pFile, cmd.viewangles );
+	fprintf( m_pFile, " %.9g %.9g %.9g %d %d %d %d %d", cmd.forwardmove, cmd.sidemove, cmd.upmove, cmd.lightlevel, cmd.buttons, cmd.impulse, cmd.weaponselect, cmd.impact_index );
+	WriteVector( m_pFile, cmd.impact_position );
+	fputc( '\n', m_pFile );
+
+	WritePhysEnts( m_pFile, "physent", frame.PhysEnts );
+	WritePhysEnts( m_pFile, "moveent", frame.MoveEnts );
+
+	WriteState( m_pFile, "pre", frame.Pre );
+
+	fprintf( m_pFile, "random %u", static_cast<unsigned int>( frame.RandomLongs.size() ) );
+
+	for( auto iValue : frame.RandomLongs )
+	{
+		fprintf( m_pFile, " %d", iValue );
+	}
+
+	fprintf( m_pFile, "\nfloattime %u", static_cast<unsigned int>( frame.FloatTimes.size() ) );
+
+	for( auto flValue : frame.FloatTimes )
+	{
+		fprintf( m_pFile, " %.17g", flValue );
+	}
+
+	fputc( '\n', m_pFile );
+
+	WriteState( m_pFile, "post", frame.Post );
+
+	fputs( "end\n", m_pFile );
+
+	++m_uiFrames;
+}
+
+CPMoveRecordReader::~CPMoveRecordReader()
+{
+	Close();
+}
+
+bool CPMoveRecordReader::Open( const char* const pszFileName, PMoveRecordHeader& header )
+{
+	Close();
+
+	m_uiLine = 0;
+	m_szError.clear();
+	m_StateFields.clear();
+	m_szPhysInfo.clear();
+	memset( &m_MoveVars, 0, sizeof( m_MoveVars ) );
+
+	m_pFile = fopen( pszFileName, "r" );
+
+	if( !m_pFile )
+		return Fail( "couldn't open \"%s\"", pszFileName );
+
+	std::string szToken;
+
+	{
+		if( !ReadLine() )
+			return Fail( "empty file" );
+
+		CLineParser parser( m_szLine.c_str() );
+
+		int iVersion;
+
+		if( !parser.Token( szToken ) || szToken != "pmoverecord" || !parser.Int( iVersion ) )
+			return Fail( "not a player movement recording" );
+
+		if( iVersion != PM_RECORD_VERSION )
+			return Fail( "version %d, expected %d", iVersion, PM_RECORD_VERSION );
+	}
+
+	{
+		if( !ReadLine() )
+			return Fail( "missing map" );
+
+		CLineParser parser( m_szLine.c_str() );
+
+		if( !parser.Token( szToken ) || szToken != "map" || !parser.Token( szToken ) )
+			return Fail( "missing map" );
+
+		CopyString( header.szMapName, sizeof( header.szMapName ), szToken );
+	}
+
+	for( int iHull = 0; iHull < 4; ++iHull )
+	{
+		if( !ReadLine() )
+			return Fail( "missing hull %d", iHull );
+
+		CLineParser parser( m_szLine.c_str() );
+
+		int iIndex;
+
+		if( !parser.Token( szToken ) || szToken != "hull" || !parser.Int( iIndex ) || iIndex != iHull ||
+			!parser.Vec( header.player_mins[ iHull ] ) || !parser.Vec( header.player_maxs[ iHull ] ) )
+			return Fail( "invalid hull %d", iHull );
+	}
+
+	{
+		if( !ReadLine() )
+			return Fail( "missing state fields" );
+
+		CLineParser parser( m_szLine.c_str() );
+
+		if( !parser.Token( szToken ) || szToken != "state" )
+			return Fail( "missing state fields" );
+
+		while( parser.Token( szToken ) )
+		{
+			size_t uiField;
+
+			for( uiField = 0; uiField < ARRAYSIZE( g_StateFields ); ++uiField )
+			{
+				if( szToken == g_StateFields[ uiField ].pszName )
+					break;
+			}
+
+			if( uiField == ARRAYSIZE( g_StateFields ) )
+				return Fail( "unknown state field \"%s\"", szToken.c_str() );
+
+			m_StateFields.push_back( uiField );
+		}
+	}
+
+	return true;
+}
+
+void CPMoveRecordReader::Close()
+{
+	if( m_pFile )
+	{
+		fclose( m_pFile );
+		m_pFile = nullptr;
+	}
+}
+
+bool CPMoveRecordReader::ReadFrame( PMoveRecordFrame& frame )
+{
+	if( !m_pFile || !m_szError.empty() )
+		return false;
+
+	//End of the file.
+	if( !ReadLine() )
+		return false;
+
+	std::string szToken;
+
+	{
+		CLineParser parser( m_szLine.c_str() );
+
+		if( !parser.Token( szToken ) || szToken != "frame" ||
+			!parser.Int( frame.iPlayerIndex ) || !parser.Int( frame.bServer ) || !parser.Int( frame.bMultiplayer ) || !parser.Int( frame.bRunFuncs ) )
+			return Fail( "expected a frame" );
+	}
+
+	frame.PhysEnts.clear();
+	frame.MoveEnts.clear();
+	frame.RandomLongs.clear();
+	frame.FloatTimes.clear();
+
+	bool bHasCmd = false;
+	bool bHasPre = false;
+	bool bHasPost = false;
+
+	while( true )
+	{
+		if( !ReadLine() )
+			return Fail( "unexpected end of file" );
+
+		CLineParser parser( m_szLine.c_str() );
+
+		parser.Token( szToken );
+
+		if( szToken == "end" )
+			break;
+
+		if( szToken == "movevars" )
+		{
+			for( auto uiOffset : g_MoveVarsFloats )
+			{
+				if( !parser.Float( *reinterpret_cast<float*>( reinterpret_cast<byte*>( &m_MoveVars ) + uiOffset ) ) )
+					return Fail( "invalid movevars" );
+			}
+
+			if( !parser.Int( m_MoveVars.footsteps ) || !parser.Token( szToken ) )
+				return Fail( "invalid movevars" );
+
+			CopyString( m_MoveVars.skyName, sizeof( m_MoveVars.skyName ), szToken );
+		}
+		else if( szToken == "physinfo" )
+		{
+			m_szPhysInfo = parser.Rest();
+		}
+		else if( szToken == "cmd" )
+		{
+			auto& cmd = frame.cmd;
+
+			int iLerpMSec, iMSec, iLightLevel, iButtons, iImpulse, iWeaponSelect;
+
+			if( !parser.Int( iLerpMSec ) || !parser.Int( iMSec ) || !parser.Vec( cmd.viewangles ) ||
+				!parser.Float( cmd.forwardmove ) || !parser.Float( cmd.sidemove ) || !parser.Float( cmd.upmove ) ||
+				!parser.Int( iLightLevel ) || !parser.Int( iButtons ) || !parser.Int( iImpulse ) || !parser.Int( iWeaponSelect ) ||
+				!parser.Int( cmd.impact_index ) || !parser.Vec( cmd.impact_position ) || !parser.AtEnd() )
+				return Fail( "invalid cmd" );
+
+			cmd.lerp_msec = static_cast<short>( iLerpMSec );
+			cmd.msec = static_cast<byte>( iMSec );
+			cmd.lightlevel = static_cast<byte>( iLightLevel );
+			cmd.buttons = static_cast<unsigned short>( iButtons );
+			cmd.impulse = static_cast<byte>( iImpulse );
+			cmd.weaponselect = static_cast<byte>( iWeaponSelect );
+
+			bHasCmd = true;
+		}
+		else if( szToken == "physent" || szToken == "moveent" )
+		{
+			auto& list = szToken == "physent" ? frame.PhysEnts : frame.MoveEnts;
+
+			list.emplace_back();
+
+			if( !ReadPhysEnt( parser, list.back() ) )
+				return Fail( "invalid %s", szToken.c_str() );
+		}
+		else if( szToken == "pre" || szToken == "post" )
+		{
+			const bool bPre = szToken == "pre";
+
+			if( !ReadState( parser, m_StateFields, bPre ? frame.Pre : frame.Post ) )
+				return Fail( "invalid %s state", szToken.c_str() );
+
+			( bPre ? bHasPre : bHasPost ) = true;
+		}
+		else if( szToken == "random" )
+		{
+			int iCount;
+
+			if( !parser.Int( iCount ) || iCount < 0 )
+				return Fail( "invalid random" );
+
+			frame.RandomLongs.resize( iCount );
+
+			for( auto& iValue : frame.RandomLongs )
+			{
+				if( !parser.Int( iValue ) )
+					return Fail( "invalid random" );
+			}
+		}
+		else if( szToken == "floattime" )
+		{
+			int iCount;
+
+			if( !parser.Int( iCount ) || iCount < 0 )
+				return Fail( "invalid floattime" );
+
+			frame.FloatTimes.resize( iCount );
+
+			for( auto& flValue : frame.FloatTimes )
+			{
+				if( !parser.Double( flValue ) )
+					return Fail( "invalid floattime" );
+			}
+		}
+		else
+		{
+			return Fail( "unknown line \"%s\"", szToken.c_str() );
+		}
+	}
+
+	if( !bHasCmd || !bHasPre || !bHasPost )
+		return Fail( "incomplete frame" );
+
+	frame.movevars = m_MoveVars;
+
+	strncpy( frame.szPhysInfo, m_szPhysInfo.c_str(), sizeof( frame.szPhysInfo ) );
+	frame.szPhysInfo[ sizeof( frame.szPhysInfo ) - 1 ] = '\0';
+
+	return true;
+}
+
+bool CPMoveRecordReader::ReadLine()
+{
+	m_szLine.clear();
+
+	char szBuffer[ 1024 ];
+
+	while( fgets( szBuffer, sizeof( szBuffer ), m_pFile ) )
+	{
+		m_szLine += szBuffer;
+
+		if( !m_szLine.empty() && m_szLine.back() == '\n' )
+			break;
+	}
+
+	if( m_szLine.empty() )
+		return false;
+
+	while( !m_szLine.empty() && ( m_szLine.back() == '\n' || m_szLine.back() == '\r' ) )
+		m_szLine.pop_back();
+
+	++m_uiLine;
+
+	return true;
+}
+
+bool CPMoveRecordReader::Fail( const char* const pszFormat, ... )
+{
+	char szMessage[ 512 ];
+
+	va_list list;
+
+	va_start( list, pszFormat );
+	vsnprintf( szMessage, sizeof( szMessage ), pszFormat, list );
+	va_end( list );
+
+	char szError[ 600 ];
+
+	snprintf( szError, sizeof( szError ), "line %u: %s", m_uiLine, szMessage );
+
+	m_szError = szError;
+
+	return false;
+}
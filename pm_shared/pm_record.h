@@ -0,0 +1,284 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef PM_RECORD_H
+#define PM_RECORD_H
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "pm_defs.h"
+#include "pm_movevars.h"
+
+/**
+*	@file
+*
+*	Player movement recordings. A recording holds everything a PM_Move call reads, and what it produced,
+*	so the move can be run again outside of the engine. Recordings are text files, floats are written with enough digits to be read back exactly.
+*/
+
+#define PM_RECORD_VERSION 1
+
+/**
+*	The parts of playermove_t that belong to the player being moved. Saved before and after each move.
+*/
+struct PMoveRecordState
+{
+	float		time;
+	float		frametime;
+
+	Vector		origin;
+	Vector		angles;
+	Vector		oldangles;
+	Vector		velocity;
+	Vector		movedir;
+	Vector		basevelocity;
+
+	Vector		view_ofs;
+	float		flDuckTime;
+	qboolean	bInDuck;
+
+	int			flTimeStepSound;
+	int			iStepLeft;
+	float		flFallVelocity;
+	Vector		punchangle;
+	float		flSwimTime;
+	float		flNextPrimaryAttack;
+	int			effects;
+	int			flags;
+	int			usehull;
+	float		gravity;
+	float		friction;
+	int			oldbuttons;
+	float		waterjumptime;
+	qboolean	dead;
+	int			deadflag;
+	int			spectator;
+	int			movetype;
+	int			onground;
+	int			waterlevel;
+	int			watertype;
+	int			oldwaterlevel;
+	char		sztexturename[ 256 ];
+	char		chtexturetype;
+	float		maxspeed;
+	float		clientmaxspeed;
+
+	int			iuser1;
+	int			iuser2;
+	int			iuser3;
+	int			iuser4;
+	float		fuser1;
+	float		fuser2;
+	float		fuser3;
+	float		fuser4;
+	Vector		vuser1;
+	Vector		vuser2;
+	Vector		vuser3;
+	Vector		vuser4;
+
+	int			numtouch;
+};
+
+/**
+*	A physent_t, with brush models referred to by name.
+*/
+struct PMoveRecordPhysEnt
+{
+	/**
+	*	Brush model name, "*1" for submodels, the map's name for the world. Empty if the entity collides as a box.
+	*/
+	char		szModel[ 64 ];
+
+	char		name[ 32 ];
+	int			player;
+	Vector		origin;
+	Vector		mins;
+	Vector		maxs;
+	Vector		angles;
+
+	/**
+	*	Not part of physent_t, the movement code asks the engine for it when the player lands on the entity.
+	*	Filled in by the recorder.
+	*/
+	Vector		velocity;
+
+	int			info;
+	int			solid;
+	int			skin;
+	int			rendermode;
+	int			movetype;
+};
+
+struct PMoveRecordHeader
+{
+	char		szMapName[ 64 ];
+
+	Vector		player_mins[ 4 ];
+	Vector		player_maxs[ 4 ];
+};
+
+/**
+*	One PM_Move call.
+*/
+struct PMoveRecordFrame
+{
+	int			iPlayerIndex;
+	qboolean	bServer;
+	qboolean	bMultiplayer;
+	qboolean	bRunFuncs;
+
+	movevars_t	movevars;
+	char		szPhysInfo[ MAX_PHYSINFO_STRING ];
+
+	/**
+	*	The command as it was passed in. PM_Move clamps some of its values.
+	*/
+	usercmd_t	cmd;
+
+	std::vector<PMoveRecordPhysEnt> PhysEnts;
+	std::vector<PMoveRecordPhysEnt> MoveEnts;
+
+	/**
+	*	Values returned by RandomLong and Sys_FloatTime, in the order they were returned.
+	*/
+	std::vector<int> RandomLongs;
+	std::vector<double> FloatTimes;
+
+	PMoveRecordState Pre;
+	PMoveRecordState Post;
+};
+
+/**
+*	Largest difference between two states.
+*/
+struct PMoveRecordDifference
+{
+	/**
+	*	Field with the largest difference, or null if the states are equal.
+	*/
+	const char* pszField = nullptr;
+
+	/**
+	*	Absolute difference, infinite if a non float field differs.
+	*/
+	float flDifference = 0;
+};
+
+void PM_SaveRecordState( const playermove_t& pmove, PMoveRecordState& state );
+
+void PM_RestoreRecordState( const PMoveRecordState& state, playermove_t& pmove );
+
+PMoveRecordDifference PM_CompareRecordStates( const PMoveRecordState& lhs, const PMoveRecordState& rhs );
+
+void PM_SaveRecordPhysEnts( const physent_t* pPhysEnts, const int iCount, std::vector<PMoveRecordPhysEnt>& list );
+
+/**
+*	Captures everything that PM_Move reads from pmove, except for the values returned by callbacks and the velocities of entities.
+*/
+void PM_SaveRecordFrame( const playermove_t& pmove, PMoveRecordFrame& frame );
+
+/**
+*	Writes a recording to a file.
+*/
+class CPMoveRecordWriter final
+{
+public:
+	CPMoveRecordWriter() = default;
+	~CPMoveRecordWriter();
+
+	bool IsOpen() const { return m_pFile != nullptr; }
+
+	/**
+	*	Creates the file and writes the header.
+	*/
+	bool Open( const char* const pszFileName, const PMoveRecordHeader& header );
+
+	void Close();
+
+	void WriteFrame( const PMoveRecordFrame& frame );
+
+	unsigned int GetFrameCount() const { return m_uiFrames; }
+
+private:
+	FILE* m_pFile = nullptr;
+
+	unsigned int m_uiFrames = 0;
+
+	//Movevars and physinfo are only written when they change.
+	bool m_bWroteMoveVars = false;
+	movevars_t m_MoveVars;
+	std::string m_szPhysInfo;
+
+private:
+	CPMoveRecordWriter( const CPMoveRecordWriter& ) = delete;
+	CPMoveRecordWriter& operator=( const CPMoveRecordWriter& ) = delete;
+};
+
+/**
+*	Reads a recording from a file.
+*/
+class CPMoveRecordReader final
+{
+public:
+	CPMoveRecordReader() = default;
+	~CPMoveRecordReader();
+
+	/**
+	*	Opens the file and reads the header.
+	*/
+	bool Open( const char* const pszFileName, PMoveRecordHeader& header );
+
+	void Close();
+
+	/**
+	*	Reads the next frame.
+	*	@return false at the end of the file, or if the frame is invalid. Check GetError to tell them apart.
+	*/
+	bool ReadFrame( PMoveRecordFrame& frame );
+
+	/**
+	*	@return Description of the last error, or an empty string if there was none.
+	*/
+	const std::string& GetError() const { return m_szError; }
+
+private:
+	bool ReadLine();
+
+	bool Fail( const char* const pszFormat, ... );
+
+private:
+	FILE* m_pFile = nullptr;
+
+	unsigned int m_uiLine = 0;
+
+	std::string m_szLine;
+	std::string m_szError;
+
+	/**
+	*	Index in PMoveRecordState's field list of each value on pre and post lines.
+	*/
+	std::vector<size_t> m_StateFields;
+
+	movevars_t m_MoveVars;
+	std::string m_szPhysInfo;
+
+private:
+	CPMoveRecordReader( const CPMoveRecordReader& ) = delete;
+	CPMoveRecordReader& operator=( const CPMoveRecordReader& ) = delete;
+};
+
+#endif //PM_RECORD_H
@@ -267,19 +267,11 @@ void PM_CategorizeTextureType()
 	if ( !pTextureName )
 		return;
 
-	// strip leading '-0' or '+0~' or '{' or '!'
-	if (*pTextureName == '-' || *pTextureName == '+')
-		pTextureName += 2;
-
-	if (*pTextureName == '{' || *pTextureName == '!' || *pTextureName == '~' || *pTextureName == ' ')
-		pTextureName++;
-	// '}}'
-	
-	strcpy( pmove->sztexturename, pTextureName);
+	strcpy( pmove->sztexturename, CMaterialsList::StripTexturePrefix( pTextureName ) );
 	pmove->sztexturename[ CBTEXTURENAMEMAX - 1 ] = 0;
 		
-	// get texture type
-	pmove->chtexturetype = g_MaterialsList.FindTextureType( pmove->sztexturename );	
+	// get texture type, cached per engine texture
+	pmove->chtexturetype = g_MaterialsList.FindEngineTextureType( pTextureName );
 }
 
 void PM_UpdateStepSound()
@@ -3029,7 +3021,7 @@ int PM_GetPhysEntInfo( int ent )
 	return -1;
 }
 
-void PM_Init( playermove_t *ppmove )
+void PM_InitMovement( playermove_t *ppmove )
 {
 	assert( !pm_shared_initialized );
 
@@ -3037,7 +3029,12 @@ void PM_Init( playermove_t *ppmove )
 
 	PM_CreateStuckTable();
 
-	g_MaterialsList.LoadFromFile( "sound/materials.txt" );
-
 	pm_shared_initialized = true;
 }
+
+void PM_Init( playermove_t *ppmove )
+{
+	PM_InitMovement( ppmove );
+
+	g_MaterialsList.LoadFromFile( "sound/materials.txt" );
+}
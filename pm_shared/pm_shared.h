@@ -21,6 +21,13 @@
 #pragma once
 
 void PM_Init( playermove_t *ppmove );
+
+/**
+*	Initializes player movement without loading the materials list.
+*	Used by tools that run player movement outside of the engine and load the materials themselves.
+*/
+void PM_InitMovement( playermove_t *ppmove );
+
 void PM_Move ( playermove_t *ppmove, int server );
 
 /**
@@ -16,6 +16,7 @@
 #include <cstring>
 
 #include "mathlib.h"
+#include "ssemath.h"
 
 const Vector vec3_origin( 0, 0, 0 );
 
@@ -517,7 +518,45 @@ ConcatTransforms
 
 ================
 */
+#if MATHLIB_USE_SSE2
 void ConcatTransforms( const Matrix3x4& in1, const Matrix3x4& in2, Matrix3x4& out )
+{
+	const __m128 row0 = _mm_loadu_ps( in2.matrix[ 0 ] );
+	const __m128 row1 = _mm_loadu_ps( in2.matrix[ 1 ] );
+	const __m128 row2 = _mm_loadu_ps( in2.matrix[ 2 ] );
+
+	//The translation of in1 is only added to the 4th column.
+	const __m128 translationMask = _mm_castsi128_ps( _mm_set_epi32( -1, 0, 0, 0 ) );
+
+	__m128 result[ 3 ];
+
+	//Everything is computed before storing anything, so out can be the same matrix as one of the inputs.
+	for( size_t i = 0; i < 3; ++i )
+	{
+		__m128 row = _mm_mul_ps( _mm_set1_ps( in1.matrix[ i ][ 0 ] ), row0 );
+		row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( in1.matrix[ i ][ 1 ] ), row1 ) );
+		row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( in1.matrix[ i ][ 2 ] ), row2 ) );
+		result[ i ] = _mm_add_ps( row, _mm_and_ps( _mm_set1_ps( in1.matrix[ i ][ 3 ] ), translationMask ) );
+	}
+
+	_mm_storeu_ps( out.matrix[ 0 ], result[ 0 ] );
+	_mm_storeu_ps( out.matrix[ 1 ], result[ 1 ] );
+	_mm_storeu_ps( out.matrix[ 2 ], result[ 2 ] );
+}
+#else
+void ConcatTransforms( const Matrix3x4& in1, const Matrix3x4& in2, Matrix3x4& out )
+{
+	ConcatTransformsScalar( in1, in2, out );
+}
+#endif
+
+/*
+================
+ConcatTransformsScalar
+
+================
+*/
+void ConcatTransformsScalar( const Matrix3x4& in1, const Matrix3x4& in2, Matrix3x4& out )
 {
 	out[ 0 ][ 0 ] = in1[ 0 ][ 0 ] * in2[ 0 ][ 0 ] + in1[ 0 ][ 1 ] * in2[ 1 ][ 0 ] +
 		in1[ 0 ][ 2 ] * in2[ 2 ][ 0 ];
@@ -657,4 +696,90 @@ void QuaternionMatrix( const Vector4D& quaternion, Matrix3x4& matrix )
 	matrix[ 0 ][ 2 ] = static_cast<float>( 2.0 * quaternion[ 0 ] * quaternion[ 2 ] + 2.0 * quaternion[ 3 ] * quaternion[ 1 ] );
 	matrix[ 1 ][ 2 ] = static_cast<float>( 2.0 * quaternion[ 1 ] * quaternion[ 2 ] - 2.0 * quaternion[ 3 ] * quaternion[ 0 ] );
 	matrix[ 2 ][ 2 ] = static_cast<float>( 1.0 - 2.0 * quaternion[ 0 ] * quaternion[ 0 ] - 2.0 * quaternion[ 1 ] * quaternion[ 1 ] );
-}
\ No newline at end of file
+}
+
+/*
+====================
+QuaternionMatrices
+
+====================
+*/
+void QuaternionMatricesScalar( const Vector4D* pQuaternions, const Vector* pPositions, Matrix3x4* pMatrices, const size_t uiCount )
+{
+	for( size_t i = 0; i < uiCount; ++i )
+	{
+		QuaternionMatrix( pQuaternions[ i ], pMatrices[ i ] );
+
+		pMatrices[ i ][ 0 ][ 3 ] = pPositions[ i ][ 0 ];
+		pMatrices[ i ][ 1 ][ 3 ] = pPositions[ i ][ 1 ];
+		pMatrices[ i ][ 2 ][ 3 ] = pPositions[ i ][ 2 ];
+	}
+}
+
+#if MATHLIB_USE_SSE2
+void QuaternionMatrices( const Vector4D* pQuaternions, const Vector* pPositions, Matrix3x4* pMatrices, const size_t uiCount )
+{
+	const __m128 one = _mm_set1_ps( 1.0f );
+
+	size_t i = 0;
+
+	for( ; i + 4 <= uiCount; i += 4 )
+	{
+		__m128 x, y, z, w;
+
+		SSE_LoadQuaternions( &pQuaternions[ i ].x, x, y, z, w );
+
+		const __m128 x2 = _mm_add_ps( x, x );
+		const __m128 y2 = _mm_add_ps( y, y );
+		const __m128 z2 = _mm_add_ps( z, z );
+
+		const __m128 xx2 = _mm_mul_ps( x, x2 );
+		const __m128 yy2 = _mm_mul_ps( y, y2 );
+		const __m128 zz2 = _mm_mul_ps( z, z2 );
+		const __m128 xy2 = _mm_mul_ps( x, y2 );
+		const __m128 xz2 = _mm_mul_ps( x, z2 );
+		const __m128 yz2 = _mm_mul_ps( y, z2 );
+		const __m128 wx2 = _mm_mul_ps( w, x2 );
+		const __m128 wy2 = _mm_mul_ps( w, y2 );
+		const __m128 wz2 = _mm_mul_ps( w, z2 );
+
+		//Row by row, one vector per column. Transposing a row gives that row of each of the 4 matrices.
+		__m128 rows[ 3 ][ 4 ] =
+		{
+			{
+				_mm_sub_ps( _mm_sub_ps( one, yy2 ), zz2 ),
+				_mm_sub_ps( xy2, wz2 ),
+				_mm_add_ps( xz2, wy2 ),
+				_mm_set_ps( pPositions[ i + 3 ].x, pPositions[ i + 2 ].x, pPositions[ i + 1 ].x, pPositions[ i ].x )
+			},
+			{
+				_mm_add_ps( xy2, wz2 ),
+				_mm_sub_ps( _mm_sub_ps( one, xx2 ), zz2 ),
+				_mm_sub_ps( yz2, wx2 ),
+				_mm_set_ps( pPositions[ i + 3 ].y, pPositions[ i + 2 ].y, pPositions[ i + 1 ].y, pPositions[ i ].y )
+			},
+			{
+				_mm_sub_ps( xz2, wy2 ),
+				_mm_add_ps( yz2, wx2 ),
+				_mm_sub_ps( _mm_sub_ps( one, xx2 ), yy2 ),
+				_mm_set_ps( pPositions[ i + 3 ].z, pPositions[ i + 2 ].z, pPositions[ i + 1 ].z, pPositions[ i ].z )
+			}
+		};
+
+		for( size_t iRow = 0; iRow < 3; ++iRow )
+		{
+			_MM_TRANSPOSE4_PS( rows[ iRow ][ 0 ], rows[ iRow ][ 1 ], rows[ iRow ][ 2 ], rows[ iRow ][ 3 ] );
+
+			for( size_t iMatrix = 0; iMatrix < 4; ++iMatrix )
+				_mm_storeu_ps( pMatrices[ i + iMatrix ].matrix[ iRow ], rows[ iRow ][ iMatrix ] );
+		}
+	}
+
+	QuaternionMatricesScalar( pQuaternions + i, pPositions + i, pMatrices + i, uiCount - i );
+}
+#else
+void QuaternionMatrices( const Vector4D* pQuaternions, const Vector* pPositions, Matrix3x4* pMatrices, const size_t uiCount )
+{
+	QuaternionMatricesScalar( pQuaternions, pPositions, pMatrices, uiCount );
+}
+#endif
@@ -153,6 +153,18 @@ extern float UTIL_DotPoints( const Vector &vecSrc, const Vector &vecCheck, const
 void AngleMatrix( const Vector& angles, Matrix3x4& matrix );
 void ConcatTransforms( const Matrix3x4& in1, const Matrix3x4& in2, Matrix3x4& out );
 void QuaternionMatrix( const Vector4D& quaternion, Matrix3x4& matrix );
+
+/**
+*	Builds the matrices for a number of quaternions, with the given positions as the translation.
+*	Uses SSE2 to build 4 matrices at a time if available.
+*/
+void QuaternionMatrices( const Vector4D* pQuaternions, const Vector* pPositions, Matrix3x4* pMatrices, const size_t uiCount );
+
+/**
+*	Scalar versions of ConcatTransforms and QuaternionMatrices. Used if SSE2 isn't available, and to verify the SSE2 versions.
+*/
+void ConcatTransformsScalar( const Matrix3x4& in1, const Matrix3x4& in2, Matrix3x4& out );
+void QuaternionMatricesScalar( const Vector4D* pQuaternions, const Vector* pPositions, Matrix3x4* pMatrices, const size_t uiCount );
 void QuaternionSlerp( const Vector4D& p, Vector4D& q, float t, Vector4D& qt );
 void AngleQuaternion( const Vector& vecAngles, Vector4D& quaternion );
 
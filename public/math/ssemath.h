@@ -0,0 +1,269 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+// ssemath.h -- SSE2 versions of the math primitives, 4 values at a time
+#ifndef PUBLIC_MATH_SSEMATH_H
+#define PUBLIC_MATH_SSEMATH_H
+
+/**
+*	Whether the SSE2 kernels are available. If not, the scalar versions are used.
+*	Only intrinsics are used; scalar float math is unaffected, so the 387 precision used by the rest of the game is kept.
+*/
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define MATHLIB_USE_SSE2 1
+#else
+#define MATHLIB_USE_SSE2 0
+#endif
+
+#if MATHLIB_USE_SSE2
+#include <cmath>
+
+#include <emmintrin.h>
+
+/**
+*	@return For each lane, a if the mask is set, b otherwise.
+*/
+inline __m128 SSE_Select( const __m128 mask, const __m128 a, const __m128 b )
+{
+	return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+/**
+*	Computes the sine and cosine of 4 angles.
+*	Cephes sinf/cosf polynomials, accurate to about 1 ulp for angles up to 8192 radians.
+*/
+inline void SSE_SinCos( __m128 x, __m128& sine, __m128& cosine )
+{
+	const __m128 signMask = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+
+	__m128 signSin = _mm_and_ps( x, signMask );
+
+	x = _mm_andnot_ps( signMask, x );
+
+	//Octant, rounded up to an even number.
+	__m128i j = _mm_cvttps_epi32( _mm_mul_ps( x, _mm_set1_ps( 1.27323954473516f ) ) );
+	j = _mm_and_si128( _mm_add_epi32( j, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( ~1 ) );
+
+	const __m128 y = _mm_cvtepi32_ps( j );
+
+	const __m128 swapSignSin = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( j, _mm_set1_epi32( 4 ) ), 29 ) );
+	const __m128 signCos = _mm_castsi128_ps( _mm_slli_epi32( _mm_andnot_si128( _mm_sub_epi32( j, _mm_set1_epi32( 2 ) ), _mm_set1_epi32( 4 ) ), 29 ) );
+	const __m128 polyMask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( j, _mm_set1_epi32( 2 ) ), _mm_setzero_si128() ) );
+
+	signSin = _mm_xor_ps( signSin, swapSignSin );
+
+	//Extended precision modular arithmetic: x - y * pi / 4.
+	x = _mm_add_ps( x, _mm_mul_ps( y, _mm_set1_ps( -0.78515625f ) ) );
+	x = _mm_add_ps( x, _mm_mul_ps( y, _mm_set1_ps( -2.4187564849853515625e-4f ) ) );
+	x = _mm_add_ps( x, _mm_mul_ps( y, _mm_set1_ps( -3.77489497744594108e-8f ) ) );
+
+	const __m128 z = _mm_mul_ps( x, x );
+
+	__m128 polyCos = _mm_set1_ps( 2.443315711809948E-005f );
+	polyCos = _mm_add_ps( _mm_mul_ps( polyCos, z ), _mm_set1_ps( -1.388731625493765E-003f ) );
+	polyCos = _mm_add_ps( _mm_mul_ps( polyCos, z ), _mm_set1_ps( 4.166664568298827E-002f ) );
+	polyCos = _mm_mul_ps( _mm_mul_ps( polyCos, z ), z );
+	polyCos = _mm_sub_ps( polyCos, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+	polyCos = _mm_add_ps( polyCos, _mm_set1_ps( 1.0f ) );
+
+	__m128 polySin = _mm_set1_ps( -1.9515295891E-4f );
+	polySin = _mm_add_ps( _mm_mul_ps( polySin, z ), _mm_set1_ps( 8.3321608736E-3f ) );
+	polySin = _mm_add_ps( _mm_mul_ps( polySin, z ), _mm_set1_ps( -1.6666654611E-1f ) );
+	polySin = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( polySin, z ), x ), x );
+
+	sine = _mm_xor_ps( SSE_Select( polyMask, polySin, polyCos ), signSin );
+	cosine = _mm_xor_ps( SSE_Select( polyMask, polyCos, polySin ), signCos );
+}
+
+inline __m128 SSE_Sin( const __m128 x )
+{
+	__m128 sine, cosine;
+
+	SSE_SinCos( x, sine, cosine );
+
+	return sine;
+}
+
+/**
+*	Computes the arc cosine of 4 values in the range [ -1, 1 ].
+*	Cephes acosf, which avoids the cancellation of pi / 2 - asin( x ) near -1 and 1.
+*/
+inline __m128 SSE_ACos( const __m128 x )
+{
+	const __m128 signMask = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+	const __m128 half = _mm_set1_ps( 0.5f );
+
+	const __m128 a = _mm_andnot_ps( signMask, x );
+	const __m128 negative = _mm_cmplt_ps( x, _mm_setzero_ps() );
+	const __m128 large = _mm_cmpgt_ps( a, half );
+
+	//For large values, asin is evaluated at sqrt( ( 1 - |x| ) / 2 ).
+	const __m128 zLarge = _mm_mul_ps( half, _mm_sub_ps( _mm_set1_ps( 1.0f ), a ) );
+	const __m128 z = SSE_Select( large, zLarge, _mm_mul_ps( a, a ) );
+	const __m128 s = SSE_Select( large, _mm_sqrt_ps( zLarge ), a );
+
+	__m128 poly = _mm_set1_ps( 4.2163199048E-2f );
+	poly = _mm_add_ps( _mm_mul_ps( poly, z ), _mm_set1_ps( 2.4181311049E-2f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, z ), _mm_set1_ps( 4.5470025998E-2f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, z ), _mm_set1_ps( 7.4953002686E-2f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, z ), _mm_set1_ps( 1.6666752422E-1f ) );
+
+	//asin( s ).
+	const __m128 asinS = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( poly, z ), s ), s );
+
+	const __m128 pi = _mm_set1_ps( 3.14159265358979f );
+
+	//|x| > 0.5: acos( x ) = 2 * asin( s ), or pi - 2 * asin( s ) for negative x.
+	const __m128 twoAsin = _mm_add_ps( asinS, asinS );
+	const __m128 resultLarge = SSE_Select( negative, _mm_sub_ps( pi, twoAsin ), twoAsin );
+
+	//|x| <= 0.5: acos( x ) = pi / 2 - asin( x ).
+	const __m128 resultSmall = _mm_sub_ps( _mm_set1_ps( 1.57079632679490f ), _mm_or_ps( asinS, _mm_and_ps( x, signMask ) ) );
+
+	return SSE_Select( large, resultLarge, resultSmall );
+}
+
+/**
+*	AngleQuaternion for 4 sets of angles, stored as separate components.
+*/
+inline void SSE_AngleQuaternion( const __m128 angles0, const __m128 angles1, const __m128 angles2,
+								 __m128& x, __m128& y, __m128& z, __m128& w )
+{
+	const __m128 half = _mm_set1_ps( 0.5f );
+
+	__m128 sr, cr, sp, cp, sy, cy;
+
+	SSE_SinCos( _mm_mul_ps( angles2, half ), sy, cy );
+	SSE_SinCos( _mm_mul_ps( angles1, half ), sp, cp );
+	SSE_SinCos( _mm_mul_ps( angles0, half ), sr, cr );
+
+	const __m128 srcp = _mm_mul_ps( sr, cp );
+	const __m128 crsp = _mm_mul_ps( cr, sp );
+	const __m128 crcp = _mm_mul_ps( cr, cp );
+	const __m128 srsp = _mm_mul_ps( sr, sp );
+
+	x = _mm_sub_ps( _mm_mul_ps( srcp, cy ), _mm_mul_ps( crsp, sy ) );
+	y = _mm_add_ps( _mm_mul_ps( crsp, cy ), _mm_mul_ps( srcp, sy ) );
+	z = _mm_sub_ps( _mm_mul_ps( crcp, sy ), _mm_mul_ps( srsp, cy ) );
+	w = _mm_add_ps( _mm_mul_ps( crcp, cy ), _mm_mul_ps( srsp, sy ) );
+}
+
+/**
+*	QuaternionSlerp for 4 pairs of quaternions, stored as separate components, with the same fraction.
+*	Like QuaternionSlerp, q is negated if it is on the other side of the hypersphere.
+*/
+inline void SSE_QuaternionSlerp( const __m128 px, const __m128 py, const __m128 pz, const __m128 pw,
+								 __m128& qx, __m128& qy, __m128& qz, __m128& qw,
+								 const float t,
+								 __m128& x, __m128& y, __m128& z, __m128& w )
+{
+	const __m128 signMask = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 epsilon = _mm_set1_ps( 0.000001f );
+
+	//Decide if one of the quaternions is backwards.
+	__m128 a, b, d;
+
+	d = _mm_sub_ps( px, qx ); a = _mm_mul_ps( d, d );
+	d = _mm_sub_ps( py, qy ); a = _mm_add_ps( a, _mm_mul_ps( d, d ) );
+	d = _mm_sub_ps( pz, qz ); a = _mm_add_ps( a, _mm_mul_ps( d, d ) );
+	d = _mm_sub_ps( pw, qw ); a = _mm_add_ps( a, _mm_mul_ps( d, d ) );
+
+	d = _mm_add_ps( px, qx ); b = _mm_mul_ps( d, d );
+	d = _mm_add_ps( py, qy ); b = _mm_add_ps( b, _mm_mul_ps( d, d ) );
+	d = _mm_add_ps( pz, qz ); b = _mm_add_ps( b, _mm_mul_ps( d, d ) );
+	d = _mm_add_ps( pw, qw ); b = _mm_add_ps( b, _mm_mul_ps( d, d ) );
+
+	const __m128 flip = _mm_and_ps( _mm_cmpgt_ps( a, b ), signMask );
+
+	qx = _mm_xor_ps( qx, flip );
+	qy = _mm_xor_ps( qy, flip );
+	qz = _mm_xor_ps( qz, flip );
+	qw = _mm_xor_ps( qw, flip );
+
+	__m128 cosom = _mm_mul_ps( px, qx );
+	cosom = _mm_add_ps( cosom, _mm_mul_ps( py, qy ) );
+	cosom = _mm_add_ps( cosom, _mm_mul_ps( pz, qz ) );
+	cosom = _mm_add_ps( cosom, _mm_mul_ps( pw, qw ) );
+
+	const __m128 vecT = _mm_set1_ps( t );
+	const __m128 vecT1 = _mm_set1_ps( 1.0f - t );
+
+	const __m128 notOpposite = _mm_cmpgt_ps( _mm_add_ps( one, cosom ), epsilon );
+	const __m128 notClose = _mm_cmpgt_ps( _mm_sub_ps( one, cosom ), epsilon );
+
+	//Clamp so rounding can't produce NaNs in lanes that don't use the result.
+	const __m128 clamped = _mm_min_ps( _mm_max_ps( cosom, _mm_set1_ps( -1.0f ) ), one );
+
+	const __m128 omega = SSE_ACos( clamped );
+	//sin( acos( x ) ) is sqrt( 1 - x * x ). Factored so it's accurate when x is close to 1.
+	const __m128 sinom = _mm_sqrt_ps( _mm_max_ps( _mm_mul_ps( _mm_sub_ps( one, clamped ), _mm_add_ps( one, clamped ) ), epsilon ) );
+
+	__m128 sclp = _mm_div_ps( SSE_Sin( _mm_mul_ps( vecT1, omega ) ), sinom );
+	__m128 sclq = _mm_div_ps( SSE_Sin( _mm_mul_ps( vecT, omega ) ), sinom );
+
+	//Too close to slerp, lerp instead.
+	sclp = SSE_Select( notClose, sclp, vecT1 );
+	sclq = SSE_Select( notClose, sclq, vecT );
+
+	x = _mm_add_ps( _mm_mul_ps( sclp, px ), _mm_mul_ps( sclq, qx ) );
+	y = _mm_add_ps( _mm_mul_ps( sclp, py ), _mm_mul_ps( sclq, qy ) );
+	z = _mm_add_ps( _mm_mul_ps( sclp, pz ), _mm_mul_ps( sclq, qz ) );
+	w = _mm_add_ps( _mm_mul_ps( sclp, pw ), _mm_mul_ps( sclq, qw ) );
+
+	if( _mm_movemask_ps( notOpposite ) != 0xF )
+	{
+		//Opposite quaternions: rotate through a perpendicular quaternion. W is left as is, same as the scalar version.
+		const __m128 sclpPerp = _mm_set1_ps( static_cast<float>( sin( ( 1.0 - t ) * 1.57079632679489661923 ) ) );
+		const __m128 sclqPerp = _mm_set1_ps( static_cast<float>( sin( t * 1.57079632679489661923 ) ) );
+
+		const __m128 perpX = _mm_sub_ps( _mm_mul_ps( sclpPerp, px ), _mm_mul_ps( sclqPerp, qy ) );
+		const __m128 perpY = _mm_add_ps( _mm_mul_ps( sclpPerp, py ), _mm_mul_ps( sclqPerp, qx ) );
+		const __m128 perpZ = _mm_sub_ps( _mm_mul_ps( sclpPerp, pz ), _mm_mul_ps( sclqPerp, qw ) );
+
+		x = SSE_Select( notOpposite, x, perpX );
+		y = SSE_Select( notOpposite, y, perpY );
+		z = SSE_Select( notOpposite, z, perpZ );
+		w = SSE_Select( notOpposite, w, qz );
+	}
+}
+
+/**
+*	Loads 4 quaternions and transposes them into separate components.
+*/
+inline void SSE_LoadQuaternions( const float* pflQuaternions, __m128& x, __m128& y, __m128& z, __m128& w )
+{
+	x = _mm_loadu_ps( pflQuaternions );
+	y = _mm_loadu_ps( pflQuaternions + 4 );
+	z = _mm_loadu_ps( pflQuaternions + 8 );
+	w = _mm_loadu_ps( pflQuaternions + 12 );
+
+	_MM_TRANSPOSE4_PS( x, y, z, w );
+}
+
+/**
+*	Transposes 4 quaternions stored as separate components and stores them.
+*/
+inline void SSE_StoreQuaternions( float* pflQuaternions, __m128 x, __m128 y, __m128 z, __m128 w )
+{
+	_MM_TRANSPOSE4_PS( x, y, z, w );
+
+	_mm_storeu_ps( pflQuaternions, x );
+	_mm_storeu_ps( pflQuaternions + 4, y );
+	_mm_storeu_ps( pflQuaternions + 8, z );
+	_mm_storeu_ps( pflQuaternions + 12, w );
+}
+#endif
+
+#endif //PUBLIC_MATH_SSEMATH_H
@@ -12,7 +12,11 @@
 #define NO_THREAD_NAMES
 #include "threads.h"
 
-#define	MAX_THREADS	64
+#define	MAX_THREADS	256
+
+#if !defined( WIN32 ) && !defined( __osf__ ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+#define	PTHREADS
+#endif
 
 int		dispatch;
 int		workcount;
@@ -21,6 +25,7 @@ qboolean		pacifier;
 
 qboolean	threaded;
 
+#ifndef PTHREADS
 /*
 =============
 GetThreadWork
@@ -54,6 +59,7 @@ int	GetThreadWork (void)
 
 	return r;
 }
+#endif
 
 
 void (*workfunction) (int);
@@ -274,6 +280,253 @@ void RunThreadsOn (int workcnt, qboolean showpacifier, void(*func)(int))
 }
 
 
+#endif
+
+/*
+===================================================================
+
+POSIX THREADS
+
+===================================================================
+*/
+
+#ifdef PTHREADS
+#define	USED
+
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+// qrad keeps a full transfer list on the stack of each thread
+#define	THREAD_STACK_SIZE	0x800000
+
+// each chunk takes at most 1/(numthreads*CHUNK_DIVISOR) of the remaining work,
+// so chunks get smaller towards the end and the threads finish together
+#define	CHUNK_DIVISOR	8
+
+int		numthreads = -1;
+
+static pthread_mutex_t	my_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int		enter;
+
+static void		(*threadfunction) (int);
+
+// bumped by every RunThreadsOn so stale chunks from a previous run are dropped
+static int		workgeneration;
+
+typedef struct
+{
+	int		generation;
+	int		next;
+	int		end;
+} workchunk_t;
+
+static __thread workchunk_t	threadchunk;
+
+void ThreadSetDefault (void)
+{
+	if (numthreads == -1)	// not set manually
+	{
+		numthreads = sysconf (_SC_NPROCESSORS_ONLN);
+		if (numthreads < 1)
+			numthreads = 1;
+	}
+
+	if (numthreads > MAX_THREADS)
+		numthreads = MAX_THREADS;
+
+	qprintf ("%i threads\n", numthreads);
+}
+
+
+void ThreadLock (void)
+{
+	if (!threaded)
+		return;
+	pthread_mutex_lock (&my_mutex);
+	if (enter)
+		Error ("Recursive ThreadLock\n");
+	enter = 1;
+}
+
+void ThreadUnlock (void)
+{
+	if (!threaded)
+		return;
+	if (!enter)
+		Error ("ThreadUnlock without lock\n");
+	enter = 0;
+	pthread_mutex_unlock (&my_mutex);
+}
+
+static double ThreadWallTime (void)
+{
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static double ThreadCPUTime (void)
+{
+	struct rusage	usage;
+
+	getrusage (RUSAGE_SELF, &usage);
+
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0
+		+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+/*
+=============
+UpdatePacifier
+
+Prints the progress once for every tenth of the work handed out
+=============
+*/
+static void UpdatePacifier (int work)
+{
+	int	f;
+	int	old;
+
+	f = 10*work / workcount;
+	old = __atomic_load_n (&oldf, __ATOMIC_RELAXED);
+
+	while (f > old)
+	{
+		if (__atomic_compare_exchange_n (&oldf, &old, f, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+			if (pacifier)
+				printf ("%i...", f);
+			break;
+		}
+	}
+}
+
+/*
+=============
+GetThreadWork
+
+Threads claim chunks of work off a shared counter without locking,
+and hand out the items in their chunk one at a time.
+Every item is handed out exactly once, but items are processed in no
+particular order: a thread can still be working through an early chunk
+after others have moved on to later ones. Callers must not depend on
+the order; vis picks its portals by complexity in GetNextPortal and only
+uses the count from here.
+=============
+*/
+int	GetThreadWork (void)
+{
+	workchunk_t	*chunk;
+	int		remaining;
+	int		size;
+	int		start;
+
+	chunk = &threadchunk;
+
+	if (chunk->generation != workgeneration)
+	{
+		chunk->generation = workgeneration;
+		chunk->next = chunk->end = 0;
+	}
+
+	if (chunk->next == chunk->end)
+	{
+		remaining = workcount - __atomic_load_n (&dispatch, __ATOMIC_RELAXED);
+		if (remaining <= 0)
+			return -1;
+
+		size = remaining / (numthreads * CHUNK_DIVISOR);
+		if (size < 1)
+			size = 1;
+
+		start = __atomic_fetch_add (&dispatch, size, __ATOMIC_RELAXED);
+		if (start >= workcount)
+			return -1;
+
+		chunk->next = start;
+		chunk->end = start + size;
+		if (chunk->end > workcount)
+			chunk->end = workcount;
+
+		UpdatePacifier (start);
+	}
+
+	return chunk->next++;
+}
+
+static void *ThreadEntry (void *arg)
+{
+	threadfunction ((int)(intptr_t)arg);
+	return NULL;
+}
+
+/*
+=============
+RunThreadsOn
+=============
+*/
+void RunThreadsOn (int workcnt, qboolean showpacifier, void(*func)(int))
+{
+	int		i;
+	pthread_t	work_threads[MAX_THREADS];
+	pthread_attr_t	attrib;
+	double	start, end;
+	double	cpustart, cpuend;
+
+	start = ThreadWallTime ();
+	cpustart = ThreadCPUTime ();
+	dispatch = 0;
+	workcount = workcnt;
+	oldf = -1;
+	pacifier = showpacifier;
+	threadfunction = func;
+	workgeneration++;
+
+	if (pacifier)
+		setbuf (stdout, NULL);
+
+	if (numthreads <= 1)
+	{
+		func (0);
+	}
+	else
+	{
+		threaded = true;
+
+		if (pthread_attr_init (&attrib))
+			Error ("pthread_attr_init failed");
+		if (pthread_attr_setstacksize (&attrib, THREAD_STACK_SIZE))
+			Error ("pthread_attr_setstacksize failed");
+
+		for (i=0 ; i<numthreads ; i++)
+		{
+			if (pthread_create (&work_threads[i], &attrib, ThreadEntry, (void *)(intptr_t)i))
+				Error ("pthread_create failed");
+		}
+
+		for (i=0 ; i<numthreads ; i++)
+		{
+			if (pthread_join (work_threads[i], NULL))
+				Error ("pthread_join failed");
+		}
+
+		pthread_attr_destroy (&attrib);
+
+		threaded = false;
+	}
+
+	end = ThreadWallTime ();
+	cpuend = ThreadCPUTime ();
+	if (pacifier)
+		printf (" (%.2fs, %.2fs cpu)\n", end-start, cpuend-cpustart);
+}
+
+
 #endif
 
 /*
@@ -0,0 +1,730 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "extdll.h"
+#include "enginecallback.h"
+
+#include "pm_defs.h"
+#include "pm_shared.h"
+
+#include "CPMoveWorld.h"
+
+#include "CPMoveSimulation.h"
+
+namespace
+{
+/**
+*	The simulation whose move is running.
+*/
+CPMoveSimulation* g_pSimulation = nullptr;
+
+/**
+*	Hull of a brush model to use for each of the player's hulls.
+*/
+const int PLAYER_TO_MODEL_HULL[ 4 ] = { 1, 3, 0, 2 };
+
+int ModelHullForPlayerHull( const int iUseHull )
+{
+	return iUseHull >= 0 && iUseHull < 4 ? PLAYER_TO_MODEL_HULL[ iUseHull ] : 1;
+}
+
+bool IsRotated( const physent_t* pe )
+{
+	return pe->solid == SOLID_BSP && ( pe->angles[ 0 ] || pe->angles[ 1 ] || pe->angles[ 2 ] );
+}
+
+/**
+*	Moves a point into the space of a rotated entity.
+*/
+Vector RotatePoint( const Vector& vecAngles, const Vector& vecPoint )
+{
+	Vector forward, right, up;
+	AngleVectors( vecAngles, forward, right, up );
+
+	return Vector( DotProduct( vecPoint, forward ), -DotProduct( vecPoint, right ), DotProduct( vecPoint, up ) );
+}
+
+/**
+*	Water brushes are not solid, their skin holds their contents.
+*/
+bool IsWaterBrush( const physent_t* pe )
+{
+	return pe->model && pe->solid == SOLID_NOT && pe->skin != 0;
+}
+}
+
+CPMoveSimulation::CPMoveSimulation( CPMoveWorld& world, const PMoveRecordHeader& header )
+	: m_World( world )
+	, m_pMove( new playermove_t() )
+	, m_Edict()
+{
+	//The movement code reads the velocity of the entity it lands on from the engine.
+	g_engfuncs.pfnPEntityOfEntIndex = &CPMoveSimulation::PEntityOfEntIndex;
+
+	auto& move = *m_pMove;
+
+	for( int iHull = 0; iHull < 4; ++iHull )
+	{
+		move.player_mins[ iHull ] = header.player_mins[ iHull ];
+		move.player_maxs[ iHull ] = header.player_maxs[ iHull ];
+	}
+
+	move.movevars = &m_MoveVars;
+
+	move.PM_Info_ValueForKey = &CPMoveSimulation::Info_ValueForKey;
+	move.PM_Particle = &CPMoveSimulation::Particle;
+	move.PM_TestPlayerPosition = &CPMoveSimulation::PM_TestPlayerPosition;
+	move.Con_NPrintf = &CPMoveSimulation::Con_NPrintf;
+	move.Con_DPrintf = &CPMoveSimulation::Con_DPrintf;
+	move.Con_Printf = &CPMoveSimulation::Con_Printf;
+	move.Sys_FloatTime = &CPMoveSimulation::Sys_FloatTime;
+	move.PM_StuckTouch = &CPMoveSimulation::StuckTouch;
+	move.PM_PointContents = &CPMoveSimulation::PointContents;
+	move.PM_TruePointContents = &CPMoveSimulation::TruePointContents;
+	move.PM_HullPointContents = &CPMoveSimulation::HullPointContents;
+	move.PM_PlayerTrace = &CPMoveSimulation::PM_PlayerTrace;
+	move.PM_TraceLine = &CPMoveSimulation::TraceLine;
+	move.RandomLong = &CPMoveSimulation::RandomLong;
+	move.RandomFloat = &CPMoveSimulation::RandomFloat;
+	move.PM_GetModelType = &CPMoveSimulation::GetModelType;
+	move.PM_GetModelBounds = &CPMoveSimulation::GetModelBounds;
+	move.PM_HullForBsp = &CPMoveSimulation::HullForBsp;
+	move.PM_TraceModel = &CPMoveSimulation::TraceModel;
+	move.COM_FileSize = &CPMoveSimulation::COM_FileSize;
+	move.COM_LoadFile = &CPMoveSimulation::COM_LoadFile;
+	move.COM_FreeFile = &CPMoveSimulation::COM_FreeFile;
+	move.memfgets = &CPMoveSimulation::memfgets;
+	move.PM_PlaySound = &CPMoveSimulation::PlaySound;
+	move.PM_TraceTexture = &CPMoveSimulation::TraceTexture;
+	move.PM_PlaybackEventFull = &CPMoveSimulation::PlaybackEventFull;
+	move.PM_PlayerTraceEx = &CPMoveSimulation::PlayerTraceEx;
+	move.PM_TestPlayerPositionEx = &CPMoveSimulation::TestPlayerPositionEx;
+	move.PM_TraceLineEx = &CPMoveSimulation::TraceLineEx;
+}
+
+CPMoveSimulation::~CPMoveSimulation()
+{
+	if( g_pSimulation == this )
+		g_pSimulation = nullptr;
+}
+
+bool CPMoveSimulation::SetupFrame( const PMoveRecordFrame& frame )
+{
+	auto& move = *m_pMove;
+
+	m_pFrame = &frame;
+
+	move.player_index = frame.iPlayerIndex;
+	move.server = frame.bServer;
+	move.multiplayer = frame.bMultiplayer;
+	move.runfuncs = frame.bRunFuncs;
+
+	m_MoveVars = frame.movevars;
+
+	strncpy( move.physinfo, frame.szPhysInfo, sizeof( move.physinfo ) - 1 );
+	move.physinfo[ sizeof( move.physinfo ) - 1 ] = '\0';
+
+	move.cmd = frame.cmd;
+
+	PM_RestoreRecordState( frame.Pre, move );
+
+	move.numvisent = 0;
+
+	return SetupPhysEnts( frame.PhysEnts, move.physents, move.numphysent, MAX_PHYSENTS ) &&
+		SetupPhysEnts( frame.MoveEnts, move.moveents, move.nummoveent, MAX_MOVEENTS );
+}
+
+void CPMoveSimulation::Move()
+{
+	m_uiNextRandomLong = 0;
+	m_uiNextFloatTime = 0;
+	m_bRanOutOfValues = false;
+	m_Counts = CallbackCounts();
+
+	g_pSimulation = this;
+
+	PM_Move( m_pMove.get(), m_pMove->server );
+
+	g_pSimulation = nullptr;
+}
+
+bool CPMoveSimulation::SetupPhysEnts( const std::vector<PMoveRecordPhysEnt>& list, physent_t* pPhysEnts, int& iCount, const int iMaxCount )
+{
+	if( list.size() > static_cast<size_t>( iMaxCount ) )
+	{
+		fprintf( stderr, "Frame has %u entities, at most %d are allowed\n", static_cast<unsigned int>( list.size() ), iMaxCount );
+		return false;
+	}
+
+	iCount = static_cast<int>( list.size() );
+
+	for( int i = 0; i < iCount; ++i )
+	{
+		const auto& ent = list[ i ];
+		auto& pe = pPhysEnts[ i ];
+
+		pe = physent_t();
+
+		if( *ent.szModel )
+		{
+			pe.model = m_World.FindModel( ent.szModel );
+
+			if( !pe.model )
+			{
+				fprintf( stderr, "Entity %d uses model \"%s\", which is not in the map\n", i, ent.szModel );
+				return false;
+			}
+		}
+
+		memcpy( pe.name, ent.name, sizeof( pe.name ) );
+		pe.name[ sizeof( pe.name ) - 1 ] = '\0';
+
+		pe.player = ent.player;
+		pe.origin = ent.origin;
+		pe.mins = ent.mins;
+		pe.maxs = ent.maxs;
+		pe.info = ent.info;
+		pe.angles = ent.angles;
+		pe.solid = ent.solid;
+		pe.skin = ent.skin;
+		pe.rendermode = ent.rendermode;
+		pe.movetype = ent.movetype;
+	}
+
+	return true;
+}
+
+hull_t* CPMoveSimulation::HullForEnt( physent_t* pe, Vector& offset )
+{
+	const auto& move = *m_pMove;
+
+	if( pe->model )
+	{
+		hull_t* hull = &pe->model->hulls[ ModelHullForPlayerHull( move.usehull ) ];
+
+		offset = hull->clip_mins - move.player_mins[ move.usehull ] + pe->origin;
+
+		return hull;
+	}
+
+	//Studio models collide as their boxes, there are no hitboxes to trace against.
+	offset = pe->origin;
+
+	return m_World.HullForBox( pe->mins - move.player_maxs[ move.usehull ], pe->maxs - move.player_mins[ move.usehull ] );
+}
+
+pmtrace_t CPMoveSimulation::PlayerTrace( const Vector& start, const Vector& end, int traceFlags, int ignore_pe, int ( *pfnIgnore )( physent_t* pe ) )
+{
+	auto& move = *m_pMove;
+
+	++m_Counts.uiTraces;
+
+	pmtrace_t total = pmtrace_t();
+
+	total.fraction = 1;
+	total.endpos = end;
+	total.ent = -1;
+
+	for( int i = 0; i < move.numphysent; ++i )
+	{
+		physent_t* pe = &move.physents[ i ];
+
+		if( i > 0 && ( traceFlags & PM_WORLD_ONLY ) )
+			break;
+
+		if( pfnIgnore ? pfnIgnore( pe ) != 0 : i == ignore_pe )
+			continue;
+
+		if( IsWaterBrush( pe ) )
+			continue;
+
+		if( ( traceFlags & PM_GLASS_IGNORE ) && pe->rendermode != kRenderNormal )
+			continue;
+
+		Vector offset;
+		hull_t* hull = HullForEnt( pe, offset );
+
+		Vector start_l = start - offset;
+		Vector end_l = end - offset;
+
+		const bool bRotated = IsRotated( pe );
+
+		if( bRotated )
+		{
+			start_l = RotatePoint( pe->angles, start_l );
+			end_l = RotatePoint( pe->angles, end_l );
+		}
+
+		pmtrace_t trace = pmtrace_t();
+
+		trace.fraction = 1;
+		trace.allsolid = true;
+		trace.endpos = end;
+
+		CPMoveWorld::RecursiveHullCheck( hull, hull->firstclipnode, 0, 1, start_l, end_l, &trace );
+
+		if( trace.allsolid )
+			trace.startsolid = true;
+
+		if( trace.startsolid )
+			trace.fraction = 0;
+
+		if( trace.fraction != 1 )
+		{
+			if( bRotated )
+			{
+				Vector forward, right, up;
+				AngleVectorsTranspose( pe->angles, forward, right, up );
+
+				const Vector normal = trace.plane.normal;
+
+				trace.plane.normal = Vector( DotProduct( normal, forward ), DotProduct( normal, right ), DotProduct( normal, up ) );
+			}
+
+			trace.endpos = start + ( end - start ) * trace.fraction;
+		}
+
+		if( trace.fraction < total.fraction )
+		{
+			total = trace;
+			total.ent = i;
+		}
+	}
+
+	return total;
+}
+
+int CPMoveSimulation::TestPlayerPosition( const Vector& pos, pmtrace_t* ptrace, int ( *pfnIgnore )( physent_t* pe ) )
+{
+	auto& move = *m_pMove;
+
+	++m_Counts.uiPositionTests;
+
+	if( ptrace )
+		*ptrace = PlayerTrace( pos, pos, PM_NORMAL, -1, pfnIgnore );
+
+	for( int i = 0; i < move.numphysent; ++i )
+	{
+		physent_t* pe = &move.physents[ i ];
+
+		if( pfnIgnore && pfnIgnore( pe ) )
+			continue;
+
+		if( IsWaterBrush( pe ) )
+			continue;
+
+		Vector offset;
+		hull_t* hull = HullForEnt( pe, offset );
+
+		Vector test = pos - offset;
+
+		if( IsRotated( pe ) )
+			test = RotatePoint( pe->angles, test );
+
+		if( CPMoveWorld::HullPointContents( hull, hull->firstclipnode, test ) == CONTENTS_SOLID )
+			return i;
+	}
+
+	return -1;
+}
+
+int32 CPMoveSimulation::NextRandom()
+{
+	//Same constants as the C standard's example rand.
+	m_uiRandomSeed = m_uiRandomSeed * 1103515245 + 12345;
+
+	return ( m_uiRandomSeed >> 16 ) & 0x7FFF;
+}
+
+const char* CPMoveSimulation::Info_ValueForKey( const char* s, const char* key )
+{
+	static char szValue[ MAX_PHYSINFO_STRING ];
+
+	const size_t uiKeyLength = strlen( key );
+
+	if( *s == '\\' )
+		++s;
+
+	while( *s )
+	{
+		const char* pszKey = s;
+
+		while( *s && *s != '\\' )
+			++s;
+
+		const size_t uiLength = s - pszKey;
+
+		if( !*s )
+			break;
+
+		++s;
+
+		const char* pszValue = s;
+
+		while( *s && *s != '\\' )
+			++s;
+
+		if( uiLength == uiKeyLength && !strncmp( pszKey, key, uiLength ) )
+		{
+			const size_t uiValueLength = min( static_cast<size_t>( s - pszValue ), sizeof( szValue ) - 1 );
+
+			memcpy( szValue, pszValue, uiValueLength );
+			szValue[ uiValueLength ] = '\0';
+
+			return szValue;
+		}
+
+		if( *s )
+			++s;
+	}
+
+	return "";
+}
+
+void CPMoveSimulation::Particle( const Vector&, int, float, int, int )
+{
+}
+
+int CPMoveSimulation::PM_TestPlayerPosition( const Vector& pos, pmtrace_t* ptrace )
+{
+	return g_pSimulation->TestPlayerPosition( pos, ptrace, nullptr );
+}
+
+void CPMoveSimulation::Con_NPrintf( int idx, const char* const pszFormat, ... )
+{
+	if( !g_pSimulation->m_bVerbose )
+		return;
+
+	printf( "%d: ", idx );
+
+	va_list list;
+	va_start( list, pszFormat );
+	vprintf( pszFormat, list );
+	va_end( list );
+}
+
+void CPMoveSimulation::Con_DPrintf( const char* const pszFormat, ... )
+{
+	if( !g_pSimulation->m_bVerbose )
+		return;
+
+	va_list list;
+	va_start( list, pszFormat );
+	vprintf( pszFormat, list );
+	va_end( list );
+}
+
+void CPMoveSimulation::Con_Printf( const char* const pszFormat, ... )
+{
+	if( !g_pSimulation->m_bVerbose )
+		return;
+
+	va_list list;
+	va_start( list, pszFormat );
+	vprintf( pszFormat, list );
+	va_end( list );
+}
+
+double CPMoveSimulation::Sys_FloatTime()
+{
+	auto& sim = *g_pSimulation;
+
+	const auto& times = sim.m_pFrame->FloatTimes;
+
+	if( sim.m_uiNextFloatTime < times.size() )
+	{
+		sim.m_flLastTime = times[ sim.m_uiNextFloatTime++ ];
+	}
+	else
+	{
+		sim.m_bRanOutOfValues = true;
+		sim.m_flLastTime = sim.m_pMove->time / 1000.0;
+	}
+
+	return sim.m_flLastTime;
+}
+
+void CPMoveSimulation::StuckTouch( int hitent, pmtrace_t* ptraceresult )
+{
+	//The engine only records touches on the server.
+	auto& move = *g_pSimulation->m_pMove;
+
+	if( !move.server )
+		return;
+
+	for( int i = 0; i < move.numtouch; ++i )
+	{
+		if( move.touchindex[ i ].ent == hitent )
+			return;
+	}
+
+	if( move.numtouch >= MAX_PHYSENTS )
+		return;
+
+	ptraceresult->deltavelocity = move.velocity;
+	ptraceresult->ent = hitent;
+
+	move.touchindex[ move.numtouch++ ] = *ptraceresult;
+}
+
+int CPMoveSimulation::PointContents( const Vector& p, int* truecontents )
+{
+	auto& sim = *g_pSimulation;
+	auto& move = *sim.m_pMove;
+
+	++sim.m_Counts.uiPointContents;
+
+	const hull_t* pWorldHull = &move.physents[ 0 ].model->hulls[ 0 ];
+
+	int contents = CPMoveWorld::HullPointContents( pWorldHull, pWorldHull->firstclipnode, p );
+
+	if( truecontents )
+		*truecontents = contents;
+
+	//Currents are water.
+	if( contents <= CONTENTS_CURRENT_0 && contents >= CONTENTS_CURRENT_DOWN )
+		contents = CONTENTS_WATER;
+
+	if( contents == CONTENTS_SOLID )
+		return contents;
+
+	for( int i = 1; i < move.numphysent; ++i )
+	{
+		const physent_t* pe = &move.physents[ i ];
+
+		if( pe->solid != SOLID_NOT || !pe->model )
+			continue;
+
+		const hull_t* hull = &pe->model->hulls[ 0 ];
+
+		const int entityContents = CPMoveWorld::HullPointContents( hull, hull->firstclipnode, p - pe->origin );
+
+		if( entityContents != CONTENTS_EMPTY )
+			return entityContents;
+	}
+
+	return contents;
+}
+
+int CPMoveSimulation::TruePointContents( const Vector& p )
+{
+	auto& sim = *g_pSimulation;
+
+	++sim.m_Counts.uiPointContents;
+
+	const hull_t* pWorldHull = &sim.m_pMove->physents[ 0 ].model->hulls[ 0 ];
+
+	return CPMoveWorld::HullPointContents( pWorldHull, pWorldHull->firstclipnode, p );
+}
+
+int CPMoveSimulation::HullPointContents( hull_t* hull, int num, const Vector& p )
+{
+	++g_pSimulation->m_Counts.uiPointContents;
+
+	return CPMoveWorld::HullPointContents( hull, num, p );
+}
+
+pmtrace_t CPMoveSimulation::PM_PlayerTrace( const Vector& start, const Vector& end, int traceFlags, int ignore_pe )
+{
+	return g_pSimulation->PlayerTrace( start, end, traceFlags, ignore_pe, nullptr );
+}
+
+pmtrace_t* CPMoveSimulation::TraceLine( const Vector& start, const Vector& end, int flags, int usehull, int ignore_pe )
+{
+	auto& sim = *g_pSimulation;
+	auto& move = *sim.m_pMove;
+
+	const int iOldHull = move.usehull;
+	move.usehull = usehull;
+
+	sim.m_TraceLineResult = sim.PlayerTrace( start, end, flags, ignore_pe, nullptr );
+
+	move.usehull = iOldHull;
+
+	return &sim.m_TraceLineResult;
+}
+
+int32 CPMoveSimulation::RandomLong( int32 lLow, int32 lHigh )
+{
+	auto& sim = *g_pSimulation;
+
+	const auto& values = sim.m_pFrame->RandomLongs;
+
+	if( sim.m_uiNextRandomLong < values.size() )
+		return values[ sim.m_uiNextRandomLong++ ];
+
+	sim.m_bRanOutOfValues = true;
+
+	if( lHigh <= lLow )
+		return lLow;
+
+	return lLow + sim.NextRandom() % ( lHigh - lLow + 1 );
+}
+
+float CPMoveSimulation::RandomFloat( float flLow, float flHigh )
+{
+	return flLow + ( flHigh - flLow ) * ( g_pSimulation->NextRandom() / static_cast<float>( 0x7FFF ) );
+}
+
+int CPMoveSimulation::GetModelType( model_t* mod )
+{
+	return mod->type;
+}
+
+void CPMoveSimulation::GetModelBounds( model_t* mod, Vector& mins, Vector& maxs )
+{
+	mins = mod->mins;
+	maxs = mod->maxs;
+}
+
+hull_t* CPMoveSimulation::HullForBsp( physent_t* pe, Vector& offset )
+{
+	return g_pSimulation->HullForEnt( pe, offset );
+}
+
+float CPMoveSimulation::TraceModel( physent_t* pEnt, const Vector& start, const Vector& end, trace_t* trace )
+{
+	auto& sim = *g_pSimulation;
+	auto& move = *sim.m_pMove;
+
+	++sim.m_Counts.uiTraces;
+
+	//Model traces use the point hull.
+	const int iOldHull = move.usehull;
+	move.usehull = 2;
+
+	Vector offset;
+	hull_t* hull = sim.HullForEnt( pEnt, offset );
+
+	move.usehull = iOldHull;
+
+	pmtrace_t result = pmtrace_t();
+
+	result.fraction = 1;
+	result.allsolid = true;
+	result.endpos = end - offset;
+
+	CPMoveWorld::RecursiveHullCheck( hull, hull->firstclipnode, 0, 1, start - offset, end - offset, &result );
+
+	*trace = trace_t();
+
+	trace->allsolid = result.allsolid;
+	trace->startsolid = result.startsolid;
+	trace->inopen = result.inopen;
+	trace->inwater = result.inwater;
+	trace->fraction = result.fraction;
+	trace->endpos = result.endpos;
+	trace->plane.normal = result.plane.normal;
+	trace->plane.dist = result.plane.dist;
+
+	return trace->fraction;
+}
+
+int CPMoveSimulation::COM_FileSize( char* )
+{
+	return -1;
+}
+
+byte* CPMoveSimulation::COM_LoadFile( char*, int, int* pLength )
+{
+	if( pLength )
+		*pLength = 0;
+
+	return nullptr;
+}
+
+void CPMoveSimulation::COM_FreeFile( void* )
+{
+}
+
+char* CPMoveSimulation::memfgets( byte*, int, int*, char*, int )
+{
+	return nullptr;
+}
+
+void CPMoveSimulation::PlaySound( int, const char*, float, float, int, int )
+{
+	++g_pSimulation->m_Counts.uiSounds;
+}
+
+const char* CPMoveSimulation::TraceTexture( int ground, const Vector& vstart, const Vector& vend )
+{
+	auto& sim = *g_pSimulation;
+	auto& move = *sim.m_pMove;
+
+	++sim.m_Counts.uiTextureTraces;
+
+	if( ground < 0 || ground >= move.numphysent )
+		return nullptr;
+
+	const physent_t* pe = &move.physents[ ground ];
+
+	if( !pe->model )
+		return nullptr;
+
+	return sim.m_World.TraceTexture( pe->model, vstart - pe->origin, vend - pe->origin );
+}
+
+void CPMoveSimulation::PlaybackEventFull( int, int, unsigned short, float, const Vector&, const Vector&,
+										  float, float, int, int, int, int )
+{
+	++g_pSimulation->m_Counts.uiSounds;
+}
+
+pmtrace_t CPMoveSimulation::PlayerTraceEx( const Vector& start, const Vector& end, int traceFlags, int ( *pfnIgnore )( physent_t* pe ) )
+{
+	return g_pSimulation->PlayerTrace( start, end, traceFlags, -1, pfnIgnore );
+}
+
+int CPMoveSimulation::TestPlayerPositionEx( const Vector& pos, pmtrace_t* ptrace, int ( *pfnIgnore )( physent_t* pe ) )
+{
+	return g_pSimulation->TestPlayerPosition( pos, ptrace, pfnIgnore );
+}
+
+edict_t* CPMoveSimulation::PEntityOfEntIndex( int iEntIndex )
+{
+	auto& sim = *g_pSimulation;
+
+	for( const auto& ent : sim.m_pFrame->PhysEnts )
+	{
+		if( ent.info == iEntIndex )
+		{
+			sim.m_Edict.v.velocity = ent.velocity;
+			return &sim.m_Edict;
+		}
+	}
+
+	sim.m_Edict.v.velocity = Vector( 0, 0, 0 );
+
+	return &sim.m_Edict;
+}
+
+pmtrace_t* CPMoveSimulation::TraceLineEx( const Vector& start, const Vector& end, int flags, int usehull, int ( *pfnIgnore )( physent_t* pe ) )
+{
+	auto& sim = *g_pSimulation;
+	auto& move = *sim.m_pMove;
+
+	const int iOldHull = move.usehull;
+	move.usehull = usehull;
+
+	sim.m_TraceLineResult = sim.PlayerTrace( start, end, flags, -1, pfnIgnore );
+
+	move.usehull = iOldHull;
+
+	return &sim.m_TraceLineResult;
+}
@@ -0,0 +1,159 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef UTILS_PMOVESIM_CPMOVESIMULATION_H
+#define UTILS_PMOVESIM_CPMOVESIMULATION_H
+
+#include <memory>
+
+#include "pm_record.h"
+
+class CPMoveWorld;
+
+/**
+*	Runs recorded moves through PM_Move, with the engine's movement callbacks implemented against a CPMoveWorld.
+*	Only one simulation can run moves at a time, the callbacks are plain functions.
+*/
+class CPMoveSimulation final
+{
+public:
+	/**
+	*	How often PM_Move called back into the engine.
+	*/
+	struct CallbackCounts
+	{
+		unsigned int uiTraces = 0;
+		unsigned int uiPositionTests = 0;
+		unsigned int uiPointContents = 0;
+		unsigned int uiTextureTraces = 0;
+		unsigned int uiSounds = 0;
+
+		unsigned int GetTotal() const
+		{
+			return uiTraces + uiPositionTests + uiPointContents + uiTextureTraces + uiSounds;
+		}
+	};
+
+public:
+	CPMoveSimulation( CPMoveWorld& world, const PMoveRecordHeader& header );
+	~CPMoveSimulation();
+
+	playermove_t* GetMove() { return m_pMove.get(); }
+
+	/**
+	*	Sets up the player and its surroundings as they were before the recorded move.
+	*	@return Whether the frame refers to models that the world has. Errors are printed.
+	*/
+	bool SetupFrame( const PMoveRecordFrame& frame );
+
+	/**
+	*	Runs PM_Move with the frame that was set up last.
+	*/
+	void Move();
+
+	/**
+	*	Counts of the last move.
+	*/
+	const CallbackCounts& GetCounts() const { return m_Counts; }
+
+	/**
+	*	@return Whether the last move asked for more random numbers or times than were recorded.
+	*	Values past the recorded ones are made up, the move may not match the recording.
+	*/
+	bool RanOutOfRecordedValues() const { return m_bRanOutOfValues; }
+
+	void SetVerbose( const bool bVerbose ) { m_bVerbose = bVerbose; }
+
+private:
+	bool SetupPhysEnts( const std::vector<PMoveRecordPhysEnt>& list, physent_t* pPhysEnts, int& iCount, const int iMaxCount );
+
+	hull_t* HullForEnt( physent_t* pe, Vector& offset );
+
+	pmtrace_t PlayerTrace( const Vector& start, const Vector& end, int traceFlags, int ignore_pe, int ( *pfnIgnore )( physent_t* pe ) );
+
+	int TestPlayerPosition( const Vector& pos, pmtrace_t* ptrace, int ( *pfnIgnore )( physent_t* pe ) );
+
+	int32 NextRandom();
+
+	//Engine callbacks.
+	static const char* Info_ValueForKey( const char* s, const char* key );
+	static void Particle( const Vector& origin, int color, float life, int zpos, int zvel );
+	static int PM_TestPlayerPosition( const Vector& pos, pmtrace_t* ptrace );
+	static void Con_NPrintf( int idx, const char* const pszFormat, ... );
+	static void Con_DPrintf( const char* const pszFormat, ... );
+	static void Con_Printf( const char* const pszFormat, ... );
+	static double Sys_FloatTime();
+	static void StuckTouch( int hitent, pmtrace_t* ptraceresult );
+	static int PointContents( const Vector& p, int* truecontents );
+	static int TruePointContents( const Vector& p );
+	static int HullPointContents( hull_t* hull, int num, const Vector& p );
+	static pmtrace_t PM_PlayerTrace( const Vector& start, const Vector& end, int traceFlags, int ignore_pe );
+	static pmtrace_t* TraceLine( const Vector& start, const Vector& end, int flags, int usehull, int ignore_pe );
+	static int32 RandomLong( int32 lLow, int32 lHigh );
+	static float RandomFloat( float flLow, float flHigh );
+	static int GetModelType( model_t* mod );
+	static void GetModelBounds( model_t* mod, Vector& mins, Vector& maxs );
+	static hull_t* HullForBsp( physent_t* pe, Vector& offset );
+	static float TraceModel( physent_t* pEnt, const Vector& start, const Vector& end, trace_t* trace );
+	static int COM_FileSize( char* filename );
+	static byte* COM_LoadFile( char* path, int usehunk, int* pLength );
+	static void COM_FreeFile( void* buffer );
+	static char* memfgets( byte* pMemFile, int fileSize, int* pFilePos, char* pBuffer, int bufferSize );
+	static void PlaySound( int channel, const char* sample, float volume, float attenuation, int fFlags, int pitch );
+	static const char* TraceTexture( int ground, const Vector& vstart, const Vector& vend );
+	static void PlaybackEventFull( int flags, int clientindex, unsigned short eventindex, float delay, const Vector& origin, const Vector& angles,
+								   float fparam1, float fparam2, int iparam1, int iparam2, int bparam1, int bparam2 );
+	static pmtrace_t PlayerTraceEx( const Vector& start, const Vector& end, int traceFlags, int ( *pfnIgnore )( physent_t* pe ) );
+	static int TestPlayerPositionEx( const Vector& pos, pmtrace_t* ptrace, int ( *pfnIgnore )( physent_t* pe ) );
+	static pmtrace_t* TraceLineEx( const Vector& start, const Vector& end, int flags, int usehull, int ( *pfnIgnore )( physent_t* pe ) );
+	static edict_t* PEntityOfEntIndex( int iEntIndex );
+
+private:
+	CPMoveWorld& m_World;
+
+	/**
+	*	playermove_t is too large for the stack.
+	*/
+	std::unique_ptr<playermove_t> m_pMove;
+
+	movevars_t m_MoveVars;
+
+	const PMoveRecordFrame* m_pFrame = nullptr;
+
+	size_t m_uiNextRandomLong = 0;
+	size_t m_uiNextFloatTime = 0;
+
+	//Made up values once the recorded ones run out.
+	uint32_t m_uiRandomSeed = 1;
+	double m_flLastTime = 0;
+
+	bool m_bRanOutOfValues = false;
+
+	CallbackCounts m_Counts;
+
+	bool m_bVerbose = false;
+
+	pmtrace_t m_TraceLineResult;
+
+	/**
+	*	Stands in for the entity that the movement code asks the engine for.
+	*/
+	edict_t m_Edict;
+
+private:
+	CPMoveSimulation( const CPMoveSimulation& ) = delete;
+	CPMoveSimulation& operator=( const CPMoveSimulation& ) = delete;
+};
+
+#endif //UTILS_PMOVESIM_CPMOVESIMULATION_H
@@ -0,0 +1,638 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "extdll.h"
+
+#include "pmtrace.h"
+
+#include "CPMoveWorld.h"
+
+namespace
+{
+/**
+*	Distance kept between the end of a trace and the plane it hit.
+*/
+const float DIST_EPSILON = 0.03125f;
+
+/**
+*	@return Whether the given lump is within the file and holds a whole number of elements of the given size.
+*/
+bool IsValidLump( const lump_t& lump, const size_t uiFileLength, const size_t uiSize )
+{
+	if( lump.fileofs < 0 || lump.filelen < 0 || static_cast<size_t>( lump.fileofs ) + lump.filelen > uiFileLength )
+		return false;
+
+	return ( lump.filelen % uiSize ) == 0;
+}
+
+/**
+*	@return Texture coordinate of a point, for one of the texture axes of a texinfo.
+*/
+float TexCoord( const float* pflAxis, const Vector& vecPoint )
+{
+	return vecPoint.x * pflAxis[ 0 ] + vecPoint.y * pflAxis[ 1 ] + vecPoint.z * pflAxis[ 2 ] + pflAxis[ 3 ];
+}
+
+template<typename T>
+const T* GetLump( const std::vector<byte>& data, const lump_t& lump, size_t& uiCount )
+{
+	uiCount = lump.filelen / sizeof( T );
+
+	return reinterpret_cast<const T*>( data.data() + lump.fileofs );
+}
+}
+
+const Vector CPMoveWorld::HULL_MINS[ MAX_MAP_HULLS ] =
+{
+	Vector( 0, 0, 0 ),
+	Vector( -16, -16, -36 ),
+	Vector( -32, -32, -32 ),
+	Vector( -16, -16, -18 )
+};
+
+const Vector CPMoveWorld::HULL_MAXS[ MAX_MAP_HULLS ] =
+{
+	Vector( 0, 0, 0 ),
+	Vector( 16, 16, 36 ),
+	Vector( 32, 32, 32 ),
+	Vector( 16, 16, 18 )
+};
+
+CPMoveWorld::CPMoveWorld()
+{
+	//Same layout as the engine's box hull: one node per side, the inside of the last one is solid.
+	m_BoxHull.clipnodes = m_BoxClipNodes;
+	m_BoxHull.planes = m_BoxPlanes;
+	m_BoxHull.firstclipnode = 0;
+	m_BoxHull.lastclipnode = 5;
+	m_BoxHull.clip_mins = Vector( 0, 0, 0 );
+	m_BoxHull.clip_maxs = Vector( 0, 0, 0 );
+
+	for( int i = 0; i < 6; ++i )
+	{
+		m_BoxClipNodes[ i ].planenum = i;
+
+		const int side = i & 1;
+
+		m_BoxClipNodes[ i ].children[ side ] = CONTENTS_EMPTY;
+		m_BoxClipNodes[ i ].children[ side ^ 1 ] = i != 5 ? i + 1 : CONTENTS_SOLID;
+
+		m_BoxPlanes[ i ].type = i >> 1;
+		m_BoxPlanes[ i ].normal = Vector( 0, 0, 0 );
+		m_BoxPlanes[ i ].normal[ i >> 1 ] = 1;
+		m_BoxPlanes[ i ].dist = 0;
+		m_BoxPlanes[ i ].signbits = 0;
+	}
+}
+
+void CPMoveWorld::Clear()
+{
+	m_Planes.clear();
+	m_ClipNodes.clear();
+	m_PointNodes.clear();
+	m_Nodes.clear();
+	m_Surfaces.clear();
+	m_TexInfo.clear();
+	m_TextureNames.clear();
+	m_Models.clear();
+}
+
+bool CPMoveWorld::Load( const char* const pszFileName, const char* const pszModelName )
+{
+	Clear();
+
+	std::vector<byte> data;
+
+	{
+		FILE* pFile = fopen( pszFileName, "rb" );
+
+		if( !pFile )
+		{
+			fprintf( stderr, "Couldn't open \"%s\"\n", pszFileName );
+			return false;
+		}
+
+		fseek( pFile, 0, SEEK_END );
+		const long iLength = ftell( pFile );
+		fseek( pFile, 0, SEEK_SET );
+
+		if( iLength > 0 )
+		{
+			data.resize( iLength );
+
+			if( fread( data.data(), iLength, 1, pFile ) != 1 )
+				data.clear();
+		}
+
+		fclose( pFile );
+	}
+
+	const auto pHeader = reinterpret_cast<const dheader_t*>( data.data() );
+
+	if( data.size() < sizeof( dheader_t ) || pHeader->version != BSPVERSION ||
+		!IsValidLump( pHeader->lumps[ LUMP_PLANES ], data.size(), sizeof( dplane_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_TEXTURES ], data.size(), 1 ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_VERTEXES ], data.size(), sizeof( dvertex_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_NODES ], data.size(), sizeof( dnode_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_TEXINFO ], data.size(), sizeof( dtexinfo_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_FACES ], data.size(), sizeof( dface_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_CLIPNODES ], data.size(), sizeof( dclipnode_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_LEAFS ], data.size(), sizeof( dleaf_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_EDGES ], data.size(), sizeof( dedge_t ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_SURFEDGES ], data.size(), sizeof( int ) ) ||
+		!IsValidLump( pHeader->lumps[ LUMP_MODELS ], data.size(), sizeof( dmodel_t ) ) )
+	{
+		fprintf( stderr, "\"%s\" is not a valid BSP file\n", pszFileName );
+		return false;
+	}
+
+	bool bIsValid = true;
+
+	size_t uiPlaneCount;
+	const auto pPlanes = GetLump<dplane_t>( data, pHeader->lumps[ LUMP_PLANES ], uiPlaneCount );
+
+	m_Planes.resize( uiPlaneCount );
+
+	for( size_t i = 0; i < uiPlaneCount; ++i )
+	{
+		auto& plane = m_Planes[ i ];
+
+		plane.normal = Vector( pPlanes[ i ].normal[ 0 ], pPlanes[ i ].normal[ 1 ], pPlanes[ i ].normal[ 2 ] );
+		plane.dist = pPlanes[ i ].dist;
+		plane.type = static_cast<byte>( pPlanes[ i ].type );
+		plane.signbits = 0;
+
+		for( int j = 0; j < 3; ++j )
+		{
+			if( plane.normal[ j ] < 0 )
+				plane.signbits |= 1 << j;
+		}
+	}
+
+	size_t uiClipNodeCount;
+	const auto pClipNodes = GetLump<dclipnode_t>( data, pHeader->lumps[ LUMP_CLIPNODES ], uiClipNodeCount );
+
+	m_ClipNodes.assign( pClipNodes, pClipNodes + uiClipNodeCount );
+
+	for( const auto& node : m_ClipNodes )
+	{
+		if( node.planenum < 0 || static_cast<size_t>( node.planenum ) >= uiPlaneCount ||
+			node.children[ 0 ] >= static_cast<int>( uiClipNodeCount ) || node.children[ 1 ] >= static_cast<int>( uiClipNodeCount ) )
+			bIsValid = false;
+	}
+
+	size_t uiLeafCount;
+	const auto pLeafs = GetLump<dleaf_t>( data, pHeader->lumps[ LUMP_LEAFS ], uiLeafCount );
+
+	size_t uiNodeCount;
+	const auto pNodes = GetLump<dnode_t>( data, pHeader->lumps[ LUMP_NODES ], uiNodeCount );
+
+	size_t uiFaceCount;
+	const auto pFaces = GetLump<dface_t>( data, pHeader->lumps[ LUMP_FACES ], uiFaceCount );
+
+	m_Nodes.assign( pNodes, pNodes + uiNodeCount );
+	m_PointNodes.resize( uiNodeCount );
+
+	for( size_t i = 0; i < uiNodeCount && bIsValid; ++i )
+	{
+		const auto& node = m_Nodes[ i ];
+
+		if( node.planenum < 0 || static_cast<size_t>( node.planenum ) >= uiPlaneCount ||
+			static_cast<size_t>( node.firstface ) + node.numfaces > uiFaceCount )
+			bIsValid = false;
+
+		m_PointNodes[ i ].planenum = node.planenum;
+
+		for( int j = 0; j < 2; ++j )
+		{
+			const int child = node.children[ j ];
+
+			if( child >= 0 )
+			{
+				if( static_cast<size_t>( child ) >= uiNodeCount )
+					bIsValid = false;
+
+				m_PointNodes[ i ].children[ j ] = child;
+			}
+			else
+			{
+				//The point hull has no leafs, only their contents.
+				const size_t uiLeaf = -1 - child;
+
+				if( uiLeaf >= uiLeafCount )
+				{
+					bIsValid = false;
+					break;
+				}
+
+				m_PointNodes[ i ].children[ j ] = pLeafs[ uiLeaf ].contents;
+			}
+		}
+	}
+
+	//Texture names. Missing textures have an offset of -1.
+	const auto& textureLump = pHeader->lumps[ LUMP_TEXTURES ];
+
+	if( textureLump.filelen >= static_cast<int>( sizeof( int ) ) )
+	{
+		const byte* pTextures = data.data() + textureLump.fileofs;
+		const int iTextureCount = *reinterpret_cast<const int*>( pTextures );
+
+		if( iTextureCount < 0 || static_cast<size_t>( iTextureCount + 1 ) * sizeof( int ) > static_cast<size_t>( textureLump.filelen ) )
+		{
+			bIsValid = false;
+		}
+		else
+		{
+			const int* pOffsets = reinterpret_cast<const int*>( pTextures ) + 1;
+
+			m_TextureNames.resize( iTextureCount );
+
+			for( int i = 0; i < iTextureCount; ++i )
+			{
+				if( pOffsets[ i ] < 0 || static_cast<size_t>( pOffsets[ i ] ) + sizeof( dmiptexname_t ) > static_cast<size_t>( textureLump.filelen ) )
+					continue;
+
+				const auto pMipTex = reinterpret_cast<const dmiptexname_t*>( pTextures + pOffsets[ i ] );
+
+				m_TextureNames[ i ].assign( pMipTex->name, strnlen( pMipTex->name, sizeof( pMipTex->name ) ) );
+			}
+		}
+	}
+
+	size_t uiTexInfoCount;
+	const auto pTexInfo = GetLump<dtexinfo_t>( data, pHeader->lumps[ LUMP_TEXINFO ], uiTexInfoCount );
+
+	m_TexInfo.resize( uiTexInfoCount );
+
+	for( size_t i = 0; i < uiTexInfoCount; ++i )
+	{
+		memcpy( m_TexInfo[ i ].vecs, pTexInfo[ i ].vecs, sizeof( m_TexInfo[ i ].vecs ) );
+
+		m_TexInfo[ i ].iTexture = pTexInfo[ i ].miptex >= 0 && static_cast<size_t>( pTexInfo[ i ].miptex ) < m_TextureNames.size() ? pTexInfo[ i ].miptex : -1;
+	}
+
+	//Texture extents, the texture trace only accepts points inside of them.
+	size_t uiVertexCount, uiEdgeCount, uiSurfEdgeCount;
+	const auto pVertexes = GetLump<dvertex_t>( data, pHeader->lumps[ LUMP_VERTEXES ], uiVertexCount );
+	const auto pEdges = GetLump<dedge_t>( data, pHeader->lumps[ LUMP_EDGES ], uiEdgeCount );
+	const auto pSurfEdges = GetLump<int>( data, pHeader->lumps[ LUMP_SURFEDGES ], uiSurfEdgeCount );
+
+	m_Surfaces.resize( uiFaceCount );
+
+	for( size_t i = 0; i < uiFaceCount && bIsValid; ++i )
+	{
+		const auto& face = pFaces[ i ];
+		auto& surface = m_Surfaces[ i ];
+
+		if( face.texinfo < 0 || static_cast<size_t>( face.texinfo ) >= uiTexInfoCount ||
+			face.firstedge < 0 || face.numedges < 0 || static_cast<size_t>( face.firstedge ) + face.numedges > uiSurfEdgeCount )
+		{
+			bIsValid = false;
+			break;
+		}
+
+		surface.iTexInfo = face.texinfo;
+
+		const auto& texInfo = m_TexInfo[ face.texinfo ];
+
+		float mins[ 2 ] = { 999999, 999999 };
+		float maxs[ 2 ] = { -99999, -99999 };
+
+		for( int iEdge = 0; iEdge < face.numedges; ++iEdge )
+		{
+			const int iSurfEdge = pSurfEdges[ face.firstedge + iEdge ];
+			const size_t uiEdge = abs( iSurfEdge );
+
+			if( uiEdge >= uiEdgeCount )
+			{
+				bIsValid = false;
+				break;
+			}
+
+			const size_t uiVertex = iSurfEdge >= 0 ? pEdges[ uiEdge ].v[ 0 ] : pEdges[ uiEdge ].v[ 1 ];
+
+			if( uiVertex >= uiVertexCount )
+			{
+				bIsValid = false;
+				break;
+			}
+
+			const float* pPoint = pVertexes[ uiVertex ].point;
+
+			for( int j = 0; j < 2; ++j )
+			{
+				const float val = TexCoord( texInfo.vecs[ j ], Vector( pPoint[ 0 ], pPoint[ 1 ], pPoint[ 2 ] ) );
+
+				if( val < mins[ j ] )
+					mins[ j ] = val;
+
+				if( val > maxs[ j ] )
+					maxs[ j ] = val;
+			}
+		}
+
+		for( int j = 0; j < 2; ++j )
+		{
+			const int bmins = static_cast<int>( floor( mins[ j ] / 16 ) );
+			const int bmaxs = static_cast<int>( ceil( maxs[ j ] / 16 ) );
+
+			surface.texturemins[ j ] = bmins * 16;
+			surface.extents[ j ] = ( bmaxs - bmins ) * 16;
+		}
+	}
+
+	size_t uiModelCount;
+	const auto pModels = GetLump<dmodel_t>( data, pHeader->lumps[ LUMP_MODELS ], uiModelCount );
+
+	for( size_t i = 0; i < uiModelCount && bIsValid; ++i )
+	{
+		const auto& in = pModels[ i ];
+
+		if( in.headnode[ 0 ] >= static_cast<int>( uiNodeCount ) )
+		{
+			bIsValid = false;
+			break;
+		}
+
+		for( int iHull = 1; iHull < MAX_MAP_HULLS; ++iHull )
+		{
+			if( in.headnode[ iHull ] >= static_cast<int>( uiClipNodeCount ) )
+				bIsValid = false;
+		}
+
+		auto model = std::make_unique<model_t>();
+
+		if( i == 0 )
+			strncpy( model->name, pszModelName, sizeof( model->name ) - 1 );
+		else
+			snprintf( model->name, sizeof( model->name ), "*%u", static_cast<unsigned int>( i ) );
+
+		model->type = mod_brush;
+
+		//The engine spreads the bounds by a unit.
+		for( int j = 0; j < 3; ++j )
+		{
+			model->mins[ j ] = in.mins[ j ] - 1;
+			model->maxs[ j ] = in.maxs[ j ] + 1;
+		}
+
+		for( int iHull = 0; iHull < MAX_MAP_HULLS; ++iHull )
+		{
+			auto& hull = model->hulls[ iHull ];
+
+			hull.clipnodes = iHull == 0 ? m_PointNodes.data() : m_ClipNodes.data();
+			hull.planes = m_Planes.data();
+			hull.firstclipnode = in.headnode[ iHull ];
+			hull.lastclipnode = static_cast<int>( iHull == 0 ? uiNodeCount : uiClipNodeCount ) - 1;
+			hull.clip_mins = HULL_MINS[ iHull ];
+			hull.clip_maxs = HULL_MAXS[ iHull ];
+		}
+
+		m_Models.emplace_back( std::move( model ) );
+	}
+
+	if( !bIsValid || m_Models.empty() )
+	{
+		fprintf( stderr, "\"%s\" is not a valid BSP file\n", pszFileName );
+		Clear();
+		return false;
+	}
+
+	return true;
+}
+
+model_t* CPMoveWorld::FindModel( const char* const pszName )
+{
+	if( m_Models.empty() )
+		return nullptr;
+
+	if( *pszName != '*' )
+		return m_Models[ 0 ].get();
+
+	char* pszEnd;
+	const unsigned long uiIndex = strtoul( pszName + 1, &pszEnd, 10 );
+
+	if( *pszEnd || uiIndex == 0 || uiIndex >= m_Models.size() )
+		return nullptr;
+
+	return m_Models[ uiIndex ].get();
+}
+
+hull_t* CPMoveWorld::HullForBox( const Vector& vecMins, const Vector& vecMaxs )
+{
+	m_BoxPlanes[ 0 ].dist = vecMaxs[ 0 ];
+	m_BoxPlanes[ 1 ].dist = vecMins[ 0 ];
+	m_BoxPlanes[ 2 ].dist = vecMaxs[ 1 ];
+	m_BoxPlanes[ 3 ].dist = vecMins[ 1 ];
+	m_BoxPlanes[ 4 ].dist = vecMaxs[ 2 ];
+	m_BoxPlanes[ 5 ].dist = vecMins[ 2 ];
+
+	return &m_BoxHull;
+}
+
+const char* CPMoveWorld::TraceTexture( const model_t* pModel, const Vector& vecStart, const Vector& vecEnd ) const
+{
+	const int iHeadNode = pModel->hulls[ 0 ].firstclipnode;
+
+	if( iHeadNode < 0 || pModel->hulls[ 0 ].clipnodes != m_PointNodes.data() )
+		return nullptr;
+
+	const auto pSurface = SurfaceAtPoint( iHeadNode, vecStart, vecEnd );
+
+	if( !pSurface )
+		return nullptr;
+
+	const int iTexture = m_TexInfo[ pSurface->iTexInfo ].iTexture;
+
+	return iTexture != -1 ? m_TextureNames[ iTexture ].c_str() : nullptr;
+}
+
+const CPMoveWorld::Surface* CPMoveWorld::SurfaceAtPoint( int iNode, const Vector& vecStart, const Vector& vecEnd ) const
+{
+	//Leafs have no surfaces.
+	if( iNode < 0 )
+		return nullptr;
+
+	const auto& node = m_Nodes[ iNode ];
+	const auto& plane = m_Planes[ node.planenum ];
+
+	const float front = DotProduct( vecStart, plane.normal ) - plane.dist;
+	const float back = DotProduct( vecEnd, plane.normal ) - plane.dist;
+
+	const int s = front < 0 ? 1 : 0;
+	const int t = back < 0 ? 1 : 0;
+
+	if( s == t )
+		return SurfaceAtPoint( node.children[ s ], vecStart, vecEnd );
+
+	const float frac = front / ( front - back );
+
+	const Vector vecMid = vecStart + ( vecEnd - vecStart ) * frac;
+
+	if( auto pSurface = SurfaceAtPoint( node.children[ s ], vecStart, vecMid ) )
+		return pSurface;
+
+	for( int i = 0; i < node.numfaces; ++i )
+	{
+		const auto& surface = m_Surfaces[ node.firstface + i ];
+		const auto& texInfo = m_TexInfo[ surface.iTexInfo ];
+
+		int ds = static_cast<int>( TexCoord( texInfo.vecs[ 0 ], vecMid ) );
+		int dt = static_cast<int>( TexCoord( texInfo.vecs[ 1 ], vecMid ) );
+
+		if( ds >= surface.texturemins[ 0 ] && dt >= surface.texturemins[ 1 ] )
+		{
+			ds -= surface.texturemins[ 0 ];
+			dt -= surface.texturemins[ 1 ];
+
+			if( ds <= surface.extents[ 0 ] && dt <= surface.extents[ 1 ] )
+				return &surface;
+		}
+	}
+
+	return SurfaceAtPoint( node.children[ t ], vecMid, vecEnd );
+}
+
+int CPMoveWorld::HullPointContents( const hull_t* hull, int num, const Vector& p )
+{
+	while( num >= 0 )
+	{
+		const auto& node = hull->clipnodes[ num ];
+		const auto& plane = hull->planes[ node.planenum ];
+
+		float d;
+
+		if( plane.type < 3 )
+			d = p[ plane.type ] - plane.dist;
+		else
+			d = DotProduct( plane.normal, p ) - plane.dist;
+
+		num = node.children[ d < 0 ? 1 : 0 ];
+	}
+
+	return num;
+}
+
+bool CPMoveWorld::RecursiveHullCheck( const hull_t* hull, int num, float p1f, float p2f, const Vector& p1, const Vector& p2, pmtrace_t* trace )
+{
+	//Check for empty.
+	if( num < 0 )
+	{
+		if( num != CONTENTS_SOLID )
+		{
+			trace->allsolid = false;
+
+			if( num == CONTENTS_EMPTY )
+				trace->inopen = true;
+			else
+				trace->inwater = true;
+		}
+		else
+			trace->startsolid = true;
+
+		return true;
+	}
+
+	const auto& node = hull->clipnodes[ num ];
+	const auto& plane = hull->planes[ node.planenum ];
+
+	float t1, t2;
+
+	if( plane.type < 3 )
+	{
+		t1 = p1[ plane.type ] - plane.dist;
+		t2 = p2[ plane.type ] - plane.dist;
+	}
+	else
+	{
+		t1 = DotProduct( plane.normal, p1 ) - plane.dist;
+		t2 = DotProduct( plane.normal, p2 ) - plane.dist;
+	}
+
+	if( t1 >= 0 && t2 >= 0 )
+		return RecursiveHullCheck( hull, node.children[ 0 ], p1f, p2f, p1, p2, trace );
+
+	if( t1 < 0 && t2 < 0 )
+		return RecursiveHullCheck( hull, node.children[ 1 ], p1f, p2f, p1, p2, trace );
+
+	//Put the crosspoint just on the near side of the plane.
+	float frac;
+
+	if( t1 < 0 )
+		frac = ( t1 + DIST_EPSILON ) / ( t1 - t2 );
+	else
+		frac = ( t1 - DIST_EPSILON ) / ( t1 - t2 );
+
+	if( frac < 0 )
+		frac = 0;
+
+	if( frac > 1 )
+		frac = 1;
+
+	float midf = p1f + ( p2f - p1f ) * frac;
+	Vector mid = p1 + ( p2 - p1 ) * frac;
+
+	const int side = t1 < 0 ? 1 : 0;
+
+	//Move up to the node.
+	if( !RecursiveHullCheck( hull, node.children[ side ], p1f, midf, p1, mid, trace ) )
+		return false;
+
+	//Go past the node.
+	if( HullPointContents( hull, node.children[ side ^ 1 ], mid ) != CONTENTS_SOLID )
+		return RecursiveHullCheck( hull, node.children[ side ^ 1 ], midf, p2f, mid, p2, trace );
+
+	//Never got out of the solid area.
+	if( trace->allsolid )
+		return false;
+
+	//The other side of the node is solid, this is the impact point.
+	if( !side )
+	{
+		trace->plane.normal = plane.normal;
+		trace->plane.dist = plane.dist;
+	}
+	else
+	{
+		trace->plane.normal = -plane.normal;
+		trace->plane.dist = -plane.dist;
+	}
+
+	while( HullPointContents( hull, hull->firstclipnode, mid ) == CONTENTS_SOLID )
+	{
+		//Shouldn't really happen, but does occasionally.
+		frac -= 0.1f;
+
+		if( frac < 0 )
+		{
+			trace->fraction = midf;
+			trace->endpos = mid;
+			return false;
+		}
+
+		midf = p1f + ( p2f - p1f ) * frac;
+		mid = p1 + ( p2 - p1 ) * frac;
+	}
+
+	trace->fraction = midf;
+	trace->endpos = mid;
+
+	return false;
+}
@@ -0,0 +1,128 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+#ifndef UTILS_PMOVESIM_CPMOVEWORLD_H
+#define UTILS_PMOVESIM_CPMOVEWORLD_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "com_model.h"
+#include "MiniBSPFile.h"
+
+struct pmtrace_t;
+
+/**
+*	The collision data of a BSP file: the clipping hulls of the world and its brush models, and the surfaces needed to find the texture under the player.
+*	Hull 0 is built from the BSP nodes and leaf contents, the way the engine builds it.
+*	Traces and contents queries work like the engine's, so movement run against this matches movement on a server.
+*/
+class CPMoveWorld final
+{
+public:
+	/**
+	*	Sizes of the engine's clipping hulls, which are compiled into the map.
+	*/
+	static const Vector HULL_MINS[ MAX_MAP_HULLS ];
+	static const Vector HULL_MAXS[ MAX_MAP_HULLS ];
+
+public:
+	CPMoveWorld();
+
+	/**
+	*	Loads the collision data of a BSP file.
+	*	@param pszFileName Name of the file.
+	*	@param pszModelName Name of the world model, as the engine names it.
+	*	@return Whether the file was loaded. Errors are printed.
+	*/
+	bool Load( const char* const pszFileName, const char* const pszModelName );
+
+	model_t* GetWorldModel() { return !m_Models.empty() ? m_Models[ 0 ].get() : nullptr; }
+
+	/**
+	*	Finds a brush model by name: "*n" for submodels, anything else is the world.
+	*	@return The model, or null if there's no such submodel.
+	*/
+	model_t* FindModel( const char* const pszName );
+
+	/**
+	*	Makes a hull for a box, in the space of the box's entity. The hull is overwritten by the next call.
+	*/
+	hull_t* HullForBox( const Vector& vecMins, const Vector& vecMaxs );
+
+	/**
+	*	Finds the texture at the point where a line enters a surface of the given model.
+	*	@param vecStart Start of the line, relative to the model.
+	*	@param vecEnd End of the line, relative to the model.
+	*	@return Texture name, or null if the line doesn't hit a surface.
+	*/
+	const char* TraceTexture( const model_t* pModel, const Vector& vecStart, const Vector& vecEnd ) const;
+
+	static int HullPointContents( const hull_t* hull, int num, const Vector& p );
+
+	/**
+	*	Traces a line through a hull. The trace must be initialized with a fraction of 1 and allsolid set.
+	*	@return false once the impact point has been found.
+	*/
+	static bool RecursiveHullCheck( const hull_t* hull, int num, float p1f, float p2f, const Vector& p1, const Vector& p2, pmtrace_t* trace );
+
+private:
+	struct TexInfo
+	{
+		float vecs[ 2 ][ 4 ];
+		int iTexture;
+	};
+
+	struct Surface
+	{
+		int iTexInfo;
+		int texturemins[ 2 ];
+		int extents[ 2 ];
+	};
+
+	void Clear();
+
+	const Surface* SurfaceAtPoint( int iNode, const Vector& vecStart, const Vector& vecEnd ) const;
+
+private:
+	std::vector<mplane_t> m_Planes;
+
+	/**
+	*	Clipnodes of hulls 1 to 3.
+	*/
+	std::vector<dclipnode_t> m_ClipNodes;
+
+	/**
+	*	Hull 0, leafs are replaced by their contents.
+	*/
+	std::vector<dclipnode_t> m_PointNodes;
+
+	std::vector<dnode_t> m_Nodes;
+	std::vector<Surface> m_Surfaces;
+	std::vector<TexInfo> m_TexInfo;
+	std::vector<std::string> m_TextureNames;
+
+	std::vector<std::unique_ptr<model_t>> m_Models;
+
+	hull_t m_BoxHull;
+	dclipnode_t m_BoxClipNodes[ 6 ];
+	mplane_t m_BoxPlanes[ 6 ];
+
+private:
+	CPMoveWorld( const CPMoveWorld& ) = delete;
+	CPMoveWorld& operator=( const CPMoveWorld& ) = delete;
+};
+
+#endif //UTILS_PMOVESIM_CPMOVEWORLD_H
@@ -0,0 +1,441 @@
+/***
+*
+*	Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+*
+*	This product contains software technology licensed from Id
+*	Software, Inc. ("Id Technology").  Id Technology (c) 1996 Id Software, Inc.
+*	All Rights Reserved.
+*
+*   Use, distribution, and modification of this source code and/or resulting
+*   object code is restricted to non-commercial enhancements to products from
+*   Valve LLC.  All other use, distribution, or modification is prohibited
+*   without written permission from Valve LLC.
+*
+****/
+/**
+*	@file
+*
+*	pmovesim: replays player movement recorded with sv_pmove_record, without the engine.
+*	Every recorded move is run through PM_Move against the map's collision hulls, and the result is compared with the recorded result.
+*	Moves are timed, so changes to the movement code can be checked for both correctness and speed.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "extdll.h"
+#include "util.h"
+
+#include "pm_defs.h"
+#include "pm_shared.h"
+#include "pm_record.h"
+
+#include "materials/Materials.h"
+
+#include "CPMoveWorld.h"
+#include "CPMoveSimulation.h"
+
+//Movement code expects these, the tool provides what it needs.
+enginefuncs_t g_engfuncs;
+IFileSystem* g_pFileSystem = nullptr;
+
+namespace
+{
+enum ExitCode
+{
+	EXIT_MATCH			= 0,
+	EXIT_MISMATCH		= 1,
+	EXIT_ERROR			= 2
+};
+
+struct Options
+{
+	const char* pszMapFileName = nullptr;
+	const char* pszRecordFileName = nullptr;
+	const char* pszMaterialsFileName = nullptr;
+	const char* pszOutputFileName = nullptr;
+
+	unsigned int uiIterations = 0;
+
+	float flTolerance = 0.01f;
+
+	bool bVerbose = false;
+};
+
+/**
+*	Results of one move.
+*/
+struct MoveResult
+{
+	//Fastest time of all passes, in nanoseconds.
+	long long iTime = std::numeric_limits<long long>::max();
+
+	PMoveRecordDifference difference;
+
+	unsigned int uiCallbacks = 0;
+};
+
+bool g_bVerbose = false;
+
+void AlertMessage( ALERT_TYPE aType, const char* pszFormat, ... )
+{
+	if( aType != at_console && aType != at_error && aType != at_warning && !g_bVerbose )
+		return;
+
+	va_list list;
+	va_start( list, pszFormat );
+	vprintf( pszFormat, list );
+	va_end( list );
+}
+
+void PrintUsage()
+{
+	printf(
+		"Usage: pmovesim [options] <map.bsp> <recording>\n"
+		"Replays player movement recorded with sv_pmove_record, and compares the result with the recording.\n"
+		"Options:\n"
+		"\t-materials <file>\tMaterials list to use, sound/materials.txt in the game directory\n"
+		"\t-iterations <count>\tNumber of extra passes to time moves with\n"
+		"\t-tolerance <value>\tLargest difference that is still a match (default 0.01)\n"
+		"\t-output <file>\t\tWrite a recording with the replayed results\n"
+		"\t-verbose\t\tPrint messages from the movement code\n"
+		"Exits with 0 if all moves match, 1 if a move doesn't, 2 on error.\n" );
+}
+
+bool ParseOptions( const int argc, char* argv[], Options& options )
+{
+	int i;
+
+	for( i = 1; i < argc && argv[ i ][ 0 ] == '-'; ++i )
+	{
+		const char* pszOption = argv[ i ];
+
+		if( !strcmp( pszOption, "-verbose" ) )
+		{
+			options.bVerbose = true;
+			continue;
+		}
+
+		if( i + 1 >= argc )
+		{
+			fprintf( stderr, "Option \"%s\" needs a value\n", pszOption );
+			return false;
+		}
+
+		const char* pszValue = argv[ ++i ];
+
+		if( !strcmp( pszOption, "-materials" ) )
+			options.pszMaterialsFileName = pszValue;
+		else if( !strcmp( pszOption, "-output" ) )
+			options.pszOutputFileName = pszValue;
+		else if( !strcmp( pszOption, "-iterations" ) )
+			options.uiIterations = static_cast<unsigned int>( max( 0, atoi( pszValue ) ) );
+		else if( !strcmp( pszOption, "-tolerance" ) )
+			options.flTolerance = static_cast<float>( atof( pszValue ) );
+		else
+		{
+			fprintf( stderr, "Unknown option \"%s\"\n", pszOption );
+			return false;
+		}
+	}
+
+	if( argc - i != 2 )
+		return false;
+
+	options.pszMapFileName = argv[ i ];
+	options.pszRecordFileName = argv[ i + 1 ];
+
+	return true;
+}
+
+bool LoadMaterials( const char* const pszFileName )
+{
+	FILE* pFile = fopen( pszFileName, "rb" );
+
+	if( !pFile )
+	{
+		fprintf( stderr, "Couldn't open materials file \"%s\"\n", pszFileName );
+		return false;
+	}
+
+	std::vector<char> buffer;
+
+	char szChunk[ 4096 ];
+	size_t uiRead;
+
+	while( ( uiRead = fread( szChunk, 1, sizeof( szChunk ), pFile ) ) > 0 )
+		buffer.insert( buffer.end(), szChunk, szChunk + uiRead );
+
+	fclose( pFile );
+
+	buffer.push_back( '\0' );
+
+	return g_MaterialsList.LoadFromBuffer( buffer.data() );
+}
+
+/**
+*	Runs every frame once.
+*	@return Whether every frame could be set up.
+*/
+bool RunPass( CPMoveSimulation& simulation, std::vector<PMoveRecordFrame>& frames, std::vector<MoveResult>& results, const bool bCompare, bool& bRanOutOfValues )
+{
+	for( size_t i = 0; i < frames.size(); ++i )
+	{
+		auto& frame = frames[ i ];
+		auto& result = results[ i ];
+
+		if( !simulation.SetupFrame( frame ) )
+		{
+			fprintf( stderr, "Frame %u can't be replayed\n", static_cast<unsigned int>( i ) );
+			return false;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		simulation.Move();
+
+		const auto end = std::chrono::steady_clock::now();
+
+		result.iTime = std::min<long long>( result.iTime, std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count() );
+
+		if( bCompare )
+		{
+			PMoveRecordState state;
+			PM_SaveRecordState( *simulation.GetMove(), state );
+
+			result.difference = PM_CompareRecordStates( frame.Post, state );
+			result.uiCallbacks = simulation.GetCounts().GetTotal();
+
+			if( simulation.RanOutOfRecordedValues() )
+				bRanOutOfValues = true;
+
+			//Keep the replayed result, in case it's written out.
+			frame.Post = state;
+		}
+	}
+
+	return true;
+}
+
+double Microseconds( const long long iNanoseconds )
+{
+	return iNanoseconds / 1000.0;
+}
+
+void PrintReport( const Options& options, const std::vector<PMoveRecordFrame>& frames, const std::vector<MoveResult>& results, const bool bRanOutOfValues )
+{
+	size_t uiMismatches = 0;
+	size_t uiFirstMismatch = 0;
+	size_t uiLargest = 0;
+
+	unsigned long long uiTotalCallbacks = 0;
+	unsigned int uiMaxCallbacks = 0;
+
+	std::vector<long long> times;
+	times.reserve( results.size() );
+
+	for( size_t i = 0; i < results.size(); ++i )
+	{
+		const auto& result = results[ i ];
+
+		if( result.difference.pszField && result.difference.flDifference > options.flTolerance )
+		{
+			if( !uiMismatches )
+				uiFirstMismatch = i;
+
+			++uiMismatches;
+		}
+
+		if( result.difference.flDifference > results[ uiLargest ].difference.flDifference )
+			uiLargest = i;
+
+		uiTotalCallbacks += result.uiCallbacks;
+		uiMaxCallbacks = std::max( uiMaxCallbacks, result.uiCallbacks );
+
+		times.push_back( result.iTime );
+	}
+
+	printf( "Moves: %u\n", static_cast<unsigned int>( results.size() ) );
+
+	const auto& largest = results[ uiLargest ].difference;
+
+	if( largest.pszField )
+		printf( "Largest difference: %g in %s, move %u\n", largest.flDifference, largest.pszField, static_cast<unsigned int>( uiLargest ) );
+	else
+		printf( "Largest difference: none\n" );
+
+	printf( "Moves over tolerance %g: %u\n", options.flTolerance, static_cast<unsigned int>( uiMismatches ) );
+
+	if( uiMismatches )
+	{
+		const auto& first = results[ uiFirstMismatch ].difference;
+
+		printf( "First divergence: move %u (player %d), %s differs by %g\n",
+				static_cast<unsigned int>( uiFirstMismatch ), frames[ uiFirstMismatch ].iPlayerIndex + 1, first.pszField, first.flDifference );
+	}
+
+	std::vector<long long> sorted = times;
+	std::sort( sorted.begin(), sorted.end() );
+
+	long long iTotal = 0;
+
+	for( auto iTime : sorted )
+		iTotal += iTime;
+
+	printf( "Time per move (us): mean %.3f, median %.3f, p99 %.3f, max %.3f\n",
+			Microseconds( iTotal ) / sorted.size(),
+			Microseconds( sorted[ sorted.size() / 2 ] ),
+			Microseconds( sorted[ std::min( sorted.size() - 1, ( sorted.size() * 99 ) / 100 ) ] ),
+			Microseconds( sorted.back() ) );
+
+	printf( "Engine callbacks per move: mean %.1f, max %u\n", static_cast<double>( uiTotalCallbacks ) / results.size(), uiMaxCallbacks );
+
+	//Slowest moves, with what they were doing.
+	std::vector<size_t> slowest( results.size() );
+
+	for( size_t i = 0; i < slowest.size(); ++i )
+		slowest[ i ] = i;
+
+	const size_t uiSlowestCount = std::min<size_t>( 5, slowest.size() );
+
+	std::partial_sort( slowest.begin(), slowest.begin() + uiSlowestCount, slowest.end(),
+		[ & ]( size_t lhs, size_t rhs )
+		{
+			return times[ lhs ] > times[ rhs ];
+		}
+	);
+
+	printf( "Slowest moves:\n" );
+
+	for( size_t i = 0; i < uiSlowestCount; ++i )
+	{
+		const size_t uiMove = slowest[ i ];
+		const auto& frame = frames[ uiMove ];
+
+		printf( "\tmove %u: %.3f us, %u callbacks, movetype %d, waterlevel %d, %u entities\n",
+				static_cast<unsigned int>( uiMove ), Microseconds( times[ uiMove ] ), results[ uiMove ].uiCallbacks,
+				frame.Pre.movetype, frame.Pre.waterlevel, static_cast<unsigned int>( frame.PhysEnts.size() ) );
+	}
+
+	if( bRanOutOfValues )
+		printf( "Some moves used more random numbers or times than were recorded, those moves may not match\n" );
+}
+}
+
+int main( int argc, char* argv[] )
+{
+	Options options;
+
+	if( !ParseOptions( argc, argv, options ) )
+	{
+		PrintUsage();
+		return EXIT_ERROR;
+	}
+
+	g_bVerbose = options.bVerbose;
+	g_engfuncs.pfnAlertMessage = &AlertMessage;
+
+	if( options.pszMaterialsFileName )
+	{
+		if( !LoadMaterials( options.pszMaterialsFileName ) )
+			return EXIT_ERROR;
+	}
+	else
+	{
+		printf( "No materials list given, all textures are concrete\n" );
+		g_MaterialsList.LoadFromBuffer( "" );
+	}
+
+	PMoveRecordHeader header;
+	std::vector<PMoveRecordFrame> frames;
+
+	{
+		CPMoveRecordReader reader;
+
+		if( !reader.Open( options.pszRecordFileName, header ) )
+		{
+			fprintf( stderr, "Couldn't read recording \"%s\": %s\n", options.pszRecordFileName, reader.GetError().c_str() );
+			return EXIT_ERROR;
+		}
+
+		PMoveRecordFrame frame;
+
+		while( reader.ReadFrame( frame ) )
+			frames.push_back( frame );
+
+		if( !reader.GetError().empty() )
+		{
+			fprintf( stderr, "Couldn't read recording \"%s\": %s\n", options.pszRecordFileName, reader.GetError().c_str() );
+			return EXIT_ERROR;
+		}
+	}
+
+	if( frames.empty() )
+	{
+		fprintf( stderr, "Recording \"%s\" has no moves\n", options.pszRecordFileName );
+		return EXIT_ERROR;
+	}
+
+	CPMoveWorld world;
+
+	{
+		char szModelName[ 128 ];
+		snprintf( szModelName, sizeof( szModelName ), "maps/%s.bsp", header.szMapName );
+
+		if( !world.Load( options.pszMapFileName, szModelName ) )
+			return EXIT_ERROR;
+	}
+
+	CPMoveSimulation simulation( world, header );
+
+	simulation.SetVerbose( options.bVerbose );
+
+	PM_InitMovement( simulation.GetMove() );
+
+	//The recorded results are needed for every pass, compare against a copy.
+	std::vector<PMoveRecordFrame> replayed = frames;
+	std::vector<MoveResult> results( frames.size() );
+
+	bool bRanOutOfValues = false;
+
+	if( !RunPass( simulation, replayed, results, true, bRanOutOfValues ) )
+		return EXIT_ERROR;
+
+	//Extra passes only time moves, the first pass has warmed up the caches.
+	for( unsigned int uiPass = 0; uiPass < options.uiIterations; ++uiPass )
+	{
+		if( !RunPass( simulation, frames, results, false, bRanOutOfValues ) )
+			return EXIT_ERROR;
+	}
+
+	PrintReport( options, frames, results, bRanOutOfValues );
+
+	if( options.pszOutputFileName )
+	{
+		CPMoveRecordWriter writer;
+
+		if( !writer.Open( options.pszOutputFileName, header ) )
+		{
+			fprintf( stderr, "Couldn't create \"%s\"\n", options.pszOutputFileName );
+			return EXIT_ERROR;
+		}
+
+		for( const auto& frame : replayed )
+			writer.WriteFrame( frame );
+	}
+
+	for( const auto& result : results )
+	{
+		if( result.difference.pszField && result.difference.flDifference > options.flTolerance )
+			return EXIT_MISMATCH;
+	}
+
+	return EXIT_MATCH;
+}
@@ -12,6 +12,13 @@
 
 #include "qrad.h"
 
+#ifdef WIN32
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
 
 /*
 
@@ -685,6 +692,90 @@ MakeScales
 =============
 */
 int	total_transfer;
+double	total_transfer_bytes;
+
+/*
+=============
+WriteTransferPatch
+
+Writes the difference to the previous patch index, 7 bits per byte
+=============
+*/
+static byte *WriteTransferPatch (byte *out, int delta)
+{
+	while (delta >= 0x80)
+	{
+		*out++ = (byte)(delta | 0x80);
+		delta >>= 7;
+	}
+	*out++ = (byte)delta;
+
+	return out;
+}
+
+/*
+=============
+ReadTransferPatch
+
+Adds the next difference to the patch index
+=============
+*/
+static byte *ReadTransferPatch (byte *in, int *patchnum)
+{
+	int		delta;
+	int		shift;
+
+	delta = 0;
+	shift = 0;
+	while (*in & 0x80)
+	{
+		delta |= (*in++ & 0x7f) << shift;
+		shift += 7;
+	}
+	delta |= *in++ << shift;
+
+	*patchnum += delta;
+
+	return in;
+}
+
+/*
+=============
+CompressTransfers
+
+Transfer lists are the bulk of qrad's memory use.  They are stored as
+16 bit weights, followed by the patch indices as variable length
+differences from the previous index, which usually fit in a byte.
+=============
+*/
+void CompressTransfers (patch_t *patch, transfer_t *list)
+{
+	int		i;
+	int		prev;
+	byte	*out;
+	byte	scratch[4];
+
+	prev = 0;
+	patch->transfersize = 0;
+	for (i=0 ; i<patch->numtransfers ; i++)
+	{
+		patch->transfersize += WriteTransferPatch (scratch, list[i].patch - prev) - scratch;
+		prev = list[i].patch;
+	}
+
+	patch->transfers = malloc (TransferBlockSize (patch));
+	if (!patch->transfers)
+		Error ("Memory allocation failure");
+
+	out = TransferPatches (patch);
+	prev = 0;
+	for (i=0 ; i<patch->numtransfers ; i++)
+	{
+		patch->transfers[i] = list[i].transfer;
+		out = WriteTransferPatch (out, list[i].patch - prev);
+		prev = list[i].patch;
+	}
+}
 
 void MakeScales (int threadnum)
 {
@@ -700,8 +791,10 @@ void MakeScales (int threadnum)
 	vec3_t		origin;
 	vec_t		area;
 	transfer_t	transfers[MAX_PATCHES], *all_transfers;
+	double		bytes;
 
 	count = 0;
+	bytes = 0;
 
 	while (1)
 	{
@@ -772,30 +865,22 @@ void MakeScales (int threadnum)
 		// copy the transfers out
 		if (patch->numtransfers)
 		{
-			transfer_t	*t, *t2;
-
-			patch->transfers = calloc (patch->numtransfers, sizeof(transfer_t));
-
-			if (!patch->transfers)
-				Error ("Memory allocation failure");
-
 			//
 			// normalize all transfers so exactly 50% of the light
 			// is transfered to the surroundings
 			//
 			total = 0.5f/total;
-			t = patch->transfers;
-			t2 = transfers;
-			for (j=0 ; j<(unsigned)patch->numtransfers ; j++, t++, t2++)
-			{
-				t->transfer = (unsigned short)(t2->transfer*total);
-				t->patch = t2->patch;
-			}
+			for (j=0 ; j<(unsigned)patch->numtransfers ; j++)
+				transfers[j].transfer = (unsigned short)(transfers[j].transfer*total);
+
+			CompressTransfers (patch, transfers);
+			bytes += TransferBlockSize (patch);
 		}
 	}
 
 	ThreadLock ();
 	total_transfer += count;
+	total_transfer_bytes += bytes;
 	ThreadUnlock ();
 }
 
@@ -839,79 +924,76 @@ void WriteWorld (char *name)
 
 /*
 =============
-SwapTransfersTask
+SwapTransfers
 
 Change transfers from light sent out to light collected in.
 In an ideal world, they would be exactly symetrical, but
 because the form factors are only aproximated, then normalized,
 they will actually be rather different.
+
+The patch indices can only be read in order, so every list keeps a
+cursor.  Lists are sorted and patches are visited in order, so the
+matching entry is always at or after the cursor.
 =============
 */
-void SwapTransfersTask (int patchnum)
+void SwapTransfers (void)
 {
-	int		j, k, l, m, n, h;
+	unsigned	i;
+	int		j, k;
 	patch_t	*patch, *patch2;
-	transfer_t	*t, *t2;
+	byte	*in;
+	byte	**cursor;
+	int		*cursorpos, *cursorpatch;
 	int		transfer;
 
-	patch = patches + patchnum;
+	cursor = malloc (num_patches * sizeof(*cursor));
+	cursorpos = malloc (num_patches * sizeof(int));
+	cursorpatch = malloc (num_patches * sizeof(int));
+	if (!cursor || !cursorpos || !cursorpatch)
+		Error ("Memory allocation failure");
 
-	t = patch->transfers;
-	for (j=0 ; j<patch->numtransfers ; j++, t++)
+	for (i=0, patch=patches ; i<num_patches ; i++, patch++)
 	{
-		k = t->patch;
-		if (k > patchnum)
-			break;		// done with this list
-		patch2 = &patches[k];
-		t2 = patch2->transfers;
+		cursorpos[i] = 0;
+		cursorpatch[i] = 0;
+		if (patch->numtransfers)
+			cursor[i] = ReadTransferPatch (TransferPatches (patch), &cursorpatch[i]);
+		else
+			cursorpatch[i] = num_patches;
+	}
 
-		if (!patch2->numtransfers)
-		{
-			printf ("WARNING: SwapTransfers: unmatched\n");
-			continue;
-		}
-		//
-		// binary search for match
-		//
-		l = 0;
-		h = patch2->numtransfers-1;
-		while (1)
+	for (i=0, patch=patches ; i<num_patches ; i++, patch++)
+	{
+		in = TransferPatches (patch);
+		k = 0;
+		for (j=0 ; j<patch->numtransfers ; j++)
 		{
-			m = (l+h)>>1;
-			n = t2[m].patch;
-			if (n < patchnum)
+			in = ReadTransferPatch (in, &k);
+			if ((unsigned)k >= i)
+				break;		// done with this list
+			patch2 = &patches[k];
+
+			while ((unsigned)cursorpatch[k] < i && cursorpos[k] < patch2->numtransfers-1)
 			{
-				l = m+1;
-				continue;
+				cursor[k] = ReadTransferPatch (cursor[k], &cursorpatch[k]);
+				cursorpos[k]++;
 			}
-			if (n > patchnum)
+
+			if ((unsigned)cursorpatch[k] != i)
 			{
-				h = m-1;
+				printf ("WARNING: SwapTransfers: unmatched\n");
 				continue;
 			}
 
-			t2 += m;
-			transfer = t2->transfer;
-			t2->transfer = t->transfer;
-			t->transfer = transfer;
-			break;
+			transfer = patch2->transfers[cursorpos[k]];
+			patch2->transfers[cursorpos[k]] = patch->transfers[j];
+			patch->transfers[j] = transfer;
 		}
-
-#if 0
-		for (l=0 ; l<patch2->numtransfers ; l++, t2++)
-		{
-			if (t2->patch == i)
-			{
-				transfer = t2->transfer;
-				t2->transfer = t->transfer;
-				t->transfer = transfer;
-				break;
-			}
-		}
-#endif
-		if (l == patch2->numtransfers)
-			Error ("Didn't match transfer");
 	}
+
+	free (cursor);
+	free (cursorpos);
+	free (cursorpatch);
 }
 
 /*
@@ -955,8 +1037,9 @@ Get light from other patches
 */
 void GatherLight (int threadnum)
 {
-	int			j, k;
-	transfer_t	*trans;
+	int			j, k, n;
+	unsigned short	*weight;
+	byte		*in;
 	int			num;
 	patch_t		*patch;
 	vec3_t		sum, v;
@@ -969,14 +1052,16 @@ void GatherLight (int threadnum)
 
 		patch = &patches[j];
 
-		trans = patch->transfers;
+		weight = patch->transfers;
+		in = TransferPatches (patch);
 		num = patch->numtransfers;
 
 		VectorFill( sum, 0 )
 
-		for (k=0 ; k<num ; k++, trans++)
+		for (k=0, n=0 ; k<num ; k++, weight++)
 		{
-			VectorScale( emitlight[trans->patch], trans->transfer, v );
+			in = ReadTransferPatch (in, &n);
+			VectorScale( emitlight[n], *weight, v );
 			VectorAdd( sum, v, sum );
 		}
 
@@ -1016,49 +1101,57 @@ void BounceLight (void)
 /*
 =============
 writetransfers
+
+The file is a version and patch count, the numtransfers and transfersize
+of every patch, and then the transfer blocks of every patch.
+The transfers are saved after they have been swapped.
 =============
 */
 
+#define	TRANSFERFILE_VERSION	2
+
 long
 writetransfers(char *transferfile, long total_patches)
 {
 	int		handle;
-	long	writtenpatches = 0, writtentransfers = 0, totalbytes = 0;
-	int		spacerequired = sizeof(long) + total_patches * sizeof(long) + total_transfer * sizeof(transfer_t);
+	long	writtenpatches = 0, totalbytes = 0;
+	int		header[2];
+	double	spacerequired = sizeof(header) + total_patches * 2 * sizeof(int) + total_transfer_bytes;
 
 	if ( spacerequired - getfilesize(transferfile) < getfreespace(transferfile) )
 	{
 		if ( (handle = _open( transferfile, _O_WRONLY | _O_BINARY | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE )) != -1 )
 		{
-			unsigned			byteswritten;
+			patch_t			*patch;
+			int				sizes[2];
+			long			i;
+
 			qprintf("Writing [%s] with new saved qrad data", transferfile );
-			
-			if ( (byteswritten = _write(handle, &total_patches, sizeof(total_patches))) == sizeof(total_patches) )
+
+			header[0] = TRANSFERFILE_VERSION;
+			header[1] = total_patches;
+
+			if ( _write(handle, header, sizeof(header)) == sizeof(header) )
 			{
-				patch_t			*patch;
+				totalbytes += sizeof(header);
 
-				totalbytes += byteswritten;
+				for( i = 0, patch = patches; i < total_patches; i++, patch++ )
+				{
+					sizes[0] = patch->numtransfers;
+					sizes[1] = patch->transfersize;
+					if ( _write(handle, sizes, sizeof(sizes)) != sizeof(sizes) )
+						break;
+					totalbytes += sizeof(sizes);
+				}
 
-				for( patch = patches; total_patches-- > 0; patch++ )
+				for( i = 0, patch = patches; i < total_patches; i++, patch++ )
 				{
-					if ( (byteswritten = _write(handle, &patch->numtransfers, sizeof(patch->numtransfers)))
-					  == sizeof(patch->numtransfers) )
-					{
-						totalbytes += byteswritten;
-
-						if ( patch->numtransfers && 
-							 (byteswritten = _write(handle, patch->transfers, patch->numtransfers*sizeof(transfer_t)))
-						      == patch->numtransfers*sizeof(transfer_t) )
-						{
-							totalbytes += byteswritten;
-							writtentransfers += patch->numtransfers;
-						}
-						writtenpatches++;
-					}
-					else
-					{
+					int		size = patch->numtransfers ? TransferBlockSize(patch) : 0;
+
+					if ( size && _write(handle, patch->transfers, size) != size )
 						break;
-					}
+					totalbytes += size;
+					writtenpatches++;
 				}
 			}
 
@@ -1068,13 +1161,73 @@ writetransfers(char *transferfile, long total_patches)
 		}
 	}
 	else
-		printf("Insufficient disk space(%ld) for 'QRAD save file'[%s]!\n",
+		printf("Insufficient disk space(%.0f) for 'QRAD save file'[%s]!\n",
 				spacerequired - getfilesize(transferfile), transferfile );
 
 
 	return writtenpatches;
 }
 
+/*
+=============
+MapTransferFile
+
+Maps the whole file read only, the pages are loaded as they're used
+and can be dropped by the system instead of being swapped out.
+The view stays mapped until qrad exits.
+=============
+*/
+byte *MapTransferFile (char *filename, long *size)
+{
+	byte	*view;
+#ifdef WIN32
+	HANDLE	file, mapping;
+
+	file = CreateFile (filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	*size = GetFileSize (file, NULL);
+	view = NULL;
+
+	if (*size > 0 && (mapping = CreateFileMapping (file, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
+	{
+		view = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle (mapping);
+	}
+
+	CloseHandle (file);
+#else
+	int			handle;
+	struct stat	st;
+
+	if ( (handle = open (filename, O_RDONLY)) == -1 )
+		return NULL;
+
+	view = NULL;
+	if (fstat (handle, &st) == 0 && st.st_size > 0)
+	{
+		*size = st.st_size;
+		view = mmap (NULL, *size, PROT_READ, MAP_SHARED, handle, 0);
+		if (view == MAP_FAILED)
+			view = NULL;
+	}
+
+	close (handle);
+#endif
+
+	return view;
+}
+
+void UnmapTransferFile (byte *view, long size)
+{
+#ifdef WIN32
+	UnmapViewOfFile (view);
+#else
+	munmap (view, size);
+#endif
+}
+
 /*
 =============
 readtransfers
@@ -1084,82 +1237,78 @@ readtransfers
 long
 readtransfers(char *transferfile, long numpatches)
 {
-	int		handle;
-	long	readpatches = 0, readtransfers = 0, totalbytes = 0;
+	long	readpatches = 0, readtransfers = 0;
 	long	start, end;
+	long	size, offset;
+	int		*header, *sizes;
+	byte	*view;
+	patch_t	*patch;
+	double	bytes = 0;
+
 	time(&start);
-	if ( (handle = _open( transferfile, _O_RDONLY | _O_BINARY )) != -1 )
+
+	if ( (view = MapTransferFile( transferfile, &size )) != NULL )
 	{
-		long			filepatches;
-		unsigned long	bytesread;
+		printf("%-20s Mapping [%-13s - ", "MakeAllScales:", transferfile );
 
-		printf("%-20s Restoring [%-13s - ", "MakeAllScales:", transferfile );
-		
-		if ( (bytesread = _read(handle, &filepatches, sizeof(filepatches))) == sizeof(filepatches) )
-		{
-			if ( filepatches == numpatches )
-			{
+		header = (int *)view;
+		offset = 2 * sizeof(int) + numpatches * 2 * sizeof(int);
 
-				patch_t			*patch;
+		if ( size < offset || header[0] != TRANSFERFILE_VERSION )
+			printf("\nOld or damaged transfer file!  Save file will now be rebuilt." );
+		else if ( header[1] != numpatches )
+			printf("\nIncorrect transfer patch count found!  Save file will now be rebuilt." );
+		else
+		{
+			sizes = header + 2;
 
-				totalbytes += bytesread;
+			for( patch = patches; readpatches < numpatches; patch++, sizes += 2 )
+			{
+				patch->numtransfers = sizes[0];
+				patch->transfersize = sizes[1];
+				patch->transfers = (unsigned short *)(view + offset);
 
-				for( patch = patches; readpatches < numpatches; patch++ )
+				if ( patch->numtransfers )
 				{
-					if ( (bytesread = _read(handle, &patch->numtransfers, sizeof(patch->numtransfers)))
-					  == sizeof(patch->numtransfers) )
+					offset += TransferBlockSize(patch);
+					if ( offset > size )
 					{
-						if ( patch->transfers = calloc(patch->numtransfers, sizeof(patch->transfers[0])) )
-						{
-							totalbytes += bytesread;
-
-							if ( patch->numtransfers )
-							{
-								if ( (bytesread = _read(handle, patch->transfers, patch->numtransfers*sizeof(transfer_t)))
-								  == patch->numtransfers*sizeof(transfer_t) )
-									{
-										totalbytes += bytesread;
-										readtransfers += patch->numtransfers;
-									}
-								else
-								{
-									printf("\nMissing transfer count!  Save file will now be rebuilt." );
-									break;
-								}
-							}
-							readpatches++;
-						}
-						else
-						{
-							printf("\nMemory allocation failure creating transfer lists(%d*%d)!\n",
-								  patch->numtransfers, sizeof(transfer_t) );
-							break;
-						}
-					}
-					else
-					{
-						printf("\nMissing patch count!  Save file will now be rebuilt." );
+						printf("\nMissing transfers!  Save file will now be rebuilt." );
 						break;
 					}
+					bytes += TransferBlockSize(patch);
 				}
+				readtransfers += patch->numtransfers;
+				readpatches++;
 			}
-			else
-				printf("\nIncorrect transfer patch count found!  Save file will now be rebuilt." );
 		}
-		_close( handle );
+
 		time(&end);
-		printf("%10.3fMB] (%d)\n",totalbytes/(1024.0*1024.0), end-start);
+		printf("%10.3fMB] (%d)\n",size/(1024.0*1024.0), end-start);
+
+		if (readpatches != numpatches)
+			UnmapTransferFile( view, size );
 	}
 
 	if (readpatches != numpatches )
+	{
+		// don't leave pointers into the released view
+		for( patch = patches; patch < patches + numpatches; patch++ )
+		{
+			patch->numtransfers = 0;
+			patch->transfers = NULL;
+		}
 		unlink(transferfile);
+	}
 	else
+	{
 		total_transfer = readtransfers;
+		total_transfer_bytes = bytes;
+	}
 
 	return readpatches;
 }
 
-
 //==============================================================
 
 void MakeAllScales (void)
@@ -1176,16 +1325,21 @@ void MakeAllScales (void)
 		BuildVisMatrix ();
 
 		RunThreadsOn (num_patches, true, MakeScales);
+
+		// release visibility matrix
+		FreeVisMatrix ();
+
+		// invert the transfers for gather vs scatter
+		SwapTransfers ();
+
 		if ( incremental )
 			writetransfers(transferfile, num_patches);
 		else
 			unlink(transferfile);
-
-		// release visibility matrix
-		FreeVisMatrix ();
 	}
 
-	qprintf ("transfer lists: %5.1f megs\n"
+	qprintf ("transfer lists: %5.1f megs (%5.1f uncompressed)\n"
+		, total_transfer_bytes / (1024*1024)
 		, (float)total_transfer * sizeof(transfer_t) / (1024*1024));
 }
 
@@ -1227,9 +1381,6 @@ void RadWorld (void)
 		// build transfer lists
 		MakeAllScales ();
 
-		// invert the transfers for gather vs scatter
-		RunThreadsOnIndividual (num_patches, true, SwapTransfersTask);
-
 		// spread light around
 		BounceLight ();
 
@@ -1245,6 +1396,26 @@ void RadWorld (void)
 }
 
 
+/*
+========
+PrintPeakMemory
+========
+*/
+void PrintPeakMemory (void)
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS	counters;
+
+	if (GetProcessMemoryInfo (GetCurrentProcess (), &counters, sizeof(counters)))
+		printf ("%5.1f megs peak memory\n", counters.PeakWorkingSetSize / (1024*1024.0));
+#else
+	struct rusage	usage;
+
+	if (getrusage (RUSAGE_SELF, &usage) == 0)
+		printf ("%5.1f megs peak memory\n", usage.ru_maxrss / 1024.0);
+#endif
+}
+
 /*
 ========
 main
@@ -1563,6 +1734,7 @@ int main (int argc, char **argv)
 
 	end = I_FloatTime ();
 	printf ("%5.0f seconds elapsed\n", end-start);
+	PrintPeakMemory ();
 	
 	return 0;
 }
@@ -67,13 +67,17 @@ typedef struct
 
 #define	MAX_PATCHES	65536
 
+#define	TransferPatches(p)	((byte *)((p)->transfers + (p)->numtransfers))
+#define	TransferBlockSize(p)	(((p)->numtransfers * sizeof(unsigned short) + (p)->transfersize + 3) & ~3)
+
 typedef struct patch_s
 {
 	winding_t	*winding;
 	vec3_t		mins, maxs, face_mins, face_maxs;
 	struct patch_s		*next;		// next in face
 	int			numtransfers;
-	transfer_t	*transfers;
+	unsigned short	*transfers;		// numtransfers weights, followed by the delta encoded patch indices
+	int			transfersize;		// bytes used by the patch indices
 	vec3_t		origin;
 	vec3_t		normal;
 